@@ -0,0 +1,977 @@
+#include "../DirectX.Texturing/GeometryGenerator.h"
+#include "../DirectX.Texturing/MeshCompactor.h"
+#include "../DirectX.Texturing/MeshOptimizer.h"
+#include "../DirectX.Texturing/MeshSimplifier.h"
+#include "../DirectX.Texturing/Meshlets.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		double seconds = 0.2;
+		bool csv = false;
+	};
+
+	struct Result
+	{
+		std::string name;
+		double nanoseconds; // per call
+		double bytes;       // covered by each call, 0 if throughput doesn't apply
+	};
+
+	// Results are added in here so the optimizer can't drop the work being measured
+	volatile size_t g_Sink = 0;
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: MeshBenchmark [options]\n"
+			"\n"
+			"Times generation of every surface GeometryGenerator makes, at the tessellation the\n"
+			"scene uses and at the high ones procedural props and LOD rebuilds ask for. GB/s is of\n"
+			"vertices and indices written, against a plain fill of the same number of bytes.\n"
+			"\n"
+			"The same surfaces, and the box and grid, then go through the mesh optimizer. Each\n"
+			"stage's cache miss ratio (ACMR, vertices transformed per triangle through a FIFO of\n"
+			"16) and overfetch (vertex bytes read per byte held) is printed, and every stage is\n"
+			"checked to draw the same triangles it was given.\n"
+			"\n"
+			"Last, the generated surfaces are compacted to packed vertices and 16-bit indices\n"
+			"where they fit. Every index is checked, every position to be within the bound\n"
+			"quantizing promises (the worst is printed as a fraction of it) and every texture\n"
+			"coordinate to be within half a step of half float precision.\n"
+			"\n"
+			"Then each optimized mesh gets an LOD chain. Every LOD's triangles, error and the\n"
+			"furthest any vertex of the full mesh is from it are printed, with the distance the\n"
+			"pillar's camera would switch to it at. Closed meshes are checked to stay closed,\n"
+			"and the selector to only ever get coarser further away.\n"
+			"\n"
+			"Finally the optimized meshes are split into meshlets, and each is checked to keep\n"
+			"within its limits, to draw the same triangles, and to have bounds that hold every\n"
+			"vertex and normal, and none to be closed while a triangle that fits is left. They\n"
+			"are then culled from eight views around the mesh, some looking past it. Every\n"
+			"meshlet culled is checked to really be outside the frustum or facing away, and the\n"
+			"culling to match a plain one meshlet at a time, and the share of triangles left is\n"
+			"printed. The exit code is 1 if any check fails.\n"
+			"\n"
+			"  -t <seconds>  Minimum time to run each case for (default 0.2)\n"
+			"  --csv         Print name,ns,GB/s,acmr,overfetch,vertices,bytes,compact,triangles,\n"
+			"                error,meshlets,visible for every case instead of the summary\n";
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "-t" && i + 1 < argc)
+			{
+				options.seconds = std::stod(argv[++i]);
+			}
+			else if (arg == "--csv")
+			{
+				options.csv = true;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Calls body in batches, doubling the batch until one takes a quarter of the time
+	// allowed, then returns the fastest of four batches that size in ns per call
+	template<typename Body>
+	double Measure(double seconds, Body&& body)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		auto runBatch = [&](size_t iterations)
+		{
+			auto start = Clock::now();
+			for (size_t i = 0; i < iterations; i++)
+				body();
+			return std::chrono::duration<double>(Clock::now() - start).count();
+		};
+
+		size_t iterations = 1;
+		while (runBatch(iterations) < seconds / 4 && iterations < (size_t(1) << 40))
+			iterations *= 2;
+
+		double best = runBatch(iterations);
+		for (int i = 0; i < 3; i++)
+			best = std::min(best, runBatch(iterations));
+
+		return best * 1e9 / double(iterations);
+	}
+
+	size_t MeshBytes(const MeshData& mesh)
+	{
+		return mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(unsigned int);
+	}
+
+	void PrintResult(const Options& options, const Result& result)
+	{
+		double gbps = result.bytes > 0 ? result.bytes / result.nanoseconds : 0.0;
+		if (options.csv)
+		{
+			std::cout << result.name << "," << result.nanoseconds << "," << gbps << ",,,,,,,,,\n";
+			return;
+		}
+
+		std::cout << "  " << std::left << std::setw(40) << result.name << std::right << std::fixed
+			<< std::setprecision(1) << std::setw(12) << result.nanoseconds;
+		if (result.bytes > 0)
+			std::cout << std::setprecision(2) << std::setw(12) << gbps;
+		std::cout << "\n";
+	}
+
+	void PrintStage(const Options& options, const std::string& name, float cacheMissRatio, float overfetch, size_t vertexCount)
+	{
+		if (options.csv)
+		{
+			std::cout << name << ",,," << cacheMissRatio << "," << overfetch << "," << vertexCount << ",,,,,,\n";
+			return;
+		}
+
+		std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(12) << cacheMissRatio << std::setprecision(2) << std::setw(12) << overfetch << std::setw(12) << vertexCount << "\n";
+	}
+
+	void PrintCompaction(const Options& options, const std::string& name, size_t vertexCount, size_t bytes, size_t compactBytes, float errorFraction)
+	{
+		if (options.csv)
+		{
+			std::cout << name << ",,,,," << vertexCount << "," << bytes << "," << compactBytes << ",,,,\n";
+			return;
+		}
+
+		std::cout << "  " << std::left << std::setw(40) << name << std::right << std::setw(12) << bytes << std::setw(12) << compactBytes
+			<< std::fixed << std::setprecision(3) << std::setw(12) << errorFraction << "\n";
+	}
+
+	void PrintLod(const Options& options, const std::string& name, size_t triangleCount, float error, float measured, float distance)
+	{
+		if (options.csv)
+		{
+			std::cout << name << ",,,,,,,," << triangleCount << "," << error << ",,\n";
+			return;
+		}
+
+		std::cout << "  " << std::left << std::setw(40) << name << std::right << std::setw(12) << triangleCount << std::fixed
+			<< std::setprecision(4) << std::setw(12) << error << std::setw(12) << measured << std::setprecision(1) << std::setw(12) << distance << "\n";
+	}
+
+	void PrintMeshlets(const Options& options, const std::string& name, size_t triangleCount, size_t meshletCount, float averageVertices,
+		float averageTriangles, float visible)
+	{
+		if (options.csv)
+		{
+			std::cout << name << ",,,,,,,," << triangleCount << ",," << meshletCount << "," << visible << "\n";
+			return;
+		}
+
+		std::cout << "  " << std::left << std::setw(40) << name << std::right << std::setw(12) << meshletCount << std::fixed
+			<< std::setprecision(1) << std::setw(12) << averageVertices << std::setw(12) << averageTriangles << std::setw(11) << visible * 100.0f << "%\n";
+	}
+
+	void PrintHeading(const Options& options, const char* heading, const char* unit)
+	{
+		if (!options.csv)
+			std::cout << "\n" << std::left << std::setw(42) << heading << std::right << std::setw(12) << unit << std::setw(12) << "GB/s" << "\n";
+	}
+
+	// Every triangle as the vertices it draws, turned to start at its smallest corner so
+	// the winding still shows, in sorted order. Optimizing may reorder and renumber but
+	// must leave this the same, apart from triangles that welding collapses.
+	using TriangleKey = std::array<float, 15>;
+
+	std::vector<TriangleKey> TriangleKeys(const MeshData& mesh)
+	{
+		std::vector<TriangleKey> keys;
+		keys.reserve(mesh.indices.size() / 3);
+		for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+		{
+			std::array<std::array<float, 5>, 3> corners;
+			for (int k = 0; k < 3; ++k)
+			{
+				const Vertex& v = mesh.vertices[mesh.indices[t + k]];
+				corners[k] = { v.x, v.y, v.z, v.u, v.v };
+			}
+
+			if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+				continue;
+
+			int first = int(std::min_element(corners.begin(), corners.end()) - corners.begin());
+
+			TriangleKey key;
+			for (int k = 0; k < 3; ++k)
+				std::copy(corners[(first + k) % 3].begin(), corners[(first + k) % 3].end(), key.begin() + k * 5);
+			keys.push_back(key);
+		}
+
+		std::sort(keys.begin(), keys.end());
+		return keys;
+	}
+
+	size_t CompactBytes(const Geometry::CompactMeshData& compact)
+	{
+		return compact.vertices.size() * sizeof(Geometry::PackedVertex) + compact.indices.size();
+	}
+
+	// Checks a compacted mesh against the one it came from, and returns the largest position
+	// error as a fraction of the bound, or a negative number if anything is wrong
+	float CheckCompaction(const MeshData& mesh, const Geometry::CompactMeshData& compact)
+	{
+		using namespace DirectX;
+		using namespace DirectX::PackedVector;
+
+		unsigned int expectedIndexSize = mesh.vertices.size() <= 0x10000 ? 2 : 4;
+		if (compact.indexSize != expectedIndexSize || compact.indexCount != mesh.indices.size()
+			|| compact.indices.size() != mesh.indices.size() * compact.indexSize || compact.vertices.size() != mesh.vertices.size())
+			return -1.0f;
+
+		for (unsigned int i = 0; i < compact.indexCount; ++i)
+		{
+			if (Geometry::GetIndex(compact, i) != mesh.indices[i])
+				return -1.0f;
+		}
+
+		// Positions go back through the same transform the models put in front of their world
+		// matrix. A half float keeps 11 significant bits, so rounding to it is off by at most
+		// 2^-11 of the value, or half the smallest denormal.
+		XMMATRIX dequantize = Geometry::GetDequantizeTransform(compact);
+		XMFLOAT3 bound = Geometry::GetPositionErrorBound(compact);
+
+		float worst = 0.0f;
+		for (size_t i = 0; i < mesh.vertices.size(); ++i)
+		{
+			const Vertex& vertex = mesh.vertices[i];
+			const Geometry::PackedVertex& packed = compact.vertices[i];
+
+			XMFLOAT3 position;
+			XMStoreFloat3(&position, XMVector3Transform(XMLoadUShortN4(&packed.position), dequantize));
+
+			const float errors[3] = { std::fabs(position.x - vertex.x), std::fabs(position.y - vertex.y), std::fabs(position.z - vertex.z) };
+			const float bounds[3] = { bound.x, bound.y, bound.z };
+			for (int k = 0; k < 3; ++k)
+			{
+				if (errors[k] > bounds[k])
+					return -1.0f;
+				if (bounds[k] > 0.0f)
+					worst = std::max(worst, errors[k] / bounds[k]);
+			}
+
+			const float texture[2] = { vertex.u, vertex.v };
+			const HALF halves[2] = { packed.texture.x, packed.texture.y };
+			for (int k = 0; k < 2; ++k)
+			{
+				float textureBound = std::max(std::fabs(texture[k]) * std::ldexp(1.0f, -11), std::ldexp(1.0f, -25));
+				if (std::fabs(XMConvertHalfToFloat(halves[k]) - texture[k]) > textureBound)
+					return -1.0f;
+			}
+		}
+
+		return worst;
+	}
+
+	using Position = std::array<float, 3>;
+
+	Position GetPosition(const Vertex& vertex)
+	{
+		return { vertex.x, vertex.y, vertex.z };
+	}
+
+	// Edges with no triangle the other way along them, comparing by position so texture
+	// seams don't count
+	size_t CountOpenEdges(const MeshData& mesh, size_t indexOffset, size_t indexCount)
+	{
+		using Edge = std::array<Position, 2>;
+
+		std::vector<Edge> edges;
+		edges.reserve(indexCount);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			size_t next = i - i % 3 + (i % 3 + 1) % 3;
+			edges.push_back({ GetPosition(mesh.vertices[mesh.indices[indexOffset + i]]), GetPosition(mesh.vertices[mesh.indices[indexOffset + next]]) });
+		}
+		std::sort(edges.begin(), edges.end());
+
+		size_t open = 0;
+		for (const Edge& edge : edges)
+		{
+			if (!std::binary_search(edges.begin(), edges.end(), Edge{ edge[1], edge[0] }))
+				open++;
+		}
+
+		return open;
+	}
+
+	float Distance(const Position& a, const Position& b)
+	{
+		float d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+		return std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	}
+
+	// Not normalized; it points to the side the triangle is drawn from
+	Position TriangleNormal(const MeshData& mesh, const unsigned int* corners)
+	{
+		Position a = GetPosition(mesh.vertices[corners[0]]), b = GetPosition(mesh.vertices[corners[1]]), c = GetPosition(mesh.vertices[corners[2]]);
+		Position ab = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, ac = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		return { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+	}
+
+	// Closest point on a triangle, by which of its regions the point falls in
+	Position ClosestPointOnTriangle(const Position& p, const Position& a, const Position& b, const Position& c)
+	{
+		auto sub = [](const Position& x, const Position& y) { return Position{ x[0] - y[0], x[1] - y[1], x[2] - y[2] }; };
+		auto dot = [](const Position& x, const Position& y) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; };
+		auto at = [&](float v, float w) { return Position{ a[0] + (b[0] - a[0]) * v + (c[0] - a[0]) * w, a[1] + (b[1] - a[1]) * v + (c[1] - a[1]) * w, a[2] + (b[2] - a[2]) * v + (c[2] - a[2]) * w }; };
+
+		Position ab = sub(b, a), ac = sub(c, a), ap = sub(p, a);
+		float d1 = dot(ab, ap), d2 = dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f)
+			return a;
+
+		Position bp = sub(p, b);
+		float d3 = dot(ab, bp), d4 = dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3)
+			return b;
+
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return at(d1 / (d1 - d3), 0.0f);
+
+		Position cp = sub(p, c);
+		float d5 = dot(ab, cp), d6 = dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6)
+			return c;
+
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return at(0.0f, d2 / (d2 - d6));
+
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+		{
+			float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			return at(1.0f - w, w);
+		}
+
+		float denominator = 1.0f / (va + vb + vc);
+		return at(vb * denominator, vc * denominator);
+	}
+
+	// The furthest a vertex of the full mesh is from an LOD's surface, over enough of the
+	// vertices to keep the brute force search quick
+	float MeasureDeviation(const Geometry::MeshLodChain& chain, size_t lodIndex)
+	{
+		const MeshData& mesh = chain.mesh;
+		const Geometry::MeshLod& full = chain.lods[0];
+		const Geometry::MeshLod& lod = chain.lods[lodIndex];
+
+		size_t triangleCount = lod.indexCount / 3;
+		size_t step = std::max<size_t>(1, mesh.vertices.size() * triangleCount / 4000000);
+
+		std::vector<bool> used(mesh.vertices.size(), false);
+		for (size_t i = 0; i < full.indexCount; ++i)
+			used[mesh.indices[full.indexOffset + i]] = true;
+
+		float furthest = 0.0f;
+		for (size_t v = 0; v < mesh.vertices.size(); v += step)
+		{
+			if (!used[v])
+				continue;
+
+			Position p = GetPosition(mesh.vertices[v]);
+			float nearest = FLT_MAX;
+			for (size_t t = 0; t < triangleCount; ++t)
+			{
+				const unsigned int* corners = &mesh.indices[lod.indexOffset + t * 3];
+				Position closest = ClosestPointOnTriangle(p, GetPosition(mesh.vertices[corners[0]]), GetPosition(mesh.vertices[corners[1]]),
+					GetPosition(mesh.vertices[corners[2]]));
+				nearest = std::min(nearest, Distance(p, closest));
+			}
+
+			furthest = std::max(furthest, nearest);
+		}
+
+		return furthest;
+	}
+
+	bool ValidIndices(const MeshData& mesh)
+	{
+		if (mesh.indices.size() % 3 != 0)
+			return false;
+
+		for (unsigned int index : mesh.indices)
+		{
+			if (index >= mesh.vertices.size())
+				return false;
+		}
+
+		return true;
+	}
+
+	// Checks a mesh's meshlets keep within their limits, draw every triangle of the mesh once,
+	// and have bounds that hold all of their vertices and normals
+	bool CheckMeshlets(const MeshData& mesh, const Geometry::MeshletMesh& meshlets)
+	{
+		using namespace DirectX;
+
+		if (meshlets.indices.size() != mesh.indices.size() || meshlets.bounds.size() != (meshlets.meshlets.size() + 3) / 4)
+			return false;
+
+		MeshData reordered;
+		reordered.vertices = mesh.vertices;
+		reordered.indices = meshlets.indices;
+		if (!ValidIndices(reordered) || TriangleKeys(reordered) != TriangleKeys(mesh))
+			return false;
+
+		unsigned int indexOffset = 0;
+		for (size_t i = 0; i < meshlets.meshlets.size(); ++i)
+		{
+			const Geometry::Meshlet& meshlet = meshlets.meshlets[i];
+			if (meshlet.indexOffset != indexOffset || meshlet.triangleCount == 0 || meshlet.triangleCount > Geometry::c_MeshletMaxTriangles
+				|| meshlet.vertexCount > Geometry::c_MeshletMaxVertices)
+				return false;
+			indexOffset += meshlet.triangleCount * 3;
+
+			std::vector<unsigned int> used(&meshlets.indices[meshlet.indexOffset], &meshlets.indices[meshlet.indexOffset] + meshlet.triangleCount * 3);
+			std::sort(used.begin(), used.end());
+			if (std::unique(used.begin(), used.end()) - used.begin() != meshlet.vertexCount)
+				return false;
+
+			const Geometry::MeshletBoundsBlock& block = meshlets.bounds[i / 4];
+			size_t lane = i % 4;
+			Position center = { (&block.centerX.x)[lane], (&block.centerY.x)[lane], (&block.centerZ.x)[lane] };
+			Position axis = { (&block.axisX.x)[lane], (&block.axisY.x)[lane], (&block.axisZ.x)[lane] };
+			float radius = (&block.radius.x)[lane];
+			float cutoff = (&block.cutoff.x)[lane];
+			float slack = 1e-5f * (radius + Distance(center, Position{ 0.0f, 0.0f, 0.0f }));
+
+			// Every normal within the cone's half angle of its axis, whose cosine is
+			// sqrt(1 - cutoff^2)
+			float minimumDot = cutoff < 1.0f ? std::sqrt(1.0f - cutoff * cutoff) : -1.0f;
+			for (unsigned int k = 0; k < meshlet.triangleCount * 3; k += 3)
+			{
+				const unsigned int* corners = &meshlets.indices[meshlet.indexOffset + k];
+				for (int c = 0; c < 3; ++c)
+				{
+					if (Distance(GetPosition(mesh.vertices[corners[c]]), center) > radius + slack)
+						return false;
+				}
+
+				Position normal = TriangleNormal(mesh, corners);
+				float length = Distance(normal, Position{ 0.0f, 0.0f, 0.0f });
+				if (length > 0.0f && (normal[0] * axis[0] + normal[1] * axis[1] + normal[2] * axis[2]) / length < minimumDot - 1e-4f)
+					return false;
+			}
+		}
+
+		// Lanes past the last meshlet never cull by cone
+		for (size_t i = meshlets.meshlets.size(); i < meshlets.bounds.size() * 4; ++i)
+		{
+			if ((&meshlets.bounds[i / 4].cutoff.x)[i % 4] != 1.0f)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Checks no meshlet was closed early: each but the last is at its triangle limit, or no
+	// triangle of a later meshlet would fit within its vertex limit. A mesh small enough for
+	// one meshlet, like the box, is one meshlet.
+	bool CheckMeshletsFilled(const Geometry::MeshletMesh& meshlets)
+	{
+		std::vector<size_t> inMeshlet;
+		for (size_t i = 0; i + 1 < meshlets.meshlets.size(); ++i)
+		{
+			const Geometry::Meshlet& meshlet = meshlets.meshlets[i];
+			if (meshlet.triangleCount == Geometry::c_MeshletMaxTriangles)
+				continue;
+
+			for (unsigned int k = 0; k < meshlet.triangleCount * 3; ++k)
+			{
+				unsigned int v = meshlets.indices[meshlet.indexOffset + k];
+				if (v >= inMeshlet.size())
+					inMeshlet.resize(v + 1, ~size_t(0));
+				inMeshlet[v] = i;
+			}
+
+			unsigned int laterBegin = meshlet.indexOffset + meshlet.triangleCount * 3;
+			for (size_t k = laterBegin; k < meshlets.indices.size(); k += 3)
+			{
+				unsigned int added = 0;
+				for (int c = 0; c < 3; ++c)
+				{
+					unsigned int v = meshlets.indices[k + c];
+					added += v < inMeshlet.size() && inMeshlet[v] == i ? 0 : 1;
+				}
+				if (meshlet.vertexCount + added <= Geometry::c_MeshletMaxVertices)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// Culls the meshlets one at a time from the same bounds, for the four at a time culling
+	// to be checked against
+	std::vector<unsigned int> CullMeshletsOneByOne(const Geometry::MeshletMesh& meshlets, const Geometry::MeshletCullView& cullView)
+	{
+		std::vector<unsigned int> visible;
+		for (unsigned int i = 0; i < meshlets.meshlets.size(); ++i)
+		{
+			const Geometry::MeshletBoundsBlock& block = meshlets.bounds[i / 4];
+			unsigned int lane = i % 4;
+			float center[3] = { (&block.centerX.x)[lane], (&block.centerY.x)[lane], (&block.centerZ.x)[lane] };
+			float axis[3] = { (&block.axisX.x)[lane], (&block.axisY.x)[lane], (&block.axisZ.x)[lane] };
+			float radius = (&block.radius.x)[lane];
+			float cutoff = (&block.cutoff.x)[lane];
+
+			bool culled = false;
+			for (const DirectX::XMFLOAT4& plane : cullView.planes)
+				culled = culled || plane.x * center[0] + plane.y * center[1] + plane.z * center[2] + plane.w < -radius;
+
+			float toCenter[3] = { center[0] - cullView.eye.x, center[1] - cullView.eye.y, center[2] - cullView.eye.z };
+			float along = toCenter[0] * axis[0] + toCenter[1] * axis[1] + toCenter[2] * axis[2];
+			float distance = std::sqrt(toCenter[0] * toCenter[0] + toCenter[1] * toCenter[1] + toCenter[2] * toCenter[2]);
+			culled = culled || along > cutoff * distance + radius * (1.0f + cutoff);
+
+			if (!culled)
+				visible.push_back(i);
+		}
+
+		return visible;
+	}
+
+	// Whether every vertex of the meshlet is outside one frustum plane, or every triangle of
+	// it faces away from the eye, so that culling it can't have lost anything on screen
+	bool IsMeshletHidden(const MeshData& mesh, const Geometry::MeshletMesh& meshlets, const Geometry::MeshletCullView& cullView, unsigned int index)
+	{
+		const Geometry::Meshlet& meshlet = meshlets.meshlets[index];
+		const unsigned int* indices = &meshlets.indices[meshlet.indexOffset];
+		unsigned int indexCount = meshlet.triangleCount * 3;
+
+		for (const DirectX::XMFLOAT4& plane : cullView.planes)
+		{
+			bool outside = true;
+			for (unsigned int k = 0; k < indexCount && outside; ++k)
+			{
+				const Vertex& v = mesh.vertices[indices[k]];
+				outside = double(plane.x) * v.x + double(plane.y) * v.y + double(plane.z) * v.z + plane.w < 0.0;
+			}
+
+			if (outside)
+				return true;
+		}
+
+		Position eye = { cullView.eye.x, cullView.eye.y, cullView.eye.z };
+		for (unsigned int k = 0; k < indexCount; k += 3)
+		{
+			Position normal = TriangleNormal(mesh, &indices[k]);
+			const Vertex& a = mesh.vertices[indices[k]];
+			if (double(normal[0]) * (a.x - eye[0]) + double(normal[1]) * (a.y - eye[1]) + double(normal[2]) * (a.z - eye[2]) < 0.0)
+				return false;
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return -1;
+	}
+
+	if (options.csv)
+		std::cout << "name,ns,GB/s,acmr,overfetch,vertices,bytes,compact,triangles,error,meshlets,visible\n";
+
+	int failures = 0;
+
+	// Every surface, generated over and over into the same mesh the way an LOD rebuild would,
+	// so only the first call sizes it
+	PrintHeading(options, "Surface generation", "ns/mesh");
+
+	struct Surface
+	{
+		std::string name;
+		void (*generate)(MeshData* mesh);
+	};
+
+	struct Stage
+	{
+		const char* name;
+		void (*run)(MeshData* mesh);
+	};
+
+	// The pillar's cylinder first, then tessellations a procedural prop could ask for
+	const Surface surfaces[] =
+	{
+		{ "Cylinder 8x8", [](MeshData* mesh) { Geometry::CreateCylinder(0.5f, 0.5f, 4.0f, 8, 8, mesh); } },
+		{ "Cylinder 512x512", [](MeshData* mesh) { Geometry::CreateCylinder(0.5f, 0.5f, 4.0f, 512, 512, mesh); } },
+		{ "Cone 512x512", [](MeshData* mesh) { Geometry::CreateCone(0.5f, 1.0f, 512, 512, mesh); } },
+		{ "Sphere 512x256", [](MeshData* mesh) { Geometry::CreateSphere(1.0f, 512, 256, mesh); } },
+		{ "Geosphere 7", [](MeshData* mesh) { Geometry::CreateGeosphere(1.0f, 7, mesh); } },
+		{ "Torus 512x256", [](MeshData* mesh) { Geometry::CreateTorus(1.0f, 0.25f, 512, 256, mesh); } },
+	};
+
+	size_t largestBytes = 0;
+	for (const auto& surface : surfaces)
+	{
+		MeshData mesh;
+		surface.generate(&mesh);
+
+		double ns = Measure(options.seconds, [&]
+		{
+			surface.generate(&mesh);
+			g_Sink = g_Sink + mesh.indices.back();
+		});
+
+		std::string name = surface.name + " (" + std::to_string(mesh.vertices.size()) + " vertices)";
+		PrintResult(options, { name, ns, double(MeshBytes(mesh)) });
+		largestBytes = std::max(largestBytes, MeshBytes(mesh));
+	}
+
+	// What writing that much memory costs with nothing to work out, for comparison
+	std::vector<unsigned char> fill(largestBytes);
+	double ns = Measure(options.seconds, [&]
+	{
+		memset(fill.data(), int(g_Sink & 0xff), fill.size());
+		g_Sink = g_Sink + fill.back();
+	});
+	PrintResult(options, { "memset, " + std::to_string(largestBytes >> 20) + " MB", ns, double(largestBytes) });
+
+	// Each optimizer stage in turn, checked against the triangles it was given
+	if (!options.csv)
+	{
+		std::cout << "\n" << std::left << std::setw(42) << "Mesh optimization" << std::right
+			<< std::setw(12) << "ACMR" << std::setw(12) << "overfetch" << std::setw(12) << "vertices" << "\n";
+	}
+
+	const Surface meshes[] =
+	{
+		{ "Box", [](MeshData* mesh) { Geometry::CreateBox(1.0f, 1.0f, 1.0f, mesh); } },
+		{ "Grid 64x64", [](MeshData* mesh) { Geometry::CreateGrid(10.0f, 10.0f, 64, 64, mesh); } },
+		{ "Cylinder 8x8", [](MeshData* mesh) { Geometry::CreateCylinder(0.5f, 0.5f, 4.0f, 8, 8, mesh); } },
+		{ "Cylinder 128x128", [](MeshData* mesh) { Geometry::CreateCylinder(0.5f, 0.5f, 4.0f, 128, 128, mesh); } },
+		{ "Sphere 64x32", [](MeshData* mesh) { Geometry::CreateSphere(1.0f, 64, 32, mesh); } },
+		{ "Geosphere 4", [](MeshData* mesh) { Geometry::CreateGeosphere(1.0f, 4, mesh); } },
+		{ "Torus 64x32", [](MeshData* mesh) { Geometry::CreateTorus(1.0f, 0.25f, 64, 32, mesh); } },
+	};
+
+	const Stage stages[] =
+	{
+		{ "weld", [](MeshData* mesh) { Geometry::WeldVertices(mesh); } },
+		{ "vertex cache", [](MeshData* mesh) { Geometry::OptimizeVertexCache(mesh); } },
+		{ "overdraw", [](MeshData* mesh) { Geometry::OptimizeOverdraw(mesh); } },
+		{ "vertex fetch", [](MeshData* mesh) { Geometry::OptimizeVertexFetch(mesh); } },
+	};
+
+	std::vector<MeshData> inputs;
+	for (const auto& surface : meshes)
+	{
+		MeshData mesh;
+		surface.generate(&mesh);
+		inputs.push_back(mesh);
+
+		PrintStage(options, surface.name + " input", Geometry::ComputeCacheMissRatio(mesh), Geometry::ComputeOverfetchRatio(mesh), mesh.vertices.size());
+
+		std::vector<TriangleKey> triangles = TriangleKeys(mesh);
+		for (const auto& stage : stages)
+		{
+			stage.run(&mesh);
+			PrintStage(options, surface.name + " " + stage.name, Geometry::ComputeCacheMissRatio(mesh), Geometry::ComputeOverfetchRatio(mesh), mesh.vertices.size());
+
+			if (!ValidIndices(mesh) || TriangleKeys(mesh) != triangles)
+			{
+				std::cerr << surface.name << ": " << stage.name << " changed the triangles drawn" << std::endl;
+				failures++;
+			}
+		}
+	}
+
+	// The whole pipeline, from a copy of the generated mesh each time
+	PrintHeading(options, "Mesh optimization time", "ns/mesh");
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		MeshData mesh;
+		ns = Measure(options.seconds, [&]
+		{
+			mesh = inputs[i];
+			Geometry::OptimizeMesh(&mesh);
+			g_Sink = g_Sink + mesh.vertices.size();
+		});
+		std::string name = meshes[i].name + " (" + std::to_string(inputs[i].indices.size() / 3) + " triangles)";
+		PrintResult(options, { name, ns, 0.0 });
+	}
+
+	// Compaction of the generated surfaces, from the pillar's up to ones too big for 16-bit
+	// indices, checked against the bounds it promises
+	if (!options.csv)
+	{
+		std::cout << "\n" << std::left << std::setw(42) << "Mesh compaction" << std::right
+			<< std::setw(12) << "bytes" << std::setw(12) << "compact" << std::setw(12) << "error" << "\n";
+	}
+
+	std::vector<MeshData> generated;
+	for (const auto& surface : surfaces)
+	{
+		MeshData mesh;
+		surface.generate(&mesh);
+		generated.push_back(mesh);
+
+		Geometry::CompactMeshData compact;
+		Geometry::CompactMesh(mesh, &compact);
+
+		float errorFraction = CheckCompaction(mesh, compact);
+		if (errorFraction < 0.0f)
+		{
+			std::cerr << surface.name << ": compacting doesn't match the mesh within its bounds" << std::endl;
+			failures++;
+		}
+
+		PrintCompaction(options, surface.name + " (" + std::to_string(compact.indexSize * 8) + "-bit indices)", mesh.vertices.size(),
+			MeshBytes(mesh), CompactBytes(compact), errorFraction);
+	}
+
+	// Compacting into the same mesh each time, in GB/s of the mesh read
+	PrintHeading(options, "Mesh compaction time", "ns/mesh");
+	for (size_t i = 0; i < generated.size(); i++)
+	{
+		Geometry::CompactMeshData compact;
+		ns = Measure(options.seconds, [&]
+		{
+			Geometry::CompactMesh(generated[i], &compact);
+			g_Sink = g_Sink + compact.indices.back();
+		});
+		PrintResult(options, { surfaces[i].name, ns, double(MeshBytes(generated[i])) });
+	}
+
+	// An LOD chain for every optimized mesh, with the pillar's error limit. The distances are
+	// where the selector switches to each LOD, for the scene's camera and window.
+	const float lodMaxError = 0.25f;
+	const float viewportHeight = 600.0f;
+	DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(50.0f), 800.0f / 600.0f, 0.01f, 100.0f);
+
+	if (!options.csv)
+	{
+		std::cout << "\n" << std::left << std::setw(42) << "Mesh LODs" << std::right << std::setw(12) << "triangles"
+			<< std::setw(12) << "error" << std::setw(12) << "measured" << std::setw(12) << "from" << "\n";
+	}
+
+	std::vector<MeshData> optimized;
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		MeshData mesh = inputs[i];
+		Geometry::OptimizeMesh(&mesh);
+		optimized.push_back(mesh);
+
+		Geometry::MeshLodChain chain;
+		Geometry::BuildLodChain(mesh, 8, lodMaxError, &chain);
+
+		bool closed = CountOpenEdges(chain.mesh, 0, chain.lods[0].indexCount) == 0;
+		bool valid = ValidIndices(chain.mesh);
+		for (size_t l = 0; l < chain.lods.size(); l++)
+		{
+			const Geometry::MeshLod& lod = chain.lods[l];
+			if (l > 0)
+			{
+				const Geometry::MeshLod& previous = chain.lods[l - 1];
+				valid = valid && lod.indexCount < previous.indexCount && lod.error >= previous.error && lod.error <= lodMaxError;
+				valid = valid && lod.indexCount % 3 == 0 && lod.indexOffset + lod.indexCount <= chain.mesh.indices.size();
+			}
+
+			if (closed && CountOpenEdges(chain.mesh, lod.indexOffset, lod.indexCount) != 0)
+			{
+				std::cerr << meshes[i].name << ": LOD " << l << " opened up" << std::endl;
+				failures++;
+			}
+
+			float distance = Geometry::ComputeScreenError(lod.error, projection, viewportHeight, 1.0f);
+			PrintLod(options, meshes[i].name + " LOD " + std::to_string(l), lod.indexCount / 3, lod.error,
+				l > 0 ? MeasureDeviation(chain, l) : 0.0f, distance);
+		}
+
+		if (!valid)
+		{
+			std::cerr << meshes[i].name << ": LOD chain isn't ordered fine to coarse within the error limit" << std::endl;
+			failures++;
+		}
+
+		// Further away the selector may only get coarser, and never past what a pixel allows
+		unsigned int selected = 0;
+		for (float distance = 0.01f; distance < 1000.0f; distance *= 1.25f)
+		{
+			unsigned int lod = Geometry::SelectLod(chain, projection, viewportHeight, distance);
+			if (lod < selected || (lod > 0 && Geometry::ComputeScreenError(chain.lods[lod].error, projection, viewportHeight, distance) > 1.0f))
+			{
+				std::cerr << meshes[i].name << ": LOD " << lod << " selected at " << distance << std::endl;
+				failures++;
+				break;
+			}
+			selected = lod;
+		}
+	}
+
+	PrintHeading(options, "LOD chain build time", "ns/mesh");
+	for (size_t i = 0; i < optimized.size(); i++)
+	{
+		Geometry::MeshLodChain chain;
+		ns = Measure(options.seconds, [&]
+		{
+			Geometry::BuildLodChain(optimized[i], 8, lodMaxError, &chain);
+			g_Sink = g_Sink + chain.mesh.indices.size();
+		});
+		std::string name = meshes[i].name + " (" + std::to_string(chain.lods.size()) + " LODs)";
+		PrintResult(options, { name, ns, 0.0 });
+	}
+
+	// Meshlets of every optimized mesh, culled from eight views orbiting it. The odd ones look
+	// off to one side, so some of the mesh is outside the frustum as well as facing away.
+	if (!options.csv)
+	{
+		std::cout << "\n" << std::left << std::setw(42) << "Meshlets" << std::right << std::setw(12) << "meshlets"
+			<< std::setw(12) << "vertices" << std::setw(12) << "triangles" << std::setw(12) << "visible" << "\n";
+	}
+
+	const int viewCount = 8;
+	std::vector<Geometry::MeshletMesh> meshletMeshes;
+	std::vector<std::vector<Geometry::MeshletCullView>> cullViews;
+	for (size_t i = 0; i < optimized.size(); i++)
+	{
+		const MeshData& mesh = optimized[i];
+		Geometry::MeshletMesh meshlets;
+		Geometry::BuildMeshlets(mesh, &meshlets);
+		meshletMeshes.push_back(meshlets);
+
+		if (!CheckMeshlets(mesh, meshlets))
+		{
+			std::cerr << meshes[i].name << ": meshlets don't match the mesh or their bounds" << std::endl;
+			failures++;
+		}
+
+		if (!CheckMeshletsFilled(meshlets))
+		{
+			std::cerr << meshes[i].name << ": a meshlet was closed while triangles that fit were left" << std::endl;
+			failures++;
+		}
+
+		Geometry::MeshLodChain bounds;
+		Geometry::BuildLodChain(mesh, 1, 0.0f, &bounds);
+		DirectX::XMVECTOR center = DirectX::XMLoadFloat3(&bounds.center);
+
+		std::vector<Geometry::MeshletCullView> views;
+		std::vector<unsigned int> visible(meshlets.meshlets.size());
+		std::vector<unsigned int> indices(meshlets.indices.size());
+		size_t visibleTriangles = 0;
+		for (int v = 0; v < viewCount; v++)
+		{
+			float angle = DirectX::XM_2PI * v / viewCount;
+			DirectX::XMVECTOR offset = DirectX::XMVectorScale(DirectX::XMVectorSet(std::cos(angle), 0.5f, std::sin(angle), 0.0f), 2.5f * bounds.radius);
+			DirectX::XMVECTOR eye = DirectX::XMVectorAdd(center, offset);
+			DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(eye, center, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			if (v % 2)
+				view = DirectX::XMMatrixMultiply(view, DirectX::XMMatrixRotationY(DirectX::XMConvertToRadians(30.0f)));
+
+			// A world transform that isn't the identity, for the planes and eye to be brought back through
+			DirectX::XMMATRIX world = DirectX::XMMatrixTranslation(1.0f, 2.0f, 3.0f);
+			view = DirectX::XMMatrixMultiply(DirectX::XMMatrixTranslation(-1.0f, -2.0f, -3.0f), view);
+
+			Geometry::MeshletCullView cullView;
+			Geometry::ComputeMeshletCullView(world, view, projection, &cullView);
+			views.push_back(cullView);
+
+			unsigned int visibleCount = Geometry::CullMeshlets(meshlets, cullView, visible.data());
+			unsigned int indexCount = Geometry::CompactMeshlets(meshlets, visible.data(), visibleCount, indices.data());
+
+			std::vector<unsigned int> expected = CullMeshletsOneByOne(meshlets, cullView);
+			bool matches = std::vector<unsigned int>(visible.begin(), visible.begin() + visibleCount) == expected;
+
+			std::vector<unsigned int> expectedIndices;
+			for (unsigned int m = 0, next = 0; m < meshlets.meshlets.size(); m++)
+			{
+				const Geometry::Meshlet& meshlet = meshlets.meshlets[m];
+				if (next < visibleCount && visible[next] == m)
+				{
+					expectedIndices.insert(expectedIndices.end(), &meshlets.indices[meshlet.indexOffset],
+						&meshlets.indices[meshlet.indexOffset] + meshlet.triangleCount * 3);
+					next++;
+				}
+				else if (!IsMeshletHidden(mesh, meshlets, cullView, m))
+				{
+					std::cerr << meshes[i].name << ": meshlet " << m << " culled from view " << v << " but could be seen" << std::endl;
+					failures++;
+				}
+			}
+
+			if (!matches || std::vector<unsigned int>(indices.begin(), indices.begin() + indexCount) != expectedIndices)
+			{
+				std::cerr << meshes[i].name << ": culling from view " << v << " doesn't match culling one meshlet at a time" << std::endl;
+				failures++;
+			}
+
+			visibleTriangles += indexCount / 3;
+		}
+		cullViews.push_back(views);
+
+		size_t meshletVertices = 0;
+		for (const Geometry::Meshlet& meshlet : meshlets.meshlets)
+			meshletVertices += meshlet.vertexCount;
+
+		size_t triangleCount = mesh.indices.size() / 3;
+		float meshletCount = float(std::max<size_t>(1, meshlets.meshlets.size()));
+		PrintMeshlets(options, meshes[i].name, triangleCount, meshlets.meshlets.size(), meshletVertices / meshletCount,
+			triangleCount / meshletCount, float(visibleTriangles) / float(std::max<size_t>(1, triangleCount * viewCount)));
+	}
+
+	PrintHeading(options, "Meshlet build time", "ns/mesh");
+	for (size_t i = 0; i < optimized.size(); i++)
+	{
+		Geometry::MeshletMesh meshlets;
+		ns = Measure(options.seconds, [&]
+		{
+			Geometry::BuildMeshlets(optimized[i], &meshlets);
+			g_Sink = g_Sink + meshlets.meshlets.size();
+		});
+		PrintResult(options, { meshes[i].name, ns, 0.0 });
+	}
+
+	// Culling and compacting for each view in turn, in GB/s of bounds read
+	PrintHeading(options, "Meshlet cull and compact time", "ns/view");
+	for (size_t i = 0; i < meshletMeshes.size(); i++)
+	{
+		const Geometry::MeshletMesh& meshlets = meshletMeshes[i];
+		std::vector<unsigned int> visible(meshlets.meshlets.size());
+		std::vector<unsigned int> indices(meshlets.indices.size());
+
+		size_t view = 0;
+		ns = Measure(options.seconds, [&]
+		{
+			const Geometry::MeshletCullView& cullView = cullViews[i][view++ % viewCount];
+			unsigned int visibleCount = Geometry::CullMeshlets(meshlets, cullView, visible.data());
+			g_Sink = g_Sink + Geometry::CompactMeshlets(meshlets, visible.data(), visibleCount, indices.data());
+		});
+		std::string name = meshes[i].name + " (" + std::to_string(meshlets.meshlets.size()) + " meshlets)";
+		PrintResult(options, { name, ns, double(meshlets.bounds.size() * sizeof(Geometry::MeshletBoundsBlock)) });
+	}
+
+	std::cout << std::flush;
+	return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,2118 @@
+#include "../DirectX.Texturing/BCDecoder.h"
+#include "../DirectX.Texturing/DDSParser.h"
+#include "../DirectX.Texturing/DXGIFormatTraits.h"
+#include "../DirectX.Texturing/FileSource.h"
+#include "../DirectX.Texturing/LegacyFormatConverter.h"
+#include "../DirectX.Texturing/LZ4Frame.h"
+#include "../DirectX.Texturing/MipGenerator.h"
+#include "../DirectX.Texturing/MipStreaming.h"
+#include "../DirectX.Texturing/RingAllocator.h"
+#include "../DirectX.Texturing/TextureArchive.h"
+#include "../DirectX.Texturing/TextureArrayPacker.h"
+#include "../DirectX.Texturing/VirtualTexture.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	// Values from d3d11.h, which the parser doesn't need
+	const uint32_t ResourceMiscTextureCube = 0x4;
+	const uint32_t ResourceDimensionTexture3D = 4;
+
+	struct Options
+	{
+		std::string directory = "Textures";
+		double seconds = 0.2;
+		bool csv = false;
+		std::string source;     // empty for io_uring where there is one, the platform's own otherwise
+	};
+
+	// A DDS file in memory
+	struct Sample
+	{
+		std::string name;
+		std::filesystem::path path;
+		std::vector<uint8_t> data;
+	};
+
+	// Sequential read speeds to weigh decompression against, in bytes per second
+	struct Disk
+	{
+		const char* name;
+		double bytesPerSecond;
+	};
+
+	const Disk c_Disks[] =
+	{
+		{ "HDD 150 MB/s", 150e6 },
+		{ "SATA SSD 550 MB/s", 550e6 },
+		{ "NVMe SSD 3.5 GB/s", 3.5e9 },
+	};
+
+	struct Result
+	{
+		std::string name;
+		double nanoseconds; // per call
+		double bytes;       // covered by each call, 0 if throughput doesn't apply
+	};
+
+	// What -r accepts, in the order the file reads are timed
+	const char* const c_Sources[] =
+	{
+#ifdef _WIN32
+		"win32",
+#else
+		"posix",
+#endif
+#ifdef __linux__
+		"io_uring",
+#endif
+	};
+
+	// Results are added in here so the optimizer can't drop the work being measured
+	volatile size_t g_Sink = 0;
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: TextureBenchmark [options] [directory]\n"
+			"\n"
+			"Times DDS header parsing and subresource layout over the .dds files in directory\n"
+			"(default Textures) and over synthetic headers for every DXGI format. Pixels are never\n"
+			"read, so GB/s is how much file the loader gets through, not memory bandwidth.\n"
+			"\n"
+			"The same files are then compressed into LZ4 frames (.dds.lz4) to time decompression,\n"
+			"and the load time of each is worked out raw and compressed, at the speed the files\n"
+			"read from their own disk and at typical hard disk and SSD speeds.\n"
+			"\n"
+			"Conversion of each legacy layout no DXGI format has is timed on a 1024x1024 surface\n"
+			"for every path the CPU has, on one thread and on all of them; GB/s is of pixels written.\n"
+			"\n"
+			"The mip streaming schedule is run over two sets of textures drawn one after the other,\n"
+			"in a budget that holds one set whole, and checked to stay in it.\n"
+			"\n"
+			"Each file's headers are then probed through the file source, as is and compressed.\n"
+			"On Linux, an io_uring batch of more files than its queue is deep is checked to read\n"
+			"with only a queue's worth of file descriptors free, and to fail cleanly with none.\n"
+			"\n"
+			"Each frame is also decoded corrupted, truncated and into too small a buffer, which\n"
+			"has to fail, and as a header prefix, which has to match the file.\n"
+			"The staging ring allocator is checked against a randomized model of live space.\n"
+			"Virtual texturing's page table, tile cache and feedback are checked, and a frame of\n"
+			"feedback is timed.\n"
+			"Texture array packing is checked on the shipped textures and on synthetic mixes, and\n"
+			"a texture saved without mips is checked to come out of an archive with its chain.\n"
+			"Each BC format is decoded from noise on every path the CPU has, checked against the\n"
+			"scalar decoder, and timed in MP/s.\n"
+			"\n"
+			"Files are read through a file source, and every source the platform has reads the\n"
+			"whole directory in one batch with the files' pages dropped from the cache first.\n"
+			"Each file is also read into memory and mapped, then copied as the driver would,\n"
+			"from the cache and from the disk, where the mapping is also timed prefaulted.\n"
+			"\n"
+			"Exits with 1 if a check along the way fails.\n"
+			"\n"
+			"  -t <seconds>  Minimum time to run each case for (default 0.2)\n"
+			"  -r <source>   Read the files through win32, posix or io_uring (default io_uring\n"
+			"                where the kernel has it, the platform's own source otherwise)\n"
+			"  --csv         Print name,ns,GB/s for every case instead of the summary\n";
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		std::vector<std::string> directories;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "-t" && i + 1 < argc)
+			{
+				options.seconds = std::stod(argv[++i]);
+			}
+			else if (arg == "-r" && i + 1 < argc)
+			{
+				options.source = argv[++i];
+			}
+			else if (arg == "--csv")
+			{
+				options.csv = true;
+			}
+			else if (!arg.empty() && arg[0] != '-')
+			{
+				directories.push_back(arg);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		if (directories.size() > 1)
+			return false;
+
+		if (!directories.empty())
+			options.directory = directories[0];
+		return true;
+	}
+
+	// Calls body in batches, doubling the batch until one takes a quarter of the time
+	// allowed, then returns the fastest of four batches that size in ns per call
+	template<typename Body>
+	double Measure(double seconds, Body&& body)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		auto runBatch = [&](size_t iterations)
+		{
+			auto start = Clock::now();
+			for (size_t i = 0; i < iterations; i++)
+				body();
+			return std::chrono::duration<double>(Clock::now() - start).count();
+		};
+
+		size_t iterations = 1;
+		while (runBatch(iterations) < seconds / 4 && iterations < (size_t(1) << 40))
+			iterations *= 2;
+
+		double best = runBatch(iterations);
+		for (int i = 0; i < 3; i++)
+			best = std::min(best, runBatch(iterations));
+
+		return best * 1e9 / double(iterations);
+	}
+
+	// What the loader does before creating any resources: validate the header, work out the
+	// texture's shape from it, then lay every subresource out over the pixel data
+	HRESULT ParseDDS(const uint8_t* data, size_t size, std::vector<D3D11_SUBRESOURCE_DATA>& initData)
+	{
+		const DDS_HEADER* header = nullptr;
+		const uint8_t* bitData = nullptr;
+		size_t bitSize = 0;
+		HRESULT hr = DirectX::LoadTextureDataFromMemory(data, size, &header, &bitData, &bitSize);
+		if (FAILED(hr))
+			return hr;
+
+		size_t width = header->width;
+		size_t height = header->height;
+		size_t depth = 1;
+		size_t mipCount = std::max<size_t>(header->mipMapCount, 1);
+		size_t arraySize = 1;
+		DXGI_FORMAT format;
+
+		if ((header->ddspf.flags & DDS_FOURCC) && header->ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0'))
+		{
+			auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(reinterpret_cast<const uint8_t*>(header) + sizeof(DDS_HEADER));
+			format = d3d10ext->dxgiFormat;
+			arraySize = d3d10ext->arraySize;
+			if (d3d10ext->miscFlag & ResourceMiscTextureCube)
+				arraySize *= 6;
+			if (d3d10ext->resourceDimension == ResourceDimensionTexture3D)
+				depth = header->depth;
+		}
+		else
+		{
+			format = DirectX::GetDXGIFormat(header->ddspf);
+			if (header->flags & DDS_HEADER_FLAGS_VOLUME)
+				depth = header->depth;
+			else if (header->caps2 & DDS_CUBEMAP)
+				arraySize = 6;
+		}
+
+		if (arraySize == 0 || mipCount * arraySize > initData.size())
+			return E_FAIL;
+
+		size_t twidth, theight, tdepth, skipMip;
+		hr = DirectX::FillInitData(width, height, depth, mipCount, arraySize, format, 0, bitSize, bitData, twidth, theight, tdepth, skipMip, initData.data());
+		if (SUCCEEDED(hr))
+			g_Sink = g_Sink + twidth + reinterpret_cast<size_t>(initData[mipCount * arraySize - 1].pSysMem);
+		return hr;
+	}
+
+	HRESULT CreateSource(const std::string& name, std::unique_ptr<DirectX::IFileSource>& source)
+	{
+		if (name.empty())
+		{
+#ifdef __linux__
+			if (SUCCEEDED(DirectX::CreateIoUringFileSource(source)))
+				return S_OK;
+#endif
+			return DirectX::CreateDefaultFileSource(source);
+		}
+
+#ifdef _WIN32
+		if (name == "win32")
+			return DirectX::CreateWin32FileSource(source);
+#else
+		if (name == "posix")
+			return DirectX::CreatePosixFileSource(source);
+#endif
+#ifdef __linux__
+		if (name == "io_uring")
+			return DirectX::CreateIoUringFileSource(source);
+#endif
+		return E_INVALIDARG;
+	}
+
+	// Reads every sample's file in one batch; requests hold the data, or the failure, of each
+	void ReadSamples(DirectX::IFileSource* source, const std::vector<Sample>& samples, std::vector<DirectX::FileReadRequest>& requests)
+	{
+		std::vector<std::wstring> fileNames;
+		for (const auto& sample : samples)
+			fileNames.push_back(sample.path.wstring());
+
+		requests.clear();
+		requests.resize(samples.size());
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			requests[i].fileName = fileNames[i].c_str();
+			requests[i].offset = 0;
+			requests[i].size = 0;
+			requests[i].result = S_OK;
+		}
+
+		source->ReadFiles(requests.data(), requests.size());
+	}
+
+	bool LoadSamples(DirectX::IFileSource* source, const std::string& directory, std::vector<Sample>& samples)
+	{
+		std::vector<Sample> found;
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::u8path(directory), error))
+		{
+			std::string extension = entry.path().extension().u8string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+			if (!entry.is_regular_file() || extension != ".dds")
+				continue;
+
+			Sample sample;
+			sample.name = entry.path().filename().u8string();
+			sample.path = entry.path();
+			found.push_back(std::move(sample));
+		}
+
+		if (error)
+		{
+			std::cerr << directory << ": " << error.message() << std::endl;
+			return false;
+		}
+
+		std::sort(found.begin(), found.end(), [](const Sample& a, const Sample& b) { return a.name < b.name; });
+
+		std::vector<DirectX::FileReadRequest> requests;
+		ReadSamples(source, found, requests);
+		for (size_t i = 0; i < found.size(); i++)
+		{
+			if (FAILED(requests[i].result))
+			{
+				std::cerr << found[i].name << ": read failed (0x" << std::hex << (unsigned int)requests[i].result << std::dec << ")" << std::endl;
+				continue;
+			}
+
+			found[i].data.assign(requests[i].data.get(), requests[i].data.get() + requests[i].size);
+			samples.push_back(std::move(found[i]));
+		}
+
+		return true;
+	}
+
+	enum SyntheticShape
+	{
+		SHAPE_2D,
+		SHAPE_CUBE,
+		SHAPE_ARRAY,
+		SHAPE_VOLUME,
+	};
+
+	const char* ShapeName(SyntheticShape shape)
+	{
+		switch (shape)
+		{
+		case SHAPE_CUBE: return "cube 128";
+		case SHAPE_ARRAY: return "array 256x8";
+		case SHAPE_VOLUME: return "volume 64";
+		default: return "2D 256";
+		}
+	}
+
+	// A "DX10" DDS file with a full mip chain and zeroed pixels; false if the format can't
+	// have that shape
+	bool MakeSyntheticDDS(DXGI_FORMAT format, SyntheticShape shape, std::vector<uint8_t>& data)
+	{
+		const DirectX::DXGIFormatTraits& traits = DirectX::GetDXGIFormatTraits(format);
+		if (!traits.bitsPerPixel)
+			return false;
+
+		// Video formats only come as single 2D surfaces
+		bool video = traits.layout == DirectX::DXGI_FORMAT_LAYOUT_PACKED || traits.layout == DirectX::DXGI_FORMAT_LAYOUT_PLANAR || traits.layout == DirectX::DXGI_FORMAT_LAYOUT_NV11;
+		if (video && shape != SHAPE_2D)
+			return false;
+
+		size_t size = shape == SHAPE_VOLUME ? 64 : shape == SHAPE_CUBE ? 128 : 256;
+		size_t depth = shape == SHAPE_VOLUME ? size : 1;
+		size_t arraySize = shape == SHAPE_ARRAY ? 8 : 1;
+		size_t faces = shape == SHAPE_CUBE ? 6 : 1;
+		size_t mipCount = video ? 1 : 0;
+		if (!mipCount)
+		{
+			for (size_t s = size; s; s >>= 1)
+				mipCount++;
+		}
+
+		size_t payload = 0;
+		for (size_t item = 0; item < arraySize * faces; item++)
+		{
+			for (size_t mip = 0; mip < mipCount; mip++)
+			{
+				size_t mipSize = std::max<size_t>(size >> mip, 1);
+				size_t numBytes = 0;
+				if (FAILED(DirectX::GetSurfaceInfo(mipSize, mipSize, format, &numBytes, nullptr, nullptr)))
+					return false;
+				payload += numBytes * std::max<size_t>(depth >> mip, 1);
+			}
+		}
+
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.flags = depth > 1 ? DDS_HEADER_FLAGS_VOLUME : 0;
+		header.width = uint32_t(size);
+		header.height = uint32_t(size);
+		header.depth = uint32_t(depth);
+		header.mipMapCount = uint32_t(mipCount);
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+
+		DDS_HEADER_DXT10 d3d10ext = {};
+		d3d10ext.dxgiFormat = format;
+		d3d10ext.resourceDimension = depth > 1 ? ResourceDimensionTexture3D : 3; // D3D11_RESOURCE_DIMENSION_TEXTURE2D
+		d3d10ext.miscFlag = faces > 1 ? ResourceMiscTextureCube : 0;
+		d3d10ext.arraySize = uint32_t(arraySize);
+
+		data.assign(sizeof(uint32_t) + sizeof(header) + sizeof(d3d10ext) + payload, 0);
+		memcpy(data.data(), &DDS_MAGIC, sizeof(uint32_t));
+		memcpy(data.data() + sizeof(uint32_t), &header, sizeof(header));
+		memcpy(data.data() + sizeof(uint32_t) + sizeof(header), &d3d10ext, sizeof(d3d10ext));
+		return true;
+	}
+
+	// The pixel formats legacy files are most often written with, plus one that matches nothing
+	std::vector<DDS_PIXELFORMAT> LegacyPixelFormats()
+	{
+		const uint32_t size = sizeof(DDS_PIXELFORMAT);
+		return {
+			{ size, DDS_FOURCC, MAKEFOURCC('D', 'X', 'T', '1'), 0, 0, 0, 0, 0 },
+			{ size, DDS_FOURCC, MAKEFOURCC('D', 'X', 'T', '5'), 0, 0, 0, 0, 0 },
+			{ size, DDS_FOURCC, MAKEFOURCC('A', 'T', 'I', '2'), 0, 0, 0, 0, 0 },
+			{ size, DDS_FOURCC, 116, 0, 0, 0, 0, 0 },
+			{ size, DDS_RGB, 0, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 },
+			{ size, DDS_RGB, 0, 16, 0xf800, 0x07e0, 0x001f, 0 },
+			{ size, DDS_LUMINANCE, 0, 8, 0xff, 0, 0, 0 },
+			{ size, DDS_RGB, 0, 24, 0xff0000, 0x00ff00, 0x0000ff, 0 },
+		};
+	}
+
+	const DirectX::LegacyFormat c_LegacyFormats[] =
+	{
+		DirectX::LegacyFormat::R8G8B8,
+		DirectX::LegacyFormat::B8G8R8,
+		DirectX::LegacyFormat::X8B8G8R8,
+		DirectX::LegacyFormat::X1R5G5B5,
+		DirectX::LegacyFormat::X4R4G4B4,
+		DirectX::LegacyFormat::A4L4,
+		DirectX::LegacyFormat::L8A8,
+		DirectX::LegacyFormat::R3G3B2,
+		DirectX::LegacyFormat::A8R3G3B2,
+	};
+
+	const char* LegacyFormatName(DirectX::LegacyFormat format)
+	{
+		switch (format)
+		{
+		case DirectX::LegacyFormat::R8G8B8: return "R8G8B8";
+		case DirectX::LegacyFormat::B8G8R8: return "B8G8R8";
+		case DirectX::LegacyFormat::X8B8G8R8: return "X8B8G8R8";
+		case DirectX::LegacyFormat::X1R5G5B5: return "X1R5G5B5";
+		case DirectX::LegacyFormat::X4R4G4B4: return "X4R4G4B4";
+		case DirectX::LegacyFormat::A4L4: return "A4L4";
+		case DirectX::LegacyFormat::L8A8: return "L8A8";
+		case DirectX::LegacyFormat::R3G3B2: return "R3G3B2";
+		case DirectX::LegacyFormat::A8R3G3B2: return "A8R3G3B2";
+		default: return "None";
+		}
+	}
+
+	const char* ConverterPathName(DirectX::LegacyConverterPath path)
+	{
+		switch (path)
+		{
+		case DirectX::LegacyConverterPath::SSSE3: return "SSSE3";
+		case DirectX::LegacyConverterPath::AVX2: return "AVX2";
+		default: return "scalar";
+		}
+	}
+
+	const DXGI_FORMAT c_BCFormats[] =
+	{
+		DXGI_FORMAT_BC1_UNORM,
+		DXGI_FORMAT_BC2_UNORM,
+		DXGI_FORMAT_BC3_UNORM,
+		DXGI_FORMAT_BC4_UNORM,
+		DXGI_FORMAT_BC4_SNORM,
+		DXGI_FORMAT_BC5_UNORM,
+		DXGI_FORMAT_BC5_SNORM,
+		DXGI_FORMAT_BC6H_UF16,
+		DXGI_FORMAT_BC6H_SF16,
+		DXGI_FORMAT_BC7_UNORM,
+	};
+
+	const char* BCFormatName(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM: return "BC1";
+		case DXGI_FORMAT_BC2_UNORM: return "BC2";
+		case DXGI_FORMAT_BC3_UNORM: return "BC3";
+		case DXGI_FORMAT_BC4_UNORM: return "BC4";
+		case DXGI_FORMAT_BC4_SNORM: return "BC4 SNORM";
+		case DXGI_FORMAT_BC5_UNORM: return "BC5";
+		case DXGI_FORMAT_BC5_SNORM: return "BC5 SNORM";
+		case DXGI_FORMAT_BC6H_UF16: return "BC6H UF16";
+		case DXGI_FORMAT_BC6H_SF16: return "BC6H SF16";
+		case DXGI_FORMAT_BC7_UNORM: return "BC7";
+		default: return "unknown";
+		}
+	}
+
+	const char* DecoderPathName(DirectX::BCDecoderPath path)
+	{
+		switch (path)
+		{
+		case DirectX::BCDecoderPath::SSE41: return "SSE4.1";
+		case DirectX::BCDecoderPath::AVX2: return "AVX2";
+		default: return "scalar";
+		}
+	}
+
+	// Decode rows give megapixels a second as well; --csv keeps to GB/s of pixels written
+	void PrintDecodeResult(const Options& options, const std::string& name, double nanoseconds, size_t pixels)
+	{
+		if (options.csv)
+		{
+			std::cout << name << "," << nanoseconds << "," << double(pixels) * 4.0 / nanoseconds << "\n";
+			return;
+		}
+
+		std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed
+			<< std::setprecision(1) << std::setw(12) << nanoseconds
+			<< std::setw(12) << double(pixels) * 1e3 / nanoseconds
+			<< std::setprecision(2) << std::setw(12) << double(pixels) * 4.0 / nanoseconds << "\n";
+	}
+
+	void PrintResult(const Options& options, const Result& result)
+	{
+		double gbps = result.bytes > 0 ? result.bytes / result.nanoseconds : 0.0;
+		if (options.csv)
+		{
+			std::cout << result.name << "," << result.nanoseconds << "," << gbps << "\n";
+			return;
+		}
+
+		std::cout << "  " << std::left << std::setw(40) << result.name << std::right << std::fixed
+			<< std::setprecision(1) << std::setw(12) << result.nanoseconds;
+		if (result.bytes > 0)
+			std::cout << std::setprecision(2) << std::setw(12) << gbps;
+		std::cout << "\n";
+	}
+
+	// On Linux the samples' pages are dropped from the cache so the disk is really read;
+	// elsewhere the first run after copying the files is the one to trust
+	void DropFromCache(const std::vector<Sample>& samples)
+	{
+#ifdef __linux__
+		for (const auto& sample : samples)
+		{
+			int fd = open(sample.path.c_str(), O_RDONLY);
+			if (fd >= 0)
+			{
+				fdatasync(fd);
+				posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+				close(fd);
+			}
+		}
+#else
+		(void)samples;
+#endif
+	}
+
+	// Seconds for source to read every sample from disk in one batch
+	double MeasureDiskRead(DirectX::IFileSource* source, const std::vector<Sample>& samples)
+	{
+		DropFromCache(samples);
+
+		std::vector<DirectX::FileReadRequest> requests;
+		auto start = std::chrono::steady_clock::now();
+		ReadSamples(source, samples, requests);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		for (const auto& request : requests)
+			g_Sink = g_Sink + request.size;
+		return seconds;
+	}
+
+#ifdef __linux__
+	// An io_uring batch of ten times as many files as its queue is deep, one of them missing,
+	// read with only enough file descriptors left for the queue and then with none. Files have
+	// to be opened as others finish; running out has to fail every request the same way.
+	// Returns the number of failures.
+	int CheckIoUringBatch(const std::vector<Sample>& samples)
+	{
+		const size_t queueDepth = 4;
+		std::unique_ptr<DirectX::IFileSource> source;
+		if (samples.empty() || FAILED(DirectX::CreateIoUringFileSource(source, queueDepth)))
+			return 0;
+
+		std::vector<std::wstring> fileNames;
+		for (size_t i = 0; i < queueDepth * 10; i++)
+			fileNames.push_back(samples[i % samples.size()].path.wstring());
+		fileNames.push_back((samples[0].path.parent_path() / "missing.dds").wstring());
+
+		std::vector<DirectX::FileReadRequest> requests(fileNames.size());
+		auto readAll = [&]
+		{
+			for (size_t i = 0; i < requests.size(); i++)
+			{
+				requests[i].fileName = fileNames[i].c_str();
+				requests[i].offset = 0;
+				requests[i].size = 0;
+				requests[i].result = S_OK;
+			}
+
+			return source->ReadFiles(requests.data(), requests.size());
+		};
+
+		// Descriptors are limited by number and handed out lowest free first
+		int lowest = open("/dev/null", O_RDONLY | O_CLOEXEC);
+		if (lowest < 0)
+			return 0;
+
+		int highest = lowest;
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator("/proc/self/fd", error))
+			highest = std::max(highest, atoi(entry.path().filename().c_str()));
+		close(lowest);
+
+		rlimit saved = {};
+		if (getrlimit(RLIMIT_NOFILE, &saved) != 0 || saved.rlim_max < rlim_t(highest + 1 + queueDepth))
+			return 0;
+
+		int failures = 0;
+		rlimit limit = saved;
+		limit.rlim_cur = rlim_t(highest + 1 + queueDepth);
+		if (setrlimit(RLIMIT_NOFILE, &limit) == 0)
+		{
+			HRESULT hr = readAll();
+			for (size_t i = 0; i + 1 < requests.size(); i++)
+			{
+				const Sample& sample = samples[i % samples.size()];
+				if (FAILED(requests[i].result) || requests[i].size != sample.data.size() || memcmp(requests[i].data.get(), sample.data.data(), sample.data.size()) != 0)
+				{
+					std::cerr << "io_uring, " << sample.name << " read " << i << ": doesn't match the file" << std::endl;
+					failures++;
+				}
+			}
+
+			if (hr != S_FALSE || requests.back().result != HRESULT_FROM_WIN32(2 /*ERROR_FILE_NOT_FOUND*/))
+			{
+				std::cerr << "io_uring, missing.dds: didn't fail as not found" << std::endl;
+				failures++;
+			}
+		}
+
+		limit.rlim_cur = rlim_t(lowest);
+		if (setrlimit(RLIMIT_NOFILE, &limit) == 0)
+		{
+			HRESULT hr = readAll();
+			size_t wrong = 0;
+			for (const auto& request : requests)
+			{
+				if (request.result != HRESULT_FROM_WIN32(4 /*ERROR_TOO_MANY_OPEN_FILES*/) || request.data)
+					wrong++;
+			}
+
+			if (hr != S_FALSE || wrong != 0)
+			{
+				std::cerr << "io_uring, no file descriptors: " << wrong << " of " << requests.size() << " reads didn't fail as too many open files" << std::endl;
+				failures++;
+			}
+		}
+
+		setrlimit(RLIMIT_NOFILE, &saved);
+		return failures;
+	}
+#endif
+
+	// The two ways the loader gets a file to the driver, each ending in the copy the driver
+	// makes into upload memory. Reading copies the file into a heap buffer first; mapping
+	// parses and copies straight out of the page cache, through the same FileMapping the
+	// loader uses when no file source is set. A split load prefaults the view before parsing.
+	// Both return false if the file can't be read or parsed.
+	bool ReadCopy(DirectX::IFileSource* source, const Sample& sample, std::vector<uint8_t>& buffer, std::vector<uint8_t>& upload, std::vector<D3D11_SUBRESOURCE_DATA>& initData)
+	{
+		std::unique_ptr<DirectX::IFileSourceFile> file;
+		if (FAILED(source->Open(sample.path.wstring().c_str(), file)))
+			return false;
+
+		buffer.resize(size_t(file->GetSize()));
+		size_t bytesRead = 0;
+		if (FAILED(file->Read(0, buffer.data(), buffer.size(), &bytesRead)) || bytesRead != buffer.size())
+			return false;
+
+		if (FAILED(ParseDDS(buffer.data(), buffer.size(), initData)))
+			return false;
+
+		upload.resize(buffer.size());
+		memcpy(upload.data(), buffer.data(), buffer.size());
+		return true;
+	}
+
+	bool MappedCopy(const Sample& sample, bool prefault, std::vector<uint8_t>& upload, std::vector<D3D11_SUBRESOURCE_DATA>& initData)
+	{
+		DirectX::FileMapping view;
+		if (FAILED(view.Open(sample.path.wstring().c_str())))
+			return false;
+
+		if (prefault)
+			view.Prefault();
+
+		if (FAILED(ParseDDS(view.GetData(), view.GetSize(), initData)))
+			return false;
+
+		upload.resize(view.GetSize());
+		memcpy(upload.data(), view.GetData(), view.GetSize());
+		return true;
+	}
+
+	// The mips of a streamed texture, as the loader works them out from its header
+	std::vector<DirectX::StreamedMip> MakeStreamedMips(size_t width, size_t height, DXGI_FORMAT format)
+	{
+		std::vector<DirectX::StreamedMip> mips;
+		for (;;)
+		{
+			size_t numBytes = 0;
+			DirectX::GetSurfaceInfo(width, height, format, &numBytes, nullptr, nullptr);
+			mips.push_back({ numBytes, width, height });
+			if (width == 1 && height == 1)
+				return mips;
+
+			width = std::max<size_t>(width >> 1, 1);
+			height = std::max<size_t>(height >> 1, 1);
+		}
+	}
+
+	size_t ResidentBytes(const std::vector<DirectX::StreamedMip>& mips, size_t baseMip)
+	{
+		size_t bytes = 0;
+		for (size_t mip = baseMip; mip < mips.size(); mip++)
+			bytes += mips[mip].size;
+		return bytes;
+	}
+
+	// A texture in the streaming simulation. Nothing of it is resident until its tail has been
+	// read, and every read lands the frame after it is queued.
+	struct SimulatedTexture
+	{
+		std::vector<DirectX::StreamedMip> mips;
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		size_t tailMip = 0;
+		bool created = false;
+		size_t baseMip = 0;
+		bool reading = false;
+		size_t readMip = 0;
+		uint64_t lastUsed = 0;
+	};
+
+	struct SimulationResult
+	{
+		int failures = 0;
+		uint64_t residentFrame[2] = {};  // first frame each set was drawn whole, 0 if never
+		size_t peakBytes = 0;
+	};
+
+	// Runs the loader's schedule over two sets of textures: the first is drawn for half the
+	// frames, then the second for the rest. The budget holds either set whole plus every
+	// tail, so each set has to reach mip 0 while it is drawn, at the other's expense.
+	SimulationResult SimulateMipStreaming(std::vector<SimulatedTexture>& textures, size_t firstSetSize, uint64_t frames, size_t budget)
+	{
+		SimulationResult result;
+		std::vector<DirectX::StreamedTexture> streamed;
+		std::vector<size_t> indices;
+		std::vector<DirectX::MipStreamingStep> shrinks(textures.size());
+		std::vector<DirectX::MipStreamingStep> reads(textures.size());
+
+		for (auto& texture : textures)
+			texture.tailMip = DirectX::GetMipTailStart(texture.mips.data(), texture.mips.size(), texture.format, 64 * 1024);
+
+		for (uint64_t frame = 1; frame <= frames; frame++)
+		{
+			// Last frame's reads land first, then the frame draws whatever is created
+			for (auto& texture : textures)
+			{
+				if (texture.reading)
+				{
+					texture.baseMip = texture.readMip;
+					texture.created = true;
+					texture.reading = false;
+				}
+			}
+
+			const int set = frame <= frames / 2 ? 0 : 1;
+			bool whole = true;
+			for (size_t i = 0; i < textures.size(); i++)
+			{
+				if (int(i >= firstSetSize) != set)
+					continue;
+
+				textures[i].lastUsed = frame;
+				whole = whole && textures[i].created && textures[i].baseMip == 0;
+			}
+
+			if (whole && !result.residentFrame[set])
+				result.residentFrame[set] = frame;
+
+			// Frame 1 queues every tail, as Stream does
+			if (frame == 1)
+			{
+				for (auto& texture : textures)
+				{
+					texture.reading = true;
+					texture.readMip = texture.tailMip;
+				}
+				continue;
+			}
+
+			streamed.clear();
+			indices.clear();
+			size_t resident = 0;
+			for (size_t i = 0; i < textures.size(); i++)
+			{
+				const SimulatedTexture& texture = textures[i];
+				if (!texture.created)
+					continue;
+
+				resident += ResidentBytes(texture.mips, texture.baseMip);
+				streamed.push_back({ texture.mips.data(), texture.mips.size(), texture.format, texture.baseMip, texture.lastUsed, texture.reading });
+				indices.push_back(i);
+			}
+
+			size_t shrinkCount = 0;
+			size_t readCount = 0;
+			if (FAILED(DirectX::PlanMipStreaming(streamed.data(), streamed.size(), budget, frame, &resident, shrinks.data(), &shrinkCount, reads.data(), &readCount)))
+			{
+				result.failures++;
+				return result;
+			}
+
+			for (size_t i = 0; i < shrinkCount; i++)
+				textures[indices[shrinks[i].texture]].baseMip = shrinks[i].mip;
+
+			for (size_t i = 0; i < readCount; i++)
+			{
+				SimulatedTexture& texture = textures[indices[reads[i].texture]];
+				texture.reading = true;
+				texture.readMip = reads[i].mip;
+			}
+
+			// What is resident and reserved stays in the budget, and every texture can be created at its base mip
+			size_t check = 0;
+			for (const auto& texture : textures)
+			{
+				if (!texture.created)
+					continue;
+
+				check += ResidentBytes(texture.mips, texture.reading ? texture.readMip : texture.baseMip);
+				if (!DirectX::CanBeBaseMip(texture.mips.data(), texture.baseMip, texture.format))
+					result.failures++;
+			}
+
+			if (check != resident || resident > budget)
+				result.failures++;
+
+			result.peakBytes = std::max(result.peakBytes, resident);
+		}
+
+		return result;
+	}
+
+	// The sample as TextureArrayBuilder would see it; false for anything but a plain 2D texture
+	bool GetTextureArraySource(const uint8_t* data, size_t size, DirectX::TextureArraySource& source)
+	{
+		const DDS_HEADER* header = nullptr;
+		const uint8_t* bitData = nullptr;
+		size_t bitSize = 0;
+		if (FAILED(DirectX::LoadTextureDataFromMemory(data, size, &header, &bitData, &bitSize)))
+			return false;
+
+		DXGI_FORMAT format;
+		if ((header->ddspf.flags & DDS_FOURCC) && header->ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0'))
+		{
+			auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(reinterpret_cast<const uint8_t*>(header) + sizeof(DDS_HEADER));
+			if (d3d10ext->arraySize != 1 || (d3d10ext->miscFlag & ResourceMiscTextureCube) || d3d10ext->resourceDimension == ResourceDimensionTexture3D)
+				return false;
+			format = d3d10ext->dxgiFormat;
+		}
+		else
+		{
+			if (header->flags & DDS_HEADER_FLAGS_VOLUME || header->caps2 & DDS_CUBEMAP)
+				return false;
+			format = DirectX::GetDXGIFormat(header->ddspf);
+		}
+
+		if (format == DXGI_FORMAT_UNKNOWN)
+			return false;
+
+		// A texture saved without mips is loaded with its chain generated, wherever it is read from
+		size_t mipCount = DirectX::GetLoadedMipCount(header->width, header->height, std::max<size_t>(header->mipMapCount, 1), format);
+		source = { header->width, header->height, mipCount, format };
+		return true;
+	}
+
+	// What TextureArrayBuilder relies on from a packing: every array holds matching textures in
+	// the order they were given, from slice 0 up and no more than maxSlices of them, arrays
+	// are numbered by their first texture, and a texture only starts a new array if no array
+	// it matches has room
+	bool CheckPacking(const DirectX::TextureArraySource* sources, size_t count, size_t maxSlices, const DirectX::TextureArraySlot* slots, size_t arrayCount)
+	{
+		std::vector<size_t> first(arrayCount, count);
+		std::vector<size_t> sizes(arrayCount, 0);
+		size_t nextArray = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			const DirectX::TextureArraySlot& slot = slots[i];
+			if (slot.array >= arrayCount || slot.slice != sizes[slot.array] || slot.slice >= maxSlices)
+				return false;
+
+			if (sizes[slot.array]++ == 0)
+			{
+				if (slot.array != nextArray++)
+					return false;
+
+				first[slot.array] = i;
+
+				// Every earlier array it matches has to be full
+				for (size_t j = 0; j < slot.array; j++)
+				{
+					if (DirectX::IsTextureArrayCompatible(sources[first[j]], sources[i]) && sizes[j] < maxSlices)
+						return false;
+				}
+			}
+			else if (!DirectX::IsTextureArrayCompatible(sources[first[slot.array]], sources[i]))
+			{
+				return false;
+			}
+		}
+
+		return nextArray == arrayCount;
+	}
+
+	// A 64x64 RGBA texture with mipCount mips, the first one a pattern and the rest generated
+	// from it the way the loaders fill in a chain
+	bool MakeRGBADDS(size_t mipCount, std::vector<uint8_t>& data)
+	{
+		const size_t size = 64;
+		const DXGI_FORMAT format = DXGI_FORMAT_R8G8B8A8_UNORM;
+
+		DDS_HEADER header = {};
+		header.size = sizeof(DDS_HEADER);
+		header.width = uint32_t(size);
+		header.height = uint32_t(size);
+		header.mipMapCount = uint32_t(mipCount);
+		header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+		header.ddspf.flags = DDS_FOURCC;
+		header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+
+		DDS_HEADER_DXT10 d3d10ext = {};
+		d3d10ext.dxgiFormat = format;
+		d3d10ext.resourceDimension = 3; // D3D11_RESOURCE_DIMENSION_TEXTURE2D
+		d3d10ext.arraySize = 1;
+
+		const size_t offset = sizeof(uint32_t) + sizeof(header) + sizeof(d3d10ext);
+		const size_t topBytes = size * size * 4;
+		const size_t chainBytes = DirectX::GetMipChainSize(size, size, mipCount);
+		data.assign(offset + topBytes + chainBytes, 0);
+		memcpy(data.data(), &DDS_MAGIC, sizeof(uint32_t));
+		memcpy(data.data() + sizeof(uint32_t), &header, sizeof(header));
+		memcpy(data.data() + sizeof(uint32_t) + sizeof(header), &d3d10ext, sizeof(d3d10ext));
+
+		uint8_t* top = data.data() + offset;
+		for (size_t i = 0; i < topBytes; i++)
+			top[i] = uint8_t((i * 7) ^ (i / (size * 4) * 13));
+
+		return mipCount == 1 || SUCCEEDED(DirectX::GenerateMipChain(format, size, size, top, size * 4, mipCount,
+			DirectX::MIP_FILTER_BOX, DirectX::MIP_FLAGS_NONE, top + topBytes, chainBytes));
+	}
+
+	// A one entry archive laid out the way the texture packer writes one
+	bool WriteTextureArchive(const std::filesystem::path& path, const char* name, const std::vector<uint8_t>& payload)
+	{
+		char normalized[DirectX::TEXTURE_ARCHIVE_MAX_NAME];
+		size_t nameLength = DirectX::NormalizeTextureArchiveName(name, normalized);
+		if (nameLength == 0)
+			return false;
+
+		DirectX::TEXTURE_ARCHIVE_ENTRY entry = { 0, uint32_t(nameLength), DirectX::TEXTURE_ARCHIVE_ALIGNMENT, payload.size(), DirectX::TextureArchiveChecksum(payload.data(), payload.size()) };
+		std::vector<uint8_t> index(sizeof(entry) + nameLength + 1);
+		memcpy(index.data(), &entry, sizeof(entry));
+		memcpy(index.data() + sizeof(entry), normalized, nameLength + 1);
+
+		DirectX::TEXTURE_ARCHIVE_HEADER header = { DirectX::TEXTURE_ARCHIVE_MAGIC, DirectX::TEXTURE_ARCHIVE_VERSION, 1, uint32_t(nameLength + 1), DirectX::TextureArchiveChecksum(index.data(), index.size()) };
+		std::vector<uint8_t> archive(size_t(DirectX::TEXTURE_ARCHIVE_ALIGNMENT) + payload.size(), 0);
+		memcpy(archive.data(), &header, sizeof(header));
+		memcpy(archive.data() + sizeof(header), index.data(), index.size());
+		memcpy(archive.data() + DirectX::TEXTURE_ARCHIVE_ALIGNMENT, payload.data(), payload.size());
+
+		FILE* file = fopen(path.string().c_str(), "wb");
+		if (!file)
+			return false;
+
+		bool written = fwrite(archive.data(), 1, archive.size(), file) == archive.size();
+		return fclose(file) == 0 && written;
+	}
+
+	// A texture saved without mips and read from an archive has to come back with the chain a
+	// loose file gets: described with it for packing, so it shares an array with a copy saved
+	// with the chain, and loaded with it, matching that copy mip for mip. Returns the number
+	// of failures.
+	int CheckArchivedSlice()
+	{
+		std::vector<uint8_t> mipLess;
+		std::vector<uint8_t> withMips;
+		const size_t fullChain = DirectX::CountMips(64, 64);
+		if (!MakeRGBADDS(1, mipLess) || !MakeRGBADDS(fullChain, withMips))
+		{
+			std::cerr << "Archived slice: can't make the textures" << std::endl;
+			return 1;
+		}
+
+		std::error_code error;
+		std::filesystem::path path = std::filesystem::temp_directory_path(error) / "TextureBenchmark.pak";
+		DirectX::TextureArchive archive;
+		const DirectX::TEXTURE_ARCHIVE_ENTRY* entry = nullptr;
+		if (!WriteTextureArchive(path, "Textures/pattern.dds", mipLess) || FAILED(archive.Open(path.wstring().c_str()))
+			|| (entry = archive.Find(L"Textures\\pattern.dds")) == nullptr || !archive.Verify(*entry))
+		{
+			std::cerr << "Archived slice: the archive doesn't read back" << std::endl;
+			std::filesystem::remove(path, error);
+			return 1;
+		}
+
+		int failures = 0;
+		const uint8_t* payload = archive.GetData(*entry);
+		const size_t payloadSize = size_t(entry->size);
+
+		DirectX::TextureArraySource sources[2] = {};
+		DirectX::TextureArraySlot slots[2] = {};
+		size_t arrayCount = 0;
+		if (!GetTextureArraySource(payload, payloadSize, sources[0]) || !GetTextureArraySource(withMips.data(), withMips.size(), sources[1])
+			|| sources[0].mipCount != fullChain
+			|| FAILED(DirectX::PackTextureArrays(sources, 2, DirectX::TEXTURE_ARRAY_MAX_SLICES, slots, &arrayCount)) || arrayCount != 1)
+		{
+			std::cerr << "Archived slice: isn't described with its generated mips" << std::endl;
+			failures++;
+		}
+
+		const DDS_HEADER* header = nullptr;
+		const uint8_t* bitData = nullptr;
+		size_t bitSize = 0;
+		std::unique_ptr<uint8_t[]> mipData;
+		size_t mipDataSize = 0;
+		size_t mipCount = 0;
+		std::vector<D3D11_SUBRESOURCE_DATA> initData(fullChain);
+		size_t twidth = 0;
+		size_t theight = 0;
+		size_t tdepth = 0;
+		size_t skipMip = 0;
+		const size_t chainOffset = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+		if (FAILED(DirectX::LoadTextureDataFromMemory(payload, payloadSize, &header, &bitData, &bitSize))
+			|| DirectX::GenerateMissingMips(DXGI_FORMAT_R8G8B8A8_UNORM, header->width, header->height, header->mipMapCount, 1, bitData, bitSize, mipData, mipDataSize, mipCount) != S_OK
+			|| mipCount != fullChain
+			|| FAILED(DirectX::FillInitData(header->width, header->height, 1, mipCount, 1, DXGI_FORMAT_R8G8B8A8_UNORM, 0, mipDataSize, mipData.get(), twidth, theight, tdepth, skipMip, initData.data()))
+			|| mipDataSize != withMips.size() - chainOffset
+			|| memcmp(mipData.get(), withMips.data() + chainOffset, mipDataSize) != 0)
+		{
+			std::cerr << "Archived slice: doesn't load with the chain a loose copy has" << std::endl;
+			failures++;
+		}
+
+		archive.Close();
+		std::filesystem::remove(path, error);
+		return failures;
+	}
+
+	// The staging rings' bookkeeping against a model of what is live: random allocations,
+	// frames and fences completing out of step, and no allocation may overlap one the GPU
+	// could still be reading or be misaligned. Returns how many runs broke that.
+	int CheckRingAllocator()
+	{
+		struct Allocation
+		{
+			size_t offset;
+			size_t size;
+			uint64_t fence;
+		};
+
+		int failures = 0;
+		std::mt19937 rng(5);
+		for (int run = 0; run < 20; run++)
+		{
+			const size_t size = 1000 + rng() % 100000;
+			DirectX::RingAllocator ring;
+			if (FAILED(ring.Initialize(size)))
+			{
+				failures++;
+				continue;
+			}
+
+			std::deque<Allocation> live;
+			std::vector<Allocation> frame;
+			uint64_t fence = 0;
+			uint64_t completed = 0;
+			bool broken = false;
+			for (int step = 0; step < 20000 && !broken; step++)
+			{
+				unsigned int action = rng() % 10;
+				if (action < 6)
+				{
+					size_t allocationSize = 1 + rng() % (size / 8);
+					size_t alignment = size_t(1) << (rng() % 9);
+					size_t offset = 0;
+					HRESULT hr = ring.Allocate(allocationSize, alignment, &offset);
+					if (hr != S_OK)
+					{
+						broken = (hr != S_FALSE);
+						continue;
+					}
+
+					auto overlaps = [&](const Allocation& a) { return offset < a.offset + a.size && a.offset < offset + allocationSize; };
+					broken = offset % alignment != 0 || offset + allocationSize > size
+						|| std::any_of(live.begin(), live.end(), overlaps) || std::any_of(frame.begin(), frame.end(), overlaps);
+					frame.push_back({ offset, allocationSize, 0 });
+				}
+				else if (action < 8)
+				{
+					fence++;
+					for (auto& allocation : frame)
+					{
+						allocation.fence = fence;
+						live.push_back(allocation);
+					}
+					frame.clear();
+					ring.FinishFrame(fence);
+				}
+				else
+				{
+					if (completed < fence)
+						completed += 1 + rng() % (fence - completed);
+					ring.Retire(completed);
+					while (!live.empty() && live.front().fence <= completed)
+						live.pop_front();
+				}
+			}
+
+			// Everything comes back once the last fence completes
+			ring.FinishFrame(++fence);
+			ring.Retire(fence);
+			if (broken || ring.GetUsed() != 0)
+			{
+				std::cerr << "Ring allocator, run " << run << " of " << size << " bytes: "
+					<< (broken ? "an allocation overlapped live space or was misaligned" : "space wasn't given back") << std::endl;
+				failures++;
+			}
+		}
+
+		return failures;
+	}
+
+	// 1024x1024 RGBA in 128 texel tiles over four mips: 8x8, 4x4, 2x2 and one tile
+	HRESULT GetCheckedVirtualLayout(DirectX::VirtualTextureLayout& layout)
+	{
+		return DirectX::GetVirtualTextureLayout(1024, 1024, 4, DXGI_FORMAT_R8G8B8A8_UNORM, 128, 0, layout);
+	}
+
+	// Every entry of the page table, against the page and mip expected of each tile
+	template<typename Expected>
+	bool CheckPageEntries(const DirectX::VirtualTexturePageTable& pageTable, Expected&& expected)
+	{
+		const DirectX::VirtualTextureLayout& layout = pageTable.GetLayout();
+		for (size_t mip = 0; mip < layout.mipCount; mip++)
+		{
+			const DirectX::VirtualTexturePageEntry* entries = pageTable.GetEntries(mip);
+			for (size_t y = 0; y < layout.tilesY[mip]; y++)
+			{
+				for (size_t x = 0; x < layout.tilesX[mip]; x++)
+				{
+					DirectX::VirtualTexturePageEntry entry = expected(x, y, mip);
+					const DirectX::VirtualTexturePageEntry& actual = entries[y * layout.tilesX[mip] + x];
+					if (actual.page != entry.page || actual.mip != entry.mip)
+						return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	// Tiles that aren't resident take the entry of their nearest resident ancestor, and only
+	// the mips at and below the one that changed are resolved again
+	int CheckVirtualPageTable()
+	{
+		using namespace DirectX;
+
+		VirtualTextureLayout layout = {};
+		VirtualTexturePageTable pageTable;
+		if (FAILED(GetCheckedVirtualLayout(layout)) || FAILED(pageTable.Initialize(layout)))
+		{
+			std::cerr << "Virtual texture page table: couldn't be created" << std::endl;
+			return 1;
+		}
+
+		const VirtualTexturePageEntry none = { VIRTUAL_TEXTURE_NO_PAGE, 4 };
+		const VirtualTexturePageEntry coarsest = { 0, 3 };
+		const VirtualTexturePageEntry detail = { 1, 2 };
+
+		// Mip 2's tile (1, 1) covers tiles 2 and 3 of mip 1 and tiles 4 to 7 of mip 0
+		auto underDetail = [](size_t x, size_t y, size_t mip) { return mip <= 2 && (x >> (2 - mip)) == 1 && (y >> (2 - mip)) == 1; };
+
+		int failures = 0;
+		auto check = [&](const char* name, size_t levels, size_t expectedLevels, bool entriesMatch)
+		{
+			if (levels != expectedLevels || !entriesMatch)
+			{
+				std::cerr << "Virtual texture page table, " << name << ": " << levels << " levels updated, entries " << (entriesMatch ? "match" : "don't match") << std::endl;
+				failures++;
+			}
+		};
+
+		size_t levels = pageTable.Update();
+		check("nothing resident", levels, 4, CheckPageEntries(pageTable, [&](size_t, size_t, size_t) { return none; }));
+
+		pageTable.Map(MakeVirtualTextureTile(0, 0, 3), 0);
+		levels = pageTable.Update();
+		check("coarsest mip", levels, 4, CheckPageEntries(pageTable, [&](size_t, size_t, size_t) { return coarsest; }));
+
+		pageTable.Map(MakeVirtualTextureTile(1, 1, 2), 1);
+		levels = pageTable.Update();
+		check("one mip 2 tile", levels, 3, CheckPageEntries(pageTable, [&](size_t x, size_t y, size_t mip) { return underDetail(x, y, mip) ? detail : coarsest; }));
+
+		if (pageTable.GetPage(MakeVirtualTextureTile(1, 1, 2)) != 1 || pageTable.GetPage(MakeVirtualTextureTile(2, 2, 1)) != VIRTUAL_TEXTURE_NO_PAGE)
+		{
+			std::cerr << "Virtual texture page table: GetPage reports an ancestor's page, or loses the tile's own" << std::endl;
+			failures++;
+		}
+
+		pageTable.Unmap(MakeVirtualTextureTile(1, 1, 2));
+		levels = pageTable.Update();
+		check("mip 2 tile unmapped", levels, 3, CheckPageEntries(pageTable, [&](size_t, size_t, size_t) { return coarsest; }));
+
+		levels = pageTable.Update();
+		check("no change", levels, 0, true);
+
+		return failures;
+	}
+
+	// Pages are taken free first, then least recently used first, but never from a pinned
+	// tile or one used this frame; freed pages are the next to go
+	int CheckVirtualTileCache()
+	{
+		using namespace DirectX;
+
+		VirtualTextureTileCache cache;
+		if (FAILED(cache.Initialize(4)))
+		{
+			std::cerr << "Virtual texture tile cache: couldn't be created" << std::endl;
+			return 1;
+		}
+
+		const uint32_t tiles[] =
+		{
+			MakeVirtualTextureTile(0, 0, 3), MakeVirtualTextureTile(0, 0, 2), MakeVirtualTextureTile(1, 0, 2), MakeVirtualTextureTile(0, 1, 2),
+			MakeVirtualTextureTile(1, 1, 2), MakeVirtualTextureTile(0, 0, 1), MakeVirtualTextureTile(1, 0, 1), MakeVirtualTextureTile(0, 1, 1),
+		};
+
+		const struct
+		{
+			const char* name;
+			size_t tile;
+			uint64_t frame;
+			bool pin;
+			HRESULT result;
+			uint16_t page;
+			uint32_t evicted;
+		}
+		steps[] =
+		{
+			{ "pinned into a free page", 0, 1, true, S_OK, 0, VIRTUAL_TEXTURE_NO_TILE },
+			{ "second free page", 1, 1, false, S_OK, 1, VIRTUAL_TEXTURE_NO_TILE },
+			{ "third free page", 2, 1, false, S_OK, 2, VIRTUAL_TEXTURE_NO_TILE },
+			{ "last free page", 3, 1, false, S_OK, 3, VIRTUAL_TEXTURE_NO_TILE },
+			// Page 2 is touched in frame 2 here, which leaves page 1 least recently used
+			{ "least recently used", 4, 2, false, S_OK, 1, tiles[1] },
+			{ "touched page skipped", 5, 2, false, S_OK, 3, tiles[3] },
+			{ "every page pinned or used this frame", 6, 2, false, S_FALSE, VIRTUAL_TEXTURE_NO_PAGE, VIRTUAL_TEXTURE_NO_TILE },
+			{ "touched page, a frame later", 6, 3, false, S_OK, 2, tiles[2] },
+		};
+
+		int failures = 0;
+		for (const auto& step : steps)
+		{
+			if (step.tile == 4)
+				cache.Touch(2, 2);
+
+			uint16_t page = 0;
+			uint32_t evicted = 0;
+			HRESULT hr = cache.Allocate(tiles[step.tile], step.frame, step.pin, &page, &evicted);
+			if (hr != step.result || page != step.page || evicted != step.evicted)
+			{
+				std::cerr << "Virtual texture tile cache, " << step.name << ": got page " << page << std::endl;
+				failures++;
+			}
+		}
+
+		// Freed pages, pinned or not, are taken before any page holding a tile
+		cache.Free(1);
+		cache.Free(0);
+		uint16_t pages[2] = {};
+		uint32_t evicted[2] = {};
+		cache.Allocate(tiles[7], 3, false, &pages[0], &evicted[0]);
+		cache.Allocate(tiles[1], 3, false, &pages[1], &evicted[1]);
+		if (pages[0] != 0 || pages[1] != 1 || evicted[0] != VIRTUAL_TEXTURE_NO_TILE || evicted[1] != VIRTUAL_TEXTURE_NO_TILE || cache.GetTile(0) != tiles[7])
+		{
+			std::cerr << "Virtual texture tile cache: freed pages weren't taken first" << std::endl;
+			failures++;
+		}
+
+		return failures;
+	}
+
+	// Each sample asks for the missing tile just below its nearest resident ancestor and
+	// touches the pages on its way; requests come coarsest mip first, then most wanted
+	int CheckVirtualFeedback()
+	{
+		using namespace DirectX;
+
+		VirtualTextureLayout layout = {};
+		VirtualTexturePageTable pageTable;
+		VirtualTextureTileCache cache;
+		VirtualTextureFeedback feedback;
+		if (FAILED(GetCheckedVirtualLayout(layout)) || FAILED(pageTable.Initialize(layout)) || FAILED(cache.Initialize(2)) || FAILED(feedback.Initialize(layout)))
+		{
+			std::cerr << "Virtual texture feedback: couldn't be created" << std::endl;
+			return 1;
+		}
+
+		uint16_t page = 0;
+		uint32_t evicted = 0;
+		cache.Allocate(MakeVirtualTextureTile(0, 0, 3), 1, true, &page, &evicted);
+		pageTable.Map(MakeVirtualTextureTile(0, 0, 3), page);
+		cache.Allocate(MakeVirtualTextureTile(1, 1, 2), 1, false, &page, &evicted);
+		pageTable.Map(MakeVirtualTextureTile(1, 1, 2), page);
+
+		std::vector<uint32_t> samples;
+		samples.insert(samples.end(), 2, MakeVirtualTextureTile(0, 0, 0));  // wants mip 2 (0, 0)
+		samples.insert(samples.end(), 5, MakeVirtualTextureTile(7, 7, 0));  // wants mip 1 (3, 3), under the resident tile
+		samples.insert(samples.end(), 1, MakeVirtualTextureTile(6, 6, 0));  // the same
+		samples.insert(samples.end(), 3, MakeVirtualTextureTile(1, 0, 0));  // wants mip 2 (0, 0)
+		samples.insert(samples.end(), 1, MakeVirtualTextureTile(1, 0, 2));  // wants itself
+		samples.push_back(VIRTUAL_TEXTURE_NO_TILE);
+		samples.push_back(MakeVirtualTextureTile(8, 0, 0));                 // outside the layout
+
+		const VirtualTextureRequest expected[] =
+		{
+			{ MakeVirtualTextureTile(0, 0, 2), 5 },
+			{ MakeVirtualTextureTile(1, 0, 2), 1 },
+			{ MakeVirtualTextureTile(3, 3, 1), 6 },
+		};
+
+		int failures = 0;
+		for (size_t maxRequests : { size_t(3), size_t(2) })
+		{
+			VirtualTextureRequest requests[4] = {};
+			size_t requestCount = 0;
+			HRESULT hr = feedback.Analyze(samples.data(), samples.size(), pageTable, cache, 2, requests, maxRequests, &requestCount);
+
+			bool ordered = SUCCEEDED(hr) && requestCount == maxRequests;
+			for (size_t i = 0; ordered && i < requestCount; i++)
+				ordered = requests[i].tile == expected[i].tile && requests[i].count == expected[i].count;
+
+			if (!ordered)
+			{
+				std::cerr << "Virtual texture feedback, " << maxRequests << " requests: not coarsest first, then most wanted" << std::endl;
+				failures++;
+			}
+		}
+
+		// The resident mip 2 tile was sampled through in frame 2, so it can't make room then
+		HRESULT hr = cache.Allocate(MakeVirtualTextureTile(0, 0, 2), 2, false, &page, &evicted);
+		if (hr != S_FALSE)
+		{
+			std::cerr << "Virtual texture feedback: a page sampled through this frame was evicted" << std::endl;
+			failures++;
+		}
+
+		return failures;
+	}
+
+	// An LZ4 frame in memory, read the way the loader reads one from a file
+	struct FrameReader
+	{
+		const uint8_t* data;
+		size_t size;
+	};
+
+	HRESULT ReadFromFrame(void* context, uint8_t* buffer, size_t size)
+	{
+		auto reader = static_cast<FrameReader*>(context);
+		if (size > reader->size)
+			return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+		memcpy(buffer, reader->data, size);
+		reader->data += size;
+		reader->size -= size;
+		return S_OK;
+	}
+
+	// Decodes the frame after its header with info changed by adjust, prefix or whole
+	HRESULT DecodeFrame(const uint8_t* frame, size_t frameSize, std::vector<uint8_t>& destination, bool prefix, void (*adjust)(DirectX::LZ4FrameInfo&), size_t* decodedSize)
+	{
+		FrameReader reader = { frame, frameSize };
+		DirectX::LZ4FrameInfo info;
+		HRESULT hr = DirectX::ReadLZ4FrameHeader(ReadFromFrame, &reader, info);
+		if (FAILED(hr))
+			return hr;
+
+		if (adjust)
+			adjust(info);
+
+		return prefix
+			? DirectX::DecompressLZ4FramePrefix(ReadFromFrame, &reader, info, destination.data(), destination.size(), decodedSize)
+			: DirectX::DecompressLZ4Frame(ReadFromFrame, &reader, info, destination.data(), destination.size(), decodedSize);
+	}
+
+	// A whole frame has to decode to exactly its content, end mark and checksum included;
+	// only a prefix may stop early. Returns how many cases didn't.
+	int CheckCorruptFrames(const Sample& sample, const std::vector<uint8_t>& frame, size_t frameSize)
+	{
+		const size_t size = sample.data.size();
+		std::vector<uint8_t> flipped(frame.begin(), frame.begin() + frameSize);
+		flipped[frameSize / 2] ^= 0x55;
+		std::vector<uint8_t> badChecksum(frame.begin(), frame.begin() + frameSize);
+		badChecksum[frameSize - 1] ^= 0x01;
+
+		const size_t prefixSize = std::min<size_t>(DirectX::DDS_HEADER_PROBE_SIZE, size);
+
+		const struct
+		{
+			const char* name;
+			const uint8_t* frame;
+			size_t frameSize;
+			size_t destinationSize;
+			bool prefix;
+			void (*adjust)(DirectX::LZ4FrameInfo&);
+			bool succeeds;
+		}
+		cases[] =
+		{
+			{ "one byte short of the content size", frame.data(), frameSize, size - 1, false, nullptr, false },
+			{ "overrun with no content size", frame.data(), frameSize, size - 1, false, [](DirectX::LZ4FrameInfo& info) { info.contentSize = 0; }, false },
+			{ "overrun of a smaller content size", frame.data(), frameSize, size - 1, false, [](DirectX::LZ4FrameInfo& info) { info.contentSize--; }, false },
+			{ "no content checksum", frame.data(), frameSize - 4, size, false, nullptr, false },
+			{ "no end mark", frame.data(), frameSize - 8, size, false, nullptr, false },
+			{ "bad content checksum", badChecksum.data(), frameSize, size, false, nullptr, false },
+			{ "corrupt block", flipped.data(), frameSize, size, false, nullptr, false },
+			{ "header prefix", frame.data(), frameSize, prefixSize, true, nullptr, true },
+			{ "prefix past the end", frame.data(), frameSize, size + 1, true, nullptr, true },
+		};
+
+		int failures = 0;
+		for (const auto& c : cases)
+		{
+			std::vector<uint8_t> destination(c.destinationSize);
+			size_t decodedSize = 0;
+			HRESULT hr = DecodeFrame(c.frame, c.frameSize, destination, c.prefix, c.adjust, &decodedSize);
+
+			size_t expectedSize = std::min(c.destinationSize, size);
+			bool passed = c.succeeds
+				? SUCCEEDED(hr) && decodedSize == expectedSize && memcmp(destination.data(), sample.data.data(), decodedSize) == 0
+				: FAILED(hr);
+			if (!passed)
+			{
+				std::cerr << sample.name << ".lz4, " << c.name << ": " << (c.succeeds ? "didn't decode" : "decoded") << std::endl;
+				failures++;
+			}
+		}
+
+		return failures;
+	}
+
+	void PrintLoadTime(const Options& options, const std::string& name, double bytes, double rawSeconds, double lz4Seconds)
+	{
+		if (options.csv)
+		{
+			std::cout << name << " raw," << rawSeconds * 1e9 << "," << bytes / (rawSeconds * 1e9) << "\n";
+			std::cout << name << " lz4," << lz4Seconds * 1e9 << "," << bytes / (lz4Seconds * 1e9) << "\n";
+			return;
+		}
+
+		std::cout << "  " << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << rawSeconds * 1e3 << std::setw(12) << lz4Seconds * 1e3
+			<< std::setprecision(2) << std::setw(11) << rawSeconds / lz4Seconds << "x\n";
+	}
+
+	void PrintHeading(const Options& options, const char* heading, const char* unit)
+	{
+		if (!options.csv)
+			std::cout << "\n" << std::left << std::setw(42) << heading << std::right << std::setw(12) << unit << std::setw(12) << "GB/s" << "\n";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return -1;
+	}
+
+	if (options.csv)
+		std::cout << "name,ns,GB/s\n";
+
+	std::unique_ptr<DirectX::IFileSource> source;
+	if (FAILED(CreateSource(options.source, source)))
+	{
+		std::cerr << options.source << ": no such file source here" << std::endl;
+		return -1;
+	}
+
+	int failures = 0;
+
+	std::vector<D3D11_SUBRESOURCE_DATA> initData(4096);
+
+	// Shipped textures, parsed from memory so only the loader is measured, not the disk
+	std::vector<Sample> samples;
+	if (!LoadSamples(source.get(), options.directory, samples))
+		return -1;
+
+	PrintHeading(options, options.directory.c_str(), "ns/header");
+	for (const auto& sample : samples)
+	{
+		if (FAILED(ParseDDS(sample.data.data(), sample.data.size(), initData)))
+		{
+			std::cerr << sample.name << ": not a DDS file the loader can parse" << std::endl;
+			continue;
+		}
+
+		double ns = Measure(options.seconds, [&] { ParseDDS(sample.data.data(), sample.data.size(), initData); });
+		PrintResult(options, { sample.name, ns, double(sample.data.size()) });
+	}
+
+	// The header probe the loader sorts files into arrays with, through the file source, of
+	// each file and of the file compressed into a .dds.lz4. Only the headers may be read, and
+	// they have to be the file's own.
+	PrintHeading(options, "Header probe", "ns/file");
+
+	std::filesystem::path probeDirectory = std::filesystem::temp_directory_path() / "TextureBenchmark";
+	std::error_code probeError;
+	std::filesystem::create_directories(probeDirectory, probeError);
+	for (const auto& sample : samples)
+	{
+		std::vector<uint8_t> frame(DirectX::GetLZ4FrameBound(sample.data.size()));
+		size_t frameSize = 0;
+		std::filesystem::path framePath = probeDirectory / (sample.name + ".lz4");
+		if (SUCCEEDED(DirectX::CompressLZ4Frame(sample.data.data(), sample.data.size(), frame.data(), frame.size(), &frameSize)))
+		{
+			FILE* file = fopen(framePath.string().c_str(), "wb");
+			if (file)
+			{
+				fwrite(frame.data(), 1, frameSize, file);
+				fclose(file);
+			}
+		}
+
+		const size_t expectedSize = std::min(sample.data.size(), DirectX::DDS_HEADER_PROBE_SIZE);
+		for (bool compressed : { false, true })
+		{
+			std::wstring path = compressed ? framePath.wstring() : sample.path.wstring();
+			std::string name = sample.name + (compressed ? ".lz4" : "");
+
+			uint8_t header[DirectX::DDS_HEADER_PROBE_SIZE];
+			size_t headerSize = 0;
+			bool isLZ4Frame = false;
+			HRESULT hr = DirectX::ReadDDSHeaderFromFile(source.get(), path.c_str(), header, &headerSize, &isLZ4Frame);
+			if (FAILED(hr) || headerSize != expectedSize || isLZ4Frame != compressed || memcmp(header, sample.data.data(), headerSize) != 0)
+			{
+				std::cerr << name << ": the header probe doesn't match the file" << std::endl;
+				failures++;
+				continue;
+			}
+
+			double ns = Measure(options.seconds / 4, [&]
+			{
+				DirectX::ReadDDSHeaderFromFile(source.get(), path.c_str(), header, &headerSize, &isLZ4Frame);
+				g_Sink = g_Sink + headerSize;
+			});
+			PrintResult(options, { name, ns, 0.0 });
+		}
+
+		std::filesystem::remove(framePath, probeError);
+	}
+	std::filesystem::remove(probeDirectory, probeError);
+
+	// Every format the table can size, in each shape it can take. The summary averages the
+	// formats of a shape; --csv lists them all.
+	PrintHeading(options, "Synthetic headers", "ns/header");
+	std::vector<uint8_t> data;
+	for (SyntheticShape shape : { SHAPE_2D, SHAPE_CUBE, SHAPE_ARRAY, SHAPE_VOLUME })
+	{
+		double totalNanoseconds = 0.0;
+		double totalBytes = 0.0;
+		size_t formats = 0;
+		for (size_t f = 0; f < DirectX::c_DXGIFormatTraitsCount; f++)
+		{
+			DXGI_FORMAT format = DXGI_FORMAT(f);
+			if (!MakeSyntheticDDS(format, shape, data))
+				continue;
+
+			if (FAILED(ParseDDS(data.data(), data.size(), initData)))
+			{
+				std::cerr << ShapeName(shape) << " format " << f << ": parse failed" << std::endl;
+				continue;
+			}
+
+			double ns = Measure(options.seconds / 8, [&] { ParseDDS(data.data(), data.size(), initData); });
+			if (options.csv)
+				PrintResult(options, { std::string(ShapeName(shape)) + " format " + std::to_string(f), ns, double(data.size()) });
+
+			totalNanoseconds += ns;
+			totalBytes += double(data.size());
+			formats++;
+		}
+
+		if (!options.csv && formats)
+			PrintResult(options, { std::string(ShapeName(shape)) + " (" + std::to_string(formats) + " formats)", totalNanoseconds / formats, totalBytes / formats });
+	}
+
+	// The two lookups every header goes through on its own
+	PrintHeading(options, "Lookups", "ns/call");
+
+	double ns = Measure(options.seconds, [&]
+	{
+		size_t bytes = 0;
+		for (size_t f = 0; f < DirectX::c_DXGIFormatTraitsCount; f++)
+		{
+			for (size_t size = 4096; size; size >>= 1)
+			{
+				size_t numBytes = 0;
+				DirectX::GetSurfaceInfo(size, size, DXGI_FORMAT(f), &numBytes, nullptr, nullptr);
+				bytes += numBytes;
+			}
+		}
+		g_Sink = g_Sink + bytes;
+	});
+	PrintResult(options, { "GetSurfaceInfo", ns / double(DirectX::c_DXGIFormatTraitsCount * 13), 0.0 });
+
+	std::vector<DDS_PIXELFORMAT> pixelFormats = LegacyPixelFormats();
+	ns = Measure(options.seconds, [&]
+	{
+		size_t formats = 0;
+		for (const auto& pixelFormat : pixelFormats)
+			formats += DirectX::GetDXGIFormat(pixelFormat);
+		g_Sink = g_Sink + formats;
+	});
+	PrintResult(options, { "GetDXGIFormat", ns / double(pixelFormats.size()), 0.0 });
+
+	// Legacy layouts converted as the loader does for files without the "DX10" header. Each
+	// path the CPU has runs on one thread, then the fastest runs on every thread.
+	PrintHeading(options, "Legacy conversion, 1024x1024", "ns/surface");
+
+	const DirectX::LegacyConverterPath supportedPath = DirectX::GetLegacyConverterPath();
+	const size_t legacySize = 1024;
+	for (DirectX::LegacyFormat format : c_LegacyFormats)
+	{
+		size_t sourcePitch = legacySize * DirectX::GetLegacyBitsPerPixel(format) / 8;
+		size_t destPitch = 0;
+		DirectX::GetSurfaceInfo(legacySize, 1, DirectX::GetLegacyConvertedFormat(format), nullptr, &destPitch, nullptr);
+
+		std::vector<uint8_t> source(sourcePitch * legacySize);
+		for (size_t i = 0; i < source.size(); i++)
+			source[i] = uint8_t(i * 7);
+		std::vector<uint8_t> dest(destPitch * legacySize);
+
+		for (int pass = 0; pass <= int(supportedPath) + 1; pass++)
+		{
+			bool threaded = pass > int(supportedPath);
+			DirectX::LegacyConverterPath path = threaded ? supportedPath : DirectX::LegacyConverterPath(pass);
+			DirectX::SetLegacyConverterPath(path);
+
+			double ns = Measure(options.seconds, [&]
+			{
+				DirectX::ConvertLegacySurface(format, legacySize, legacySize, source.data(), sourcePitch, dest.data(), destPitch, threaded ? 0 : 1);
+				g_Sink = g_Sink + dest[0];
+			});
+
+			std::string name = std::string(LegacyFormatName(format)) + " " + ConverterPathName(path) + (threaded ? " threads" : "");
+			PrintResult(options, { name, ns, double(dest.size()) });
+		}
+	}
+
+	DirectX::SetLegacyConverterPath(supportedPath);
+
+	// Block decompression as the cooker's --verify and the software fallbacks do it, on every
+	// path the CPU has and then on every thread. The blocks are noise, so every mode and
+	// endpoint encoding a format has gets decoded.
+	if (!options.csv)
+	{
+		std::cout << "\n" << std::left << std::setw(42) << "BC decode, 1024x1024" << std::right
+			<< std::setw(12) << "ns/surface" << std::setw(12) << "MP/s" << std::setw(12) << "GB/s" << "\n";
+	}
+
+	DirectX::SetBCDecoderPath(DirectX::BCDecoderPath::AVX2);
+	const DirectX::BCDecoderPath decoderPath = DirectX::GetBCDecoderPath();
+	const size_t decodeSize = 1024;
+	for (DXGI_FORMAT format : c_BCFormats)
+	{
+		if (!DirectX::IsBCDecodable(format))
+			continue;
+
+		size_t blockRowPitch = 0;
+		size_t blockRows = 0;
+		DirectX::GetSurfaceInfo(decodeSize, decodeSize, format, nullptr, &blockRowPitch, &blockRows);
+
+		std::vector<uint8_t> blocks(blockRowPitch * blockRows);
+		uint32_t seed = 0x9E3779B9u;
+		for (auto& byte : blocks)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			byte = uint8_t(seed >> 24);
+		}
+
+		std::vector<uint8_t> pixels(decodeSize * decodeSize * 4);
+		std::vector<uint8_t> scalarPixels;
+		for (int pass = 0; pass <= int(decoderPath) + 1; pass++)
+		{
+			bool threaded = pass > int(decoderPath);
+			DirectX::BCDecoderPath path = threaded ? decoderPath : DirectX::BCDecoderPath(pass);
+			DirectX::SetBCDecoderPath(path);
+
+			if (FAILED(DirectX::DecodeBCSurface(format, decodeSize, decodeSize, blocks.data(), blockRowPitch, pixels.data(), decodeSize * 4, threaded ? 0 : 1)))
+			{
+				std::cerr << BCFormatName(format) << " " << DecoderPathName(path) << ": decode failed" << std::endl;
+				failures++;
+				continue;
+			}
+
+			// Every path has to give the scalar decoder's pixels
+			if (scalarPixels.empty())
+			{
+				scalarPixels = pixels;
+			}
+			else if (pixels != scalarPixels)
+			{
+				std::cerr << BCFormatName(format) << " " << DecoderPathName(path) << ": doesn't match the scalar decoder" << std::endl;
+				failures++;
+			}
+
+			double ns = Measure(options.seconds, [&]
+			{
+				DirectX::DecodeBCSurface(format, decodeSize, decodeSize, blocks.data(), blockRowPitch, pixels.data(), decodeSize * 4, threaded ? 0 : 1);
+				g_Sink = g_Sink + pixels[0];
+			});
+
+			std::string name = std::string(BCFormatName(format)) + " " + DecoderPathName(path) + (threaded ? " threads" : "");
+			PrintDecodeResult(options, name, ns, decodeSize * decodeSize);
+		}
+	}
+
+	DirectX::SetBCDecoderPath(decoderPath);
+
+	// Decompression of the shipped textures, from memory into a buffer the size of the file,
+	// which is what the loader does for a .dds.lz4 after each block is read
+	PrintHeading(options, "LZ4 decompression", "ns/file");
+
+	double rawBytes = 0.0;
+	double compressedBytes = 0.0;
+	double decompressSeconds = 0.0;
+	for (const auto& sample : samples)
+	{
+		std::vector<uint8_t> frame(DirectX::GetLZ4FrameBound(sample.data.size()));
+		size_t frameSize = 0;
+		if (FAILED(DirectX::CompressLZ4Frame(sample.data.data(), sample.data.size(), frame.data(), frame.size(), &frameSize)))
+		{
+			std::cerr << sample.name << ": compression failed" << std::endl;
+			continue;
+		}
+
+		std::vector<uint8_t> decompressed(sample.data.size());
+		size_t decompressedSize = 0;
+		double ns = Measure(options.seconds, [&]
+		{
+			DirectX::DecompressLZ4FrameFromMemory(frame.data(), frameSize, decompressed.data(), decompressed.size(), &decompressedSize);
+			g_Sink = g_Sink + decompressedSize;
+		});
+
+		if (decompressedSize != sample.data.size() || memcmp(decompressed.data(), sample.data.data(), decompressedSize) != 0)
+		{
+			std::cerr << sample.name << ": round trip failed" << std::endl;
+			failures++;
+			continue;
+		}
+
+		failures += CheckCorruptFrames(sample, frame, frameSize);
+
+		int percent = int(100.0 * double(frameSize) / double(sample.data.size()) + 0.5);
+		PrintResult(options, { sample.name + " (" + std::to_string(percent) + "%)", ns, double(sample.data.size()) });
+
+		rawBytes += double(sample.data.size());
+		compressedBytes += double(frameSize);
+		decompressSeconds += ns * 1e-9;
+	}
+
+	// Every file source reading the whole directory in one batch, from the disk. Batching only
+	// pays when the reads can overlap, which they can with io_uring and a queue on the disk.
+	if (rawBytes > 0.0)
+	{
+		PrintHeading(options, "File reads, from disk", "ns/file");
+		for (const char* name : c_Sources)
+		{
+			std::unique_ptr<DirectX::IFileSource> reader;
+			if (FAILED(CreateSource(name, reader)))
+				continue;
+
+			double seconds = MeasureDiskRead(reader.get(), samples);
+			PrintResult(options, { std::string(name) + " (" + std::to_string(samples.size()) + " files)", seconds * 1e9 / double(samples.size()), rawBytes / double(samples.size()) });
+		}
+
+#ifdef __linux__
+		failures += CheckIoUringBatch(samples);
+#endif
+	}
+
+	// Reading each file into memory against mapping it, from the page cache and then from the
+	// disk. Mapping saves a copy per file, but pays for the mapping and its page faults instead.
+	if (rawBytes > 0.0)
+	{
+		PrintHeading(options, "Read copy vs mapped, cached", "ns/file");
+
+		std::vector<uint8_t> buffer;
+		std::vector<uint8_t> upload;
+		for (const auto& sample : samples)
+		{
+			if (!ReadCopy(source.get(), sample, buffer, upload, initData) || !MappedCopy(sample, false, upload, initData))
+			{
+				std::cerr << sample.name << ": can't be both read and mapped" << std::endl;
+				failures++;
+				continue;
+			}
+
+			if (upload != sample.data)
+			{
+				std::cerr << sample.name << ": the mapping doesn't match the file" << std::endl;
+				failures++;
+				continue;
+			}
+
+			double readNs = Measure(options.seconds, [&] { g_Sink = g_Sink + ReadCopy(source.get(), sample, buffer, upload, initData); });
+			double mappedNs = Measure(options.seconds, [&] { g_Sink = g_Sink + MappedCopy(sample, false, upload, initData); });
+			PrintResult(options, { sample.name + " read", readNs, double(sample.data.size()) });
+			PrintResult(options, { sample.name + " mapped", mappedNs, double(sample.data.size()) });
+		}
+
+		// Off the disk, prefaulting asks for the whole file at once instead of a page at a time
+		PrintHeading(options, "Read copy vs mapped, from disk", "ns/file");
+		const char* const ways[] = { "read", "mapped", "mapped, prefaulted" };
+		for (int way = 0; way < 3; way++)
+		{
+			DropFromCache(samples);
+			auto start = std::chrono::steady_clock::now();
+			for (const auto& sample : samples)
+				g_Sink = g_Sink + (way ? MappedCopy(sample, way == 2, upload, initData) : ReadCopy(source.get(), sample, buffer, upload, initData));
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			std::string name = std::string(ways[way]) + " (" + std::to_string(samples.size()) + " files)";
+			PrintResult(options, { name, seconds * 1e9 / double(samples.size()), rawBytes / double(samples.size()) });
+		}
+	}
+
+	// The streaming schedule run without a device: textures become resident tail first, the
+	// ones drawn grow a mip a frame, and the ones no longer drawn give up the room
+	{
+		std::vector<SimulatedTexture> textures;
+		for (size_t i = 0; i < 6; i++)
+		{
+			SimulatedTexture texture;
+			texture.format = DXGI_FORMAT_BC1_UNORM;
+			texture.mips = MakeStreamedMips(1024, 1024, texture.format);
+			textures.push_back(texture);
+		}
+
+		const size_t firstSetSize = textures.size();
+		for (size_t i = 0; i < 4; i++)
+		{
+			SimulatedTexture texture;
+			texture.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			texture.mips = MakeStreamedMips(640, 480, texture.format);
+			textures.push_back(texture);
+		}
+
+		size_t setBytes[2] = {};
+		size_t tailBytes = 0;
+		for (size_t i = 0; i < textures.size(); i++)
+		{
+			setBytes[i >= firstSetSize] += ResidentBytes(textures[i].mips, 0);
+			tailBytes += ResidentBytes(textures[i].mips, DirectX::GetMipTailStart(textures[i].mips.data(), textures[i].mips.size(), textures[i].format, 64 * 1024));
+		}
+
+		const uint64_t frames = 120;
+		const size_t budget = std::max(setBytes[0], setBytes[1]) + tailBytes;
+		SimulationResult result = SimulateMipStreaming(textures, firstSetSize, frames, budget);
+		if (result.failures || !result.residentFrame[0] || !result.residentFrame[1])
+		{
+			std::cerr << "Mip streaming: the schedule went over the budget, or a set drawn never became resident" << std::endl;
+			failures++;
+		}
+
+		if (!options.csv)
+		{
+			std::cout << "\n" << std::left << std::setw(42) << "Mip streaming, frames to mip 0" << std::right << std::setw(12) << "frames" << "\n";
+			for (int set = 0; set < 2; set++)
+			{
+				std::string name = set == 0 ? "6 BC1 1024x1024, drawn first" : "4 RGBA 640x480, drawn second";
+				uint64_t start = set == 0 ? 1 : frames / 2 + 1;
+				std::cout << "  " << std::left << std::setw(40) << name << std::right << std::setw(12)
+					<< (result.residentFrame[set] ? result.residentFrame[set] - start : 0) << "\n";
+			}
+
+			std::cout << "  " << std::left << std::setw(40) << "Peak resident MB, of budget" << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(12) << double(result.peakBytes) / 1e6 << std::setw(12) << double(budget) / 1e6 << "\n";
+		}
+
+		// Planning a frame for a scene with a lot of textures, over the budget so everything is looked at
+		std::vector<DirectX::StreamedMip> mips = MakeStreamedMips(1024, 1024, DXGI_FORMAT_BC1_UNORM);
+		std::vector<DirectX::StreamedTexture> streamed(4096);
+		for (size_t i = 0; i < streamed.size(); i++)
+			streamed[i] = { mips.data(), mips.size(), DXGI_FORMAT_BC1_UNORM, i % 4, uint64_t(i % 97), false };
+
+		std::vector<DirectX::MipStreamingStep> shrinks(streamed.size());
+		std::vector<DirectX::MipStreamingStep> reads(streamed.size());
+		double ns = Measure(options.seconds, [&]
+		{
+			size_t resident = streamed.size() * ResidentBytes(mips, 2);
+			size_t shrinkCount = 0;
+			size_t readCount = 0;
+			DirectX::PlanMipStreaming(streamed.data(), streamed.size(), resident / 2, 97, &resident, shrinks.data(), &shrinkCount, reads.data(), &readCount);
+			g_Sink = g_Sink + shrinkCount + readCount;
+		});
+		PrintHeading(options, "Mip streaming plan", "ns/frame");
+		PrintResult(options, { "PlanMipStreaming, 4096 textures", ns, 0.0 });
+	}
+
+	// Staging ring bookkeeping, checked against a model and then timed the way the upload
+	// manager drives it: a few allocations a frame, fences completing two frames behind
+	{
+		failures += CheckRingAllocator();
+
+		DirectX::RingAllocator ring;
+		if (SUCCEEDED(ring.Initialize(64 * 1024 * 1024)))
+		{
+			uint64_t fence = 0;
+			double ns = Measure(options.seconds, [&]
+			{
+				size_t offset = 0;
+				for (size_t size : { 512 * 1024, 128 * 1024, 32 * 1024, 8 * 1024 })
+				{
+					ring.Allocate(size, 16, &offset);
+					g_Sink = g_Sink + offset;
+				}
+
+				ring.FinishFrame(++fence);
+				if (fence > 2)
+					ring.Retire(fence - 2);
+			});
+
+			PrintHeading(options, "Staging ring", "ns/frame");
+			PrintResult(options, { "4 allocations, finish and retire", ns, 0.0 });
+		}
+	}
+
+	// Virtual texturing without a device: the page table's fallback, the tile cache's
+	// eviction order and the feedback's requests are checked, then a frame of feedback over
+	// a 16K x 16K texture is timed
+	{
+		failures += CheckVirtualPageTable();
+		failures += CheckVirtualTileCache();
+		failures += CheckVirtualFeedback();
+
+		DirectX::VirtualTextureLayout layout = {};
+		DirectX::VirtualTexturePageTable pageTable;
+		DirectX::VirtualTextureTileCache cache;
+		DirectX::VirtualTextureFeedback feedback;
+		if (SUCCEEDED(DirectX::GetVirtualTextureLayout(16384, 16384, 15, DXGI_FORMAT_BC1_UNORM, 128, 4, layout))
+			&& SUCCEEDED(pageTable.Initialize(layout)) && SUCCEEDED(cache.Initialize(1024)) && SUCCEEDED(feedback.Initialize(layout)))
+		{
+			// Everything from mip 4 down is resident, and an 80x45 feedback buffer looks at mips 0 to 3
+			uint64_t frame = 1;
+			for (size_t mip = 4; mip < layout.mipCount; mip++)
+			{
+				for (size_t y = 0; y < layout.tilesY[mip]; y++)
+				{
+					for (size_t x = 0; x < layout.tilesX[mip]; x++)
+					{
+						uint32_t tile = DirectX::MakeVirtualTextureTile(uint32_t(x), uint32_t(y), uint32_t(mip));
+						uint16_t page = 0;
+						uint32_t evicted = 0;
+						if (cache.Allocate(tile, frame, false, &page, &evicted) == S_OK)
+							pageTable.Map(tile, page);
+					}
+				}
+			}
+
+			std::vector<uint32_t> samples(80 * 45);
+			uint32_t seed = 0x9E3779B9u;
+			for (auto& sample : samples)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				uint32_t mip = seed >> 30;
+				uint32_t tiles = uint32_t(layout.tilesX[mip]);
+				sample = DirectX::MakeVirtualTextureTile((seed >> 8) % tiles, (seed >> 16) % tiles, mip);
+			}
+
+			std::vector<DirectX::VirtualTextureRequest> requests(64);
+			double analyzeNs = Measure(options.seconds, [&]
+			{
+				size_t requestCount = 0;
+				feedback.Analyze(samples.data(), samples.size(), pageTable, cache, ++frame, requests.data(), requests.size(), &requestCount);
+				g_Sink = g_Sink + requestCount;
+			});
+
+			double updateNs = Measure(options.seconds, [&]
+			{
+				pageTable.Map(DirectX::MakeVirtualTextureTile(0, 0, 2), 0);
+				g_Sink = g_Sink + pageTable.Update();
+			});
+
+			PrintHeading(options, "Virtual texture, 16K x 16K BC1", "ns/frame");
+			PrintResult(options, { "Feedback Analyze, 3600 samples", analyzeNs, 0.0 });
+			PrintResult(options, { "PageTable Update, from mip 2", updateNs, 0.0 });
+		}
+	}
+
+	// Packing for texture arrays: the shipped 2D textures as the scene's builder groups them,
+	// then mixed sizes and formats split at a small slice limit, and inputs it has to refuse
+	{
+		std::vector<DirectX::TextureArraySource> sources;
+		for (const auto& sample : samples)
+		{
+			DirectX::TextureArraySource arraySource = {};
+			if (GetTextureArraySource(sample.data.data(), sample.data.size(), arraySource))
+				sources.push_back(arraySource);
+		}
+
+		const DXGI_FORMAT formats[] = { DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM };
+		std::vector<DirectX::TextureArraySource> mixed;
+		for (size_t i = 0; i < 256; i++)
+		{
+			// 256, 512 or 1024 square, each with its full chain of 9, 10 or 11 mips, in three
+			// formats, so nine kinds interleaved
+			size_t scale = i % 3;
+			mixed.push_back({ size_t(256) << scale, size_t(256) << scale, 9 + scale, formats[i / 3 % 3] });
+		}
+
+		const struct
+		{
+			const char* name;
+			const std::vector<DirectX::TextureArraySource>& sources;
+			size_t maxSlices;
+		}
+		cases[] =
+		{
+			{ "shipped textures", sources, DirectX::TEXTURE_ARRAY_MAX_SLICES },
+			{ "256 mixed, 8 slices an array", mixed, 8 },
+			{ "256 mixed, no split", mixed, DirectX::TEXTURE_ARRAY_MAX_SLICES },
+		};
+
+		PrintHeading(options, "Texture array packing", "ns/pack");
+		for (const auto& c : cases)
+		{
+			std::vector<DirectX::TextureArraySlot> slots(c.sources.size());
+			size_t arrayCount = 0;
+			if (FAILED(DirectX::PackTextureArrays(c.sources.data(), c.sources.size(), c.maxSlices, slots.data(), &arrayCount))
+				|| !CheckPacking(c.sources.data(), c.sources.size(), c.maxSlices, slots.data(), arrayCount))
+			{
+				std::cerr << "Texture array packing, " << c.name << ": slots don't group the textures as the builder expects" << std::endl;
+				failures++;
+				continue;
+			}
+
+			double ns = Measure(options.seconds, [&]
+			{
+				DirectX::PackTextureArrays(c.sources.data(), c.sources.size(), c.maxSlices, slots.data(), &arrayCount);
+				g_Sink = g_Sink + arrayCount;
+			});
+			PrintResult(options, { std::string(c.name) + ", " + std::to_string(arrayCount) + " arrays", ns, 0.0 });
+		}
+
+		// A slice limit of 0 or past Direct3D's, and a texture with no size or format, are refused
+		DirectX::TextureArraySource empty = {};
+		DirectX::TextureArraySlot slot = {};
+		if (!mixed.empty()
+			&& (DirectX::PackTextureArrays(mixed.data(), 1, 0, &slot, nullptr) != E_INVALIDARG
+				|| DirectX::PackTextureArrays(mixed.data(), 1, DirectX::TEXTURE_ARRAY_MAX_SLICES + 1, &slot, nullptr) != E_INVALIDARG
+				|| DirectX::PackTextureArrays(&empty, 1, DirectX::TEXTURE_ARRAY_MAX_SLICES, &slot, nullptr) != E_INVALIDARG))
+		{
+			std::cerr << "Texture array packing: an invalid input was packed" << std::endl;
+			failures++;
+		}
+
+		failures += CheckArchivedSlice();
+	}
+
+	// Reading fewer bytes against decoding them afterwards, one file after another with no
+	// overlap between reading and decoding, which is how a single loader thread goes
+	if (rawBytes > 0.0)
+	{
+		if (!options.csv)
+		{
+			std::cout << "\n" << std::left << std::setw(30) << "Load time, all files" << std::right
+				<< std::setw(12) << "raw ms" << std::setw(12) << "lz4 ms" << std::setw(12) << "speedup" << "\n";
+		}
+
+		double diskSeconds = MeasureDiskRead(source.get(), samples);
+		double diskBytesPerSecond = rawBytes / diskSeconds;
+		std::ostringstream disk;
+		disk << "This disk " << std::fixed << std::setprecision(0) << diskBytesPerSecond / 1e6 << " MB/s";
+		PrintLoadTime(options, disk.str(), rawBytes, diskSeconds, compressedBytes / diskBytesPerSecond + decompressSeconds);
+
+		for (const auto& d : c_Disks)
+			PrintLoadTime(options, d.name, rawBytes, rawBytes / d.bytesPerSecond, compressedBytes / d.bytesPerSecond + decompressSeconds);
+	}
+
+	std::cout << std::flush;
+	return failures ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,602 @@
+//--------------------------------------------------------------------------------------
+// File: BCEncoder.cpp
+//
+// Offline BC1, BC3 and BC7 encoder for the texture cooker
+//--------------------------------------------------------------------------------------
+
+#include "BCEncoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Surfaces with fewer block rows than this per thread are not worth splitting
+    const size_t MinBlockRowsPerThread = 4;
+
+    const int c_BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    inline int Clamp(int value, int low, int high) noexcept
+    {
+        return std::min(std::max(value, low), high);
+    }
+
+    inline int Square(int value) noexcept
+    {
+        return value * value;
+    }
+
+    //----------------------------------------------------------------------------------
+    // Endpoint fitting
+    //----------------------------------------------------------------------------------
+
+    // Mean and principal axis of the first channelCount channels, by power iteration on the
+    // covariance matrix. Blocks of a single colour return a zero axis.
+    void PrincipalAxis(const uint8_t pixels[16][4], size_t channelCount, float mean[4], float axis[4]) noexcept
+    {
+        float low[4] = { 255, 255, 255, 255 };
+        float high[4] = {};
+        for (size_t c = 0; c < 4; c++)
+            mean[c] = 0;
+
+        for (size_t i = 0; i < 16; i++)
+        {
+            for (size_t c = 0; c < channelCount; c++)
+            {
+                mean[c] += pixels[i][c];
+                low[c] = std::min(low[c], float(pixels[i][c]));
+                high[c] = std::max(high[c], float(pixels[i][c]));
+            }
+        }
+
+        for (size_t c = 0; c < channelCount; c++)
+            mean[c] /= 16.0f;
+
+        float covariance[4][4] = {};
+        for (size_t i = 0; i < 16; i++)
+        {
+            float d[4] = {};
+            for (size_t c = 0; c < channelCount; c++)
+                d[c] = pixels[i][c] - mean[c];
+
+            for (size_t r = 0; r < channelCount; r++)
+                for (size_t c = 0; c < channelCount; c++)
+                    covariance[r][c] += d[r] * d[c];
+        }
+
+        // The bounding box diagonal is a good first guess and avoids starting orthogonal to the answer
+        for (size_t c = 0; c < 4; c++)
+            axis[c] = c < channelCount ? high[c] - low[c] : 0.0f;
+
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {};
+            for (size_t r = 0; r < channelCount; r++)
+                for (size_t c = 0; c < channelCount; c++)
+                    next[r] += covariance[r][c] * axis[c];
+
+            float length = 0;
+            for (size_t c = 0; c < channelCount; c++)
+                length += next[c] * next[c];
+
+            if (length < 1e-8f)
+                break;
+
+            length = 1.0f / std::sqrt(length);
+            for (size_t c = 0; c < channelCount; c++)
+                axis[c] = next[c] * length;
+        }
+    }
+
+    // Endpoints at the ends of the pixels' projection onto the axis
+    void FitEndpoints(const uint8_t pixels[16][4], size_t channelCount, float start[4], float end[4]) noexcept
+    {
+        float mean[4];
+        float axis[4];
+        PrincipalAxis(pixels, channelCount, mean, axis);
+
+        float low = 0;
+        float high = 0;
+        for (size_t i = 0; i < 16; i++)
+        {
+            float t = 0;
+            for (size_t c = 0; c < channelCount; c++)
+                t += (pixels[i][c] - mean[c]) * axis[c];
+
+            low = std::min(low, t);
+            high = std::max(high, t);
+        }
+
+        for (size_t c = 0; c < 4; c++)
+        {
+            start[c] = c < channelCount ? mean[c] + axis[c] * low : 255.0f;
+            end[c] = c < channelCount ? mean[c] + axis[c] * high : 255.0f;
+        }
+    }
+
+    // Least squares endpoints for the given interpolation weights (0 = start, 1 = end).
+    // Leaves the endpoints alone when every pixel uses the same weight.
+    void RefineEndpoints(const uint8_t pixels[16][4], const float weights[16], size_t channelCount, float start[4], float end[4]) noexcept
+    {
+        float aa = 0, ab = 0, bb = 0;
+        float ax[4] = {}, bx[4] = {};
+        for (size_t i = 0; i < 16; i++)
+        {
+            float b = weights[i];
+            float a = 1.0f - b;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+
+            for (size_t c = 0; c < channelCount; c++)
+            {
+                ax[c] += a * pixels[i][c];
+                bx[c] += b * pixels[i][c];
+            }
+        }
+
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f)
+            return;
+
+        for (size_t c = 0; c < channelCount; c++)
+        {
+            start[c] = std::min(std::max((bb * ax[c] - ab * bx[c]) / determinant, 0.0f), 255.0f);
+            end[c] = std::min(std::max((aa * bx[c] - ab * ax[c]) / determinant, 0.0f), 255.0f);
+        }
+    }
+
+    //----------------------------------------------------------------------------------
+    // BC1 colour blocks, also used for the colour half of BC3
+    //----------------------------------------------------------------------------------
+    struct ColorFit
+    {
+        uint16_t c0;
+        uint16_t c1;
+        uint8_t indices[16];
+        int error;
+    };
+
+    inline uint16_t Quantize565(const float rgb[3]) noexcept
+    {
+        int r = Clamp(int(rgb[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+        int g = Clamp(int(rgb[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+        int b = Clamp(int(rgb[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+        return uint16_t((r << 11) | (g << 5) | b);
+    }
+
+    inline void Expand565(uint16_t color, int rgb[3]) noexcept
+    {
+        int r = (color >> 11) & 0x1f, g = (color >> 5) & 0x3f, b = color & 0x1f;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+    }
+
+    // Indices and error for a pair of endpoints. Four colour mode needs c0 > c1 and three
+    // colour mode c0 <= c1, so the endpoints are swapped into the right order first.
+    ColorFit FitColors(const uint8_t pixels[16][4], uint16_t c0, uint16_t c1, bool threeColor) noexcept
+    {
+        if (threeColor ? c0 > c1 : c0 < c1)
+            std::swap(c0, c1);
+
+        ColorFit fit = { c0, c1, {}, 0 };
+
+        int palette[4][3];
+        Expand565(c0, palette[0]);
+        Expand565(c1, palette[1]);
+
+        // Same arithmetic as the decoder, so the error is what the GPU will show
+        size_t paletteSize;
+        if (!threeColor && c0 > c1)
+        {
+            for (size_t c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            paletteSize = 4;
+        }
+        else
+        {
+            for (size_t c = 0; c < 3; c++)
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            paletteSize = threeColor ? 3 : 1;
+        }
+
+        for (size_t i = 0; i < 16; i++)
+        {
+            // Index 3 of three colour mode is transparent black
+            if (threeColor && pixels[i][3] < 128)
+            {
+                fit.indices[i] = 3;
+                continue;
+            }
+
+            int best = INT32_MAX;
+            for (size_t p = 0; p < paletteSize; p++)
+            {
+                int error = Square(pixels[i][0] - palette[p][0]) + Square(pixels[i][1] - palette[p][1]) + Square(pixels[i][2] - palette[p][2]);
+                if (error < best)
+                {
+                    best = error;
+                    fit.indices[i] = uint8_t(p);
+                }
+            }
+
+            fit.error += best;
+        }
+
+        return fit;
+    }
+
+    void EncodeColorBlock(const uint8_t pixels[16][4], bool allowTransparent, uint8_t* block) noexcept
+    {
+        bool threeColor = false;
+        if (allowTransparent)
+        {
+            for (size_t i = 0; i < 16; i++)
+                threeColor |= pixels[i][3] < 128;
+        }
+
+        float start[4];
+        float end[4];
+        FitEndpoints(pixels, 3, start, end);
+
+        ColorFit best = FitColors(pixels, Quantize565(end), Quantize565(start), threeColor);
+
+        // One least squares pass over the indices the first fit picked
+        if (!threeColor && best.c0 != best.c1)
+        {
+            static const float c_Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+            float weights[16];
+            for (size_t i = 0; i < 16; i++)
+                weights[i] = c_Weights[best.indices[i]];
+
+            RefineEndpoints(pixels, weights, 3, start, end);
+
+            ColorFit refined = FitColors(pixels, Quantize565(start), Quantize565(end), false);
+            if (refined.error < best.error)
+                best = refined;
+        }
+
+        uint32_t indices = 0;
+        for (size_t i = 0; i < 16; i++)
+            indices |= uint32_t(best.indices[i]) << (2 * i);
+
+        block[0] = uint8_t(best.c0);
+        block[1] = uint8_t(best.c0 >> 8);
+        block[2] = uint8_t(best.c1);
+        block[3] = uint8_t(best.c1 >> 8);
+        memcpy(block + 4, &indices, sizeof(indices));
+    }
+
+    //----------------------------------------------------------------------------------
+    // BC3 alpha blocks
+    //----------------------------------------------------------------------------------
+    void EncodeAlphaBlock(const uint8_t pixels[16][4], uint8_t* block) noexcept
+    {
+        int low = 255;
+        int high = 0;
+        for (size_t i = 0; i < 16; i++)
+        {
+            low = std::min<int>(low, pixels[i][3]);
+            high = std::max<int>(high, pixels[i][3]);
+        }
+
+        // a0 > a1 selects the 8 value mode, equal endpoints need every index at 0
+        int palette[8] = { high, low };
+        for (int i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * high + i * low + 3) / 7;
+
+        uint64_t indices = 0;
+        if (high != low)
+        {
+            for (size_t i = 0; i < 16; i++)
+            {
+                int best = INT32_MAX;
+                uint64_t index = 0;
+                for (size_t p = 0; p < 8; p++)
+                {
+                    int error = Square(pixels[i][3] - palette[p]);
+                    if (error < best)
+                    {
+                        best = error;
+                        index = p;
+                    }
+                }
+
+                indices |= index << (3 * i);
+            }
+        }
+
+        block[0] = uint8_t(high);
+        block[1] = uint8_t(low);
+        for (size_t i = 0; i < 6; i++)
+            block[2 + i] = uint8_t(indices >> (8 * i));
+    }
+
+    //----------------------------------------------------------------------------------
+    // BC7 mode 6 blocks
+    //----------------------------------------------------------------------------------
+    struct BC7Fit
+    {
+        int endpoints[2][4]; // 7-bit values before the p-bit
+        int pBits[2];
+        uint8_t indices[16];
+        int error;
+    };
+
+    BC7Fit FitBC7Mode6(const uint8_t pixels[16][4], const float start[4], const float end[4], int p0, int p1) noexcept
+    {
+        BC7Fit fit = {};
+        fit.pBits[0] = p0;
+        fit.pBits[1] = p1;
+
+        int expanded[2][4];
+        for (size_t c = 0; c < 4; c++)
+        {
+            fit.endpoints[0][c] = Clamp(int((start[c] - p0) * 0.5f + 0.5f), 0, 127);
+            fit.endpoints[1][c] = Clamp(int((end[c] - p1) * 0.5f + 0.5f), 0, 127);
+            expanded[0][c] = (fit.endpoints[0][c] << 1) | p0;
+            expanded[1][c] = (fit.endpoints[1][c] << 1) | p1;
+        }
+
+        int palette[16][4];
+        for (size_t p = 0; p < 16; p++)
+        {
+            int w = c_BC7Weights4[p];
+            for (size_t c = 0; c < 4; c++)
+                palette[p][c] = ((64 - w) * expanded[0][c] + w * expanded[1][c] + 32) >> 6;
+        }
+
+        for (size_t i = 0; i < 16; i++)
+        {
+            int best = INT32_MAX;
+            for (size_t p = 0; p < 16; p++)
+            {
+                int error = 0;
+                for (size_t c = 0; c < 4; c++)
+                    error += Square(pixels[i][c] - palette[p][c]);
+
+                if (error < best)
+                {
+                    best = error;
+                    fit.indices[i] = uint8_t(p);
+                }
+            }
+
+            fit.error += best;
+        }
+
+        return fit;
+    }
+
+    BC7Fit FitBC7Mode6(const uint8_t pixels[16][4], const float start[4], const float end[4]) noexcept
+    {
+        BC7Fit best = FitBC7Mode6(pixels, start, end, 0, 0);
+        for (int p = 1; p < 4; p++)
+        {
+            BC7Fit fit = FitBC7Mode6(pixels, start, end, p & 1, p >> 1);
+            if (fit.error < best.error)
+                best = fit;
+        }
+
+        return best;
+    }
+
+    class BC7BitWriter
+    {
+    public:
+        void Write(uint32_t value, unsigned int count) noexcept
+        {
+            for (unsigned int i = 0; i < count; i++, m_Position++)
+            {
+                if ((value >> i) & 1)
+                    m_Bytes[m_Position / 8] |= uint8_t(1u << (m_Position % 8));
+            }
+        }
+
+        const uint8_t* GetBytes() const noexcept { return m_Bytes; }
+
+    private:
+        uint8_t m_Bytes[16] = {};
+        unsigned int m_Position = 0;
+    };
+
+    void EncodeBC7Block(const uint8_t pixels[16][4], uint8_t* block) noexcept
+    {
+        float start[4];
+        float end[4];
+        FitEndpoints(pixels, 4, start, end);
+
+        BC7Fit best = FitBC7Mode6(pixels, start, end);
+
+        float weights[16];
+        for (size_t i = 0; i < 16; i++)
+            weights[i] = c_BC7Weights4[best.indices[i]] / 64.0f;
+
+        RefineEndpoints(pixels, weights, 4, start, end);
+
+        BC7Fit refined = FitBC7Mode6(pixels, start, end);
+        if (refined.error < best.error)
+            best = refined;
+
+        // Pixel 0 is the anchor and its index drops the top bit, so it has to be below 8
+        if (best.indices[0] & 8)
+        {
+            for (size_t c = 0; c < 4; c++)
+                std::swap(best.endpoints[0][c], best.endpoints[1][c]);
+            std::swap(best.pBits[0], best.pBits[1]);
+
+            for (size_t i = 0; i < 16; i++)
+                best.indices[i] = uint8_t(15 - best.indices[i]);
+        }
+
+        BC7BitWriter bits;
+        bits.Write(1u << 6, 7);
+        for (size_t c = 0; c < 4; c++)
+        {
+            bits.Write(uint32_t(best.endpoints[0][c]), 7);
+            bits.Write(uint32_t(best.endpoints[1][c]), 7);
+        }
+
+        bits.Write(uint32_t(best.pBits[0]), 1);
+        bits.Write(uint32_t(best.pBits[1]), 1);
+
+        for (size_t i = 0; i < 16; i++)
+            bits.Write(best.indices[i], i == 0 ? 3 : 4);
+
+        memcpy(block, bits.GetBytes(), 16);
+    }
+
+    //----------------------------------------------------------------------------------
+    // Dispatch
+    //----------------------------------------------------------------------------------
+    void EncodeBC1Block(const uint8_t pixels[16][4], uint8_t* block) noexcept
+    {
+        EncodeColorBlock(pixels, true, block);
+    }
+
+    void EncodeBC3Block(const uint8_t pixels[16][4], uint8_t* block) noexcept
+    {
+        EncodeAlphaBlock(pixels, block);
+        EncodeColorBlock(pixels, false, block + 8);
+    }
+
+    typedef void (*BlockEncoder)(const uint8_t pixels[16][4], uint8_t* block);
+
+    BlockEncoder GetBlockEncoder(DXGI_FORMAT format) noexcept
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return EncodeBC1Block;
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return EncodeBC3Block;
+
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return EncodeBC7Block;
+
+        default:
+            return nullptr;
+        }
+    }
+
+    void EncodeBlockRows(
+        BlockEncoder encode,
+        size_t blockSize,
+        size_t width,
+        size_t height,
+        const uint8_t* pixels,
+        size_t pixelRowPitch,
+        uint8_t* blocks,
+        size_t blockRowPitch,
+        size_t firstRow,
+        size_t lastRow) noexcept
+    {
+        size_t blocksWide = (width + 3) / 4;
+
+        for (size_t by = firstRow; by < lastRow; by++)
+        {
+            uint8_t* block = blocks + by * blockRowPitch;
+
+            for (size_t bx = 0; bx < blocksWide; bx++, block += blockSize)
+            {
+                // Gather the block, repeating the edge for partial blocks
+                uint8_t source[16][4];
+                for (size_t y = 0; y < 4; y++)
+                {
+                    size_t sy = std::min(by * 4 + y, height - 1);
+                    for (size_t x = 0; x < 4; x++)
+                    {
+                        size_t sx = std::min(bx * 4 + x, width - 1);
+                        memcpy(source[y * 4 + x], pixels + sy * pixelRowPitch + sx * 4, 4);
+                    }
+                }
+
+                encode(source, block);
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+bool DirectX::IsBCEncodable(DXGI_FORMAT format) noexcept
+{
+    return GetBlockEncoder(format) != nullptr;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::EncodeBCSurface(
+    DXGI_FORMAT format,
+    size_t width,
+    size_t height,
+    const uint8_t* pixels,
+    size_t pixelRowPitch,
+    uint8_t* blocks,
+    size_t blockRowPitch,
+    unsigned int threadCount) noexcept
+{
+    BlockEncoder encode = GetBlockEncoder(format);
+    if (!encode || !pixels || !blocks || width == 0 || height == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    size_t blockSize = (encode == EncodeBC1Block) ? 8 : 16;
+    size_t blockRows = (height + 3) / 4;
+    if (blockRowPitch < ((width + 3) / 4) * blockSize || pixelRowPitch < width * 4)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    size_t chunks = std::max<size_t>(1, std::min<size_t>(threadCount, blockRows / MinBlockRowsPerThread));
+    size_t rowsPerChunk = (blockRows + chunks - 1) / chunks;
+
+    std::vector<std::thread> workers;
+    for (size_t chunk = 1; chunk < chunks; chunk++)
+    {
+        size_t firstRow = chunk * rowsPerChunk;
+        size_t lastRow = std::min(blockRows, firstRow + rowsPerChunk);
+        if (firstRow >= lastRow)
+            break;
+
+        try
+        {
+            workers.emplace_back(EncodeBlockRows, encode, blockSize, width, height, pixels, pixelRowPitch, blocks, blockRowPitch, firstRow, lastRow);
+        }
+        catch (...)
+        {
+            EncodeBlockRows(encode, blockSize, width, height, pixels, pixelRowPitch, blocks, blockRowPitch, firstRow, lastRow);
+        }
+    }
+
+    EncodeBlockRows(encode, blockSize, width, height, pixels, pixelRowPitch, blocks, blockRowPitch, 0, std::min(blockRows, rowsPerChunk));
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    return S_OK;
+}
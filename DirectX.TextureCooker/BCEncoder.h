@@ -0,0 +1,42 @@
+//--------------------------------------------------------------------------------------
+// File: BCEncoder.h
+//
+// Offline BC1, BC3 and BC7 encoder for the texture cooker
+//
+// Endpoints come from the principal axis of each block's colours, refined once by least
+// squares against the chosen indices. BC7 uses mode 6 only (one subset, RGBA endpoints and
+// 4-bit indices), which suits smooth colour and alpha but not blocks with sharp edges
+// between unrelated colours.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <dxgiformat.h>
+#else
+#include <wsl/winadapter.h>
+#include <directx/dxgiformat.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    bool IsBCEncodable(_In_ DXGI_FORMAT format) noexcept;
+
+    // Encodes 8-bit RGBA pixels into blocks, splitting the block rows across threads. Edge
+    // blocks of surfaces that aren't a multiple of 4 repeat the last row and column.
+    // threadCount 0 uses every hardware thread.
+    HRESULT EncodeBCSurface(
+        _In_ DXGI_FORMAT format,
+        _In_ size_t width,
+        _In_ size_t height,
+        _In_ const uint8_t* pixels,
+        _In_ size_t pixelRowPitch,
+        _Out_ uint8_t* blocks,
+        _In_ size_t blockRowPitch,
+        _In_ unsigned int threadCount = 0) noexcept;
+}
@@ -0,0 +1,259 @@
+#include "Image.h"
+#include "../DirectX.Texturing/LZ4Frame.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	// Bit masks of an 8-bit per channel layout, for legacy headers and the DX10 formats we take
+	struct ChannelMasks
+	{
+		uint32_t bitCount;
+		uint32_t r, g, b, a;
+	};
+
+	bool GetMasks(DXGI_FORMAT format, ChannelMasks& masks, bool& srgb)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			srgb = true;
+			[[fallthrough]];
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+			masks = { 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 };
+			return true;
+
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+			srgb = true;
+			[[fallthrough]];
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			masks = { 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 };
+			return true;
+
+		case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+			srgb = true;
+			[[fallthrough]];
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+			masks = { 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0 };
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	bool IsByteMask(uint32_t mask)
+	{
+		for (uint32_t shift = 0; shift < 32; shift += 8)
+		{
+			if (mask == (0xffu << shift))
+				return true;
+		}
+
+		return false;
+	}
+
+	uint32_t MaskShift(uint32_t mask)
+	{
+		uint32_t shift = 0;
+		while (shift < 32 && ((mask >> shift) & 1) == 0)
+			shift++;
+
+		return shift;
+	}
+}
+
+bool LoadDDSImage(const std::string& path, Image& image, ImageInfo& info)
+{
+	std::ifstream file(path, std::fstream::in | std::fstream::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Could not open " << path << std::endl;
+		return false;
+	}
+
+	uint32_t magic = 0;
+	DDS_HEADER header = {};
+	file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || magic != DDS_MAGIC || header.size != sizeof(DDS_HEADER) || header.ddspf.size != sizeof(DDS_PIXELFORMAT))
+	{
+		std::cerr << path << " is not a DDS file" << std::endl;
+		return false;
+	}
+
+	if ((header.flags & DDS_HEADER_FLAGS_VOLUME) || (header.caps2 & DDS_CUBEMAP))
+	{
+		std::cerr << path << ": only 2D textures can be cooked" << std::endl;
+		return false;
+	}
+
+	ChannelMasks masks = {};
+	info = ImageInfo();
+
+	if (header.ddspf.flags & DDS_FOURCC)
+	{
+		DDS_HEADER_DXT10 dx10 = {};
+		if (header.ddspf.fourCC == MAKEFOURCC('D', 'X', '1', '0'))
+			file.read(reinterpret_cast<char*>(&dx10), sizeof(dx10));
+
+		if (!file || header.ddspf.fourCC != MAKEFOURCC('D', 'X', '1', '0') || !GetMasks(dx10.dxgiFormat, masks, info.srgb))
+		{
+			std::cerr << path << ": input must be uncompressed 8-bit RGB(A)" << std::endl;
+			return false;
+		}
+
+		if (dx10.resourceDimension != DDS_DIMENSION_TEXTURE2D || dx10.arraySize > 1)
+		{
+			std::cerr << path << ": only 2D textures can be cooked" << std::endl;
+			return false;
+		}
+
+		info.alphaMode = static_cast<DirectX::DDS_ALPHA_MODE>(dx10.miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK);
+	}
+	else if (header.ddspf.flags & DDS_RGB)
+	{
+		masks = { header.ddspf.RGBBitCount, header.ddspf.RBitMask, header.ddspf.GBitMask, header.ddspf.BBitMask, header.ddspf.ABitMask };
+	}
+
+	bool validMasks = (masks.bitCount == 24 || masks.bitCount == 32)
+		&& IsByteMask(masks.r) && IsByteMask(masks.g) && IsByteMask(masks.b)
+		&& (masks.a == 0 || IsByteMask(masks.a));
+	if (!validMasks)
+	{
+		std::cerr << path << ": input must be uncompressed 8-bit RGB(A)" << std::endl;
+		return false;
+	}
+
+	image.width = header.width;
+	image.height = header.height;
+	image.pixels.resize(image.width * image.height * 4);
+
+	size_t bytesPerPixel = masks.bitCount / 8;
+	std::vector<uint8_t> row(image.width * bytesPerPixel);
+
+	uint32_t shifts[4] = { MaskShift(masks.r), MaskShift(masks.g), MaskShift(masks.b), MaskShift(masks.a) };
+
+	for (size_t y = 0; y < image.height; y++)
+	{
+		file.read(reinterpret_cast<char*>(row.data()), row.size());
+		if (!file)
+		{
+			std::cerr << path << " is truncated" << std::endl;
+			return false;
+		}
+
+		uint8_t* out = image.pixels.data() + y * image.RowPitch();
+		for (size_t x = 0; x < image.width; x++)
+		{
+			uint32_t pixel = 0;
+			memcpy(&pixel, row.data() + x * bytesPerPixel, bytesPerPixel);
+
+			out[x * 4 + 0] = uint8_t(pixel >> shifts[0]);
+			out[x * 4 + 1] = uint8_t(pixel >> shifts[1]);
+			out[x * 4 + 2] = uint8_t(pixel >> shifts[2]);
+			out[x * 4 + 3] = masks.a != 0 ? uint8_t(pixel >> shifts[3]) : 255;
+		}
+	}
+
+	if (info.alphaMode == DirectX::DDS_ALPHA_MODE_UNKNOWN && (header.ddspf.flags & DDS_FOURCC) == 0 && masks.a == 0)
+		info.alphaMode = DirectX::DDS_ALPHA_MODE_OPAQUE;
+
+	return true;
+}
+
+bool SaveDDS(const std::string& path, DXGI_FORMAT format, DirectX::DDS_ALPHA_MODE alphaMode, size_t width, size_t height, const std::vector<std::vector<uint8_t>>& mips, bool lz4)
+{
+	DDS_HEADER header = {};
+	header.size = sizeof(DDS_HEADER);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_LINEARSIZE;
+	header.height = uint32_t(height);
+	header.width = uint32_t(width);
+	header.pitchOrLinearSize = uint32_t(mips[0].size());
+	header.mipMapCount = uint32_t(mips.size());
+	header.ddspf.size = sizeof(DDS_PIXELFORMAT);
+	header.ddspf.flags = DDS_FOURCC;
+	header.ddspf.fourCC = MAKEFOURCC('D', 'X', '1', '0');
+	header.caps = DDS_SURFACE_FLAGS_TEXTURE;
+
+	if (mips.size() > 1)
+	{
+		header.flags |= DDS_HEADER_FLAGS_MIPMAP;
+		header.caps |= DDS_SURFACE_FLAGS_MIPMAP;
+	}
+
+	DDS_HEADER_DXT10 dx10 = {};
+	dx10.dxgiFormat = format;
+	dx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+	dx10.arraySize = 1;
+	dx10.miscFlags2 = uint32_t(alphaMode);
+
+	// The whole file is put together first so it can be compressed in one frame
+	std::vector<uint8_t> data;
+	auto append = [&data](const void* bytes, size_t size)
+	{
+		data.insert(data.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + size);
+	};
+
+	append(&DDS_MAGIC, sizeof(DDS_MAGIC));
+	append(&header, sizeof(header));
+	append(&dx10, sizeof(dx10));
+
+	for (const auto& mip : mips)
+		append(mip.data(), mip.size());
+
+	if (lz4)
+	{
+		std::vector<uint8_t> frame(DirectX::GetLZ4FrameBound(data.size()));
+		size_t frameSize = 0;
+		if (FAILED(DirectX::CompressLZ4Frame(data.data(), data.size(), frame.data(), frame.size(), &frameSize)))
+		{
+			std::cerr << "Could not compress " << path << std::endl;
+			return false;
+		}
+
+		frame.resize(frameSize);
+		data.swap(frame);
+	}
+
+	std::ofstream file(path, std::fstream::out | std::fstream::binary | std::fstream::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "Could not create " << path << std::endl;
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+	if (!file)
+	{
+		std::cerr << "Could not write " << path << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+DirectX::DDS_ALPHA_MODE GetAlphaMode(const Image& image, DirectX::DDS_ALPHA_MODE headerMode)
+{
+	switch (headerMode)
+	{
+	case DirectX::DDS_ALPHA_MODE_STRAIGHT:
+	case DirectX::DDS_ALPHA_MODE_PREMULTIPLIED:
+	case DirectX::DDS_ALPHA_MODE_OPAQUE:
+	case DirectX::DDS_ALPHA_MODE_CUSTOM:
+		return headerMode;
+
+	default:
+		break;
+	}
+
+	for (size_t i = 3; i < image.pixels.size(); i += 4)
+	{
+		if (image.pixels[i] != 255)
+			return DirectX::DDS_ALPHA_MODE_STRAIGHT;
+	}
+
+	return DirectX::DDS_ALPHA_MODE_OPAQUE;
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "DDS.h"
+#include <string>
+#include <vector>
+
+// Uncompressed 8-bit RGBA surface with tightly packed rows
+struct Image
+{
+	size_t width = 0;
+	size_t height = 0;
+	std::vector<uint8_t> pixels;
+
+	size_t RowPitch() const { return width * 4; }
+};
+
+struct ImageInfo
+{
+	bool srgb = false;
+	DirectX::DDS_ALPHA_MODE alphaMode = DirectX::DDS_ALPHA_MODE_UNKNOWN;
+};
+
+// Reads the top mip of an uncompressed 2D DDS as RGBA. Takes the 24 and 32-bit legacy RGB
+// layouts and DX10 headers holding R8G8B8A8, B8G8R8A8 or B8G8R8X8.
+bool LoadDDSImage(const std::string& path, Image& image, ImageInfo& info);
+
+// Writes a mip chain of encoded surfaces, largest first, behind a DX10 header. With lz4 the
+// file is written as an LZ4 frame, which the loader decompresses as it reads.
+bool SaveDDS(const std::string& path, DXGI_FORMAT format, DirectX::DDS_ALPHA_MODE alphaMode, size_t width, size_t height, const std::vector<std::vector<uint8_t>>& mips, bool lz4 = false);
+
+// Same as the DDS loader's GetAlphaMode, falling back to whether any pixel isn't opaque
+DirectX::DDS_ALPHA_MODE GetAlphaMode(const Image& image, DirectX::DDS_ALPHA_MODE headerMode);
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "BCEncoder.h"
+#include "../DirectX.Texturing/BCDecoder.h"
+#include "../DirectX.Texturing/DXGIFormatTraits.h"
+#include "../DirectX.Texturing/MipGenerator.h"
+#include "Image.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	struct Options
+	{
+		std::string input;
+		std::string output;
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		DirectX::MIP_FILTER filter = DirectX::MIP_FILTER_BOX;
+		bool srgb = false;
+		bool mips = true;
+		bool wrap = false;
+		bool verify = false;
+		bool lz4 = false;
+		unsigned int threads = 0;
+	};
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: TextureCooker [options] <input.dds> <output.dds>\n"
+			"\n"
+			"  -f <bc1|bc3|bc7>  Output format. By default opaque textures use BC1, premultiplied\n"
+			"                    alpha BC3 and straight alpha BC7.\n"
+			"  -m <box|kaiser>   Mip filter (default box)\n"
+			"  -t <count>        Encoder threads, 0 for one per hardware thread (default)\n"
+			"  --srgb            Treat the input as sRGB even if its header doesn't say so\n"
+			"  --wrap            Filter mips across the edges, for tiling textures\n"
+			"  --no-mips         Only cook the top level\n"
+			"  --verify          Decode the result and print the PSNR of every mip\n"
+			"  --lz4             Compress the output into an LZ4 frame (name it .dds.lz4)\n";
+	}
+
+	bool ParseOptions(int argc, char** argv, Options& options)
+	{
+		std::vector<std::string> files;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if (arg == "-f" && i + 1 < argc)
+			{
+				std::string format = argv[++i];
+				if (format == "bc1")
+					options.format = DXGI_FORMAT_BC1_UNORM;
+				else if (format == "bc3")
+					options.format = DXGI_FORMAT_BC3_UNORM;
+				else if (format == "bc7")
+					options.format = DXGI_FORMAT_BC7_UNORM;
+				else
+					return false;
+			}
+			else if (arg == "-m" && i + 1 < argc)
+			{
+				std::string filter = argv[++i];
+				if (filter == "box")
+					options.filter = DirectX::MIP_FILTER_BOX;
+				else if (filter == "kaiser")
+					options.filter = DirectX::MIP_FILTER_KAISER;
+				else
+					return false;
+			}
+			else if (arg == "-t" && i + 1 < argc)
+			{
+				options.threads = (unsigned int)std::stoul(argv[++i]);
+			}
+			else if (arg == "--srgb")
+			{
+				options.srgb = true;
+			}
+			else if (arg == "--wrap")
+			{
+				options.wrap = true;
+			}
+			else if (arg == "--no-mips")
+			{
+				options.mips = false;
+			}
+			else if (arg == "--verify")
+			{
+				options.verify = true;
+			}
+			else if (arg == "--lz4")
+			{
+				options.lz4 = true;
+			}
+			else if (!arg.empty() && arg[0] != '-')
+			{
+				files.push_back(arg);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		if (files.size() != 2)
+			return false;
+
+		options.input = files[0];
+		options.output = files[1];
+		return true;
+	}
+
+	DXGI_FORMAT ChooseFormat(DirectX::DDS_ALPHA_MODE alphaMode)
+	{
+		switch (alphaMode)
+		{
+		case DirectX::DDS_ALPHA_MODE_OPAQUE:
+			return DXGI_FORMAT_BC1_UNORM;
+
+		// Premultiplied colour already fades with alpha, so BC3's separate alpha block holds up
+		case DirectX::DDS_ALPHA_MODE_PREMULTIPLIED:
+			return DXGI_FORMAT_BC3_UNORM;
+
+		default:
+			return DXGI_FORMAT_BC7_UNORM;
+		}
+	}
+
+	const char* FormatName(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_BC1_UNORM: return "BC1";
+		case DXGI_FORMAT_BC1_UNORM_SRGB: return "BC1 sRGB";
+		case DXGI_FORMAT_BC3_UNORM: return "BC3";
+		case DXGI_FORMAT_BC3_UNORM_SRGB: return "BC3 sRGB";
+		case DXGI_FORMAT_BC7_UNORM: return "BC7";
+		case DXGI_FORMAT_BC7_UNORM_SRGB: return "BC7 sRGB";
+		default: return "unknown";
+		}
+	}
+
+	size_t BlockSize(DXGI_FORMAT format)
+	{
+		return DirectX::GetDXGIFormatTraits(format).elementBytes;
+	}
+
+	// Peak signal to noise ratio over RGBA, for --verify
+	double ComputePSNR(const Image& source, DXGI_FORMAT format, const std::vector<uint8_t>& blocks)
+	{
+		size_t blockRowPitch = ((source.width + 3) / 4) * BlockSize(format);
+
+		std::vector<uint8_t> decoded(source.pixels.size());
+		if (FAILED(DirectX::DecodeBCSurface(format, source.width, source.height, blocks.data(), blockRowPitch, decoded.data(), source.RowPitch())))
+			return 0.0;
+
+		double error = 0.0;
+		for (size_t i = 0; i < decoded.size(); i++)
+		{
+			double difference = double(decoded[i]) - double(source.pixels[i]);
+			error += difference * difference;
+		}
+
+		double mse = error / double(decoded.size());
+		return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return -1;
+	}
+
+	Image image;
+	ImageInfo info;
+	if (!LoadDDSImage(options.input, image, info))
+		return -1;
+
+	DirectX::DDS_ALPHA_MODE alphaMode = GetAlphaMode(image, info.alphaMode);
+
+	DXGI_FORMAT format = options.format != DXGI_FORMAT_UNKNOWN ? options.format : ChooseFormat(alphaMode);
+	if (info.srgb || options.srgb)
+		format = DirectX::MakeSRGB(format);
+
+	std::cout << options.input << ": " << image.width << "x" << image.height << " -> " << FormatName(format) << std::endl;
+
+	auto start = std::chrono::steady_clock::now();
+
+	// The whole chain is filtered from the source pixels before any of it is encoded
+	size_t mipCount = options.mips ? DirectX::CountMips(image.width, image.height) : 1;
+	std::vector<uint8_t> chain(DirectX::GetMipChainSize(image.width, image.height, mipCount));
+
+	DXGI_FORMAT sourceFormat = (info.srgb || options.srgb) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+	if (FAILED(DirectX::GenerateMipChain(sourceFormat, image.width, image.height, image.pixels.data(), image.RowPitch(), mipCount,
+		options.filter, options.wrap ? DirectX::MIP_FLAGS_WRAP : DirectX::MIP_FLAGS_NONE, chain.data(), chain.size(), options.threads)))
+	{
+		std::cerr << "Mip generation failed" << std::endl;
+		return -1;
+	}
+
+	std::vector<std::vector<uint8_t>> mips;
+	Image level = image;
+	size_t chainOffset = 0;
+	for (;;)
+	{
+		size_t blockRowPitch = ((level.width + 3) / 4) * BlockSize(format);
+		std::vector<uint8_t> blocks(blockRowPitch * ((level.height + 3) / 4));
+
+		if (FAILED(DirectX::EncodeBCSurface(format, level.width, level.height, level.pixels.data(), level.RowPitch(), blocks.data(), blockRowPitch, options.threads)))
+		{
+			std::cerr << "Encoding failed" << std::endl;
+			return -1;
+		}
+
+		if (options.verify)
+			std::cout << "  mip " << mips.size() << " " << level.width << "x" << level.height << ": " << ComputePSNR(level, format, blocks) << " dB" << std::endl;
+
+		mips.push_back(std::move(blocks));
+
+		if (mips.size() == mipCount)
+			break;
+
+		level.width = std::max<size_t>(level.width / 2, 1);
+		level.height = std::max<size_t>(level.height / 2, 1);
+		level.pixels.assign(chain.begin() + chainOffset, chain.begin() + chainOffset + level.RowPitch() * level.height);
+		chainOffset += level.pixels.size();
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	std::cout << "  " << mips.size() << " mips in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+	if (!SaveDDS(options.output, format, alphaMode, image.width, image.height, mips, options.lz4))
+		return -1;
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include "../DirectX.Texturing/TextureArchive.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Input
+	{
+		std::filesystem::path path;
+		std::string name;
+		std::vector<uint8_t> data;
+	};
+
+	void PrintUsage()
+	{
+		std::cout << "Usage: TexturePacker <archive> <file or directory>...\n"
+			"       TexturePacker -l <archive>\n"
+			"\n"
+			"Packs DDS files into an archive; directories are searched for .dds files. Entries are\n"
+			"named by their path as given, so run it from the directory the application loads\n"
+			"textures from.\n"
+			"\n"
+			"  -l  List the entries of an archive and verify their checksums\n";
+	}
+
+	uint64_t AlignUp(uint64_t value)
+	{
+		return (value + DirectX::TEXTURE_ARCHIVE_ALIGNMENT - 1) / DirectX::TEXTURE_ARCHIVE_ALIGNMENT * DirectX::TEXTURE_ARCHIVE_ALIGNMENT;
+	}
+
+	bool HasDDSExtension(const std::filesystem::path& path)
+	{
+		std::string extension = path.extension().u8string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+		return extension == ".dds";
+	}
+
+	bool AddInput(const std::filesystem::path& path, std::vector<Input>& inputs)
+	{
+		if (path.is_absolute())
+		{
+			std::cerr << path.u8string() << ": entries are named by their path, so it must be relative" << std::endl;
+			return false;
+		}
+
+		Input input;
+		input.path = path;
+
+		char name[DirectX::TEXTURE_ARCHIVE_MAX_NAME];
+		if (!DirectX::NormalizeTextureArchiveName(path.generic_u8string().c_str(), name))
+		{
+			std::cerr << path.u8string() << ": name is too long" << std::endl;
+			return false;
+		}
+		input.name = name;
+
+		inputs.push_back(std::move(input));
+		return true;
+	}
+
+	bool GatherInputs(const std::vector<std::string>& arguments, std::vector<Input>& inputs)
+	{
+		for (const auto& argument : arguments)
+		{
+			std::filesystem::path path = std::filesystem::u8path(argument);
+			std::error_code error;
+
+			if (std::filesystem::is_directory(path, error))
+			{
+				for (const auto& entry : std::filesystem::recursive_directory_iterator(path, error))
+				{
+					if (entry.is_regular_file() && HasDDSExtension(entry.path()) && !AddInput(entry.path(), inputs))
+						return false;
+				}
+			}
+			else if (std::filesystem::is_regular_file(path, error))
+			{
+				if (!AddInput(path, inputs))
+					return false;
+			}
+			else
+			{
+				std::cerr << argument << ": not found" << std::endl;
+				return false;
+			}
+		}
+
+		if (inputs.empty())
+		{
+			std::cerr << "No DDS files to pack" << std::endl;
+			return false;
+		}
+
+		// The index is binary searched, so it has to be in the same order as strcmp
+		std::sort(inputs.begin(), inputs.end(), [](const Input& a, const Input& b) { return strcmp(a.name.c_str(), b.name.c_str()) < 0; });
+
+		for (size_t i = 1; i < inputs.size(); i++)
+		{
+			if (inputs[i].name == inputs[i - 1].name)
+			{
+				std::cerr << inputs[i].path.u8string() << ": packed twice as " << inputs[i].name << std::endl;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool ReadInput(Input& input)
+	{
+		std::ifstream file(input.path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			std::cerr << input.path.u8string() << ": could not open" << std::endl;
+			return false;
+		}
+
+		input.data.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read((char*)input.data.data(), (std::streamsize)input.data.size());
+
+		if (input.data.size() < 4 || memcmp(input.data.data(), "DDS ", 4) != 0)
+		{
+			std::cerr << input.path.u8string() << ": not a DDS file" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	bool WriteArchive(const std::string& path, std::vector<Input>& inputs)
+	{
+		std::vector<DirectX::TEXTURE_ARCHIVE_ENTRY> entries(inputs.size());
+		std::vector<char> names;
+
+		for (size_t i = 0; i < inputs.size(); i++)
+		{
+			entries[i].nameOffset = (uint32_t)names.size();
+			entries[i].nameLength = (uint32_t)inputs[i].name.size();
+			names.insert(names.end(), inputs[i].name.begin(), inputs[i].name.end());
+			names.push_back(0);
+		}
+
+		size_t entryBytes = entries.size() * sizeof(DirectX::TEXTURE_ARCHIVE_ENTRY);
+		uint64_t offset = AlignUp(sizeof(DirectX::TEXTURE_ARCHIVE_HEADER) + entryBytes + names.size());
+
+		std::ofstream file(std::filesystem::u8path(path), std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			std::cerr << path << ": could not create" << std::endl;
+			return false;
+		}
+
+		// Payloads go in first, one at a time, then the index is written in front of them
+		std::vector<char> padding(DirectX::TEXTURE_ARCHIVE_ALIGNMENT, 0);
+		for (uint64_t written = 0; written < offset; written += padding.size())
+			file.write(padding.data(), (std::streamsize)padding.size());
+
+		for (size_t i = 0; i < inputs.size(); i++)
+		{
+			if (!ReadInput(inputs[i]))
+				return false;
+
+			const std::vector<uint8_t>& data = inputs[i].data;
+			entries[i].offset = offset;
+			entries[i].size = data.size();
+			entries[i].checksum = DirectX::TextureArchiveChecksum(data.data(), data.size());
+
+			file.write((const char*)data.data(), (std::streamsize)data.size());
+
+			uint64_t end = AlignUp(offset + data.size());
+			file.write(padding.data(), (std::streamsize)(end - offset - data.size()));
+			offset = end;
+
+			inputs[i].data.clear();
+			inputs[i].data.shrink_to_fit();
+		}
+
+		std::vector<uint8_t> index(entryBytes + names.size());
+		memcpy(index.data(), entries.data(), entryBytes);
+		memcpy(index.data() + entryBytes, names.data(), names.size());
+
+		DirectX::TEXTURE_ARCHIVE_HEADER header = {};
+		header.magic = DirectX::TEXTURE_ARCHIVE_MAGIC;
+		header.version = DirectX::TEXTURE_ARCHIVE_VERSION;
+		header.entryCount = (uint32_t)entries.size();
+		header.nameTableSize = (uint32_t)names.size();
+		header.indexChecksum = DirectX::TextureArchiveChecksum(index.data(), index.size());
+
+		file.seekp(0);
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)index.data(), (std::streamsize)index.size());
+
+		if (!file.good())
+		{
+			std::cerr << path << ": write failed" << std::endl;
+			return false;
+		}
+
+		return true;
+	}
+
+	int ListArchive(const std::string& path)
+	{
+		DirectX::TextureArchive archive;
+		if (FAILED(archive.Open(std::filesystem::u8path(path).wstring().c_str())))
+		{
+			std::cerr << path << ": not a valid archive" << std::endl;
+			return -1;
+		}
+
+		size_t failures = 0;
+		for (size_t i = 0; i < archive.GetEntryCount(); i++)
+		{
+			const DirectX::TEXTURE_ARCHIVE_ENTRY& entry = archive.GetEntry(i);
+			bool valid = archive.Verify(entry);
+			if (!valid)
+				failures++;
+
+			std::cout << archive.GetName(entry) << "  " << entry.size << " bytes" << (valid ? "" : "  CHECKSUM MISMATCH") << std::endl;
+		}
+
+		std::cout << archive.GetEntryCount() << " entries, " << failures << " corrupt" << std::endl;
+		return failures == 0 ? 0 : -1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc == 3 && strcmp(argv[1], "-l") == 0)
+		return ListArchive(argv[2]);
+
+	if (argc < 3 || argv[1][0] == '-')
+	{
+		PrintUsage();
+		return -1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<Input> inputs;
+	if (!GatherInputs(std::vector<std::string>(argv + 2, argv + argc), inputs))
+		return -1;
+
+	if (!WriteArchive(argv[1], inputs))
+		return -1;
+
+	auto end = std::chrono::steady_clock::now();
+	std::cout << argv[1] << ": packed " << inputs.size() << " files in " << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,996 @@
+//--------------------------------------------------------------------------------------
+// File: BCDecoder.cpp
+//
+// CPU decoder for BC1-BC5 and BC7 compressed surfaces
+//
+// Every format is split into building a small palette per block, which is scalar, and
+// expanding the per-pixel indices into the palette, which is where the vector paths come
+// in. BC7 reads a different bit layout for each of its eight modes, so its bits are read
+// by scalar code on every path; blending each pixel's endpoints by its weights is vectorized.
+//--------------------------------------------------------------------------------------
+
+#include "BCDecoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BC_DECODER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC allows any intrinsic anywhere, GCC and Clang need the functions that use them marked
+#if defined(BC_DECODER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BC_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BC_TARGET(isa)
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    // Surfaces with fewer block rows than this per thread are not worth splitting
+    const size_t MinBlockRowsPerThread = 16;
+
+    //----------------------------------------------------------------------------------
+    // Block helpers
+    //----------------------------------------------------------------------------------
+    inline uint32_t Load16(const uint8_t* data) noexcept
+    {
+        return uint32_t(data[0]) | (uint32_t(data[1]) << 8);
+    }
+
+    inline uint32_t Load32(const uint8_t* data) noexcept
+    {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t Load48(const uint8_t* data) noexcept
+    {
+        return uint64_t(Load32(data)) | (uint64_t(Load16(data + 4)) << 32);
+    }
+
+    inline uint32_t PackRGBA(uint32_t r, uint32_t g, uint32_t b, uint32_t a) noexcept
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    // Colour endpoints of a BC1-BC3 block. BC1 honours the 3 colour + transparent mode; BC2 and
+    // BC3 always interpolate 4 colours and leave alpha 0 for the alpha block to fill in.
+    void ColorPalette(const uint8_t* block, bool bc1, uint32_t palette[4]) noexcept
+    {
+        uint32_t c0 = Load16(block);
+        uint32_t c1 = Load16(block + 2);
+
+        uint32_t r0 = (c0 >> 11) & 0x1f, g0 = (c0 >> 5) & 0x3f, b0 = c0 & 0x1f;
+        uint32_t r1 = (c1 >> 11) & 0x1f, g1 = (c1 >> 5) & 0x3f, b1 = c1 & 0x1f;
+
+        r0 = (r0 << 3) | (r0 >> 2); g0 = (g0 << 2) | (g0 >> 4); b0 = (b0 << 3) | (b0 >> 2);
+        r1 = (r1 << 3) | (r1 >> 2); g1 = (g1 << 2) | (g1 >> 4); b1 = (b1 << 3) | (b1 >> 2);
+
+        uint32_t alpha = bc1 ? 0xff : 0;
+        palette[0] = PackRGBA(r0, g0, b0, alpha);
+        palette[1] = PackRGBA(r1, g1, b1, alpha);
+
+        if (!bc1 || c0 > c1)
+        {
+            palette[2] = PackRGBA((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3, alpha);
+            palette[3] = PackRGBA((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3, alpha);
+        }
+        else
+        {
+            palette[2] = PackRGBA((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2, alpha);
+            palette[3] = 0;
+        }
+    }
+
+    // 8 entry palette of a BC3 alpha or BC4/BC5 channel block
+    void ChannelPaletteUNorm(const uint8_t* block, uint8_t palette[8]) noexcept
+    {
+        uint32_t a0 = block[0];
+        uint32_t a1 = block[1];
+
+        palette[0] = uint8_t(a0);
+        palette[1] = uint8_t(a1);
+
+        if (a0 > a1)
+        {
+            for (uint32_t i = 1; i < 7; i++)
+                palette[i + 1] = uint8_t(((7 - i) * a0 + i * a1 + 3) / 7);
+        }
+        else
+        {
+            for (uint32_t i = 1; i < 5; i++)
+                palette[i + 1] = uint8_t(((5 - i) * a0 + i * a1 + 2) / 5);
+
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    void ChannelPaletteSNorm(const uint8_t* block, uint8_t palette[8]) noexcept
+    {
+        // -128 and -127 both mean -1
+        int32_t a0 = std::max<int32_t>(int8_t(block[0]), -127);
+        int32_t a1 = std::max<int32_t>(int8_t(block[1]), -127);
+
+        int32_t values[8] = { a0, a1 };
+        if (a0 > a1)
+        {
+            for (int32_t i = 1; i < 7; i++)
+            {
+                int32_t sum = (7 - i) * a0 + i * a1;
+                values[i + 1] = (sum + (sum >= 0 ? 3 : -3)) / 7;
+            }
+        }
+        else
+        {
+            for (int32_t i = 1; i < 5; i++)
+            {
+                int32_t sum = (5 - i) * a0 + i * a1;
+                values[i + 1] = (sum + (sum >= 0 ? 2 : -2)) / 5;
+            }
+
+            values[6] = -127;
+            values[7] = 127;
+        }
+
+        for (size_t i = 0; i < 8; i++)
+            palette[i] = uint8_t(int8_t(values[i]));
+    }
+
+    // BC2 stores 4 bits of alpha per pixel instead of an interpolated block
+    void MergeExplicitAlpha(const uint8_t* block, uint8_t* dst, size_t pitch) noexcept
+    {
+        for (size_t y = 0; y < 4; y++)
+        {
+            uint32_t bits = Load16(block + y * 2);
+            uint8_t* row = dst + y * pitch;
+            for (size_t x = 0; x < 4; x++)
+                row[x * 4 + 3] = uint8_t(((bits >> (x * 4)) & 0xf) * 17);
+        }
+    }
+
+    //----------------------------------------------------------------------------------
+    // Index expansion. WriteColors stores palette[index] for 16 2-bit indices; WriteChannel
+    // puts palette[index] for 16 3-bit indices into one byte of each pixel, either over the
+    // existing pixels (merge) or over the fill value. Interpolate blends every byte of 16
+    // pixels as BC7 does, ((64 - w) * low + w * high + 32) >> 6, with a weight per byte.
+    //----------------------------------------------------------------------------------
+    struct ScalarKernels
+    {
+        static void WriteColors(const uint32_t palette[4], uint32_t indices, uint8_t* dst, size_t pitch) noexcept
+        {
+            for (size_t y = 0; y < 4; y++)
+            {
+                uint32_t row[4];
+                for (size_t x = 0; x < 4; x++)
+                    row[x] = palette[(indices >> (2 * (y * 4 + x))) & 3];
+
+                memcpy(dst + y * pitch, row, sizeof(row));
+            }
+        }
+
+        static void WriteChannel(const uint8_t palette[8], uint64_t indices, unsigned int shift, uint32_t fill, bool merge, uint8_t* dst, size_t pitch) noexcept
+        {
+            for (size_t y = 0; y < 4; y++)
+            {
+                uint32_t row[4] = {};
+                if (merge)
+                    memcpy(row, dst + y * pitch, sizeof(row));
+
+                for (size_t x = 0; x < 4; x++)
+                    row[x] |= fill | (uint32_t(palette[(indices >> (3 * (y * 4 + x))) & 7]) << shift);
+
+                memcpy(dst + y * pitch, row, sizeof(row));
+            }
+        }
+
+        static void Interpolate(const uint32_t low[16], const uint32_t high[16], const uint8_t weights[64], uint8_t* dst, size_t pitch) noexcept
+        {
+            const uint8_t* lowBytes = reinterpret_cast<const uint8_t*>(low);
+            const uint8_t* highBytes = reinterpret_cast<const uint8_t*>(high);
+
+            for (size_t y = 0; y < 4; y++)
+            {
+                uint8_t* row = dst + y * pitch;
+                for (size_t i = y * 16; i < y * 16 + 16; i++)
+                    row[i % 16] = uint8_t(((64 - weights[i]) * uint32_t(lowBytes[i]) + weights[i] * uint32_t(highBytes[i]) + 32) >> 6);
+            }
+        }
+    };
+
+#ifdef BC_DECODER_X86
+    struct SSE41Kernels
+    {
+        BC_TARGET("sse4.1")
+        static void WriteColors(const uint32_t palette[4], uint32_t indices, uint8_t* dst, size_t pitch) noexcept
+        {
+            const __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(palette));
+
+            // Multiplying lane p by 4^(3-p) and shifting down by 6 extracts index p of the row
+            const __m128i scale = _mm_setr_epi32(64, 16, 4, 1);
+            const __m128i replicate = _mm_set1_epi32(0x04040404);
+            const __m128i byteOffsets = _mm_set1_epi32(0x03020100);
+            const __m128i mask = _mm_set1_epi32(3);
+
+            for (size_t y = 0; y < 4; y++)
+            {
+                __m128i row = _mm_set1_epi32(int((indices >> (8 * y)) & 0xff));
+                __m128i index = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi32(row, scale), 6), mask);
+
+                // Shuffle control picking the 4 bytes of palette[index] for every pixel
+                __m128i control = _mm_add_epi32(_mm_mullo_epi32(index, replicate), byteOffsets);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + y * pitch), _mm_shuffle_epi8(colors, control));
+            }
+        }
+
+        BC_TARGET("sse4.1")
+        static void WriteChannel(const uint8_t palette[8], uint64_t indices, unsigned int shift, uint32_t fill, bool merge, uint8_t* dst, size_t pitch) noexcept
+        {
+            const __m128i values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(palette));
+            const __m128i scale = _mm_setr_epi32(512, 64, 8, 1);
+            const __m128i mask = _mm_set1_epi32(7);
+
+            // Bytes other than the target select lane 0x80, which shuffles in a zero
+            const __m128i zeroBytes = _mm_set1_epi32(int(0x80808080u & ~(0xffu << shift)));
+            const __m128i fillValue = _mm_set1_epi32(int(fill));
+            const __m128i shiftCount = _mm_cvtsi32_si128(int(shift));
+
+            for (size_t y = 0; y < 4; y++)
+            {
+                __m128i* out = reinterpret_cast<__m128i*>(dst + y * pitch);
+
+                __m128i row = _mm_set1_epi32(int((indices >> (12 * y)) & 0xfff));
+                __m128i index = _mm_and_si128(_mm_srli_epi32(_mm_mullo_epi32(row, scale), 9), mask);
+                __m128i control = _mm_or_si128(_mm_sll_epi32(index, shiftCount), zeroBytes);
+
+                __m128i pixels = _mm_or_si128(_mm_shuffle_epi8(values, control), fillValue);
+                if (merge)
+                    pixels = _mm_or_si128(pixels, _mm_loadu_si128(out));
+
+                _mm_storeu_si128(out, pixels);
+            }
+        }
+
+        // low * 64 + w * (high - low) + 32 is at most 16352, so the whole blend fits 16 bits
+        BC_TARGET("sse4.1")
+        static __m128i Blend(__m128i low, __m128i high, __m128i weights) noexcept
+        {
+            __m128i delta = _mm_mullo_epi16(weights, _mm_sub_epi16(high, low));
+            return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(low, 6), delta), _mm_set1_epi16(32)), 6);
+        }
+
+        BC_TARGET("sse4.1")
+        static void Interpolate(const uint32_t low[16], const uint32_t high[16], const uint8_t weights[64], uint8_t* dst, size_t pitch) noexcept
+        {
+            const __m128i zero = _mm_setzero_si128();
+
+            for (size_t y = 0; y < 4; y++)
+            {
+                __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(low + y * 4));
+                __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(high + y * 4));
+                __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + y * 16));
+
+                __m128i left = Blend(_mm_cvtepu8_epi16(l), _mm_cvtepu8_epi16(h), _mm_cvtepu8_epi16(w));
+                __m128i right = Blend(_mm_unpackhi_epi8(l, zero), _mm_unpackhi_epi8(h, zero), _mm_unpackhi_epi8(w, zero));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + y * pitch), _mm_packus_epi16(left, right));
+            }
+        }
+    };
+
+    struct AVX2Kernels
+    {
+        BC_TARGET("avx2")
+        static void WriteColors(const uint32_t palette[4], uint32_t indices, uint8_t* dst, size_t pitch) noexcept
+        {
+            // Only lanes 0-3 are ever selected, so the upper half can be left undefined
+            const __m256i colors = _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(palette)));
+            const __m256i shifts = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14);
+            const __m256i mask = _mm256_set1_epi32(3);
+
+            // Two rows per iteration
+            for (size_t y = 0; y < 4; y += 2)
+            {
+                __m256i bits = _mm256_set1_epi32(int((indices >> (8 * y)) & 0xffff));
+                __m256i index = _mm256_and_si256(_mm256_srlv_epi32(bits, shifts), mask);
+                __m256i pixels = _mm256_permutevar8x32_epi32(colors, index);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + y * pitch), _mm256_castsi256_si128(pixels));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (y + 1) * pitch), _mm256_extracti128_si256(pixels, 1));
+            }
+        }
+
+        BC_TARGET("avx2")
+        static void WriteChannel(const uint8_t palette[8], uint64_t indices, unsigned int shift, uint32_t fill, bool merge, uint8_t* dst, size_t pitch) noexcept
+        {
+            __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(palette)));
+            values = _mm256_sll_epi32(values, _mm_cvtsi32_si128(int(shift)));
+
+            const __m256i shifts = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+            const __m256i mask = _mm256_set1_epi32(7);
+            const __m256i fillValue = _mm256_set1_epi32(int(fill));
+
+            for (size_t y = 0; y < 4; y += 2)
+            {
+                __m128i* out0 = reinterpret_cast<__m128i*>(dst + y * pitch);
+                __m128i* out1 = reinterpret_cast<__m128i*>(dst + (y + 1) * pitch);
+
+                __m256i bits = _mm256_set1_epi32(int((indices >> (12 * y)) & 0xffffff));
+                __m256i index = _mm256_and_si256(_mm256_srlv_epi32(bits, shifts), mask);
+                __m256i pixels = _mm256_or_si256(_mm256_permutevar8x32_epi32(values, index), fillValue);
+
+                if (merge)
+                {
+                    __m256i existing = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(out0)), _mm_loadu_si128(out1), 1);
+                    pixels = _mm256_or_si256(pixels, existing);
+                }
+
+                _mm_storeu_si128(out0, _mm256_castsi256_si128(pixels));
+                _mm_storeu_si128(out1, _mm256_extracti128_si256(pixels, 1));
+            }
+        }
+
+        BC_TARGET("avx2")
+        static __m256i Blend(__m256i low, __m256i high, __m256i weights) noexcept
+        {
+            __m256i delta = _mm256_mullo_epi16(weights, _mm256_sub_epi16(high, low));
+            return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_slli_epi16(low, 6), delta), _mm256_set1_epi16(32)), 6);
+        }
+
+        BC_TARGET("avx2")
+        static void Interpolate(const uint32_t low[16], const uint32_t high[16], const uint8_t weights[64], uint8_t* dst, size_t pitch) noexcept
+        {
+            // Two rows per iteration, a row widened to 16 bits per register
+            for (size_t y = 0; y < 4; y += 2)
+            {
+                __m256i rows[2];
+                for (size_t r = 0; r < 2; r++)
+                {
+                    __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(low + (y + r) * 4));
+                    __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(high + (y + r) * 4));
+                    __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + (y + r) * 16));
+                    rows[r] = Blend(_mm256_cvtepu8_epi16(l), _mm256_cvtepu8_epi16(h), _mm256_cvtepu8_epi16(w));
+                }
+
+                // Packing works within each 128-bit half, which leaves the rows' halves interleaved
+                __m256i pixels = _mm256_permute4x64_epi64(_mm256_packus_epi16(rows[0], rows[1]), 0xd8);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + y * pitch), _mm256_castsi256_si128(pixels));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (y + 1) * pitch), _mm256_extracti128_si256(pixels, 1));
+            }
+        }
+    };
+#endif
+
+    //----------------------------------------------------------------------------------
+    // BC1-BC5 blocks
+    //----------------------------------------------------------------------------------
+    template<class Kernels>
+    void DecodeBC1Block(const uint8_t* block, uint8_t* dst, size_t pitch) noexcept
+    {
+        uint32_t palette[4];
+        ColorPalette(block, true, palette);
+        Kernels::WriteColors(palette, Load32(block + 4), dst, pitch);
+    }
+
+    template<class Kernels>
+    void DecodeBC2Block(const uint8_t* block, uint8_t* dst, size_t pitch) noexcept
+    {
+        uint32_t palette[4];
+        ColorPalette(block + 8, false, palette);
+        Kernels::WriteColors(palette, Load32(block + 12), dst, pitch);
+        MergeExplicitAlpha(block, dst, pitch);
+    }
+
+    template<class Kernels>
+    void DecodeBC3Block(const uint8_t* block, uint8_t* dst, size_t pitch) noexcept
+    {
+        uint32_t colors[4];
+        ColorPalette(block + 8, false, colors);
+        Kernels::WriteColors(colors, Load32(block + 12), dst, pitch);
+
+        uint8_t alpha[8];
+        ChannelPaletteUNorm(block, alpha);
+        Kernels::WriteChannel(alpha, Load48(block + 2), 24, 0, true, dst, pitch);
+    }
+
+    template<class Kernels, bool snorm>
+    void DecodeBC4Block(const uint8_t* block, uint8_t* dst, size_t pitch) noexcept
+    {
+        uint8_t red[8];
+        if (snorm)
+            ChannelPaletteSNorm(block, red);
+        else
+            ChannelPaletteUNorm(block, red);
+
+        Kernels::WriteChannel(red, Load48(block + 2), 0, snorm ? 0x7f000000 : 0xff000000, false, dst, pitch);
+    }
+
+    template<class Kernels, bool snorm>
+    void DecodeBC5Block(const uint8_t* block, uint8_t* dst, size_t pitch) noexcept
+    {
+        DecodeBC4Block<Kernels, snorm>(block, dst, pitch);
+
+        uint8_t green[8];
+        if (snorm)
+            ChannelPaletteSNorm(block + 8, green);
+        else
+            ChannelPaletteUNorm(block + 8, green);
+
+        Kernels::WriteChannel(green, Load48(block + 10), 8, 0, true, dst, pitch);
+    }
+
+    //----------------------------------------------------------------------------------
+    // BC7 blocks
+    //----------------------------------------------------------------------------------
+    struct BC7Mode
+    {
+        uint8_t subsets;
+        uint8_t partitionBits;
+        uint8_t rotationBits;
+        uint8_t indexSelectionBits;
+        uint8_t colorBits;
+        uint8_t alphaBits;
+        uint8_t endpointPBits;
+        uint8_t sharedPBits;
+        uint8_t indexBits;
+        uint8_t secondaryIndexBits;
+    };
+
+    const BC7Mode c_BC7Modes[8] =
+    {
+        { 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+        { 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+        { 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+        { 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+        { 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+        { 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+        { 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+        { 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 },
+    };
+
+    // Subset of each pixel for the 64 two subset and 64 three subset partitions
+    const uint8_t c_BC7Partitions2[64][16] =
+    {
+        { 0,0,1,1,0,0,1,1,0,0,1,1,0,0,1,1 }, { 0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1 },
+        { 0,1,1,1,0,1,1,1,0,1,1,1,0,1,1,1 }, { 0,0,0,1,0,0,1,1,0,0,1,1,0,1,1,1 },
+        { 0,0,0,0,0,0,0,1,0,0,0,1,0,0,1,1 }, { 0,0,1,1,0,1,1,1,0,1,1,1,1,1,1,1 },
+        { 0,0,0,1,0,0,1,1,0,1,1,1,1,1,1,1 }, { 0,0,0,0,0,0,0,1,0,0,1,1,0,1,1,1 },
+        { 0,0,0,0,0,0,0,0,0,0,0,1,0,0,1,1 }, { 0,0,1,1,0,1,1,1,1,1,1,1,1,1,1,1 },
+        { 0,0,0,0,0,0,0,1,0,1,1,1,1,1,1,1 }, { 0,0,0,0,0,0,0,0,0,0,0,1,0,1,1,1 },
+        { 0,0,0,1,0,1,1,1,1,1,1,1,1,1,1,1 }, { 0,0,0,0,0,0,0,0,1,1,1,1,1,1,1,1 },
+        { 0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1 }, { 0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1 },
+        { 0,0,0,0,1,0,0,0,1,1,1,0,1,1,1,1 }, { 0,1,1,1,0,0,0,1,0,0,0,0,0,0,0,0 },
+        { 0,0,0,0,0,0,0,0,1,0,0,0,1,1,1,0 }, { 0,1,1,1,0,0,1,1,0,0,0,1,0,0,0,0 },
+        { 0,0,1,1,0,0,0,1,0,0,0,0,0,0,0,0 }, { 0,0,0,0,1,0,0,0,1,1,0,0,1,1,1,0 },
+        { 0,0,0,0,0,0,0,0,1,0,0,0,1,1,0,0 }, { 0,1,1,1,0,0,1,1,0,0,1,1,0,0,0,1 },
+        { 0,0,1,1,0,0,0,1,0,0,0,1,0,0,0,0 }, { 0,0,0,0,1,0,0,0,1,0,0,0,1,1,0,0 },
+        { 0,1,1,0,0,1,1,0,0,1,1,0,0,1,1,0 }, { 0,0,1,1,0,1,1,0,0,1,1,0,1,1,0,0 },
+        { 0,0,0,1,0,1,1,1,1,1,1,0,1,0,0,0 }, { 0,0,0,0,1,1,1,1,1,1,1,1,0,0,0,0 },
+        { 0,1,1,1,0,0,0,1,1,0,0,0,1,1,1,0 }, { 0,0,1,1,1,0,0,1,1,0,0,1,1,1,0,0 },
+        { 0,1,0,1,0,1,0,1,0,1,0,1,0,1,0,1 }, { 0,0,0,0,1,1,1,1,0,0,0,0,1,1,1,1 },
+        { 0,1,0,1,1,0,1,0,0,1,0,1,1,0,1,0 }, { 0,0,1,1,0,0,1,1,1,1,0,0,1,1,0,0 },
+        { 0,0,1,1,1,1,0,0,0,0,1,1,1,1,0,0 }, { 0,1,0,1,0,1,0,1,1,0,1,0,1,0,1,0 },
+        { 0,1,1,0,1,0,0,1,0,1,1,0,1,0,0,1 }, { 0,1,0,1,1,0,1,0,1,0,1,0,0,1,0,1 },
+        { 0,1,1,1,0,0,1,1,1,1,0,0,1,1,1,0 }, { 0,0,0,1,0,0,1,1,1,1,0,0,1,0,0,0 },
+        { 0,0,1,1,0,0,1,0,0,1,0,0,1,1,0,0 }, { 0,0,1,1,1,0,1,1,1,1,0,1,1,1,0,0 },
+        { 0,1,1,0,1,0,0,1,1,0,0,1,0,1,1,0 }, { 0,0,1,1,1,1,0,0,1,1,0,0,0,0,1,1 },
+        { 0,1,1,0,0,1,1,0,1,0,0,1,1,0,0,1 }, { 0,0,0,0,0,1,1,0,0,1,1,0,0,0,0,0 },
+        { 0,1,0,0,1,1,1,0,0,1,0,0,0,0,0,0 }, { 0,0,1,0,0,1,1,1,0,0,1,0,0,0,0,0 },
+        { 0,0,0,0,0,0,1,0,0,1,1,1,0,0,1,0 }, { 0,0,0,0,0,1,0,0,1,1,1,0,0,1,0,0 },
+        { 0,1,1,0,1,1,0,0,1,0,0,1,0,0,1,1 }, { 0,0,1,1,0,1,1,0,1,1,0,0,1,0,0,1 },
+        { 0,1,1,0,0,0,1,1,1,0,0,1,1,1,0,0 }, { 0,0,1,1,1,0,0,1,1,1,0,0,0,1,1,0 },
+        { 0,1,1,0,1,1,0,0,1,1,0,0,1,0,0,1 }, { 0,1,1,0,0,0,1,1,0,0,1,1,1,0,0,1 },
+        { 0,1,1,1,1,1,1,0,1,0,0,0,0,0,0,1 }, { 0,0,0,1,1,0,0,0,1,1,1,0,0,1,1,1 },
+        { 0,0,0,0,1,1,1,1,0,0,1,1,0,0,1,1 }, { 0,0,1,1,0,0,1,1,1,1,1,1,0,0,0,0 },
+        { 0,0,1,0,0,0,1,0,1,1,1,0,1,1,1,0 }, { 0,1,0,0,0,1,0,0,0,1,1,1,0,1,1,1 },
+    };
+
+    const uint8_t c_BC7Partitions3[64][16] =
+    {
+        { 0,0,1,1,0,0,1,1,0,2,2,1,2,2,2,2 }, { 0,0,0,1,0,0,1,1,2,2,1,1,2,2,2,1 },
+        { 0,0,0,0,2,0,0,1,2,2,1,1,2,2,1,1 }, { 0,2,2,2,0,0,2,2,0,0,1,1,0,1,1,1 },
+        { 0,0,0,0,0,0,0,0,1,1,2,2,1,1,2,2 }, { 0,0,1,1,0,0,1,1,0,0,2,2,0,0,2,2 },
+        { 0,0,2,2,0,0,2,2,1,1,1,1,1,1,1,1 }, { 0,0,1,1,0,0,1,1,2,2,1,1,2,2,1,1 },
+        { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2 }, { 0,0,0,0,1,1,1,1,1,1,1,1,2,2,2,2 },
+        { 0,0,0,0,1,1,1,1,2,2,2,2,2,2,2,2 }, { 0,0,1,2,0,0,1,2,0,0,1,2,0,0,1,2 },
+        { 0,1,1,2,0,1,1,2,0,1,1,2,0,1,1,2 }, { 0,1,2,2,0,1,2,2,0,1,2,2,0,1,2,2 },
+        { 0,0,1,1,0,1,1,2,1,1,2,2,1,2,2,2 }, { 0,0,1,1,2,0,0,1,2,2,0,0,2,2,2,0 },
+        { 0,0,0,1,0,0,1,1,0,1,1,2,1,1,2,2 }, { 0,1,1,1,0,0,1,1,2,0,0,1,2,2,0,0 },
+        { 0,0,0,0,1,1,2,2,1,1,2,2,1,1,2,2 }, { 0,0,2,2,0,0,2,2,0,0,2,2,1,1,1,1 },
+        { 0,1,1,1,0,1,1,1,0,2,2,2,0,2,2,2 }, { 0,0,0,1,0,0,0,1,2,2,2,1,2,2,2,1 },
+        { 0,0,0,0,0,0,1,1,0,1,2,2,0,1,2,2 }, { 0,0,0,0,1,1,0,0,2,2,1,0,2,2,1,0 },
+        { 0,1,2,2,0,1,2,2,0,0,1,1,0,0,0,0 }, { 0,0,1,2,0,0,1,2,1,1,2,2,2,2,2,2 },
+        { 0,1,1,0,1,2,2,1,1,2,2,1,0,1,1,0 }, { 0,0,0,0,0,1,1,0,1,2,2,1,1,2,2,1 },
+        { 0,0,2,2,1,1,0,2,1,1,0,2,0,0,2,2 }, { 0,1,1,0,0,1,1,0,2,0,0,2,2,2,2,2 },
+        { 0,0,1,1,0,1,2,2,0,1,2,2,0,0,1,1 }, { 0,0,0,0,2,0,0,0,2,2,1,1,2,2,2,1 },
+        { 0,0,0,0,0,0,0,2,1,1,2,2,1,2,2,2 }, { 0,2,2,2,0,0,2,2,0,0,1,2,0,0,1,1 },
+        { 0,0,1,1,0,0,1,2,0,0,2,2,0,2,2,2 }, { 0,1,2,0,0,1,2,0,0,1,2,0,0,1,2,0 },
+        { 0,0,0,0,1,1,1,1,2,2,2,2,0,0,0,0 }, { 0,1,2,0,1,2,0,1,2,0,1,2,0,1,2,0 },
+        { 0,1,2,0,2,0,1,2,1,2,0,1,0,1,2,0 }, { 0,0,1,1,2,2,0,0,1,1,2,2,0,0,1,1 },
+        { 0,0,1,1,1,1,2,2,2,2,0,0,0,0,1,1 }, { 0,1,0,1,0,1,0,1,2,2,2,2,2,2,2,2 },
+        { 0,0,0,0,0,0,0,0,2,1,2,1,2,1,2,1 }, { 0,0,2,2,1,1,2,2,0,0,2,2,1,1,2,2 },
+        { 0,0,2,2,0,0,1,1,0,0,2,2,0,0,1,1 }, { 0,2,2,0,1,2,2,1,0,2,2,0,1,2,2,1 },
+        { 0,1,0,1,2,2,2,2,2,2,2,2,0,1,0,1 }, { 0,0,0,0,2,1,2,1,2,1,2,1,2,1,2,1 },
+        { 0,1,0,1,0,1,0,1,0,1,0,1,2,2,2,2 }, { 0,2,2,2,0,1,1,1,0,2,2,2,0,1,1,1 },
+        { 0,0,0,2,1,1,1,2,0,0,0,2,1,1,1,2 }, { 0,0,0,0,2,1,1,2,2,1,1,2,2,1,1,2 },
+        { 0,2,2,2,0,1,1,1,0,1,1,1,0,2,2,2 }, { 0,0,0,2,1,1,1,2,1,1,1,2,0,0,0,2 },
+        { 0,1,1,0,0,1,1,0,0,1,1,0,2,2,2,2 }, { 0,0,0,0,0,0,0,0,2,1,1,2,2,1,1,2 },
+        { 0,1,1,0,0,1,1,0,2,2,2,2,2,2,2,2 }, { 0,0,2,2,0,0,1,1,0,0,1,1,0,0,2,2 },
+        { 0,0,2,2,1,1,2,2,1,1,2,2,0,0,2,2 }, { 0,0,0,0,0,0,0,0,0,0,0,0,2,1,1,2 },
+        { 0,0,0,2,0,0,0,1,0,0,0,2,0,0,0,1 }, { 0,2,2,2,1,2,2,2,0,2,2,2,1,2,2,2 },
+        { 0,1,0,1,2,2,2,2,2,2,2,2,2,2,2,2 }, { 0,1,1,1,2,0,1,1,2,2,0,1,2,2,2,0 },
+    };
+
+    // Pixel whose index is stored with one bit less, for subset 1 of two subset partitions and
+    // subsets 1 and 2 of three subset partitions. Subset 0 always anchors on pixel 0.
+    const uint8_t c_BC7Anchors2[64] =
+    {
+        15,15,15,15,15,15,15,15, 15,15,15,15,15,15,15,15,
+        15, 2, 8, 2, 2, 8, 8,15,  2, 8, 2, 2, 8, 8, 2, 2,
+        15,15, 6, 8, 2, 8,15,15,  2, 8, 2, 2, 2,15,15, 6,
+         6, 2, 6, 8,15,15, 2, 2, 15,15,15,15,15, 2, 2,15,
+    };
+
+    const uint8_t c_BC7Anchors3a[64] =
+    {
+         3, 3,15,15, 8, 3,15,15,  8, 8, 6, 6, 6, 5, 3, 3,
+         3, 3, 8,15, 3, 3, 6,10,  5, 8, 8, 6, 8, 5,15,15,
+         8,15, 3, 5, 6,10, 8,15, 15, 3,15, 5,15,15,15,15,
+         3,15, 5, 5, 5, 8, 5,10,  5,10, 8,13,15,12, 3, 3,
+    };
+
+    const uint8_t c_BC7Anchors3b[64] =
+    {
+        15, 8, 8, 3,15,15, 3, 8, 15,15,15,15,15,15,15, 8,
+        15, 8,15, 3,15, 8,15, 8,  3,15, 6,10,15,15,10, 8,
+        15, 3,15,10,10, 8, 9,10,  6,15, 8,15, 3, 6, 6, 8,
+        15, 3,15,15,15,15,15,15, 15,15,15,15, 3,15,15, 8,
+    };
+
+    const uint8_t c_BC7Weights2[4] = { 0, 21, 43, 64 };
+    const uint8_t c_BC7Weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    const uint8_t c_BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    const uint8_t* BC7Weights(unsigned int indexBits) noexcept
+    {
+        return indexBits == 2 ? c_BC7Weights2 : (indexBits == 3 ? c_BC7Weights3 : c_BC7Weights4);
+    }
+
+    class BC7BitReader
+    {
+    public:
+        explicit BC7BitReader(const uint8_t* block) noexcept
+        {
+            memcpy(&m_Low, block, sizeof(m_Low));
+            memcpy(&m_High, block + 8, sizeof(m_High));
+        }
+
+        unsigned int Read(unsigned int count) noexcept
+        {
+            if (count == 0)
+                return 0;
+
+            uint64_t value;
+            if (m_Position >= 64)
+                value = m_High >> (m_Position - 64);
+            else if (m_Position + count <= 64)
+                value = m_Low >> m_Position;
+            else
+                value = (m_Low >> m_Position) | (m_High << (64 - m_Position));
+
+            m_Position += count;
+            return unsigned(value & ((1u << count) - 1));
+        }
+
+    private:
+        uint64_t m_Low;
+        uint64_t m_High;
+        unsigned int m_Position = 0;
+    };
+
+    template<class Kernels>
+    void DecodeBC7Block(const uint8_t* block, uint8_t* dst, size_t pitch) noexcept
+    {
+        BC7BitReader bits(block);
+
+        unsigned int mode = 0;
+        while (mode < 8 && bits.Read(1) == 0)
+            mode++;
+
+        // Reserved mode, decodes to transparent black
+        if (mode == 8)
+        {
+            for (size_t y = 0; y < 4; y++)
+                memset(dst + y * pitch, 0, 16);
+            return;
+        }
+
+        const BC7Mode& info = c_BC7Modes[mode];
+        unsigned int partition = bits.Read(info.partitionBits);
+        unsigned int rotation = bits.Read(info.rotationBits);
+        unsigned int indexSelection = bits.Read(info.indexSelectionBits);
+
+        // Endpoints are stored channel by channel, each with every subset's pair
+        uint32_t endpoints[3][2][4] = {};
+        for (unsigned int c = 0; c < 3; c++)
+            for (unsigned int s = 0; s < info.subsets; s++)
+                for (unsigned int e = 0; e < 2; e++)
+                    endpoints[s][e][c] = bits.Read(info.colorBits);
+
+        for (unsigned int s = 0; s < info.subsets; s++)
+            for (unsigned int e = 0; e < 2; e++)
+                endpoints[s][e][3] = bits.Read(info.alphaBits);
+
+        unsigned int pBits[3][2] = {};
+        if (info.endpointPBits)
+        {
+            for (unsigned int s = 0; s < info.subsets; s++)
+                for (unsigned int e = 0; e < 2; e++)
+                    pBits[s][e] = bits.Read(1);
+        }
+        else if (info.sharedPBits)
+        {
+            for (unsigned int s = 0; s < info.subsets; s++)
+                pBits[s][0] = pBits[s][1] = bits.Read(1);
+        }
+
+        // Append the p-bit and replicate the top bits down to fill 8 bits
+        unsigned int hasPBit = info.endpointPBits | info.sharedPBits;
+        unsigned int colorPrecision = info.colorBits + hasPBit;
+        unsigned int alphaPrecision = info.alphaBits ? info.alphaBits + hasPBit : 0;
+
+        for (unsigned int s = 0; s < info.subsets; s++)
+        {
+            for (unsigned int e = 0; e < 2; e++)
+            {
+                for (unsigned int c = 0; c < 4; c++)
+                {
+                    unsigned int precision = c < 3 ? colorPrecision : alphaPrecision;
+                    if (precision == 0)
+                    {
+                        endpoints[s][e][c] = 255;
+                        continue;
+                    }
+
+                    uint32_t value = (endpoints[s][e][c] << hasPBit) | (hasPBit ? pBits[s][e] : 0);
+                    value <<= 8 - precision;
+                    endpoints[s][e][c] = value | (value >> precision);
+                }
+            }
+        }
+
+        static const uint8_t c_NoPartition[16] = {};
+        const uint8_t* subsets = info.subsets == 1 ? c_NoPartition : (info.subsets == 2 ? c_BC7Partitions2[partition] : c_BC7Partitions3[partition]);
+
+        unsigned int anchors[3] = { 0, 0, 0 };
+        if (info.subsets == 2)
+        {
+            anchors[1] = c_BC7Anchors2[partition];
+        }
+        else if (info.subsets == 3)
+        {
+            anchors[1] = c_BC7Anchors3a[partition];
+            anchors[2] = c_BC7Anchors3b[partition];
+        }
+
+        uint8_t indices[16];
+        for (unsigned int i = 0; i < 16; i++)
+            indices[i] = uint8_t(bits.Read(info.indexBits - (i == anchors[subsets[i]] ? 1 : 0)));
+
+        uint8_t secondary[16] = {};
+        if (info.secondaryIndexBits)
+        {
+            for (unsigned int i = 0; i < 16; i++)
+                secondary[i] = uint8_t(bits.Read(info.secondaryIndexBits - (i == 0 ? 1 : 0)));
+        }
+
+        // Modes 4 and 5 carry a second index set for alpha; mode 4 can swap which one is colour
+        const uint8_t* colorIndices = indices;
+        const uint8_t* alphaIndices = info.secondaryIndexBits ? secondary : indices;
+        unsigned int colorIndexBits = info.indexBits;
+        unsigned int alphaIndexBits = info.secondaryIndexBits ? info.secondaryIndexBits : info.indexBits;
+        if (indexSelection)
+        {
+            std::swap(colorIndices, alphaIndices);
+            std::swap(colorIndexBits, alphaIndexBits);
+        }
+
+        const uint8_t* colorWeights = BC7Weights(colorIndexBits);
+        const uint8_t* alphaWeights = BC7Weights(alphaIndexBits);
+
+        // Rotation swaps alpha with red, green or blue after interpolation, which is the same
+        // as swapping the endpoints' channels and blending the colour one with alpha's weight
+        uint32_t packed[3][2];
+        for (unsigned int s = 0; s < info.subsets; s++)
+        {
+            for (unsigned int e = 0; e < 2; e++)
+            {
+                uint32_t(&c)[4] = endpoints[s][e];
+                if (rotation)
+                    std::swap(c[3], c[rotation - 1]);
+                packed[s][e] = PackRGBA(c[0], c[1], c[2], c[3]);
+            }
+        }
+
+        uint32_t low[16];
+        uint32_t high[16];
+        uint8_t weights[64];
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            low[i] = packed[subsets[i]][0];
+            high[i] = packed[subsets[i]][1];
+
+            uint8_t* w = weights + i * 4;
+            w[0] = w[1] = w[2] = colorWeights[colorIndices[i]];
+            w[3] = alphaWeights[alphaIndices[i]];
+            if (rotation)
+                std::swap(w[3], w[rotation - 1]);
+        }
+
+        Kernels::Interpolate(low, high, weights, dst, pitch);
+    }
+
+    //----------------------------------------------------------------------------------
+    // Dispatch
+    //----------------------------------------------------------------------------------
+    typedef void (*BlockDecoder)(const uint8_t* block, uint8_t* dst, size_t pitch);
+
+    template<class Kernels>
+    BlockDecoder GetBlockDecoder(DXGI_FORMAT format) noexcept
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            return DecodeBC1Block<Kernels>;
+
+        case DXGI_FORMAT_BC2_UNORM:
+        case DXGI_FORMAT_BC2_UNORM_SRGB:
+            return DecodeBC2Block<Kernels>;
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            return DecodeBC3Block<Kernels>;
+
+        case DXGI_FORMAT_BC4_UNORM:
+            return DecodeBC4Block<Kernels, false>;
+
+        case DXGI_FORMAT_BC4_SNORM:
+            return DecodeBC4Block<Kernels, true>;
+
+        case DXGI_FORMAT_BC5_UNORM:
+            return DecodeBC5Block<Kernels, false>;
+
+        case DXGI_FORMAT_BC5_SNORM:
+            return DecodeBC5Block<Kernels, true>;
+
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return DecodeBC7Block<Kernels>;
+
+        default:
+            return nullptr;
+        }
+    }
+
+    BlockDecoder GetBlockDecoder(DXGI_FORMAT format, BCDecoderPath path) noexcept
+    {
+#ifdef BC_DECODER_X86
+        if (path == BCDecoderPath::AVX2)
+            return GetBlockDecoder<AVX2Kernels>(format);
+
+        if (path == BCDecoderPath::SSE41)
+            return GetBlockDecoder<SSE41Kernels>(format);
+#else
+        (void)path;
+#endif
+        return GetBlockDecoder<ScalarKernels>(format);
+    }
+
+    size_t BlockSize(DXGI_FORMAT format) noexcept
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+        case DXGI_FORMAT_BC4_UNORM:
+        case DXGI_FORMAT_BC4_SNORM:
+            return 8;
+
+        default:
+            return 16;
+        }
+    }
+
+    BCDecoderPath DetectPath() noexcept
+    {
+#if defined(BC_DECODER_X86) && defined(_MSC_VER)
+        int info[4] = {};
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        // AVX2 also needs the OS to save the YMM registers
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+
+        if (avx2)
+            return BCDecoderPath::AVX2;
+        if (sse41)
+            return BCDecoderPath::SSE41;
+#elif defined(BC_DECODER_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return BCDecoderPath::AVX2;
+        if (__builtin_cpu_supports("sse4.1"))
+            return BCDecoderPath::SSE41;
+#endif
+        return BCDecoderPath::Scalar;
+    }
+
+    const BCDecoderPath s_SupportedPath = DetectPath();
+    std::atomic<BCDecoderPath> s_Path(s_SupportedPath);
+
+    void DecodeBlockRows(
+        BlockDecoder decode,
+        size_t blockSize,
+        size_t width,
+        size_t height,
+        const uint8_t* blocks,
+        size_t blockRowPitch,
+        uint8_t* pixels,
+        size_t pixelRowPitch,
+        size_t firstRow,
+        size_t lastRow) noexcept
+    {
+        size_t blocksWide = (width + 3) / 4;
+
+        for (size_t by = firstRow; by < lastRow; by++)
+        {
+            const uint8_t* block = blocks + by * blockRowPitch;
+            size_t rows = std::min<size_t>(4, height - by * 4);
+
+            for (size_t bx = 0; bx < blocksWide; bx++, block += blockSize)
+            {
+                size_t columns = std::min<size_t>(4, width - bx * 4);
+                uint8_t* dst = pixels + by * 4 * pixelRowPitch + bx * 16;
+
+                if (rows == 4 && columns == 4)
+                {
+                    decode(block, dst, pixelRowPitch);
+                    continue;
+                }
+
+                // Edge block of a surface that isn't a multiple of 4, clip it
+                uint8_t clipped[64];
+                decode(block, clipped, 16);
+                for (size_t y = 0; y < rows; y++)
+                    memcpy(dst + y * pixelRowPitch, clipped + y * 16, columns * 4);
+            }
+        }
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+bool DirectX::IsBCDecodable(DXGI_FORMAT format) noexcept
+{
+    return GetBlockDecoder<ScalarKernels>(format) != nullptr;
+}
+
+
+//--------------------------------------------------------------------------------------
+BCDecoderPath DirectX::GetBCDecoderPath() noexcept
+{
+    return s_Path.load();
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::SetBCDecoderPath(BCDecoderPath path) noexcept
+{
+    s_Path.store(std::min(path, s_SupportedPath));
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::DecodeBCSurface(
+    DXGI_FORMAT format,
+    size_t width,
+    size_t height,
+    const uint8_t* blocks,
+    size_t blockRowPitch,
+    uint8_t* pixels,
+    size_t pixelRowPitch,
+    unsigned int threadCount) noexcept
+{
+    BlockDecoder decode = GetBlockDecoder(format, s_Path.load());
+    if (!decode || !blocks || !pixels || width == 0 || height == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    size_t blockSize = BlockSize(format);
+    size_t blockRows = (height + 3) / 4;
+    if (blockRowPitch < ((width + 3) / 4) * blockSize || pixelRowPitch < width * 4)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    size_t chunks = std::max<size_t>(1, std::min<size_t>(threadCount, blockRows / MinBlockRowsPerThread));
+    size_t rowsPerChunk = (blockRows + chunks - 1) / chunks;
+
+    // The calling thread takes the first chunk; if a thread can't be started its chunk is
+    // decoded here as well
+    std::vector<std::thread> workers;
+    for (size_t chunk = 1; chunk < chunks; chunk++)
+    {
+        size_t firstRow = chunk * rowsPerChunk;
+        size_t lastRow = std::min(blockRows, firstRow + rowsPerChunk);
+        if (firstRow >= lastRow)
+            break;
+
+        try
+        {
+            workers.emplace_back(DecodeBlockRows, decode, blockSize, width, height, blocks, blockRowPitch, pixels, pixelRowPitch, firstRow, lastRow);
+        }
+        catch (...)
+        {
+            DecodeBlockRows(decode, blockSize, width, height, blocks, blockRowPitch, pixels, pixelRowPitch, firstRow, lastRow);
+        }
+    }
+
+    DecodeBlockRows(decode, blockSize, width, height, blocks, blockRowPitch, pixels, pixelRowPitch, 0, std::min(blockRows, rowsPerChunk));
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::DecodeBCBlock(
+    DXGI_FORMAT format,
+    const uint8_t* block,
+    uint8_t* pixels,
+    size_t pixelRowPitch) noexcept
+{
+    BlockDecoder decode = GetBlockDecoder(format, s_Path.load());
+    if (!decode || !block || !pixels || pixelRowPitch < 16)
+    {
+        return E_INVALIDARG;
+    }
+
+    decode(block, pixels, pixelRowPitch);
+    return S_OK;
+}
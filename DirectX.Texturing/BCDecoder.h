@@ -0,0 +1,60 @@
+//--------------------------------------------------------------------------------------
+// File: BCDecoder.h
+//
+// CPU decoder for BC1-BC5 and BC7 compressed surfaces, for software fallbacks, thumbnails
+// and validating cooked textures. Uses AVX2 or SSE4.1 when the CPU has them and splits
+// large surfaces across threads by block row.
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <dxgiformat.h>
+#else
+#include <wsl/winadapter.h>
+#include <directx/dxgiformat.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    enum class BCDecoderPath
+    {
+        Scalar,
+        SSE41,
+        AVX2,
+    };
+
+    bool IsBCDecodable(_In_ DXGI_FORMAT format) noexcept;
+
+    // Fastest path the CPU supports, unless overridden. Forcing Scalar is useful for checking
+    // the vector paths; paths the CPU can't run are clamped to the best one it can.
+    BCDecoderPath GetBCDecoderPath() noexcept;
+    void SetBCDecoderPath(_In_ BCDecoderPath path) noexcept;
+
+    // Decodes one mip level to 8-bit RGBA. BC4 fills red and BC5 red and green, leaving blue 0
+    // and alpha opaque; their SNORM forms produce signed bytes. Partial blocks at the right and
+    // bottom edges are clipped to width and height. threadCount 0 uses every hardware thread.
+    HRESULT DecodeBCSurface(
+        _In_ DXGI_FORMAT format,
+        _In_ size_t width,
+        _In_ size_t height,
+        _In_ const uint8_t* blocks,
+        _In_ size_t blockRowPitch,
+        _Out_ uint8_t* pixels,
+        _In_ size_t pixelRowPitch,
+        _In_ unsigned int threadCount = 0) noexcept;
+
+    // Single 4x4 block, written as four rows of 16 bytes pixelRowPitch apart
+    HRESULT DecodeBCBlock(
+        _In_ DXGI_FORMAT format,
+        _In_ const uint8_t* block,
+        _Out_ uint8_t* pixels,
+        _In_ size_t pixelRowPitch) noexcept;
+}
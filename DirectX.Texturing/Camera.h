@@ -11,6 +11,7 @@ public:
 
 	constexpr DirectX::XMMATRIX GetView() { return m_View; }
 	constexpr DirectX::XMMATRIX GetProjection() { return m_Projection; }
+	constexpr int GetHeight() { return m_WindowHeight; }
 
 	void Update(float yaw, float pitch);
 	void UpdateFov(float fov);
@@ -0,0 +1,553 @@
+//--------------------------------------------------------------------------------------
+// File: DDSParser.cpp
+//
+// DDS header validation and surface layout, shared by the loader and the tools
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//--------------------------------------------------------------------------------------
+
+#include "DDSParser.h"
+#include "DXGIFormatTraits.h"
+#include "LZ4Frame.h"
+
+#include <assert.h>
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+    //--------------------------------------------------------------------------------------
+    // Pixel formats of DDS files written without the "DX10" header. Masks are R, G, B, A.
+    // Layouts no DXGI format has are UNKNOWN, with the conversion that loads them.
+    //--------------------------------------------------------------------------------------
+    struct LegacyDDSFormat
+    {
+        uint32_t    flags;      // the DDS_PIXELFORMAT flag this entry is for
+        uint32_t    bitCount;
+        uint32_t    masks[4];
+        uint32_t    fourCC;
+        DXGI_FORMAT format;
+        LegacyFormat conversion = LegacyFormat::None; // entries that load as stored leave it out
+    };
+
+    constexpr LegacyDDSFormat c_LegacyDDSFormats[] =
+    {
+        // Note that sRGB formats are written using the "DX10" extended header
+        { DDS_RGB, 32, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 }, 0, DXGI_FORMAT_R8G8B8A8_UNORM },
+        { DDS_RGB, 32, { 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 }, 0, DXGI_FORMAT_B8G8R8A8_UNORM },
+        { DDS_RGB, 32, { 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000 }, 0, DXGI_FORMAT_B8G8R8X8_UNORM },
+
+        { DDS_RGB, 32, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0x00000000 }, 0, DXGI_FORMAT_UNKNOWN, LegacyFormat::X8B8G8R8 },
+
+        // Note that many common DDS reader/writers (including D3DX) swap the
+        // the RED/BLUE masks for 10:10:10:2 formats. We assume
+        // below that the 'backwards' header mask is being used since it is most
+        // likely written by D3DX. The more robust solution is to use the 'DX10'
+        // header extension and specify the DXGI_FORMAT_R10G10B10A2_UNORM format directly
+
+        // For 'correct' writers, this should be 0x000003ff,0x000ffc00,0x3ff00000 for RGB data
+        { DDS_RGB, 32, { 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000 }, 0, DXGI_FORMAT_R10G10B10A2_UNORM },
+
+        // No DXGI format maps to (0x000003ff,0x000ffc00,0x3ff00000,0xc0000000) aka D3DFMT_A2R10G10B10
+
+        { DDS_RGB, 32, { 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000 }, 0, DXGI_FORMAT_R16G16_UNORM },
+
+        // Only 32-bit color channel format in D3D9 was R32F
+        { DDS_RGB, 32, { 0xffffffff, 0x00000000, 0x00000000, 0x00000000 }, 0, DXGI_FORMAT_R32_FLOAT }, // D3DX writes this out as a FourCC of 114
+
+        // No 24bpp DXGI formats aka D3DFMT_R8G8B8; the second is the same with red and blue swapped
+        { DDS_RGB, 24, { 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000 }, 0, DXGI_FORMAT_UNKNOWN, LegacyFormat::R8G8B8 },
+        { DDS_RGB, 24, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0x00000000 }, 0, DXGI_FORMAT_UNKNOWN, LegacyFormat::B8G8R8 },
+
+        { DDS_RGB, 16, { 0x7c00, 0x03e0, 0x001f, 0x8000 }, 0, DXGI_FORMAT_B5G5R5A1_UNORM },
+        { DDS_RGB, 16, { 0xf800, 0x07e0, 0x001f, 0x0000 }, 0, DXGI_FORMAT_B5G6R5_UNORM },
+
+        { DDS_RGB, 16, { 0x7c00, 0x03e0, 0x001f, 0x0000 }, 0, DXGI_FORMAT_UNKNOWN, LegacyFormat::X1R5G5B5 },
+
+        { DDS_RGB, 16, { 0x0f00, 0x00f0, 0x000f, 0xf000 }, 0, DXGI_FORMAT_B4G4R4A4_UNORM },
+
+        { DDS_RGB, 16, { 0x0f00, 0x00f0, 0x000f, 0x0000 }, 0, DXGI_FORMAT_UNKNOWN, LegacyFormat::X4R4G4B4 },
+
+        // No 3:3:2, 3:3:2:8, or paletted DXGI formats aka D3DFMT_A8R3G3B2, D3DFMT_R3G3B2, D3DFMT_P8, D3DFMT_A8P8, etc.
+        { DDS_RGB, 8, { 0xe0, 0x1c, 0x03, 0x00 }, 0, DXGI_FORMAT_UNKNOWN, LegacyFormat::R3G3B2 },
+        { DDS_RGB, 16, { 0x00e0, 0x001c, 0x0003, 0xff00 }, 0, DXGI_FORMAT_UNKNOWN, LegacyFormat::A8R3G3B2 },
+
+        { DDS_LUMINANCE, 8, { 0x000000ff, 0x00000000, 0x00000000, 0x00000000 }, 0, DXGI_FORMAT_R8_UNORM }, // D3DX10/11 writes this out as DX10 extension
+
+        { DDS_LUMINANCE, 8, { 0x0000000f, 0x00000000, 0x00000000, 0x000000f0 }, 0, DXGI_FORMAT_UNKNOWN, LegacyFormat::A4L4 },
+
+        { DDS_LUMINANCE, 8, { 0x000000ff, 0x00000000, 0x00000000, 0x0000ff00 }, 0, DXGI_FORMAT_R8G8_UNORM }, // Some DDS writers assume the bitcount should be 8 instead of 16
+        { DDS_LUMINANCE, 16, { 0x0000ffff, 0x00000000, 0x00000000, 0x00000000 }, 0, DXGI_FORMAT_R16_UNORM }, // D3DX10/11 writes this out as DX10 extension
+        { DDS_LUMINANCE, 16, { 0x000000ff, 0x00000000, 0x00000000, 0x0000ff00 }, 0, DXGI_FORMAT_R8G8_UNORM }, // D3DX10/11 writes this out as DX10 extension
+        { DDS_LUMINANCE, 16, { 0x0000ff00, 0x00000000, 0x00000000, 0x000000ff }, 0, DXGI_FORMAT_UNKNOWN, LegacyFormat::L8A8 }, // Alpha first, from writers that get the byte order backwards
+
+        // Alpha-only formats are matched on bit count alone
+        { DDS_ALPHA, 8, {}, 0, DXGI_FORMAT_A8_UNORM },
+
+        { DDS_BUMPDUDV, 16, { 0x00ff, 0xff00, 0x0000, 0x0000 }, 0, DXGI_FORMAT_R8G8_SNORM }, // D3DX10/11 writes this out as DX10 extension
+        { DDS_BUMPDUDV, 32, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 }, 0, DXGI_FORMAT_R8G8B8A8_SNORM }, // D3DX10/11 writes this out as DX10 extension
+        { DDS_BUMPDUDV, 32, { 0x0000ffff, 0xffff0000, 0x00000000, 0x00000000 }, 0, DXGI_FORMAT_R16G16_SNORM }, // D3DX10/11 writes this out as DX10 extension
+
+        // No DXGI format maps to (0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000) aka D3DFMT_A2W10V10U10
+
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('D', 'X', 'T', '1'), DXGI_FORMAT_BC1_UNORM },
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('D', 'X', 'T', '3'), DXGI_FORMAT_BC2_UNORM },
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('D', 'X', 'T', '5'), DXGI_FORMAT_BC3_UNORM },
+
+        // While pre-multiplied alpha isn't directly supported by the DXGI formats,
+        // they are basically the same as these BC formats so they can be mapped
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('D', 'X', 'T', '2'), DXGI_FORMAT_BC2_UNORM },
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('D', 'X', 'T', '4'), DXGI_FORMAT_BC3_UNORM },
+
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('A', 'T', 'I', '1'), DXGI_FORMAT_BC4_UNORM },
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('B', 'C', '4', 'U'), DXGI_FORMAT_BC4_UNORM },
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('B', 'C', '4', 'S'), DXGI_FORMAT_BC4_SNORM },
+
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('A', 'T', 'I', '2'), DXGI_FORMAT_BC5_UNORM },
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('B', 'C', '5', 'U'), DXGI_FORMAT_BC5_UNORM },
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('B', 'C', '5', 'S'), DXGI_FORMAT_BC5_SNORM },
+
+        // BC6H and BC7 are written using the "DX10" extended header
+
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('R', 'G', 'B', 'G'), DXGI_FORMAT_R8G8_B8G8_UNORM },
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('G', 'R', 'G', 'B'), DXGI_FORMAT_G8R8_G8B8_UNORM },
+
+        { DDS_FOURCC, 0, {}, MAKEFOURCC('Y', 'U', 'Y', '2'), DXGI_FORMAT_YUY2 },
+
+        // D3DFORMAT enums set as the FourCC
+        { DDS_FOURCC, 0, {}, 36, DXGI_FORMAT_R16G16B16A16_UNORM },  // D3DFMT_A16B16G16R16
+        { DDS_FOURCC, 0, {}, 110, DXGI_FORMAT_R16G16B16A16_SNORM }, // D3DFMT_Q16W16V16U16
+        { DDS_FOURCC, 0, {}, 111, DXGI_FORMAT_R16_FLOAT },          // D3DFMT_R16F
+        { DDS_FOURCC, 0, {}, 112, DXGI_FORMAT_R16G16_FLOAT },       // D3DFMT_G16R16F
+        { DDS_FOURCC, 0, {}, 113, DXGI_FORMAT_R16G16B16A16_FLOAT }, // D3DFMT_A16B16G16R16F
+        { DDS_FOURCC, 0, {}, 114, DXGI_FORMAT_R32_FLOAT },          // D3DFMT_R32F
+        { DDS_FOURCC, 0, {}, 115, DXGI_FORMAT_R32G32_FLOAT },       // D3DFMT_G32R32F
+        { DDS_FOURCC, 0, {}, 116, DXGI_FORMAT_R32G32B32A32_FLOAT }, // D3DFMT_A32B32G32R32F
+    };
+
+    // When a file sets more than one of these, the first one decides how it is read
+    constexpr uint32_t c_LegacyDDSFlagOrder[] = { DDS_RGB, DDS_LUMINANCE, DDS_ALPHA, DDS_BUMPDUDV, DDS_FOURCC };
+
+    constexpr const LegacyDDSFormat* FindLegacyEntry(const DDS_PIXELFORMAT& ddpf) noexcept
+    {
+        uint32_t flag = 0;
+        for (uint32_t candidate : c_LegacyDDSFlagOrder)
+        {
+            if (ddpf.flags & candidate)
+            {
+                flag = candidate;
+                break;
+            }
+        }
+
+        for (const LegacyDDSFormat& legacy : c_LegacyDDSFormats)
+        {
+            if (legacy.flags != flag)
+                continue;
+
+            if (flag == DDS_FOURCC)
+            {
+                if (legacy.fourCC == ddpf.fourCC)
+                    return &legacy;
+            }
+            else if (legacy.bitCount == ddpf.RGBBitCount)
+            {
+                if (flag == DDS_ALPHA
+                    || (legacy.masks[0] == ddpf.RBitMask && legacy.masks[1] == ddpf.GBitMask
+                        && legacy.masks[2] == ddpf.BBitMask && legacy.masks[3] == ddpf.ABitMask))
+                {
+                    return &legacy;
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    constexpr DXGI_FORMAT FindLegacyFormat(const DDS_PIXELFORMAT& ddpf) noexcept
+    {
+        return FindLegacyEntry(ddpf) ? FindLegacyEntry(ddpf)->format : DXGI_FORMAT_UNKNOWN;
+    }
+
+    constexpr LegacyFormat FindLegacyConversion(const DDS_PIXELFORMAT& ddpf) noexcept
+    {
+        return FindLegacyEntry(ddpf) ? FindLegacyEntry(ddpf)->conversion : LegacyFormat::None;
+    }
+
+    static_assert(FindLegacyFormat({ sizeof(DDS_PIXELFORMAT), DDS_RGB, 0, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0 }) == DXGI_FORMAT_B8G8R8X8_UNORM, "");
+    static_assert(FindLegacyFormat({ sizeof(DDS_PIXELFORMAT), DDS_RGB, 0, 24, 0xff0000, 0x00ff00, 0x0000ff, 0 }) == DXGI_FORMAT_UNKNOWN, "");
+    static_assert(FindLegacyFormat({ sizeof(DDS_PIXELFORMAT), DDS_LUMINANCE, 0, 8, 0xff, 0, 0, 0xff00 }) == DXGI_FORMAT_R8G8_UNORM, "");
+    static_assert(FindLegacyFormat({ sizeof(DDS_PIXELFORMAT), DDS_ALPHA, 0, 8, 0, 0, 0, 0xff }) == DXGI_FORMAT_A8_UNORM, "");
+    static_assert(FindLegacyFormat({ sizeof(DDS_PIXELFORMAT), DDS_BUMPDUDV, 0, 32, 0xffff, 0xffff0000, 0, 0 }) == DXGI_FORMAT_R16G16_SNORM, "");
+    static_assert(FindLegacyFormat({ sizeof(DDS_PIXELFORMAT), DDS_FOURCC, MAKEFOURCC('D', 'X', 'T', '4'), 0, 0, 0, 0, 0 }) == DXGI_FORMAT_BC3_UNORM, "");
+    static_assert(FindLegacyFormat({ sizeof(DDS_PIXELFORMAT), DDS_FOURCC, 113, 0, 0, 0, 0, 0 }) == DXGI_FORMAT_R16G16B16A16_FLOAT, "");
+    static_assert(FindLegacyFormat({ sizeof(DDS_PIXELFORMAT), DDS_RGB | DDS_FOURCC, MAKEFOURCC('D', 'X', 'T', '1'), 0, 0, 0, 0, 0 }) == DXGI_FORMAT_UNKNOWN, "");
+    static_assert(FindLegacyConversion({ sizeof(DDS_PIXELFORMAT), DDS_RGB, 0, 24, 0xff0000, 0x00ff00, 0x0000ff, 0 }) == LegacyFormat::R8G8B8, "");
+    static_assert(FindLegacyConversion({ sizeof(DDS_PIXELFORMAT), DDS_LUMINANCE, 0, 8, 0x0f, 0, 0, 0xf0 }) == LegacyFormat::A4L4, "");
+    static_assert(FindLegacyConversion({ sizeof(DDS_PIXELFORMAT), DDS_RGB, 0, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0 }) == LegacyFormat::None, "");
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadTextureDataFromMemory(
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    const DDS_HEADER** header,
+    const uint8_t** bitData,
+    size_t* bitSize) noexcept
+{
+    if (!header || !bitData || !bitSize)
+    {
+        return E_POINTER;
+    }
+
+    if (ddsDataSize > UINT32_MAX)
+    {
+        return E_FAIL;
+    }
+
+    if (ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+    {
+        return E_FAIL;
+    }
+
+    // DDS files always start with the same magic number ("DDS ")
+    auto dwMagicNumber = *reinterpret_cast<const uint32_t*>(ddsData);
+    if (dwMagicNumber != DDS_MAGIC)
+    {
+        return E_FAIL;
+    }
+
+    auto hdr = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
+
+    // Verify header to validate DDS file
+    if (hdr->size != sizeof(DDS_HEADER) ||
+        hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+    {
+        return E_FAIL;
+    }
+
+    // Check for DX10 extension
+    bool bDXT10Header = false;
+    if ((hdr->ddspf.flags & DDS_FOURCC) &&
+        (MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
+    {
+        // Must be long enough for both headers and magic value
+        if (ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
+        {
+            return E_FAIL;
+        }
+
+        bDXT10Header = true;
+    }
+
+    // setup the pointers in the process request
+    *header = hdr;
+    auto offset = sizeof(uint32_t)
+        + sizeof(DDS_HEADER)
+        + (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
+    *bitData = ddsData + offset;
+    *bitSize = ddsDataSize - offset;
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Get surface information for a particular format
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetSurfaceInfo(
+    size_t width,
+    size_t height,
+    DXGI_FORMAT fmt,
+    size_t* outNumBytes,
+    size_t* outRowBytes,
+    size_t* outNumRows) noexcept
+{
+    uint64_t numBytes = 0;
+    uint64_t rowBytes = 0;
+    uint64_t numRows = 0;
+
+    const DXGIFormatTraits& traits = GetDXGIFormatTraits(fmt);
+    const uint64_t bpe = traits.elementBytes;
+
+    if (traits.layout == DXGI_FORMAT_LAYOUT_BLOCK)
+    {
+        uint64_t numBlocksWide = 0;
+        if (width > 0)
+        {
+            numBlocksWide = std::max<uint64_t>(1u, (uint64_t(width) + 3u) / 4u);
+        }
+        uint64_t numBlocksHigh = 0;
+        if (height > 0)
+        {
+            numBlocksHigh = std::max<uint64_t>(1u, (uint64_t(height) + 3u) / 4u);
+        }
+        rowBytes = numBlocksWide * bpe;
+        numRows = numBlocksHigh;
+        numBytes = rowBytes * numBlocksHigh;
+    }
+    else if (traits.layout == DXGI_FORMAT_LAYOUT_PACKED)
+    {
+        rowBytes = ((uint64_t(width) + 1u) >> 1) * bpe;
+        numRows = uint64_t(height);
+        numBytes = rowBytes * height;
+    }
+    else if (traits.layout == DXGI_FORMAT_LAYOUT_NV11)
+    {
+        rowBytes = ((uint64_t(width) + 3u) >> 2) * bpe;
+        numRows = uint64_t(height) * 2u; // Direct3D makes this simplifying assumption, although it is larger than the 4:1:1 data
+        numBytes = rowBytes * numRows;
+    }
+    else if (traits.layout == DXGI_FORMAT_LAYOUT_PLANAR)
+    {
+        rowBytes = ((uint64_t(width) + 1u) >> 1) * bpe;
+        numBytes = (rowBytes * uint64_t(height)) + ((rowBytes * uint64_t(height) + 1u) >> 1);
+        numRows = height + ((uint64_t(height) + 1u) >> 1);
+    }
+    else
+    {
+        const uint64_t bpp = traits.bitsPerPixel;
+        if (!bpp)
+            return E_INVALIDARG;
+
+        rowBytes = (uint64_t(width) * bpp + 7u) / 8u; // round up to nearest byte
+        numRows = uint64_t(height);
+        numBytes = rowBytes * height;
+    }
+
+#if defined(_M_IX86) || defined(_M_ARM) || defined(_M_HYBRID_X86_ARM64)
+    static_assert(sizeof(size_t) == 4, "Not a 32-bit platform!");
+    if (numBytes > UINT32_MAX || rowBytes > UINT32_MAX || numRows > UINT32_MAX)
+        return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+#else
+    static_assert(sizeof(size_t) == 8, "Not a 64-bit platform!");
+#endif
+
+    if (outNumBytes)
+    {
+        *outNumBytes = static_cast<size_t>(numBytes);
+    }
+    if (outRowBytes)
+    {
+        *outRowBytes = static_cast<size_t>(rowBytes);
+    }
+    if (outNumRows)
+    {
+        *outNumRows = static_cast<size_t>(numRows);
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+DXGI_FORMAT DirectX::GetDXGIFormat(const DDS_PIXELFORMAT& ddpf) noexcept
+{
+    return FindLegacyFormat(ddpf);
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+LegacyFormat DirectX::GetLegacyFormat(const DDS_PIXELFORMAT& ddpf) noexcept
+{
+    return FindLegacyConversion(ddpf);
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::FillInitData(
+    size_t width,
+    size_t height,
+    size_t depth,
+    size_t mipCount,
+    size_t arraySize,
+    DXGI_FORMAT format,
+    size_t maxsize,
+    size_t bitSize,
+    const uint8_t* bitData,
+    size_t& twidth,
+    size_t& theight,
+    size_t& tdepth,
+    size_t& skipMip,
+    D3D11_SUBRESOURCE_DATA* initData) noexcept
+{
+    if (!bitData || !initData)
+    {
+        return E_POINTER;
+    }
+
+    skipMip = 0;
+    twidth = 0;
+    theight = 0;
+    tdepth = 0;
+
+    size_t NumBytes = 0;
+    size_t RowBytes = 0;
+    const uint8_t* pSrcBits = bitData;
+    const uint8_t* pEndBits = bitData + bitSize;
+
+    size_t index = 0;
+    for (size_t j = 0; j < arraySize; j++)
+    {
+        size_t w = width;
+        size_t h = height;
+        size_t d = depth;
+        for (size_t i = 0; i < mipCount; i++)
+        {
+            HRESULT hr = GetSurfaceInfo(w, h, format, &NumBytes, &RowBytes, nullptr);
+            if (FAILED(hr))
+                return hr;
+
+            if (NumBytes > UINT32_MAX || RowBytes > UINT32_MAX)
+                return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+            if ((mipCount <= 1) || !maxsize || (w <= maxsize && h <= maxsize && d <= maxsize))
+            {
+                if (!twidth)
+                {
+                    twidth = w;
+                    theight = h;
+                    tdepth = d;
+                }
+
+                assert(index < mipCount * arraySize);
+                initData[index].pSysMem = pSrcBits;
+                initData[index].SysMemPitch = static_cast<UINT>(RowBytes);
+                initData[index].SysMemSlicePitch = static_cast<UINT>(NumBytes);
+                ++index;
+            }
+            else if (!j)
+            {
+                // Count number of skipped mipmaps (first item only)
+                ++skipMip;
+            }
+
+            if (pSrcBits + (NumBytes*d) > pEndBits)
+            {
+                return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+            }
+
+            pSrcBits += NumBytes * d;
+
+            w = w >> 1;
+            h = h >> 1;
+            d = d >> 1;
+            if (w == 0)
+            {
+                w = 1;
+            }
+            if (h == 0)
+            {
+                h = 1;
+            }
+            if (d == 0)
+            {
+                d = 1;
+            }
+        }
+    }
+
+    return (index > 0) ? S_OK : E_FAIL;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::ReadFromFileSource(
+    void* context,
+    uint8_t* buffer,
+    size_t size) noexcept
+{
+    // Frames are read a block at a time, and blocks are at most 4MB
+    auto reader = static_cast<FileSourceReader*>(context);
+    size_t bytesRead = 0;
+    HRESULT hr = reader->file->Read(reader->position, buffer, size, &bytesRead);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    reader->position += bytesRead;
+    if (bytesRead < size)
+    {
+        return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::ReadDDSHeaderFromFile(
+    IFileSource* source,
+    const wchar_t* fileName,
+    uint8_t* headerData,
+    size_t* headerSize,
+    bool* isLZ4Frame) noexcept
+{
+    if (headerSize)
+    {
+        *headerSize = 0;
+    }
+    if (isLZ4Frame)
+    {
+        *isLZ4Frame = false;
+    }
+
+    if (!source || !fileName || !headerData || !headerSize)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::unique_ptr<IFileSourceFile> file;
+    HRESULT hr = source->Open(fileName, file);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    size_t bytesRead = 0;
+    hr = file->Read(0, headerData, DDS_HEADER_PROBE_SIZE, &bytesRead);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    if (!IsLZ4Frame(headerData, bytesRead))
+    {
+        *headerSize = bytesRead;
+        return S_OK;
+    }
+
+    // Compressed: decode just enough of the first block to cover the headers
+    FileSourceReader reader = { file.get(), 0 };
+    LZ4FrameInfo info;
+    hr = ReadLZ4FrameHeader(ReadFromFileSource, &reader, info);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = DecompressLZ4FramePrefix(ReadFromFileSource, &reader, info, headerData, DDS_HEADER_PROBE_SIZE, headerSize);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    if (isLZ4Frame)
+    {
+        *isLZ4Frame = true;
+    }
+
+    return S_OK;
+}
+
@@ -0,0 +1,194 @@
+//--------------------------------------------------------------------------------------
+// File: DDSParser.h
+//
+// The Direct3D-independent half of the DDS loader: the file structures, header
+// validation, and the surface size and subresource layout calculations.
+//
+// Builds against the DirectX-Headers WSL adapter, so the parsing can be measured and
+// exercised off Windows.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <d3d11_1.h>
+#else
+#include <wsl/winadapter.h>
+#include <directx/dxgiformat.h>
+
+// Only its layout is needed here; Windows builds get it from d3d11.h
+struct D3D11_SUBRESOURCE_DATA
+{
+    const void* pSysMem;
+    UINT SysMemPitch;
+    UINT SysMemSlicePitch;
+};
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+#include "FileSource.h"
+#include "LegacyFormatConverter.h"
+
+
+//--------------------------------------------------------------------------------------
+// Macros
+//--------------------------------------------------------------------------------------
+#ifndef MAKEFOURCC
+    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
+                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
+                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
+#endif /* defined(MAKEFOURCC) */
+
+//--------------------------------------------------------------------------------------
+// DDS file structure definitions
+//
+// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
+//--------------------------------------------------------------------------------------
+#pragma pack(push,1)
+
+const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+
+struct DDS_PIXELFORMAT
+{
+    uint32_t    size;
+    uint32_t    flags;
+    uint32_t    fourCC;
+    uint32_t    RGBBitCount;
+    uint32_t    RBitMask;
+    uint32_t    GBitMask;
+    uint32_t    BBitMask;
+    uint32_t    ABitMask;
+};
+
+#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
+#define DDS_RGB         0x00000040  // DDPF_RGB
+#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
+#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
+#define DDS_BUMPDUDV    0x00080000  // DDPF_BUMPDUDV
+
+#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
+
+#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
+
+#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
+#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
+#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
+#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
+#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
+#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
+
+#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
+                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
+                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
+
+#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
+
+enum DDS_MISC_FLAGS2
+{
+    DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
+};
+
+struct DDS_HEADER
+{
+    uint32_t        size;
+    uint32_t        flags;
+    uint32_t        height;
+    uint32_t        width;
+    uint32_t        pitchOrLinearSize;
+    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
+    uint32_t        mipMapCount;
+    uint32_t        reserved1[11];
+    DDS_PIXELFORMAT ddspf;
+    uint32_t        caps;
+    uint32_t        caps2;
+    uint32_t        caps3;
+    uint32_t        caps4;
+    uint32_t        reserved2;
+};
+
+struct DDS_HEADER_DXT10
+{
+    DXGI_FORMAT     dxgiFormat;
+    uint32_t        resourceDimension;
+    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
+    uint32_t        arraySize;
+    uint32_t        miscFlags2;
+};
+
+#pragma pack(pop)
+
+
+namespace DirectX
+{
+    // Magic number and both headers, the most of a file it takes to describe it
+    constexpr size_t DDS_HEADER_PROBE_SIZE = sizeof(uint32_t) + sizeof(DDS_HEADER) + sizeof(DDS_HEADER_DXT10);
+
+    // Checks the magic value and header sizes, and finds the pixel data that follows them
+    HRESULT LoadTextureDataFromMemory(
+        _In_reads_(ddsDataSize) const uint8_t* ddsData,
+        _In_ size_t ddsDataSize,
+        _Outptr_ const DDS_HEADER** header,
+        _Outptr_ const uint8_t** bitData,
+        _Out_ size_t* bitSize) noexcept;
+
+    // Bytes, row pitch and row count of one surface; E_INVALIDARG for formats it can't size
+    HRESULT GetSurfaceInfo(
+        _In_ size_t width,
+        _In_ size_t height,
+        _In_ DXGI_FORMAT fmt,
+        _Out_opt_ size_t* outNumBytes,
+        _Out_opt_ size_t* outRowBytes,
+        _Out_opt_ size_t* outNumRows) noexcept;
+
+    // Format of a file without the "DX10" header, DXGI_FORMAT_UNKNOWN if none matches
+    DXGI_FORMAT GetDXGIFormat(_In_ const DDS_PIXELFORMAT& ddpf) noexcept;
+
+    // Layout of a file GetDXGIFormat has no format for but ConvertLegacySurface can load,
+    // LegacyFormat::None for every other file
+    LegacyFormat GetLegacyFormat(_In_ const DDS_PIXELFORMAT& ddpf) noexcept;
+
+    // Points initData at each subresource in bitData, skipping the mips larger than maxsize
+    HRESULT FillInitData(
+        _In_ size_t width,
+        _In_ size_t height,
+        _In_ size_t depth,
+        _In_ size_t mipCount,
+        _In_ size_t arraySize,
+        _In_ DXGI_FORMAT format,
+        _In_ size_t maxsize,
+        _In_ size_t bitSize,
+        _In_reads_bytes_(bitSize) const uint8_t* bitData,
+        _Out_ size_t& twidth,
+        _Out_ size_t& theight,
+        _Out_ size_t& tdepth,
+        _Out_ size_t& skipMip,
+        _Out_writes_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData) noexcept;
+
+    // Reads an open file front to back, as the LZ4_READ_CALLBACK of the frame decoder.
+    // A read that comes up short is ERROR_HANDLE_EOF.
+    struct FileSourceReader
+    {
+        IFileSourceFile* file;
+        uint64_t position;
+    };
+
+    HRESULT ReadFromFileSource(
+        _In_opt_ void* context,
+        _Out_writes_bytes_(size) uint8_t* buffer,
+        _In_ size_t size) noexcept;
+
+    // Reads the first DDS_HEADER_PROBE_SIZE bytes of a .dds file through source, or of the
+    // decompressed contents of a .dds.lz4 file, without reading the pixels. A legacy file
+    // too small for the "DX10" header returns fewer bytes.
+    HRESULT ReadDDSHeaderFromFile(
+        _In_ IFileSource* source,
+        _In_z_ const wchar_t* fileName,
+        _Out_writes_bytes_(DDS_HEADER_PROBE_SIZE) uint8_t* headerData,
+        _Out_ size_t* headerSize,
+        _Out_opt_ bool* isLZ4Frame) noexcept;
+}
@@ -15,10 +15,27 @@
 //--------------------------------------------------------------------------------------
 
 #include "DDSTextureLoader.h"
+#include "DDSParser.h"
+#include "DXGIFormatTraits.h"
+#include "FileSource.h"
+#include "LegacyFormatConverter.h"
+#include "LZ4Frame.h"
+#include "MipGenerator.h"
 
 #include <assert.h>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef DDS_LOADER_STATS
+#include <chrono>
+#include <cwchar>
+#endif
 
 #ifdef __clang__
 #pragma clang diagnostic ignored "-Wcovered-switch-default"
@@ -28,100 +45,114 @@
 using namespace DirectX;
 
 //--------------------------------------------------------------------------------------
-// Macros
-//--------------------------------------------------------------------------------------
-#ifndef MAKEFOURCC
-    #define MAKEFOURCC(ch0, ch1, ch2, ch3)                              \
-                ((uint32_t)(uint8_t)(ch0) | ((uint32_t)(uint8_t)(ch1) << 8) |       \
-                ((uint32_t)(uint8_t)(ch2) << 16) | ((uint32_t)(uint8_t)(ch3) << 24 ))
-#endif /* defined(MAKEFOURCC) */
+namespace
+{
+    //--------------------------------------------------------------------------------------
+    // Times one load stage by stage. Each End call charges the time since the previous one
+    // to its stage, so the stages of a load add up to its wall time. Without
+    // DDS_LOADER_STATS every member is an empty inline function.
+    //--------------------------------------------------------------------------------------
+#ifdef DDS_LOADER_STATS
+    std::atomic<IDDSLoadStatsSink*> s_StatsSink(nullptr);
 
-//--------------------------------------------------------------------------------------
-// DDS file structure definitions
-//
-// See DDS.h in the 'Texconv' sample and the 'DirectXTex' library
-//--------------------------------------------------------------------------------------
-#pragma pack(push,1)
+    class LoadStats
+    {
+    public:
+        explicit LoadStats(_In_opt_z_ const wchar_t* fileName = nullptr) noexcept :
+            m_Stats{},
+            m_Mark(Clock::now())
+        {
+            if (fileName)
+            {
+                size_t length = wcslen(fileName);
+                if (length >= MAX_PATH)
+                {
+                    fileName += length - (MAX_PATH - 1);
+                    length = MAX_PATH - 1;
+                }
+
+                memcpy(m_Stats.fileName, fileName, length * sizeof(wchar_t));
+            }
+        }
 
-const uint32_t DDS_MAGIC = 0x20534444; // "DDS "
+        // Picks up the record a split load left behind; only creation is timed from here
+        explicit LoadStats(_In_ const DDSLoadStats& loaded) noexcept :
+            m_Stats{},
+            m_Mark(Clock::now())
+        {
+            memcpy(m_Stats.fileName, loaded.fileName, sizeof(m_Stats.fileName));
+            m_Stats.width = loaded.width;
+            m_Stats.height = loaded.height;
+            m_Stats.mipCount = loaded.mipCount;
+            m_Stats.format = loaded.format;
+            m_Stats.isLZ4Frame = loaded.isLZ4Frame;
+        }
 
-struct DDS_PIXELFORMAT
-{
-    uint32_t    size;
-    uint32_t    flags;
-    uint32_t    fourCC;
-    uint32_t    RGBBitCount;
-    uint32_t    RBitMask;
-    uint32_t    GBitMask;
-    uint32_t    BBitMask;
-    uint32_t    ABitMask;
-};
-
-#define DDS_FOURCC      0x00000004  // DDPF_FOURCC
-#define DDS_RGB         0x00000040  // DDPF_RGB
-#define DDS_LUMINANCE   0x00020000  // DDPF_LUMINANCE
-#define DDS_ALPHA       0x00000002  // DDPF_ALPHA
-#define DDS_BUMPDUDV    0x00080000  // DDPF_BUMPDUDV
-
-#define DDS_HEADER_FLAGS_VOLUME         0x00800000  // DDSD_DEPTH
-
-#define DDS_HEIGHT 0x00000002 // DDSD_HEIGHT
-
-#define DDS_CUBEMAP_POSITIVEX 0x00000600 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEX
-#define DDS_CUBEMAP_NEGATIVEX 0x00000a00 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEX
-#define DDS_CUBEMAP_POSITIVEY 0x00001200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEY
-#define DDS_CUBEMAP_NEGATIVEY 0x00002200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEY
-#define DDS_CUBEMAP_POSITIVEZ 0x00004200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_POSITIVEZ
-#define DDS_CUBEMAP_NEGATIVEZ 0x00008200 // DDSCAPS2_CUBEMAP | DDSCAPS2_CUBEMAP_NEGATIVEZ
-
-#define DDS_CUBEMAP_ALLFACES ( DDS_CUBEMAP_POSITIVEX | DDS_CUBEMAP_NEGATIVEX |\
-                               DDS_CUBEMAP_POSITIVEY | DDS_CUBEMAP_NEGATIVEY |\
-                               DDS_CUBEMAP_POSITIVEZ | DDS_CUBEMAP_NEGATIVEZ )
-
-#define DDS_CUBEMAP 0x00000200 // DDSCAPS2_CUBEMAP
-
-enum DDS_MISC_FLAGS2
-{
-    DDS_MISC_FLAGS2_ALPHA_MODE_MASK = 0x7L,
-};
+        void EndOpen() noexcept { End(m_Stats.openMs); }
+        void EndRead() noexcept { End(m_Stats.readMs); }
+        void EndValidate() noexcept { End(m_Stats.validateMs); }
+        void EndLayout() noexcept { End(m_Stats.layoutMs); }
+        void EndCreate() noexcept { End(m_Stats.createMs); }
 
-struct DDS_HEADER
-{
-    uint32_t        size;
-    uint32_t        flags;
-    uint32_t        height;
-    uint32_t        width;
-    uint32_t        pitchOrLinearSize;
-    uint32_t        depth; // only if DDS_HEADER_FLAGS_VOLUME is set in flags
-    uint32_t        mipMapCount;
-    uint32_t        reserved1[11];
-    DDS_PIXELFORMAT ddspf;
-    uint32_t        caps;
-    uint32_t        caps2;
-    uint32_t        caps3;
-    uint32_t        caps4;
-    uint32_t        reserved2;
-};
-
-struct DDS_HEADER_DXT10
-{
-    DXGI_FORMAT     dxgiFormat;
-    uint32_t        resourceDimension;
-    uint32_t        miscFlag; // see D3D11_RESOURCE_MISC_FLAG
-    uint32_t        arraySize;
-    uint32_t        miscFlags2;
-};
+        void AddBytesRead(_In_ uint64_t bytes) noexcept { m_Stats.bytesRead += bytes; }
+        void SetLZ4Frame() noexcept { m_Stats.isLZ4Frame = true; }
+        void SetMapped() noexcept { m_Stats.isMapped = true; }
 
-#pragma pack(pop)
+        void SetTexture(_In_ size_t width, _In_ size_t height, _In_ size_t mipCount, _In_ size_t skippedMips,
+            _In_ DXGI_FORMAT format) noexcept
+        {
+            m_Stats.width = width;
+            m_Stats.height = height;
+            m_Stats.mipCount = mipCount;
+            m_Stats.skippedMips = skippedMips;
+            m_Stats.format = format;
+        }
 
-//--------------------------------------------------------------------------------------
-namespace
-{
-    struct handle_closer { void operator()(HANDLE h) { if (h) CloseHandle(h); } };
+        void Report(_In_ HRESULT result) noexcept
+        {
+            m_Stats.result = result;
+
+            IDDSLoadStatsSink* sink = s_StatsSink.load(std::memory_order_acquire);
+            if (sink)
+            {
+                sink->OnDDSLoadStats(m_Stats);
+            }
+        }
+
+        const DDSLoadStats& Get() const noexcept { return m_Stats; }
+
+    private:
+        using Clock = std::chrono::steady_clock;
 
-    using ScopedHandle = std::unique_ptr<void, handle_closer>;
+        DDSLoadStats m_Stats;
+        Clock::time_point m_Mark;
 
-    inline HANDLE safe_handle( HANDLE h ) { return (h == INVALID_HANDLE_VALUE) ? nullptr : h; }
+        void End(double& stageMs) noexcept
+        {
+            Clock::time_point now = Clock::now();
+            stageMs += std::chrono::duration<double, std::milli>(now - m_Mark).count();
+            m_Mark = now;
+        }
+    };
+#else
+    class LoadStats
+    {
+    public:
+        explicit LoadStats(_In_opt_z_ const wchar_t* = nullptr) noexcept {}
+
+        void EndOpen() noexcept {}
+        void EndRead() noexcept {}
+        void EndValidate() noexcept {}
+        void EndLayout() noexcept {}
+        void EndCreate() noexcept {}
+
+        void AddBytesRead(_In_ uint64_t) noexcept {}
+        void SetLZ4Frame() noexcept {}
+        void SetMapped() noexcept {}
+        void SetTexture(_In_ size_t, _In_ size_t, _In_ size_t, _In_ size_t, _In_ DXGI_FORMAT) noexcept {}
+        void Report(_In_ HRESULT) noexcept {}
+    };
+#endif
 
     template<UINT TNameLength>
     inline void SetDebugObjectName(_In_ ID3D11DeviceChild* resource, _In_ const char (&name)[TNameLength])
@@ -135,67 +166,85 @@ namespace
     }
 
     //--------------------------------------------------------------------------------------
-    HRESULT LoadTextureDataFromMemory(
-        _In_reads_(ddsDataSize) const uint8_t* ddsData,
-        size_t ddsDataSize,
+    // Where the file functions read from; the default is created on first use
+    std::atomic<IFileSource*> s_FileSource(nullptr);
+
+    IFileSource* GetFileSource() noexcept
+    {
+        IFileSource* source = s_FileSource.load(std::memory_order_acquire);
+        if (source)
+            return source;
+
+        static std::unique_ptr<IFileSource> s_DefaultSource = []() noexcept
+        {
+            std::unique_ptr<IFileSource> defaultSource;
+            (void)CreateDefaultFileSource(defaultSource);
+            return defaultSource;
+        }();
+        return s_DefaultSource.get();
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Decompresses a .dds.lz4 file into ddsData. Each block is read into a staging buffer
+    // of at most the frame's block size and decoded in place, so the compressed file is
+    // never held in memory as a whole.
+    //--------------------------------------------------------------------------------------
+    HRESULT LoadCompressedTextureDataFromFile(
+        _In_ IFileSourceFile* file,
+        std::unique_ptr<uint8_t[]>& ddsData,
         const DDS_HEADER** header,
         const uint8_t** bitData,
-        size_t* bitSize) noexcept
+        size_t* bitSize,
+        LoadStats& stats) noexcept
     {
-        if (!header || !bitData || !bitSize)
-        {
-            return E_POINTER;
-        }
+        stats.SetLZ4Frame();
 
-        if (ddsDataSize > UINT32_MAX)
+        FileSourceReader reader = { file, 0 };
+        LZ4FrameInfo info;
+        HRESULT hr = ReadLZ4FrameHeader(ReadFromFileSource, &reader, info);
+        if (FAILED(hr))
         {
-            return E_FAIL;
+            return hr;
         }
 
-        if (ddsDataSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+        // The buffer is allocated up front, so the frame has to say how big it is
+        if (info.contentSize == 0)
         {
-            return E_FAIL;
+            return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
         }
 
-        // DDS files always start with the same magic number ("DDS ")
-        auto dwMagicNumber = *reinterpret_cast<const uint32_t*>(ddsData);
-        if (dwMagicNumber != DDS_MAGIC)
+        // Same limit as uncompressed files
+        if (info.contentSize > UINT32_MAX)
         {
             return E_FAIL;
         }
 
-        auto hdr = reinterpret_cast<const DDS_HEADER*>(ddsData + sizeof(uint32_t));
+        auto size = static_cast<size_t>(info.contentSize);
 
-        // Verify header to validate DDS file
-        if (hdr->size != sizeof(DDS_HEADER) ||
-            hdr->ddspf.size != sizeof(DDS_PIXELFORMAT))
+        ddsData.reset(new (std::nothrow) uint8_t[size]);
+        if (!ddsData)
         {
-            return E_FAIL;
+            return E_OUTOFMEMORY;
         }
 
-        // Check for DX10 extension
-        bool bDXT10Header = false;
-        if ((hdr->ddspf.flags & DDS_FOURCC) &&
-            (MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
+        size_t decompressedSize = 0;
+        hr = DecompressLZ4Frame(ReadFromFileSource, &reader, info, ddsData.get(), size, &decompressedSize);
+        if (FAILED(hr))
         {
-            // Must be long enough for both headers and magic value
-            if (ddsDataSize < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
-            {
-                return E_FAIL;
-            }
+            return hr;
+        }
 
-            bDXT10Header = true;
+        if (decompressedSize < size)
+        {
+            return E_FAIL;
         }
 
-        // setup the pointers in the process request
-        *header = hdr;
-        auto offset = sizeof(uint32_t)
-            + sizeof(DDS_HEADER)
-            + (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
-        *bitData = ddsData + offset;
-        *bitSize = ddsDataSize - offset;
+        stats.AddBytesRead(reader.position);
+        stats.EndRead();
 
-        return S_OK;
+        hr = LoadTextureDataFromMemory(ddsData.get(), size, header, bitData, bitSize);
+        stats.EndValidate();
+        return hr;
     }
 
 
@@ -205,78 +254,90 @@ namespace
         std::unique_ptr<uint8_t[]>& ddsData,
         const DDS_HEADER** header,
         const uint8_t** bitData,
-        size_t* bitSize) noexcept
+        size_t* bitSize,
+        LoadStats& stats,
+        _Out_opt_ bool* isLZ4Frame = nullptr) noexcept
     {
         if (!header || !bitData || !bitSize)
         {
             return E_POINTER;
         }
 
-        // open the file
-#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
-        ScopedHandle hFile(safe_handle(CreateFile2(fileName,
-            GENERIC_READ,
-            FILE_SHARE_READ,
-            OPEN_EXISTING,
-            nullptr)));
-#else
-        ScopedHandle hFile(safe_handle(CreateFileW(fileName,
-            GENERIC_READ,
-            FILE_SHARE_READ,
-            nullptr,
-            OPEN_EXISTING,
-            FILE_ATTRIBUTE_NORMAL,
-            nullptr)));
-#endif
+        if (isLZ4Frame)
+        {
+            *isLZ4Frame = false;
+        }
+
+        IFileSource* source = GetFileSource();
+        if (!source)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        std::unique_ptr<IFileSourceFile> file;
+        HRESULT hr = source->Open(fileName, file);
+        stats.EndOpen();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
 
-        if (!hFile)
+        // Compressed files are told apart by their magic number rather than their extension
+        uint8_t magic[sizeof(uint32_t)] = {};
+        size_t magicRead = 0;
+        hr = file->Read(0, magic, sizeof(magic), &magicRead);
+        if (FAILED(hr))
         {
-            return HRESULT_FROM_WIN32(GetLastError());
+            return hr;
         }
 
-        // Get the file size
-        FILE_STANDARD_INFO fileInfo;
-        if (!GetFileInformationByHandleEx(hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+        if (IsLZ4Frame(magic, magicRead))
         {
-            return HRESULT_FROM_WIN32(GetLastError());
+            if (isLZ4Frame)
+            {
+                *isLZ4Frame = true;
+            }
+
+            return LoadCompressedTextureDataFromFile(file.get(), ddsData, header, bitData, bitSize, stats);
         }
 
         // File is too big for 32-bit allocation, so reject read
-        if (fileInfo.EndOfFile.HighPart > 0)
+        const uint64_t fileSize = file->GetSize();
+        if (fileSize > UINT32_MAX)
         {
             return E_FAIL;
         }
 
         // Need at least enough data to fill the header and magic number to be a valid DDS
-        if (fileInfo.EndOfFile.LowPart < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+        if (fileSize < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
         {
             return E_FAIL;
         }
 
         // create enough space for the file data
-        ddsData.reset(new (std::nothrow) uint8_t[fileInfo.EndOfFile.LowPart]);
+        const auto size = static_cast<size_t>(fileSize);
+        ddsData.reset(new (std::nothrow) uint8_t[size]);
         if (!ddsData)
         {
             return E_OUTOFMEMORY;
         }
 
         // read the data in
-        DWORD BytesRead = 0;
-        if (!ReadFile(hFile.get(),
-            ddsData.get(),
-            fileInfo.EndOfFile.LowPart,
-            &BytesRead,
-            nullptr
-        ))
+        size_t bytesRead = 0;
+        hr = file->Read(0, ddsData.get(), size, &bytesRead);
+        if (FAILED(hr))
         {
-            return HRESULT_FROM_WIN32(GetLastError());
+            return hr;
         }
 
-        if (BytesRead < fileInfo.EndOfFile.LowPart)
+        if (bytesRead < size)
         {
             return E_FAIL;
         }
 
+        stats.AddBytesRead(bytesRead);
+        stats.EndRead();
+
         // DDS files always start with the same magic number ("DDS ")
         auto dwMagicNumber = *reinterpret_cast<const uint32_t*>(ddsData.get());
         if (dwMagicNumber != DDS_MAGIC)
@@ -299,7 +360,7 @@ namespace
             (MAKEFOURCC('D', 'X', '1', '0') == hdr->ddspf.fourCC))
         {
             // Must be long enough for both headers and magic value
-            if (fileInfo.EndOfFile.LowPart < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
+            if (size < (sizeof(DDS_HEADER) + sizeof(uint32_t) + sizeof(DDS_HEADER_DXT10)))
             {
                 return E_FAIL;
             }
@@ -312,775 +373,130 @@ namespace
         auto offset = sizeof(uint32_t) + sizeof(DDS_HEADER)
             + (bDXT10Header ? sizeof(DDS_HEADER_DXT10) : 0);
         *bitData = ddsData.get() + offset;
-        *bitSize = fileInfo.EndOfFile.LowPart - offset;
+        *bitSize = size - offset;
 
+        stats.EndValidate();
         return S_OK;
     }
 
 
     //--------------------------------------------------------------------------------------
-    // Return the BPP for a particular format
+    // Maps the whole file read-only so the subresource data can point straight into the
+    // view instead of a heap copy. The view is released when ddsData is closed or destroyed.
     //--------------------------------------------------------------------------------------
-    size_t BitsPerPixel(_In_ DXGI_FORMAT fmt) noexcept
-    {
-        switch (fmt)
-        {
-        case DXGI_FORMAT_R32G32B32A32_TYPELESS:
-        case DXGI_FORMAT_R32G32B32A32_FLOAT:
-        case DXGI_FORMAT_R32G32B32A32_UINT:
-        case DXGI_FORMAT_R32G32B32A32_SINT:
-            return 128;
-
-        case DXGI_FORMAT_R32G32B32_TYPELESS:
-        case DXGI_FORMAT_R32G32B32_FLOAT:
-        case DXGI_FORMAT_R32G32B32_UINT:
-        case DXGI_FORMAT_R32G32B32_SINT:
-            return 96;
-
-        case DXGI_FORMAT_R16G16B16A16_TYPELESS:
-        case DXGI_FORMAT_R16G16B16A16_FLOAT:
-        case DXGI_FORMAT_R16G16B16A16_UNORM:
-        case DXGI_FORMAT_R16G16B16A16_UINT:
-        case DXGI_FORMAT_R16G16B16A16_SNORM:
-        case DXGI_FORMAT_R16G16B16A16_SINT:
-        case DXGI_FORMAT_R32G32_TYPELESS:
-        case DXGI_FORMAT_R32G32_FLOAT:
-        case DXGI_FORMAT_R32G32_UINT:
-        case DXGI_FORMAT_R32G32_SINT:
-        case DXGI_FORMAT_R32G8X24_TYPELESS:
-        case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
-        case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
-        case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
-        case DXGI_FORMAT_Y416:
-        case DXGI_FORMAT_Y210:
-        case DXGI_FORMAT_Y216:
-            return 64;
-
-        case DXGI_FORMAT_R10G10B10A2_TYPELESS:
-        case DXGI_FORMAT_R10G10B10A2_UNORM:
-        case DXGI_FORMAT_R10G10B10A2_UINT:
-        case DXGI_FORMAT_R11G11B10_FLOAT:
-        case DXGI_FORMAT_R8G8B8A8_TYPELESS:
-        case DXGI_FORMAT_R8G8B8A8_UNORM:
-        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
-        case DXGI_FORMAT_R8G8B8A8_UINT:
-        case DXGI_FORMAT_R8G8B8A8_SNORM:
-        case DXGI_FORMAT_R8G8B8A8_SINT:
-        case DXGI_FORMAT_R16G16_TYPELESS:
-        case DXGI_FORMAT_R16G16_FLOAT:
-        case DXGI_FORMAT_R16G16_UNORM:
-        case DXGI_FORMAT_R16G16_UINT:
-        case DXGI_FORMAT_R16G16_SNORM:
-        case DXGI_FORMAT_R16G16_SINT:
-        case DXGI_FORMAT_R32_TYPELESS:
-        case DXGI_FORMAT_D32_FLOAT:
-        case DXGI_FORMAT_R32_FLOAT:
-        case DXGI_FORMAT_R32_UINT:
-        case DXGI_FORMAT_R32_SINT:
-        case DXGI_FORMAT_R24G8_TYPELESS:
-        case DXGI_FORMAT_D24_UNORM_S8_UINT:
-        case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
-        case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
-        case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
-        case DXGI_FORMAT_R8G8_B8G8_UNORM:
-        case DXGI_FORMAT_G8R8_G8B8_UNORM:
-        case DXGI_FORMAT_B8G8R8A8_UNORM:
-        case DXGI_FORMAT_B8G8R8X8_UNORM:
-        case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
-        case DXGI_FORMAT_B8G8R8A8_TYPELESS:
-        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
-        case DXGI_FORMAT_B8G8R8X8_TYPELESS:
-        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
-        case DXGI_FORMAT_AYUV:
-        case DXGI_FORMAT_Y410:
-        case DXGI_FORMAT_YUY2:
-            return 32;
-
-        case DXGI_FORMAT_P010:
-        case DXGI_FORMAT_P016:
-            return 24;
-
-        case DXGI_FORMAT_R8G8_TYPELESS:
-        case DXGI_FORMAT_R8G8_UNORM:
-        case DXGI_FORMAT_R8G8_UINT:
-        case DXGI_FORMAT_R8G8_SNORM:
-        case DXGI_FORMAT_R8G8_SINT:
-        case DXGI_FORMAT_R16_TYPELESS:
-        case DXGI_FORMAT_R16_FLOAT:
-        case DXGI_FORMAT_D16_UNORM:
-        case DXGI_FORMAT_R16_UNORM:
-        case DXGI_FORMAT_R16_UINT:
-        case DXGI_FORMAT_R16_SNORM:
-        case DXGI_FORMAT_R16_SINT:
-        case DXGI_FORMAT_B5G6R5_UNORM:
-        case DXGI_FORMAT_B5G5R5A1_UNORM:
-        case DXGI_FORMAT_A8P8:
-        case DXGI_FORMAT_B4G4R4A4_UNORM:
-            return 16;
-
-        case DXGI_FORMAT_NV12:
-        case DXGI_FORMAT_420_OPAQUE:
-        case DXGI_FORMAT_NV11:
-            return 12;
-
-        case DXGI_FORMAT_R8_TYPELESS:
-        case DXGI_FORMAT_R8_UNORM:
-        case DXGI_FORMAT_R8_UINT:
-        case DXGI_FORMAT_R8_SNORM:
-        case DXGI_FORMAT_R8_SINT:
-        case DXGI_FORMAT_A8_UNORM:
-        case DXGI_FORMAT_AI44:
-        case DXGI_FORMAT_IA44:
-        case DXGI_FORMAT_P8:
-            return 8;
-
-        case DXGI_FORMAT_R1_UNORM:
-            return 1;
-
-        case DXGI_FORMAT_BC1_TYPELESS:
-        case DXGI_FORMAT_BC1_UNORM:
-        case DXGI_FORMAT_BC1_UNORM_SRGB:
-        case DXGI_FORMAT_BC4_TYPELESS:
-        case DXGI_FORMAT_BC4_UNORM:
-        case DXGI_FORMAT_BC4_SNORM:
-            return 4;
-
-        case DXGI_FORMAT_BC2_TYPELESS:
-        case DXGI_FORMAT_BC2_UNORM:
-        case DXGI_FORMAT_BC2_UNORM_SRGB:
-        case DXGI_FORMAT_BC3_TYPELESS:
-        case DXGI_FORMAT_BC3_UNORM:
-        case DXGI_FORMAT_BC3_UNORM_SRGB:
-        case DXGI_FORMAT_BC5_TYPELESS:
-        case DXGI_FORMAT_BC5_UNORM:
-        case DXGI_FORMAT_BC5_SNORM:
-        case DXGI_FORMAT_BC6H_TYPELESS:
-        case DXGI_FORMAT_BC6H_UF16:
-        case DXGI_FORMAT_BC6H_SF16:
-        case DXGI_FORMAT_BC7_TYPELESS:
-        case DXGI_FORMAT_BC7_UNORM:
-        case DXGI_FORMAT_BC7_UNORM_SRGB:
-            return 8;
+    HRESULT MapTextureDataFromFile(
+        _In_z_ const wchar_t* fileName,
+        FileMapping& ddsData) noexcept
+    {
+        HRESULT hr = ddsData.Open(fileName);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
 
-        default:
-            return 0;
+        // File is too big for 32-bit allocation, so reject read
+        // Need at least enough data to fill the header and magic number to be a valid DDS
+        if (ddsData.GetSize() > UINT32_MAX || ddsData.GetSize() < (sizeof(uint32_t) + sizeof(DDS_HEADER)))
+        {
+            ddsData.Close();
+            return E_FAIL;
         }
+
+        return S_OK;
     }
 
 
     //--------------------------------------------------------------------------------------
-    // Get surface information for a particular format
-    //--------------------------------------------------------------------------------------
-    HRESULT GetSurfaceInfo(
+    HRESULT CreateD3DResources(
+        _In_ ID3D11Device* d3dDevice,
+        _In_ uint32_t resDim,
         _In_ size_t width,
         _In_ size_t height,
-        _In_ DXGI_FORMAT fmt,
-        size_t* outNumBytes,
-        _Out_opt_ size_t* outRowBytes,
-        _Out_opt_ size_t* outNumRows) noexcept
-    {
-        uint64_t numBytes = 0;
-        uint64_t rowBytes = 0;
-        uint64_t numRows = 0;
-
-        bool bc = false;
-        bool packed = false;
-        bool planar = false;
-        size_t bpe = 0;
-        switch (fmt)
-        {
-        case DXGI_FORMAT_BC1_TYPELESS:
-        case DXGI_FORMAT_BC1_UNORM:
-        case DXGI_FORMAT_BC1_UNORM_SRGB:
-        case DXGI_FORMAT_BC4_TYPELESS:
-        case DXGI_FORMAT_BC4_UNORM:
-        case DXGI_FORMAT_BC4_SNORM:
-            bc = true;
-            bpe = 8;
-            break;
-
-        case DXGI_FORMAT_BC2_TYPELESS:
-        case DXGI_FORMAT_BC2_UNORM:
-        case DXGI_FORMAT_BC2_UNORM_SRGB:
-        case DXGI_FORMAT_BC3_TYPELESS:
-        case DXGI_FORMAT_BC3_UNORM:
-        case DXGI_FORMAT_BC3_UNORM_SRGB:
-        case DXGI_FORMAT_BC5_TYPELESS:
-        case DXGI_FORMAT_BC5_UNORM:
-        case DXGI_FORMAT_BC5_SNORM:
-        case DXGI_FORMAT_BC6H_TYPELESS:
-        case DXGI_FORMAT_BC6H_UF16:
-        case DXGI_FORMAT_BC6H_SF16:
-        case DXGI_FORMAT_BC7_TYPELESS:
-        case DXGI_FORMAT_BC7_UNORM:
-        case DXGI_FORMAT_BC7_UNORM_SRGB:
-            bc = true;
-            bpe = 16;
-            break;
-
-        case DXGI_FORMAT_R8G8_B8G8_UNORM:
-        case DXGI_FORMAT_G8R8_G8B8_UNORM:
-        case DXGI_FORMAT_YUY2:
-            packed = true;
-            bpe = 4;
-            break;
-
-        case DXGI_FORMAT_Y210:
-        case DXGI_FORMAT_Y216:
-            packed = true;
-            bpe = 8;
-            break;
-
-        case DXGI_FORMAT_NV12:
-        case DXGI_FORMAT_420_OPAQUE:
-            planar = true;
-            bpe = 2;
-            break;
-
-        case DXGI_FORMAT_P010:
-        case DXGI_FORMAT_P016:
-            planar = true;
-            bpe = 4;
-            break;
+        _In_ size_t depth,
+        _In_ size_t mipCount,
+        _In_ size_t arraySize,
+        _In_ DXGI_FORMAT format,
+        _In_ D3D11_USAGE usage,
+        _In_ unsigned int bindFlags,
+        _In_ unsigned int cpuAccessFlags,
+        _In_ unsigned int miscFlags,
+        _In_ bool forceSRGB,
+        _In_ bool isCubeMap,
+        _In_reads_opt_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData,
+        _Outptr_opt_ ID3D11Resource** texture,
+        _Outptr_opt_ ID3D11ShaderResourceView** textureView) noexcept
+    {
+        if (!d3dDevice)
+            return E_POINTER;
 
-        default:
-            break;
-        }
+        HRESULT hr = E_FAIL;
 
-        if (bc)
-        {
-            uint64_t numBlocksWide = 0;
-            if (width > 0)
-            {
-                numBlocksWide = std::max<uint64_t>(1u, (uint64_t(width) + 3u) / 4u);
-            }
-            uint64_t numBlocksHigh = 0;
-            if (height > 0)
-            {
-                numBlocksHigh = std::max<uint64_t>(1u, (uint64_t(height) + 3u) / 4u);
-            }
-            rowBytes = numBlocksWide * bpe;
-            numRows = numBlocksHigh;
-            numBytes = rowBytes * numBlocksHigh;
-        }
-        else if (packed)
-        {
-            rowBytes = ((uint64_t(width) + 1u) >> 1) * bpe;
-            numRows = uint64_t(height);
-            numBytes = rowBytes * height;
-        }
-        else if (fmt == DXGI_FORMAT_NV11)
-        {
-            rowBytes = ((uint64_t(width) + 3u) >> 2) * 4u;
-            numRows = uint64_t(height) * 2u; // Direct3D makes this simplifying assumption, although it is larger than the 4:1:1 data
-            numBytes = rowBytes * numRows;
-        }
-        else if (planar)
-        {
-            rowBytes = ((uint64_t(width) + 1u) >> 1) * bpe;
-            numBytes = (rowBytes * uint64_t(height)) + ((rowBytes * uint64_t(height) + 1u) >> 1);
-            numRows = height + ((uint64_t(height) + 1u) >> 1);
-        }
-        else
+        if (forceSRGB)
         {
-            size_t bpp = BitsPerPixel(fmt);
-            if (!bpp)
-                return E_INVALIDARG;
-
-            rowBytes = (uint64_t(width) * bpp + 7u) / 8u; // round up to nearest byte
-            numRows = uint64_t(height);
-            numBytes = rowBytes * height;
+            format = MakeSRGB(format);
         }
 
-#if defined(_M_IX86) || defined(_M_ARM) || defined(_M_HYBRID_X86_ARM64)
-        static_assert(sizeof(size_t) == 4, "Not a 32-bit platform!");
-        if (numBytes > UINT32_MAX || rowBytes > UINT32_MAX || numRows > UINT32_MAX)
-            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
-#else
-        static_assert(sizeof(size_t) == 8, "Not a 64-bit platform!");
-#endif
-
-        if (outNumBytes)
-        {
-            *outNumBytes = static_cast<size_t>(numBytes);
-        }
-        if (outRowBytes)
-        {
-            *outRowBytes = static_cast<size_t>(rowBytes);
-        }
-        if (outNumRows)
+        switch (resDim)
         {
-            *outNumRows = static_cast<size_t>(numRows);
-        }
-
-        return S_OK;
-    }
-
-
-    //--------------------------------------------------------------------------------------
-    #define ISBITMASK( r,g,b,a ) ( ddpf.RBitMask == r && ddpf.GBitMask == g && ddpf.BBitMask == b && ddpf.ABitMask == a )
-
-    DXGI_FORMAT GetDXGIFormat(const DDS_PIXELFORMAT& ddpf) noexcept
-    {
-        if (ddpf.flags & DDS_RGB)
+        case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
         {
-            // Note that sRGB formats are written using the "DX10" extended header
+            D3D11_TEXTURE1D_DESC desc;
+            desc.Width = static_cast<UINT>(width);
+            desc.MipLevels = static_cast<UINT>(mipCount);
+            desc.ArraySize = static_cast<UINT>(arraySize);
+            desc.Format = format;
+            desc.Usage = usage;
+            desc.BindFlags = bindFlags;
+            desc.CPUAccessFlags = cpuAccessFlags;
+            desc.MiscFlags = miscFlags & ~static_cast<unsigned int>(D3D11_RESOURCE_MISC_TEXTURECUBE);
 
-            switch (ddpf.RGBBitCount)
+            ID3D11Texture1D* tex = nullptr;
+            hr = d3dDevice->CreateTexture1D(&desc,
+                initData,
+                &tex
+            );
+            if (SUCCEEDED(hr) && tex)
             {
-            case 32:
-                if (ISBITMASK(0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
-                {
-                    return DXGI_FORMAT_R8G8B8A8_UNORM;
-                }
-
-                if (ISBITMASK(0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
-                {
-                    return DXGI_FORMAT_B8G8R8A8_UNORM;
-                }
-
-                if (ISBITMASK(0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000))
-                {
-                    return DXGI_FORMAT_B8G8R8X8_UNORM;
-                }
-
-                // No DXGI format maps to ISBITMASK(0x000000ff,0x0000ff00,0x00ff0000,0x00000000) aka D3DFMT_X8B8G8R8
-
-                // Note that many common DDS reader/writers (including D3DX) swap the
-                // the RED/BLUE masks for 10:10:10:2 formats. We assume
-                // below that the 'backwards' header mask is being used since it is most
-                // likely written by D3DX. The more robust solution is to use the 'DX10'
-                // header extension and specify the DXGI_FORMAT_R10G10B10A2_UNORM format directly
-
-                // For 'correct' writers, this should be 0x000003ff,0x000ffc00,0x3ff00000 for RGB data
-                if (ISBITMASK(0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000))
+                if (textureView)
                 {
-                    return DXGI_FORMAT_R10G10B10A2_UNORM;
-                }
-
-                // No DXGI format maps to ISBITMASK(0x000003ff,0x000ffc00,0x3ff00000,0xc0000000) aka D3DFMT_A2R10G10B10
+                    D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
+                    SRVDesc.Format = format;
 
-                if (ISBITMASK(0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
-                {
-                    return DXGI_FORMAT_R16G16_UNORM;
-                }
+                    if (arraySize > 1)
+                    {
+                        SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE1DARRAY;
+                        SRVDesc.Texture1DArray.MipLevels = (!mipCount) ? UINT(-1) : desc.MipLevels;
+                        SRVDesc.Texture1DArray.ArraySize = static_cast<UINT>(arraySize);
+                    }
+                    else
+                    {
+                        SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE1D;
+                        SRVDesc.Texture1D.MipLevels = (!mipCount) ? UINT(-1) : desc.MipLevels;
+                    }
 
-                if (ISBITMASK(0xffffffff, 0x00000000, 0x00000000, 0x00000000))
-                {
-                    // Only 32-bit color channel format in D3D9 was R32F
-                    return DXGI_FORMAT_R32_FLOAT; // D3DX writes this out as a FourCC of 114
+                    hr = d3dDevice->CreateShaderResourceView(tex,
+                        &SRVDesc,
+                        textureView
+                    );
+                    if (FAILED(hr))
+                    {
+                        tex->Release();
+                        return hr;
+                    }
                 }
-                break;
-
-            case 24:
-                // No 24bpp DXGI formats aka D3DFMT_R8G8B8
-                break;
 
-            case 16:
-                if (ISBITMASK(0x7c00, 0x03e0, 0x001f, 0x8000))
-                {
-                    return DXGI_FORMAT_B5G5R5A1_UNORM;
-                }
-                if (ISBITMASK(0xf800, 0x07e0, 0x001f, 0x0000))
+                if (texture)
                 {
-                    return DXGI_FORMAT_B5G6R5_UNORM;
+                    *texture = tex;
                 }
-
-                // No DXGI format maps to ISBITMASK(0x7c00,0x03e0,0x001f,0x0000) aka D3DFMT_X1R5G5B5
-
-                if (ISBITMASK(0x0f00, 0x00f0, 0x000f, 0xf000))
+                else
                 {
-                    return DXGI_FORMAT_B4G4R4A4_UNORM;
+                    SetDebugObjectName(tex, "DDSTextureLoader");
+                    tex->Release();
                 }
-
-                // No DXGI format maps to ISBITMASK(0x0f00,0x00f0,0x000f,0x0000) aka D3DFMT_X4R4G4B4
-
-                // No 3:3:2, 3:3:2:8, or paletted DXGI formats aka D3DFMT_A8R3G3B2, D3DFMT_R3G3B2, D3DFMT_P8, D3DFMT_A8P8, etc.
-                break;
             }
         }
-        else if (ddpf.flags & DDS_LUMINANCE)
-        {
-            if (8 == ddpf.RGBBitCount)
-            {
-                if (ISBITMASK(0x000000ff, 0x00000000, 0x00000000, 0x00000000))
-                {
-                    return DXGI_FORMAT_R8_UNORM; // D3DX10/11 writes this out as DX10 extension
-                }
-
-                // No DXGI format maps to ISBITMASK(0x0f,0x00,0x00,0xf0) aka D3DFMT_A4L4
-
-                if (ISBITMASK(0x000000ff, 0x00000000, 0x00000000, 0x0000ff00))
-                {
-                    return DXGI_FORMAT_R8G8_UNORM; // Some DDS writers assume the bitcount should be 8 instead of 16
-                }
-            }
-
-            if (16 == ddpf.RGBBitCount)
-            {
-                if (ISBITMASK(0x0000ffff, 0x00000000, 0x00000000, 0x00000000))
-                {
-                    return DXGI_FORMAT_R16_UNORM; // D3DX10/11 writes this out as DX10 extension
-                }
-                if (ISBITMASK(0x000000ff, 0x00000000, 0x00000000, 0x0000ff00))
-                {
-                    return DXGI_FORMAT_R8G8_UNORM; // D3DX10/11 writes this out as DX10 extension
-                }
-            }
-        }
-        else if (ddpf.flags & DDS_ALPHA)
-        {
-            if (8 == ddpf.RGBBitCount)
-            {
-                return DXGI_FORMAT_A8_UNORM;
-            }
-        }
-        else if (ddpf.flags & DDS_BUMPDUDV)
-        {
-            if (16 == ddpf.RGBBitCount)
-            {
-                if (ISBITMASK(0x00ff, 0xff00, 0x0000, 0x0000))
-                {
-                    return DXGI_FORMAT_R8G8_SNORM; // D3DX10/11 writes this out as DX10 extension
-                }
-            }
-
-            if (32 == ddpf.RGBBitCount)
-            {
-                if (ISBITMASK(0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
-                {
-                    return DXGI_FORMAT_R8G8B8A8_SNORM; // D3DX10/11 writes this out as DX10 extension
-                }
-                if (ISBITMASK(0x0000ffff, 0xffff0000, 0x00000000, 0x00000000))
-                {
-                    return DXGI_FORMAT_R16G16_SNORM; // D3DX10/11 writes this out as DX10 extension
-                }
-
-                // No DXGI format maps to ISBITMASK(0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000) aka D3DFMT_A2W10V10U10
-            }
-        }
-        else if (ddpf.flags & DDS_FOURCC)
-        {
-            if (MAKEFOURCC('D', 'X', 'T', '1') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC1_UNORM;
-            }
-            if (MAKEFOURCC('D', 'X', 'T', '3') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC2_UNORM;
-            }
-            if (MAKEFOURCC('D', 'X', 'T', '5') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC3_UNORM;
-            }
-
-            // While pre-multiplied alpha isn't directly supported by the DXGI formats,
-            // they are basically the same as these BC formats so they can be mapped
-            if (MAKEFOURCC('D', 'X', 'T', '2') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC2_UNORM;
-            }
-            if (MAKEFOURCC('D', 'X', 'T', '4') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC3_UNORM;
-            }
-
-            if (MAKEFOURCC('A', 'T', 'I', '1') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC4_UNORM;
-            }
-            if (MAKEFOURCC('B', 'C', '4', 'U') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC4_UNORM;
-            }
-            if (MAKEFOURCC('B', 'C', '4', 'S') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC4_SNORM;
-            }
-
-            if (MAKEFOURCC('A', 'T', 'I', '2') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC5_UNORM;
-            }
-            if (MAKEFOURCC('B', 'C', '5', 'U') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC5_UNORM;
-            }
-            if (MAKEFOURCC('B', 'C', '5', 'S') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_BC5_SNORM;
-            }
-
-            // BC6H and BC7 are written using the "DX10" extended header
-
-            if (MAKEFOURCC('R', 'G', 'B', 'G') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_R8G8_B8G8_UNORM;
-            }
-            if (MAKEFOURCC('G', 'R', 'G', 'B') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_G8R8_G8B8_UNORM;
-            }
-
-            if (MAKEFOURCC('Y', 'U', 'Y', '2') == ddpf.fourCC)
-            {
-                return DXGI_FORMAT_YUY2;
-            }
-
-            // Check for D3DFORMAT enums being set here
-            switch (ddpf.fourCC)
-            {
-            case 36: // D3DFMT_A16B16G16R16
-                return DXGI_FORMAT_R16G16B16A16_UNORM;
-
-            case 110: // D3DFMT_Q16W16V16U16
-                return DXGI_FORMAT_R16G16B16A16_SNORM;
-
-            case 111: // D3DFMT_R16F
-                return DXGI_FORMAT_R16_FLOAT;
-
-            case 112: // D3DFMT_G16R16F
-                return DXGI_FORMAT_R16G16_FLOAT;
-
-            case 113: // D3DFMT_A16B16G16R16F
-                return DXGI_FORMAT_R16G16B16A16_FLOAT;
-
-            case 114: // D3DFMT_R32F
-                return DXGI_FORMAT_R32_FLOAT;
-
-            case 115: // D3DFMT_G32R32F
-                return DXGI_FORMAT_R32G32_FLOAT;
-
-            case 116: // D3DFMT_A32B32G32R32F
-                return DXGI_FORMAT_R32G32B32A32_FLOAT;
-            }
-        }
-
-        return DXGI_FORMAT_UNKNOWN;
-    }
-
-
-    //--------------------------------------------------------------------------------------
-    DXGI_FORMAT MakeSRGB(_In_ DXGI_FORMAT format) noexcept
-    {
-        switch (format)
-        {
-        case DXGI_FORMAT_R8G8B8A8_UNORM:
-            return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
-
-        case DXGI_FORMAT_BC1_UNORM:
-            return DXGI_FORMAT_BC1_UNORM_SRGB;
-
-        case DXGI_FORMAT_BC2_UNORM:
-            return DXGI_FORMAT_BC2_UNORM_SRGB;
-
-        case DXGI_FORMAT_BC3_UNORM:
-            return DXGI_FORMAT_BC3_UNORM_SRGB;
-
-        case DXGI_FORMAT_B8G8R8A8_UNORM:
-            return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
-
-        case DXGI_FORMAT_B8G8R8X8_UNORM:
-            return DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
-
-        case DXGI_FORMAT_BC7_UNORM:
-            return DXGI_FORMAT_BC7_UNORM_SRGB;
-
-        default:
-            return format;
-        }
-    }
-
-
-    //--------------------------------------------------------------------------------------
-    HRESULT FillInitData(
-        _In_ size_t width,
-        _In_ size_t height,
-        _In_ size_t depth,
-        _In_ size_t mipCount,
-        _In_ size_t arraySize,
-        _In_ DXGI_FORMAT format,
-        _In_ size_t maxsize,
-        _In_ size_t bitSize,
-        _In_reads_bytes_(bitSize) const uint8_t* bitData,
-        _Out_ size_t& twidth,
-        _Out_ size_t& theight,
-        _Out_ size_t& tdepth,
-        _Out_ size_t& skipMip,
-        _Out_writes_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData) noexcept
-    {
-        if (!bitData || !initData)
-        {
-            return E_POINTER;
-        }
-
-        skipMip = 0;
-        twidth = 0;
-        theight = 0;
-        tdepth = 0;
-
-        size_t NumBytes = 0;
-        size_t RowBytes = 0;
-        const uint8_t* pSrcBits = bitData;
-        const uint8_t* pEndBits = bitData + bitSize;
-
-        size_t index = 0;
-        for (size_t j = 0; j < arraySize; j++)
-        {
-            size_t w = width;
-            size_t h = height;
-            size_t d = depth;
-            for (size_t i = 0; i < mipCount; i++)
-            {
-                HRESULT hr = GetSurfaceInfo(w, h, format, &NumBytes, &RowBytes, nullptr);
-                if (FAILED(hr))
-                    return hr;
-
-                if (NumBytes > UINT32_MAX || RowBytes > UINT32_MAX)
-                    return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
-
-                if ((mipCount <= 1) || !maxsize || (w <= maxsize && h <= maxsize && d <= maxsize))
-                {
-                    if (!twidth)
-                    {
-                        twidth = w;
-                        theight = h;
-                        tdepth = d;
-                    }
-
-                    assert(index < mipCount * arraySize);
-                    _Analysis_assume_(index < mipCount * arraySize);
-                    initData[index].pSysMem = pSrcBits;
-                    initData[index].SysMemPitch = static_cast<UINT>(RowBytes);
-                    initData[index].SysMemSlicePitch = static_cast<UINT>(NumBytes);
-                    ++index;
-                }
-                else if (!j)
-                {
-                    // Count number of skipped mipmaps (first item only)
-                    ++skipMip;
-                }
-
-                if (pSrcBits + (NumBytes*d) > pEndBits)
-                {
-                    return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
-                }
-
-                pSrcBits += NumBytes * d;
-
-                w = w >> 1;
-                h = h >> 1;
-                d = d >> 1;
-                if (w == 0)
-                {
-                    w = 1;
-                }
-                if (h == 0)
-                {
-                    h = 1;
-                }
-                if (d == 0)
-                {
-                    d = 1;
-                }
-            }
-        }
-
-        return (index > 0) ? S_OK : E_FAIL;
-    }
-
-
-    //--------------------------------------------------------------------------------------
-    HRESULT CreateD3DResources(
-        _In_ ID3D11Device* d3dDevice,
-        _In_ uint32_t resDim,
-        _In_ size_t width,
-        _In_ size_t height,
-        _In_ size_t depth,
-        _In_ size_t mipCount,
-        _In_ size_t arraySize,
-        _In_ DXGI_FORMAT format,
-        _In_ D3D11_USAGE usage,
-        _In_ unsigned int bindFlags,
-        _In_ unsigned int cpuAccessFlags,
-        _In_ unsigned int miscFlags,
-        _In_ bool forceSRGB,
-        _In_ bool isCubeMap,
-        _In_reads_opt_(mipCount*arraySize) D3D11_SUBRESOURCE_DATA* initData,
-        _Outptr_opt_ ID3D11Resource** texture,
-        _Outptr_opt_ ID3D11ShaderResourceView** textureView) noexcept
-    {
-        if (!d3dDevice)
-            return E_POINTER;
-
-        HRESULT hr = E_FAIL;
-
-        if (forceSRGB)
-        {
-            format = MakeSRGB(format);
-        }
-
-        switch (resDim)
-        {
-        case D3D11_RESOURCE_DIMENSION_TEXTURE1D:
-        {
-            D3D11_TEXTURE1D_DESC desc;
-            desc.Width = static_cast<UINT>(width);
-            desc.MipLevels = static_cast<UINT>(mipCount);
-            desc.ArraySize = static_cast<UINT>(arraySize);
-            desc.Format = format;
-            desc.Usage = usage;
-            desc.BindFlags = bindFlags;
-            desc.CPUAccessFlags = cpuAccessFlags;
-            desc.MiscFlags = miscFlags & ~static_cast<unsigned int>(D3D11_RESOURCE_MISC_TEXTURECUBE);
-
-            ID3D11Texture1D* tex = nullptr;
-            hr = d3dDevice->CreateTexture1D(&desc,
-                initData,
-                &tex
-            );
-            if (SUCCEEDED(hr) && tex)
-            {
-                if (textureView)
-                {
-                    D3D11_SHADER_RESOURCE_VIEW_DESC SRVDesc = {};
-                    SRVDesc.Format = format;
-
-                    if (arraySize > 1)
-                    {
-                        SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE1DARRAY;
-                        SRVDesc.Texture1DArray.MipLevels = (!mipCount) ? UINT(-1) : desc.MipLevels;
-                        SRVDesc.Texture1DArray.ArraySize = static_cast<UINT>(arraySize);
-                    }
-                    else
-                    {
-                        SRVDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE1D;
-                        SRVDesc.Texture1D.MipLevels = (!mipCount) ? UINT(-1) : desc.MipLevels;
-                    }
-
-                    hr = d3dDevice->CreateShaderResourceView(tex,
-                        &SRVDesc,
-                        textureView
-                    );
-                    if (FAILED(hr))
-                    {
-                        tex->Release();
-                        return hr;
-                    }
-                }
-
-                if (texture)
-                {
-                    *texture = tex;
-                }
-                else
-                {
-                    SetDebugObjectName(tex, "DDSTextureLoader");
-                    tex->Release();
-                }
-            }
-        }
-        break;
+        break;
 
         case D3D11_RESOURCE_DIMENSION_TEXTURE2D:
         {
@@ -1225,30 +641,53 @@ namespace
     }
 
     //--------------------------------------------------------------------------------------
-    HRESULT CreateTextureFromDDS(
-        _In_ ID3D11Device* d3dDevice,
-        _In_opt_ ID3D11DeviceContext* d3dContext,
-        _In_ const DDS_HEADER* header,
-        _In_reads_bytes_(bitSize) const uint8_t* bitData,
-        _In_ size_t bitSize,
-        _In_ size_t maxsize,
-        _In_ D3D11_USAGE usage,
-        _In_ unsigned int bindFlags,
-        _In_ unsigned int cpuAccessFlags,
-        _In_ unsigned int miscFlags,
-        _In_ bool forceSRGB,
-        _Outptr_opt_ ID3D11Resource** texture,
-        _Outptr_opt_ ID3D11ShaderResourceView** textureView) noexcept
+    DDS_ALPHA_MODE GetAlphaMode(_In_ const DDS_HEADER* header) noexcept
     {
-        HRESULT hr = S_OK;
-
-        UINT width = header->width;
-        UINT height = header->height;
-        UINT depth = header->depth;
-
-        uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
-        UINT arraySize = 1;
-        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        if (header->ddspf.flags & DDS_FOURCC)
+        {
+            if (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC)
+            {
+                auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(reinterpret_cast<const uint8_t*>(header) + sizeof(DDS_HEADER));
+                auto mode = static_cast<DDS_ALPHA_MODE>(d3d10ext->miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK);
+                switch (mode)
+                {
+                case DDS_ALPHA_MODE_STRAIGHT:
+                case DDS_ALPHA_MODE_PREMULTIPLIED:
+                case DDS_ALPHA_MODE_OPAQUE:
+                case DDS_ALPHA_MODE_CUSTOM:
+                    return mode;
+
+                case DDS_ALPHA_MODE_UNKNOWN:
+                default:
+                    break;
+                }
+            }
+            else if ((MAKEFOURCC('D', 'X', 'T', '2') == header->ddspf.fourCC)
+                || (MAKEFOURCC('D', 'X', 'T', '4') == header->ddspf.fourCC))
+            {
+                return DDS_ALPHA_MODE_PREMULTIPLIED;
+            }
+        }
+
+        return DDS_ALPHA_MODE_UNKNOWN;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Interpret and validate the header without touching the pixel data
+    //--------------------------------------------------------------------------------------
+    HRESULT GetTextureDescFromDDS(
+        _In_ const DDS_HEADER* header,
+        _Out_ DDSTextureDesc& desc) noexcept
+    {
+        desc = {};
+
+        UINT width = header->width;
+        UINT height = header->height;
+        UINT depth = header->depth;
+
+        uint32_t resDim = D3D11_RESOURCE_DIMENSION_UNKNOWN;
+        UINT arraySize = 1;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
         bool isCubeMap = false;
 
         size_t mipCount = header->mipMapCount;
@@ -1327,6 +766,13 @@ namespace
         {
             format = GetDXGIFormat(header->ddspf);
 
+            // Layouts no DXGI format has are converted into one as they load
+            if (format == DXGI_FORMAT_UNKNOWN)
+            {
+                desc.legacyFormat = GetLegacyFormat(header->ddspf);
+                format = GetLegacyConvertedFormat(desc.legacyFormat);
+            }
+
             if (format == DXGI_FORMAT_UNKNOWN)
             {
                 return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
@@ -1408,6 +854,280 @@ namespace
             return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
         }
 
+        desc.resDim = static_cast<D3D11_RESOURCE_DIMENSION>(resDim);
+        desc.width = width;
+        desc.height = height;
+        desc.depth = depth;
+        desc.mipCount = mipCount;
+        desc.arraySize = arraySize;
+        desc.format = format;
+        desc.isCubeMap = isCubeMap;
+        desc.alphaMode = GetAlphaMode(header);
+        desc.dataOffset = sizeof(uint32_t) + sizeof(DDS_HEADER)
+            + ((header->ddspf.flags & DDS_FOURCC) && (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC) ? sizeof(DDS_HEADER_DXT10) : 0);
+
+        return S_OK;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Converts the pixels of a file saved in a layout no DXGI format has into desc.format,
+    // every subresource in the order of the file, so the rest of the load treats the
+    // result like any other file. Returns S_FALSE, leaving convertedData empty, for files
+    // that load as they are.
+    HRESULT ConvertLegacyData(
+        _In_ const DDSTextureDesc& desc,
+        _In_reads_bytes_(bitSize) const uint8_t* bitData,
+        _In_ size_t bitSize,
+        _Out_ std::unique_ptr<uint8_t[]>& convertedData,
+        _Out_ size_t& convertedSize) noexcept
+    {
+        convertedData.reset();
+        convertedSize = 0;
+
+        if (desc.legacyFormat == LegacyFormat::None)
+        {
+            return S_FALSE;
+        }
+
+        const size_t bitsPerPixel = GetLegacyBitsPerPixel(desc.legacyFormat);
+
+        // Sized first, so the file is known to hold every subresource before anything is written
+        uint64_t sourceBytes = 0;
+        uint64_t destBytes = 0;
+        for (size_t j = 0; j < desc.arraySize; j++)
+        {
+            size_t w = desc.width;
+            size_t h = desc.height;
+            size_t d = desc.depth;
+            for (size_t i = 0; i < desc.mipCount; i++)
+            {
+                size_t numBytes = 0;
+                HRESULT hr = GetSurfaceInfo(w, h, desc.format, &numBytes, nullptr, nullptr);
+                if (FAILED(hr))
+                    return hr;
+
+                sourceBytes += uint64_t((w * bitsPerPixel + 7) / 8) * h * d;
+                destBytes += uint64_t(numBytes) * d;
+
+                w = std::max<size_t>(w >> 1, 1);
+                h = std::max<size_t>(h >> 1, 1);
+                d = std::max<size_t>(d >> 1, 1);
+            }
+        }
+
+        if (sourceBytes > bitSize)
+            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+        if (destBytes > SIZE_MAX)
+            return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+
+        std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[static_cast<size_t>(destBytes)]);
+        if (!data)
+            return E_OUTOFMEMORY;
+
+        const uint8_t* pSrcBits = bitData;
+        uint8_t* pDestBits = data.get();
+        for (size_t j = 0; j < desc.arraySize; j++)
+        {
+            size_t w = desc.width;
+            size_t h = desc.height;
+            size_t d = desc.depth;
+            for (size_t i = 0; i < desc.mipCount; i++)
+            {
+                size_t rowBytes = 0;
+                size_t numBytes = 0;
+                HRESULT hr = GetSurfaceInfo(w, h, desc.format, &numBytes, &rowBytes, nullptr);
+                if (FAILED(hr))
+                    return hr;
+
+                // Direct3D 9 wrote rows with no padding, 24-bit ones included
+                const size_t sourceRowBytes = (w * bitsPerPixel + 7) / 8;
+                for (size_t slice = 0; slice < d; slice++)
+                {
+                    hr = ConvertLegacySurface(desc.legacyFormat, w, h, pSrcBits, sourceRowBytes, pDestBits, rowBytes);
+                    if (FAILED(hr))
+                        return hr;
+
+                    pSrcBits += sourceRowBytes * h;
+                    pDestBits += numBytes;
+                }
+
+                w = std::max<size_t>(w >> 1, 1);
+                h = std::max<size_t>(h >> 1, 1);
+                d = std::max<size_t>(d >> 1, 1);
+            }
+        }
+
+        convertedData = std::move(data);
+        convertedSize = static_cast<size_t>(destBytes);
+        return S_OK;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Builds a mip chain on the CPU for a 2D texture saved without one, so it can be filtered
+    // and cut down to maxsize without a device context. Returns S_FALSE, leaving mipData
+    // empty, for textures that have mips or whose format or dimension isn't supported.
+    HRESULT GenerateMissingMips(
+        _In_ const DDSTextureDesc& desc,
+        _In_reads_bytes_(bitSize) const uint8_t* bitData,
+        _In_ size_t bitSize,
+        _Out_ std::unique_ptr<uint8_t[]>& mipData,
+        _Out_ size_t& mipDataSize,
+        _Out_ size_t& mipCount) noexcept
+    {
+        if (desc.resDim != D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+        {
+            mipData.reset();
+            mipDataSize = 0;
+            mipCount = desc.mipCount;
+            return S_FALSE;
+        }
+
+        return DirectX::GenerateMissingMips(desc.format, desc.width, desc.height, desc.mipCount, desc.arraySize,
+            bitData, bitSize, mipData, mipDataSize, mipCount);
+    }
+
+
+    //--------------------------------------------------------------------------------------
+    // The rest of a split load once the file is in memory: legacy layouts converted, missing
+    // mips generated and the subresources pointed at the result. ddsData is what owns bitData,
+    // or empty when the caller does; either way it ends up in textureData.
+    HRESULT LoadTextureData(
+        _In_ const DDS_HEADER* header,
+        _In_reads_bytes_(bitSize) const uint8_t* bitData,
+        _In_ size_t bitSize,
+        std::unique_ptr<uint8_t[]> ddsData,
+        _In_ bool isLZ4Frame,
+        _In_ size_t maxsize,
+        LoadStats& stats,
+        _Out_ DDSTextureData& textureData) noexcept
+    {
+        DDSTextureDesc desc;
+        HRESULT hr = GetTextureDescFromDDS(header, desc);
+        stats.EndValidate();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        desc.isLZ4Frame = isLZ4Frame;
+
+        // Legacy layouts are converted here too, before the mips are generated from them
+        std::unique_ptr<uint8_t[]> convertedData;
+        size_t convertedSize = 0;
+        hr = ConvertLegacyData(desc, bitData, bitSize, convertedData, convertedSize);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        if (convertedData)
+        {
+            ddsData = std::move(convertedData);
+            bitData = ddsData.get();
+            bitSize = convertedSize;
+        }
+
+        // Files without mips get them generated here, on the loading thread
+        std::unique_ptr<uint8_t[]> mipData;
+        size_t mipDataSize = 0;
+        size_t mipCount = 0;
+        hr = GenerateMissingMips(desc, bitData, bitSize, mipData, mipDataSize, mipCount);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        if (mipData)
+        {
+            desc.mipCount = mipCount;
+            ddsData = std::move(mipData);
+            bitData = ddsData.get();
+            bitSize = mipDataSize;
+        }
+
+        std::unique_ptr<D3D11_SUBRESOURCE_DATA[]> initData(new (std::nothrow) D3D11_SUBRESOURCE_DATA[desc.mipCount * desc.arraySize]);
+        if (!initData)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        size_t skipMip = 0;
+        size_t twidth = 0;
+        size_t theight = 0;
+        size_t tdepth = 0;
+        hr = FillInitData(desc.width, desc.height, desc.depth, desc.mipCount, desc.arraySize,
+            desc.format, maxsize, bitSize, bitData,
+            twidth, theight, tdepth, skipMip, initData.get());
+        stats.EndLayout();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        desc.width = twidth;
+        desc.height = theight;
+        desc.depth = tdepth;
+        desc.mipCount -= skipMip;
+
+        textureData.desc = desc;
+        textureData.ddsData = std::move(ddsData);
+        textureData.initData = std::move(initData);
+
+        stats.SetTexture(desc.width, desc.height, desc.mipCount, skipMip, desc.format);
+        return S_OK;
+    }
+
+
+    //--------------------------------------------------------------------------------------
+    HRESULT CreateTextureFromDDS(
+        _In_ ID3D11Device* d3dDevice,
+        _In_opt_ ID3D11DeviceContext* d3dContext,
+        _In_ const DDS_HEADER* header,
+        _In_reads_bytes_(bitSize) const uint8_t* bitData,
+        _In_ size_t bitSize,
+        _In_ size_t maxsize,
+        _In_ D3D11_USAGE usage,
+        _In_ unsigned int bindFlags,
+        _In_ unsigned int cpuAccessFlags,
+        _In_ unsigned int miscFlags,
+        _In_ bool forceSRGB,
+        _Outptr_opt_ ID3D11Resource** texture,
+        _Outptr_opt_ ID3D11ShaderResourceView** textureView,
+        LoadStats& stats) noexcept
+    {
+        DDSTextureDesc desc;
+        HRESULT hr = GetTextureDescFromDDS(header, desc);
+        stats.EndValidate();
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        const uint32_t resDim = desc.resDim;
+        const size_t width = desc.width;
+        const size_t height = desc.height;
+        const size_t depth = desc.depth;
+        size_t mipCount = desc.mipCount;
+        const size_t arraySize = desc.arraySize;
+        const DXGI_FORMAT format = desc.format;
+        const bool isCubeMap = desc.isCubeMap;
+
+        std::unique_ptr<uint8_t[]> convertedData;
+        size_t convertedSize = 0;
+        hr = ConvertLegacyData(desc, bitData, bitSize, convertedData, convertedSize);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+
+        if (convertedData)
+        {
+            bitData = convertedData.get();
+            bitSize = convertedSize;
+            stats.EndLayout();
+        }
+
         bool autogen = false;
         if (mipCount == 1 && d3dContext && textureView) // Must have context and shader-view to auto generate mipmaps
         {
@@ -1425,6 +1145,28 @@ namespace
             }
         }
 
+        // Without auto-gen, or when the top level is over maxsize (which auto-gen can't
+        // honour), generate the mips on the CPU and create the texture from them
+        std::unique_ptr<uint8_t[]> mipData;
+        if (mipCount == 1 && (!autogen || (maxsize && (width > maxsize || height > maxsize))))
+        {
+            size_t mipDataSize = 0;
+            hr = GenerateMissingMips(desc, bitData, bitSize, mipData, mipDataSize, mipCount);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            if (mipData)
+            {
+                autogen = false;
+                bitData = mipData.get();
+                bitSize = mipDataSize;
+            }
+
+            stats.EndLayout();
+        }
+
         if (autogen)
         {
             // Create texture with auto-generated mipmaps
@@ -1506,6 +1248,8 @@ namespace
 
                 d3dContext->GenerateMips(*textureView);
 
+                stats.SetTexture(width, height, mipLevels, 0, forceSRGB ? MakeSRGB(format) : format);
+
                 if (texture)
                 {
                     *texture = tex;
@@ -1533,6 +1277,8 @@ namespace
                 format, maxsize, bitSize, bitData,
                 twidth, theight, tdepth, skipMip, initData.get());
 
+            stats.EndLayout();
+
             if (SUCCEEDED(hr))
             {
                 hr = CreateD3DResources(d3dDevice,
@@ -1543,6 +1289,7 @@ namespace
                     isCubeMap,
                     initData.get(),
                     texture, textureView);
+                stats.EndCreate();
 
                 if (FAILED(hr) && !maxsize && (mipCount > 1))
                 {
@@ -1578,6 +1325,7 @@ namespace
 
                     hr = FillInitData(width, height, depth, mipCount, arraySize, format, maxsize, bitSize, bitData,
                         twidth, theight, tdepth, skipMip, initData.get());
+                    stats.EndLayout();
                     if (SUCCEEDED(hr))
                     {
                         hr = CreateD3DResources(d3dDevice,
@@ -1588,47 +1336,24 @@ namespace
                             isCubeMap,
                             initData.get(),
                             texture, textureView);
+                        stats.EndCreate();
                     }
                 }
-            }
-        }
-
-        return hr;
-    }
 
-
-    //--------------------------------------------------------------------------------------
-    DDS_ALPHA_MODE GetAlphaMode(_In_ const DDS_HEADER* header) noexcept
-    {
-        if (header->ddspf.flags & DDS_FOURCC)
-        {
-            if (MAKEFOURCC('D', 'X', '1', '0') == header->ddspf.fourCC)
-            {
-                auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(reinterpret_cast<const uint8_t*>(header) + sizeof(DDS_HEADER));
-                auto mode = static_cast<DDS_ALPHA_MODE>(d3d10ext->miscFlags2 & DDS_MISC_FLAGS2_ALPHA_MODE_MASK);
-                switch (mode)
+                if (SUCCEEDED(hr))
                 {
-                case DDS_ALPHA_MODE_STRAIGHT:
-                case DDS_ALPHA_MODE_PREMULTIPLIED:
-                case DDS_ALPHA_MODE_OPAQUE:
-                case DDS_ALPHA_MODE_CUSTOM:
-                    return mode;
-
-                case DDS_ALPHA_MODE_UNKNOWN:
-                default:
-                    break;
+                    stats.SetTexture(twidth, theight, mipCount - skipMip, skipMip, forceSRGB ? MakeSRGB(format) : format);
                 }
             }
-            else if ((MAKEFOURCC('D', 'X', 'T', '2') == header->ddspf.fourCC)
-                || (MAKEFOURCC('D', 'X', 'T', '4') == header->ddspf.fourCC))
-            {
-                return DDS_ALPHA_MODE_PREMULTIPLIED;
-            }
         }
 
-        return DDS_ALPHA_MODE_UNKNOWN;
+        // The auto-gen branch, its uploads and GenerateMips included, counts as creation
+        stats.EndCreate();
+
+        return hr;
     }
 
+
     //--------------------------------------------------------------------------------------
     void SetDebugTextureInfo(
         _In_z_ const wchar_t* fileName,
@@ -1790,13 +1515,16 @@ HRESULT DirectX::CreateDDSTextureFromMemoryEx(
     const uint8_t* bitData = nullptr;
     size_t bitSize = 0;
 
+    LoadStats stats;
     HRESULT hr = LoadTextureDataFromMemory(ddsData, ddsDataSize,
         &header,
         &bitData,
         &bitSize
     );
+    stats.EndValidate();
     if (FAILED(hr))
     {
+        stats.Report(hr);
         return hr;
     }
 
@@ -1805,7 +1533,9 @@ HRESULT DirectX::CreateDDSTextureFromMemoryEx(
         maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
         forceSRGB,
-        texture, textureView);
+        texture, textureView,
+        stats);
+    stats.Report(hr);
     if (SUCCEEDED(hr))
     {
         if (texture && *texture)
@@ -1924,16 +1654,58 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
     const uint8_t* bitData = nullptr;
     size_t bitSize = 0;
 
+    // Prefer a read-only mapping of the file; the subresource data then points into the
+    // view and the only copy made is the driver's upload. The view is unmapped on return.
+    // A file source set by the application is always read through instead.
+    LoadStats stats(fileName);
+    FileMapping mappedData;
+    if (!s_FileSource.load(std::memory_order_acquire))
+    {
+        HRESULT hr = MapTextureDataFromFile(fileName, mappedData);
+        stats.EndOpen();
+
+        // A compressed file can't be used in place; it is decompressed as it is read below
+        if (SUCCEEDED(hr) && IsLZ4Frame(mappedData.GetData(), mappedData.GetSize()))
+        {
+            mappedData.Close();
+        }
+        else if (SUCCEEDED(hr))
+        {
+            stats.SetMapped();
+            stats.AddBytesRead(mappedData.GetSize());
+
+            hr = LoadTextureDataFromMemory(mappedData.GetData(), mappedData.GetSize(),
+                &header,
+                &bitData,
+                &bitSize
+            );
+            stats.EndValidate();
+            if (FAILED(hr))
+            {
+                stats.Report(hr);
+                return hr;
+            }
+        }
+    }
+
+    // Fall back to reading the whole file into memory if it could not be mapped
+    // or is compressed
     std::unique_ptr<uint8_t[]> ddsData;
-    HRESULT hr = LoadTextureDataFromFile(fileName,
-        ddsData,
-        &header,
-        &bitData,
-        &bitSize
-    );
-    if (FAILED(hr))
+    HRESULT hr = S_OK;
+    if (!mappedData.GetData())
     {
-        return hr;
+        hr = LoadTextureDataFromFile(fileName,
+            ddsData,
+            &header,
+            &bitData,
+            &bitSize,
+            stats
+        );
+        if (FAILED(hr))
+        {
+            stats.Report(hr);
+            return hr;
+        }
     }
 
     hr = CreateTextureFromDDS(d3dDevice, d3dContext,
@@ -1941,7 +1713,9 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
         maxsize,
         usage, bindFlags, cpuAccessFlags, miscFlags,
         forceSRGB,
-        texture, textureView);
+        texture, textureView,
+        stats);
+    stats.Report(hr);
 
     if (SUCCEEDED(hr))
     {
@@ -1953,3 +1727,592 @@ HRESULT DirectX::CreateDDSTextureFromFileEx(
 
     return hr;
 }
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadDDSTextureDataFromFile(
+    const wchar_t* fileName,
+    size_t maxsize,
+    DDSTextureData& textureData) noexcept
+{
+    textureData.desc = {};
+    textureData.ddsData.reset();
+    textureData.mappedData.Close();
+    textureData.initData.reset();
+
+    if (!fileName)
+    {
+        return E_INVALIDARG;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
+
+    // Map the file as CreateDDSTextureFromFileEx does, but fault its pages in here, so they
+    // are resident before the render thread hands them to the driver without a heap copy
+    // in between. The faults count as the read. A file source set by the application is
+    // always read through instead, as is a compressed file.
+    LoadStats stats(fileName);
+    FileMapping mappedData;
+    HRESULT hr = S_OK;
+    if (!s_FileSource.load(std::memory_order_acquire))
+    {
+        hr = MapTextureDataFromFile(fileName, mappedData);
+        stats.EndOpen();
+
+        if (SUCCEEDED(hr) && IsLZ4Frame(mappedData.GetData(), mappedData.GetSize()))
+        {
+            mappedData.Close();
+        }
+        else if (SUCCEEDED(hr))
+        {
+            mappedData.Prefault();
+            stats.SetMapped();
+            stats.AddBytesRead(mappedData.GetSize());
+            stats.EndRead();
+
+            hr = LoadTextureDataFromMemory(mappedData.GetData(), mappedData.GetSize(),
+                &header,
+                &bitData,
+                &bitSize
+            );
+            if (FAILED(hr))
+            {
+                stats.EndValidate();
+                stats.Report(hr);
+                return hr;
+            }
+        }
+    }
+
+    // Fall back to reading the whole file into memory if it could not be mapped
+    // or is compressed
+    std::unique_ptr<uint8_t[]> ddsData;
+    bool isLZ4Frame = false;
+    if (!mappedData.GetData())
+    {
+        hr = LoadTextureDataFromFile(fileName,
+            ddsData,
+            &header,
+            &bitData,
+            &bitSize,
+            stats,
+            &isLZ4Frame
+        );
+        if (FAILED(hr))
+        {
+            stats.Report(hr);
+            return hr;
+        }
+    }
+
+    hr = LoadTextureData(header, bitData, bitSize, std::move(ddsData), isLZ4Frame, maxsize, stats, textureData);
+    stats.Report(hr);
+
+    // The subresources point into the view unless the pixels had to be rewritten
+    if (SUCCEEDED(hr) && !textureData.ddsData)
+    {
+        textureData.mappedData = std::move(mappedData);
+    }
+
+#ifdef DDS_LOADER_STATS
+    textureData.loadStats = stats.Get();
+#endif
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadDDSTextureDataFromMemory(
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    size_t maxsize,
+    DDSTextureData& textureData) noexcept
+{
+    textureData.desc = {};
+    textureData.ddsData.reset();
+    textureData.mappedData.Close();
+    textureData.initData.reset();
+#ifdef DDS_LOADER_STATS
+    textureData.loadStats = {};
+#endif
+
+    if (!ddsData)
+    {
+        return E_INVALIDARG;
+    }
+
+    LoadStats stats;
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
+    HRESULT hr = LoadTextureDataFromMemory(ddsData, ddsDataSize, &header, &bitData, &bitSize);
+    if (SUCCEEDED(hr))
+    {
+        hr = LoadTextureData(header, bitData, bitSize, nullptr, false, maxsize, stats, textureData);
+    }
+
+#ifdef DDS_LOADER_STATS
+    textureData.loadStats = stats.Get();
+    textureData.loadStats.result = hr;
+#endif
+
+    return hr;
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromData(
+    ID3D11Device* d3dDevice,
+    const DDSTextureData& textureData,
+    ID3D11Resource** texture,
+    ID3D11ShaderResourceView** textureView) noexcept
+{
+    return CreateDDSTextureFromDataEx(d3dDevice, textureData,
+        D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+        false,
+        texture, textureView);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTextureFromDataEx(
+    ID3D11Device* d3dDevice,
+    const DDSTextureData& textureData,
+    D3D11_USAGE usage,
+    unsigned int bindFlags,
+    unsigned int cpuAccessFlags,
+    unsigned int miscFlags,
+    bool forceSRGB,
+    ID3D11Resource** texture,
+    ID3D11ShaderResourceView** textureView) noexcept
+{
+    if (texture)
+    {
+        *texture = nullptr;
+    }
+    if (textureView)
+    {
+        *textureView = nullptr;
+    }
+
+    if (!d3dDevice || !textureData.initData || (!texture && !textureView))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (textureView && !(bindFlags & D3D11_BIND_SHADER_RESOURCE))
+    {
+        return E_INVALIDARG;
+    }
+
+#ifdef DDS_LOADER_STATS
+    LoadStats stats(textureData.loadStats);
+#else
+    LoadStats stats;
+#endif
+
+    const DDSTextureDesc& desc = textureData.desc;
+    HRESULT hr = CreateD3DResources(d3dDevice,
+        desc.resDim, desc.width, desc.height, desc.depth, desc.mipCount, desc.arraySize,
+        desc.format,
+        usage, bindFlags, cpuAccessFlags, miscFlags,
+        forceSRGB,
+        desc.isCubeMap,
+        textureData.initData.get(),
+        texture, textureView);
+    stats.EndCreate();
+    stats.SetTexture(desc.width, desc.height, desc.mipCount, 0, forceSRGB ? MakeSRGB(desc.format) : desc.format);
+    stats.Report(hr);
+    if (SUCCEEDED(hr))
+    {
+        if (texture && *texture)
+        {
+            SetDebugObjectName(*texture, "DDSTextureLoader");
+        }
+
+        if (textureView && *textureView)
+        {
+            SetDebugObjectName(*textureView, "DDSTextureLoader");
+        }
+    }
+
+    return hr;
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTexturesFromFiles(
+    ID3D11Device* d3dDevice,
+    const wchar_t* const* fileNames,
+    size_t count,
+    ID3D11Resource** textures,
+    ID3D11ShaderResourceView** textureViews,
+    HRESULT* results,
+    size_t maxsize,
+    unsigned int threadCount) noexcept
+{
+    return CreateDDSTexturesFromFilesEx(d3dDevice,
+        fileNames, count,
+        maxsize,
+        D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+        false,
+        textures, textureViews, results,
+        threadCount);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::CreateDDSTexturesFromFilesEx(
+    ID3D11Device* d3dDevice,
+    const wchar_t* const* fileNames,
+    size_t count,
+    size_t maxsize,
+    D3D11_USAGE usage,
+    unsigned int bindFlags,
+    unsigned int cpuAccessFlags,
+    unsigned int miscFlags,
+    bool forceSRGB,
+    ID3D11Resource** textures,
+    ID3D11ShaderResourceView** textureViews,
+    HRESULT* results,
+    unsigned int threadCount) noexcept
+{
+    if (count > 0 && !results)
+    {
+        return E_INVALIDARG;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (textures)
+        {
+            textures[i] = nullptr;
+        }
+        if (textureViews)
+        {
+            textureViews[i] = nullptr;
+        }
+        results[i] = E_PENDING;
+    }
+
+    if (!d3dDevice || (count > 0 && !fileNames) || (!textures && !textureViews))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (textureViews && !(bindFlags & D3D11_BIND_SHADER_RESOURCE))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (count == 0)
+    {
+        return S_OK;
+    }
+
+    std::unique_ptr<DDSTextureData[]> data(new (std::nothrow) DDSTextureData[count]);
+    std::unique_ptr<bool[]> loaded(new (std::nothrow) bool[count]());
+    if (!data || !loaded)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // Workers take files in order, but stay no more than window files ahead of the one
+    // being created, so finished data can't pile up while the device is busy
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t workerCount = std::min<size_t>(threadCount, count);
+    size_t next = 0;
+    size_t created = 0;
+    size_t window = workerCount * 2;
+
+    auto worker = [&]() noexcept
+    {
+        for (;;)
+        {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return next >= count || next < created + window; });
+                if (next >= count)
+                    return;
+
+                index = next++;
+            }
+
+            HRESULT hr = LoadDDSTextureDataFromFile(fileNames[index], maxsize, data[index]);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                results[index] = hr;
+                loaded[index] = true;
+            }
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    try
+    {
+        workers.reserve(workerCount);
+        for (size_t i = 0; i < workerCount; i++)
+        {
+            workers.emplace_back(worker);
+        }
+    }
+    catch (...)
+    {
+    }
+
+    // Without a thread to read ahead, everything is loaded up front on this one
+    if (workers.empty())
+    {
+        window = count;
+        worker();
+    }
+
+    bool failed = false;
+    for (size_t index = 0; index < count; index++)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return loaded[index]; });
+        }
+
+        HRESULT hr = results[index];
+        if (SUCCEEDED(hr))
+        {
+            hr = CreateDDSTextureFromDataEx(d3dDevice, data[index],
+                usage, bindFlags, cpuAccessFlags, miscFlags,
+                forceSRGB,
+                textures ? &textures[index] : nullptr,
+                textureViews ? &textureViews[index] : nullptr);
+        }
+
+        results[index] = hr;
+        failed |= FAILED(hr);
+
+        // The driver has its own copy once the resource exists
+        data[index].ddsData.reset();
+        data[index].mappedData.Close();
+        data[index].initData.reset();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            created = index + 1;
+        }
+        changed.notify_all();
+    }
+
+    for (auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    return failed ? S_FALSE : S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetDDSTextureDescFromMemory(
+    const uint8_t* ddsData,
+    size_t ddsDataSize,
+    DDSTextureDesc& desc) noexcept
+{
+    desc = {};
+
+    if (!ddsData)
+    {
+        return E_INVALIDARG;
+    }
+
+    const DDS_HEADER* header = nullptr;
+    const uint8_t* bitData = nullptr;
+    size_t bitSize = 0;
+
+    HRESULT hr = LoadTextureDataFromMemory(ddsData, ddsDataSize,
+        &header,
+        &bitData,
+        &bitSize
+    );
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    return GetTextureDescFromDDS(header, desc);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::GetDDSTextureDescFromFile(
+    const wchar_t* fileName,
+    DDSTextureDesc& desc) noexcept
+{
+    desc = {};
+
+    if (!fileName)
+    {
+        return E_INVALIDARG;
+    }
+
+    IFileSource* source = GetFileSource();
+    if (!source)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    // Only the headers are read, through the same source as the pixels would be
+    uint8_t headerData[DDS_HEADER_PROBE_SIZE];
+    size_t headerSize = 0;
+    bool isLZ4Frame = false;
+    HRESULT hr = ReadDDSHeaderFromFile(source, fileName, headerData, &headerSize, &isLZ4Frame);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    hr = GetDDSTextureDescFromMemory(headerData, headerSize, desc);
+    if (SUCCEEDED(hr))
+    {
+        desc.isLZ4Frame = isLZ4Frame;
+    }
+
+    return hr;
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::GetDDSSubresourceSizes(
+    const DDSTextureDesc& desc,
+    size_t* subresourceSizes,
+    size_t subresourceCount,
+    size_t* totalSize) noexcept
+{
+    if (totalSize)
+    {
+        *totalSize = 0;
+    }
+
+    if (subresourceSizes && subresourceCount < desc.mipCount * desc.arraySize)
+    {
+        return E_INVALIDARG;
+    }
+
+    size_t total = 0;
+    size_t index = 0;
+    for (size_t j = 0; j < desc.arraySize; j++)
+    {
+        size_t w = desc.width;
+        size_t h = desc.height;
+        size_t d = desc.depth;
+        for (size_t i = 0; i < desc.mipCount; i++)
+        {
+            size_t NumBytes = 0;
+            HRESULT hr = GetSurfaceInfo(w, h, desc.format, &NumBytes, nullptr, nullptr);
+            if (FAILED(hr))
+                return hr;
+
+            const size_t subresourceSize = NumBytes * d;
+            if (subresourceSizes)
+            {
+                subresourceSizes[index] = subresourceSize;
+            }
+            ++index;
+            total += subresourceSize;
+
+            w = std::max<size_t>(w >> 1, 1);
+            h = std::max<size_t>(h >> 1, 1);
+            d = std::max<size_t>(d >> 1, 1);
+        }
+    }
+
+    if (totalSize)
+    {
+        *totalSize = total;
+    }
+
+    return S_OK;
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::GetDDSSubresourceLayout(
+    const DDSTextureDesc& desc,
+    DDSSubresourceLayout* layouts,
+    size_t subresourceCount) noexcept
+{
+    if (!layouts || subresourceCount < desc.mipCount * desc.arraySize)
+    {
+        return E_INVALIDARG;
+    }
+
+    // The file holds the pixels in another layout, so its offsets aren't these
+    if (desc.legacyFormat != LegacyFormat::None)
+    {
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    }
+
+    size_t offset = desc.dataOffset;
+    size_t index = 0;
+    for (size_t j = 0; j < desc.arraySize; j++)
+    {
+        size_t w = desc.width;
+        size_t h = desc.height;
+        size_t d = desc.depth;
+        for (size_t i = 0; i < desc.mipCount; i++)
+        {
+            size_t NumBytes = 0;
+            size_t RowBytes = 0;
+            HRESULT hr = GetSurfaceInfo(w, h, desc.format, &NumBytes, &RowBytes, nullptr);
+            if (FAILED(hr))
+                return hr;
+
+            DDSSubresourceLayout& layout = layouts[index++];
+            layout.offset = offset;
+            layout.size = NumBytes * d;
+            layout.rowPitch = RowBytes;
+            layout.slicePitch = NumBytes;
+            layout.width = w;
+            layout.height = h;
+            layout.depth = d;
+
+            offset += layout.size;
+
+            w = std::max<size_t>(w >> 1, 1);
+            h = std::max<size_t>(h >> 1, 1);
+            d = std::max<size_t>(d >> 1, 1);
+        }
+    }
+
+    return S_OK;
+}
+
+#ifdef DDS_LOADER_STATS
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::SetDDSLoadStatsSink(IDDSLoadStatsSink* sink) noexcept
+{
+    s_StatsSink.store(sink, std::memory_order_release);
+}
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::ReportDDSLoadStats(const DDSLoadStats& stats) noexcept
+{
+    IDDSLoadStatsSink* sink = s_StatsSink.load(std::memory_order_acquire);
+    if (sink)
+    {
+        sink->OnDDSLoadStats(stats);
+    }
+}
+#endif
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::SetDDSFileSource(IFileSource* source) noexcept
+{
+    s_FileSource.store(source, std::memory_order_release);
+}
@@ -18,7 +18,11 @@
 
 #include <d3d11_1.h>
 
+#include "FileSource.h"
+#include "LegacyFormatConverter.h"
+
 #include <cstdint>
+#include <memory>
 
 
 namespace DirectX
@@ -35,6 +39,100 @@ namespace DirectX
     };
 #endif
 
+#ifdef DDS_LOADER_STATS
+    // Load instrumentation, for telling disk, parsing and driver time apart. It only exists
+    // when DDS_LOADER_STATS is defined for the whole project; otherwise none of it, not even
+    // the clock reads, is compiled in.
+    //
+    // Each load that gets past argument checks produces one record, failed loads included.
+    // The split version produces two under the same file name, one from each half: loading
+    // the data fills in everything but createMs, creating it only createMs, so records for
+    // the same file can simply be added up. Textures created from memory have no file name.
+    struct DDSLoadStats
+    {
+        wchar_t fileName[MAX_PATH]; // a longer path keeps its end
+        HRESULT result;
+        double openMs;              // opening the file, or mapping it
+        double readMs;              // reading it, LZ4 decompression included
+        double validateMs;          // header checks and format lookup
+        double layoutMs;            // CPU mip generation and the subresource table
+        double createMs;            // texture and view creation, and auto-gen mips
+        uint64_t bytesRead;         // of the file as stored, so compressed for .dds.lz4
+        size_t skippedMips;         // top mips dropped because of maxsize
+        size_t width;               // of the created texture, after skipping
+        size_t height;
+        size_t mipCount;
+        DXGI_FORMAT format;         // of the created texture, after forceSRGB
+        bool isLZ4Frame;
+        bool isMapped;              // read through a mapping; its reads land in createMs unless loaded split
+    };
+
+    class IDDSLoadStatsSink
+    {
+    public:
+        // Called on the thread that did the work, which may be any of the batch or loader
+        // workers, as soon as each load finishes
+        virtual void OnDDSLoadStats(const DDSLoadStats& stats) noexcept = 0;
+
+    protected:
+        ~IDDSLoadStatsSink() = default;
+    };
+
+    // Sends the records of every load from now on to sink, or stops with nullptr. Loads already
+    // running may still report to the previous sink, so keep it alive until they are done.
+    void SetDDSLoadStatsSink(_In_opt_ IDDSLoadStatsSink* sink) noexcept;
+
+    // Sends a record made outside the loader to the same sink, for work it never sees: data
+    // parsed in place from a mapping, or resources the caller creates from DDSTextureData itself
+    void ReportDDSLoadStats(_In_ const DDSLoadStats& stats) noexcept;
+#endif
+
+    // Resource description read from a DDS header
+    struct DDSTextureDesc
+    {
+        D3D11_RESOURCE_DIMENSION resDim;
+        size_t width;
+        size_t height;
+        size_t depth;
+        size_t mipCount;
+        size_t arraySize; // already multiplied by 6 for cube maps
+        DXGI_FORMAT format;
+        bool isCubeMap;
+        DDS_ALPHA_MODE alphaMode;
+        size_t dataOffset; // file offset of the first subresource
+        bool isLZ4Frame;   // the file is compressed, so offsets are into the decompressed data
+        LegacyFormat legacyFormat; // layout the file's pixels are converted from into format, None if they load as stored
+    };
+
+    // Where a subresource lives in the file, for reading mips individually
+    struct DDSSubresourceLayout
+    {
+        size_t offset; // from the start of the file
+        size_t size;   // rowPitch * numRows * depth
+        size_t rowPitch;
+        size_t slicePitch;
+        size_t width;
+        size_t height;
+        size_t depth;
+    };
+
+    // CPU-side result of loading a DDS file: the file contents and the subresource layout
+    // that points into them. The desc reflects any mips dropped because of maxsize. For 8-bit
+    // RGBA files saved without mips, ddsData holds the top level and a generated chain instead.
+    // A file loaded in place leaves ddsData empty and mappedData holding the view.
+    struct DDSTextureData
+    {
+        DDSTextureDesc desc;
+        std::unique_ptr<uint8_t[]> ddsData;
+        FileMapping mappedData;
+        std::unique_ptr<D3D11_SUBRESOURCE_DATA[]> initData;
+
+    #ifdef DDS_LOADER_STATS
+        // How the data was loaded, so creating it can be reported under the same file name
+        DDSLoadStats loadStats;
+    #endif
+    };
+
     // Standard version
     HRESULT CreateDDSTextureFromMemory(
         _In_ ID3D11Device* d3dDevice,
@@ -130,4 +228,103 @@ namespace DirectX
         _Outptr_opt_ ID3D11Resource** texture,
         _Outptr_opt_ ID3D11ShaderResourceView** textureView,
         _Out_opt_ DDS_ALPHA_MODE* alphaMode = nullptr) noexcept;
+
+    // Split version, for reading and parsing on a worker thread and creating the resource
+    // later on the render thread. Loading the data does not need a device.
+    //
+    // The file functions also accept a DDS file compressed into an LZ4 frame (.dds.lz4) that
+    // records its content size; it is decompressed a block at a time as it is read.
+    HRESULT LoadDDSTextureDataFromFile(
+        _In_z_ const wchar_t* szFileName,
+        _In_ size_t maxsize,
+        _Out_ DDSTextureData& textureData) noexcept;
+
+    // The same for a file already in memory, such as an archive entry, converted and given
+    // mips the same way. Subresources point into ddsData, which has to outlive textureData,
+    // unless the pixels had to be rewritten; then textureData.ddsData holds them. Memory has
+    // no file name to report a load under, so its timings are only left in loadStats.
+    HRESULT LoadDDSTextureDataFromMemory(
+        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+        _In_ size_t ddsDataSize,
+        _In_ size_t maxsize,
+        _Out_ DDSTextureData& textureData) noexcept;
+
+    HRESULT CreateDDSTextureFromData(
+        _In_ ID3D11Device* d3dDevice,
+        _In_ const DDSTextureData& textureData,
+        _Outptr_opt_ ID3D11Resource** texture,
+        _Outptr_opt_ ID3D11ShaderResourceView** textureView) noexcept;
+
+    HRESULT CreateDDSTextureFromDataEx(
+        _In_ ID3D11Device* d3dDevice,
+        _In_ const DDSTextureData& textureData,
+        _In_ D3D11_USAGE usage,
+        _In_ unsigned int bindFlags,
+        _In_ unsigned int cpuAccessFlags,
+        _In_ unsigned int miscFlags,
+        _In_ bool forceSRGB,
+        _Outptr_opt_ ID3D11Resource** texture,
+        _Outptr_opt_ ID3D11ShaderResourceView** textureView) noexcept;
+
+    // Batch version: loads count files on threadCount workers (0 for one per core) that read
+    // and parse them in parallel, while the calling thread creates the resources in input
+    // order as their data arrives. At most two files per worker wait to be created, so memory
+    // stays bounded however long the list is. Each file gets its own HRESULT in results, and
+    // textures and textureViews are left null for the ones that failed. Returns S_FALSE if
+    // any did.
+    HRESULT CreateDDSTexturesFromFiles(
+        _In_ ID3D11Device* d3dDevice,
+        _In_reads_(count) const wchar_t* const* szFileNames,
+        _In_ size_t count,
+        _Out_writes_opt_(count) ID3D11Resource** textures,
+        _Out_writes_opt_(count) ID3D11ShaderResourceView** textureViews,
+        _Out_writes_(count) HRESULT* results,
+        _In_ size_t maxsize = 0,
+        _In_ unsigned int threadCount = 0) noexcept;
+
+    HRESULT CreateDDSTexturesFromFilesEx(
+        _In_ ID3D11Device* d3dDevice,
+        _In_reads_(count) const wchar_t* const* szFileNames,
+        _In_ size_t count,
+        _In_ size_t maxsize,
+        _In_ D3D11_USAGE usage,
+        _In_ unsigned int bindFlags,
+        _In_ unsigned int cpuAccessFlags,
+        _In_ unsigned int miscFlags,
+        _In_ bool forceSRGB,
+        _Out_writes_opt_(count) ID3D11Resource** textures,
+        _Out_writes_opt_(count) ID3D11ShaderResourceView** textureViews,
+        _Out_writes_(count) HRESULT* results,
+        _In_ unsigned int threadCount = 0) noexcept;
+
+    // Where the file functions read from, nullptr for the platform's own. CreateDDSTextureFromFile
+    // maps files through the platform's own source; a source set here is read through instead.
+    // Set it before loading starts, and keep it alive until loading is done.
+    void SetDDSFileSource(_In_opt_ IFileSource* source) noexcept;
+
+    // Header-only queries, for budgeting without reading the pixel data. The file version
+    // reads at most the magic value, DDS_HEADER and DDS_HEADER_DXT10 (148 bytes).
+    HRESULT GetDDSTextureDescFromMemory(
+        _In_reads_bytes_(ddsDataSize) const uint8_t* ddsData,
+        _In_ size_t ddsDataSize,
+        _Out_ DDSTextureDesc& desc) noexcept;
+
+    HRESULT GetDDSTextureDescFromFile(
+        _In_z_ const wchar_t* szFileName,
+        _Out_ DDSTextureDesc& desc) noexcept;
+
+    // Byte size of each subresource in D3D11CalcSubresource order (mipCount * arraySize
+    // entries); volume mips include all their slices
+    HRESULT GetDDSSubresourceSizes(
+        _In_ const DDSTextureDesc& desc,
+        _Out_writes_opt_(subresourceCount) size_t* subresourceSizes,
+        _In_ size_t subresourceCount,
+        _Out_opt_ size_t* totalSize) noexcept;
+
+    // Where each subresource lives in the file. ERROR_NOT_SUPPORTED for files whose pixels
+    // are converted as they load, since the file doesn't hold them in desc.format.
+    HRESULT GetDDSSubresourceLayout(
+        _In_ const DDSTextureDesc& desc,
+        _Out_writes_(subresourceCount) DDSSubresourceLayout* layouts,
+        _In_ size_t subresourceCount) noexcept;
 }
@@ -0,0 +1,266 @@
+//--------------------------------------------------------------------------------------
+// File: DXGIFormatTraits.h
+//
+// Compile-time table of DXGI format properties, indexed by format: bits per pixel, how
+// surfaces of the format are laid out, and its sRGB twin and typeless family. The DDS
+// loader sizes every surface from it, so adding a format means adding one row here.
+//
+// Formats past DXGI_FORMAT_B4G4R4A4_UNORM aren't listed and read as DXGI_FORMAT_UNKNOWN.
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <dxgiformat.h>
+#else
+#include <wsl/winadapter.h>
+#include <directx/dxgiformat.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    enum DXGI_FORMAT_LAYOUT : uint8_t
+    {
+        DXGI_FORMAT_LAYOUT_UNKNOWN = 0,
+        DXGI_FORMAT_LAYOUT_LINEAR,  // bitsPerPixel per pixel, each row rounded up to a byte
+        DXGI_FORMAT_LAYOUT_BLOCK,   // 4x4 blocks of elementBytes each
+        DXGI_FORMAT_LAYOUT_PACKED,  // each pair of pixels shares elementBytes
+        DXGI_FORMAT_LAYOUT_PLANAR,  // luma plane of elementBytes per pixel pair, then half as many chroma rows
+        DXGI_FORMAT_LAYOUT_NV11,    // 4:1:1 planar, sized the way Direct3D does
+    };
+
+    struct DXGIFormatTraits
+    {
+        DXGI_FORMAT        format;
+        uint8_t            bitsPerPixel;
+        uint8_t            elementBytes; // 0 for linear formats
+        DXGI_FORMAT_LAYOUT layout;
+        DXGI_FORMAT        srgb;         // _SRGB twin of a UNORM format, or UNKNOWN
+        DXGI_FORMAT        typeless;     // typeless family, or UNKNOWN
+    };
+
+#define DXGI_TRAITS(format, bpp, bytes, layout, srgb, typeless) \
+    { DXGI_FORMAT_##format, bpp, bytes, DXGI_FORMAT_LAYOUT_##layout, DXGI_FORMAT_##srgb, DXGI_FORMAT_##typeless }
+
+    // One row per format, in DXGI_FORMAT order
+    inline constexpr DXGIFormatTraits c_DXGIFormatTraits[] =
+    {
+        DXGI_TRAITS(UNKNOWN,                    0,   0,  UNKNOWN, UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(R32G32B32A32_TYPELESS,      128, 0,  LINEAR,  UNKNOWN,             R32G32B32A32_TYPELESS),
+        DXGI_TRAITS(R32G32B32A32_FLOAT,         128, 0,  LINEAR,  UNKNOWN,             R32G32B32A32_TYPELESS),
+        DXGI_TRAITS(R32G32B32A32_UINT,          128, 0,  LINEAR,  UNKNOWN,             R32G32B32A32_TYPELESS),
+        DXGI_TRAITS(R32G32B32A32_SINT,          128, 0,  LINEAR,  UNKNOWN,             R32G32B32A32_TYPELESS),
+        DXGI_TRAITS(R32G32B32_TYPELESS,         96,  0,  LINEAR,  UNKNOWN,             R32G32B32_TYPELESS),
+        DXGI_TRAITS(R32G32B32_FLOAT,            96,  0,  LINEAR,  UNKNOWN,             R32G32B32_TYPELESS),
+        DXGI_TRAITS(R32G32B32_UINT,             96,  0,  LINEAR,  UNKNOWN,             R32G32B32_TYPELESS),
+        DXGI_TRAITS(R32G32B32_SINT,             96,  0,  LINEAR,  UNKNOWN,             R32G32B32_TYPELESS),
+        DXGI_TRAITS(R16G16B16A16_TYPELESS,      64,  0,  LINEAR,  UNKNOWN,             R16G16B16A16_TYPELESS),
+        DXGI_TRAITS(R16G16B16A16_FLOAT,         64,  0,  LINEAR,  UNKNOWN,             R16G16B16A16_TYPELESS),
+        DXGI_TRAITS(R16G16B16A16_UNORM,         64,  0,  LINEAR,  UNKNOWN,             R16G16B16A16_TYPELESS),
+        DXGI_TRAITS(R16G16B16A16_UINT,          64,  0,  LINEAR,  UNKNOWN,             R16G16B16A16_TYPELESS),
+        DXGI_TRAITS(R16G16B16A16_SNORM,         64,  0,  LINEAR,  UNKNOWN,             R16G16B16A16_TYPELESS),
+        DXGI_TRAITS(R16G16B16A16_SINT,          64,  0,  LINEAR,  UNKNOWN,             R16G16B16A16_TYPELESS),
+        DXGI_TRAITS(R32G32_TYPELESS,            64,  0,  LINEAR,  UNKNOWN,             R32G32_TYPELESS),
+        DXGI_TRAITS(R32G32_FLOAT,               64,  0,  LINEAR,  UNKNOWN,             R32G32_TYPELESS),
+        DXGI_TRAITS(R32G32_UINT,                64,  0,  LINEAR,  UNKNOWN,             R32G32_TYPELESS),
+        DXGI_TRAITS(R32G32_SINT,                64,  0,  LINEAR,  UNKNOWN,             R32G32_TYPELESS),
+        DXGI_TRAITS(R32G8X24_TYPELESS,          64,  0,  LINEAR,  UNKNOWN,             R32G8X24_TYPELESS),
+        DXGI_TRAITS(D32_FLOAT_S8X24_UINT,       64,  0,  LINEAR,  UNKNOWN,             R32G8X24_TYPELESS),
+        DXGI_TRAITS(R32_FLOAT_X8X24_TYPELESS,   64,  0,  LINEAR,  UNKNOWN,             R32G8X24_TYPELESS),
+        DXGI_TRAITS(X32_TYPELESS_G8X24_UINT,    64,  0,  LINEAR,  UNKNOWN,             R32G8X24_TYPELESS),
+        DXGI_TRAITS(R10G10B10A2_TYPELESS,       32,  0,  LINEAR,  UNKNOWN,             R10G10B10A2_TYPELESS),
+        DXGI_TRAITS(R10G10B10A2_UNORM,          32,  0,  LINEAR,  UNKNOWN,             R10G10B10A2_TYPELESS),
+        DXGI_TRAITS(R10G10B10A2_UINT,           32,  0,  LINEAR,  UNKNOWN,             R10G10B10A2_TYPELESS),
+        DXGI_TRAITS(R11G11B10_FLOAT,            32,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(R8G8B8A8_TYPELESS,          32,  0,  LINEAR,  UNKNOWN,             R8G8B8A8_TYPELESS),
+        DXGI_TRAITS(R8G8B8A8_UNORM,             32,  0,  LINEAR,  R8G8B8A8_UNORM_SRGB, R8G8B8A8_TYPELESS),
+        DXGI_TRAITS(R8G8B8A8_UNORM_SRGB,        32,  0,  LINEAR,  UNKNOWN,             R8G8B8A8_TYPELESS),
+        DXGI_TRAITS(R8G8B8A8_UINT,              32,  0,  LINEAR,  UNKNOWN,             R8G8B8A8_TYPELESS),
+        DXGI_TRAITS(R8G8B8A8_SNORM,             32,  0,  LINEAR,  UNKNOWN,             R8G8B8A8_TYPELESS),
+        DXGI_TRAITS(R8G8B8A8_SINT,              32,  0,  LINEAR,  UNKNOWN,             R8G8B8A8_TYPELESS),
+        DXGI_TRAITS(R16G16_TYPELESS,            32,  0,  LINEAR,  UNKNOWN,             R16G16_TYPELESS),
+        DXGI_TRAITS(R16G16_FLOAT,               32,  0,  LINEAR,  UNKNOWN,             R16G16_TYPELESS),
+        DXGI_TRAITS(R16G16_UNORM,               32,  0,  LINEAR,  UNKNOWN,             R16G16_TYPELESS),
+        DXGI_TRAITS(R16G16_UINT,                32,  0,  LINEAR,  UNKNOWN,             R16G16_TYPELESS),
+        DXGI_TRAITS(R16G16_SNORM,               32,  0,  LINEAR,  UNKNOWN,             R16G16_TYPELESS),
+        DXGI_TRAITS(R16G16_SINT,                32,  0,  LINEAR,  UNKNOWN,             R16G16_TYPELESS),
+        DXGI_TRAITS(R32_TYPELESS,               32,  0,  LINEAR,  UNKNOWN,             R32_TYPELESS),
+        DXGI_TRAITS(D32_FLOAT,                  32,  0,  LINEAR,  UNKNOWN,             R32_TYPELESS),
+        DXGI_TRAITS(R32_FLOAT,                  32,  0,  LINEAR,  UNKNOWN,             R32_TYPELESS),
+        DXGI_TRAITS(R32_UINT,                   32,  0,  LINEAR,  UNKNOWN,             R32_TYPELESS),
+        DXGI_TRAITS(R32_SINT,                   32,  0,  LINEAR,  UNKNOWN,             R32_TYPELESS),
+        DXGI_TRAITS(R24G8_TYPELESS,             32,  0,  LINEAR,  UNKNOWN,             R24G8_TYPELESS),
+        DXGI_TRAITS(D24_UNORM_S8_UINT,          32,  0,  LINEAR,  UNKNOWN,             R24G8_TYPELESS),
+        DXGI_TRAITS(R24_UNORM_X8_TYPELESS,      32,  0,  LINEAR,  UNKNOWN,             R24G8_TYPELESS),
+        DXGI_TRAITS(X24_TYPELESS_G8_UINT,       32,  0,  LINEAR,  UNKNOWN,             R24G8_TYPELESS),
+        DXGI_TRAITS(R8G8_TYPELESS,              16,  0,  LINEAR,  UNKNOWN,             R8G8_TYPELESS),
+        DXGI_TRAITS(R8G8_UNORM,                 16,  0,  LINEAR,  UNKNOWN,             R8G8_TYPELESS),
+        DXGI_TRAITS(R8G8_UINT,                  16,  0,  LINEAR,  UNKNOWN,             R8G8_TYPELESS),
+        DXGI_TRAITS(R8G8_SNORM,                 16,  0,  LINEAR,  UNKNOWN,             R8G8_TYPELESS),
+        DXGI_TRAITS(R8G8_SINT,                  16,  0,  LINEAR,  UNKNOWN,             R8G8_TYPELESS),
+        DXGI_TRAITS(R16_TYPELESS,               16,  0,  LINEAR,  UNKNOWN,             R16_TYPELESS),
+        DXGI_TRAITS(R16_FLOAT,                  16,  0,  LINEAR,  UNKNOWN,             R16_TYPELESS),
+        DXGI_TRAITS(D16_UNORM,                  16,  0,  LINEAR,  UNKNOWN,             R16_TYPELESS),
+        DXGI_TRAITS(R16_UNORM,                  16,  0,  LINEAR,  UNKNOWN,             R16_TYPELESS),
+        DXGI_TRAITS(R16_UINT,                   16,  0,  LINEAR,  UNKNOWN,             R16_TYPELESS),
+        DXGI_TRAITS(R16_SNORM,                  16,  0,  LINEAR,  UNKNOWN,             R16_TYPELESS),
+        DXGI_TRAITS(R16_SINT,                   16,  0,  LINEAR,  UNKNOWN,             R16_TYPELESS),
+        DXGI_TRAITS(R8_TYPELESS,                8,   0,  LINEAR,  UNKNOWN,             R8_TYPELESS),
+        DXGI_TRAITS(R8_UNORM,                   8,   0,  LINEAR,  UNKNOWN,             R8_TYPELESS),
+        DXGI_TRAITS(R8_UINT,                    8,   0,  LINEAR,  UNKNOWN,             R8_TYPELESS),
+        DXGI_TRAITS(R8_SNORM,                   8,   0,  LINEAR,  UNKNOWN,             R8_TYPELESS),
+        DXGI_TRAITS(R8_SINT,                    8,   0,  LINEAR,  UNKNOWN,             R8_TYPELESS),
+        DXGI_TRAITS(A8_UNORM,                   8,   0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(R1_UNORM,                   1,   0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(R9G9B9E5_SHAREDEXP,         32,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(R8G8_B8G8_UNORM,            32,  4,  PACKED,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(G8R8_G8B8_UNORM,            32,  4,  PACKED,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(BC1_TYPELESS,               4,   8,  BLOCK,   UNKNOWN,             BC1_TYPELESS),
+        DXGI_TRAITS(BC1_UNORM,                  4,   8,  BLOCK,   BC1_UNORM_SRGB,      BC1_TYPELESS),
+        DXGI_TRAITS(BC1_UNORM_SRGB,             4,   8,  BLOCK,   UNKNOWN,             BC1_TYPELESS),
+        DXGI_TRAITS(BC2_TYPELESS,               8,   16, BLOCK,   UNKNOWN,             BC2_TYPELESS),
+        DXGI_TRAITS(BC2_UNORM,                  8,   16, BLOCK,   BC2_UNORM_SRGB,      BC2_TYPELESS),
+        DXGI_TRAITS(BC2_UNORM_SRGB,             8,   16, BLOCK,   UNKNOWN,             BC2_TYPELESS),
+        DXGI_TRAITS(BC3_TYPELESS,               8,   16, BLOCK,   UNKNOWN,             BC3_TYPELESS),
+        DXGI_TRAITS(BC3_UNORM,                  8,   16, BLOCK,   BC3_UNORM_SRGB,      BC3_TYPELESS),
+        DXGI_TRAITS(BC3_UNORM_SRGB,             8,   16, BLOCK,   UNKNOWN,             BC3_TYPELESS),
+        DXGI_TRAITS(BC4_TYPELESS,               4,   8,  BLOCK,   UNKNOWN,             BC4_TYPELESS),
+        DXGI_TRAITS(BC4_UNORM,                  4,   8,  BLOCK,   UNKNOWN,             BC4_TYPELESS),
+        DXGI_TRAITS(BC4_SNORM,                  4,   8,  BLOCK,   UNKNOWN,             BC4_TYPELESS),
+        DXGI_TRAITS(BC5_TYPELESS,               8,   16, BLOCK,   UNKNOWN,             BC5_TYPELESS),
+        DXGI_TRAITS(BC5_UNORM,                  8,   16, BLOCK,   UNKNOWN,             BC5_TYPELESS),
+        DXGI_TRAITS(BC5_SNORM,                  8,   16, BLOCK,   UNKNOWN,             BC5_TYPELESS),
+        DXGI_TRAITS(B5G6R5_UNORM,               16,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(B5G5R5A1_UNORM,             16,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(B8G8R8A8_UNORM,             32,  0,  LINEAR,  B8G8R8A8_UNORM_SRGB, B8G8R8A8_TYPELESS),
+        DXGI_TRAITS(B8G8R8X8_UNORM,             32,  0,  LINEAR,  B8G8R8X8_UNORM_SRGB, B8G8R8X8_TYPELESS),
+        DXGI_TRAITS(R10G10B10_XR_BIAS_A2_UNORM, 32,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(B8G8R8A8_TYPELESS,          32,  0,  LINEAR,  UNKNOWN,             B8G8R8A8_TYPELESS),
+        DXGI_TRAITS(B8G8R8A8_UNORM_SRGB,        32,  0,  LINEAR,  UNKNOWN,             B8G8R8A8_TYPELESS),
+        DXGI_TRAITS(B8G8R8X8_TYPELESS,          32,  0,  LINEAR,  UNKNOWN,             B8G8R8X8_TYPELESS),
+        DXGI_TRAITS(B8G8R8X8_UNORM_SRGB,        32,  0,  LINEAR,  UNKNOWN,             B8G8R8X8_TYPELESS),
+        DXGI_TRAITS(BC6H_TYPELESS,              8,   16, BLOCK,   UNKNOWN,             BC6H_TYPELESS),
+        DXGI_TRAITS(BC6H_UF16,                  8,   16, BLOCK,   UNKNOWN,             BC6H_TYPELESS),
+        DXGI_TRAITS(BC6H_SF16,                  8,   16, BLOCK,   UNKNOWN,             BC6H_TYPELESS),
+        DXGI_TRAITS(BC7_TYPELESS,               8,   16, BLOCK,   UNKNOWN,             BC7_TYPELESS),
+        DXGI_TRAITS(BC7_UNORM,                  8,   16, BLOCK,   BC7_UNORM_SRGB,      BC7_TYPELESS),
+        DXGI_TRAITS(BC7_UNORM_SRGB,             8,   16, BLOCK,   UNKNOWN,             BC7_TYPELESS),
+        DXGI_TRAITS(AYUV,                       32,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(Y410,                       32,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(Y416,                       64,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(NV12,                       12,  2,  PLANAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(P010,                       24,  4,  PLANAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(P016,                       24,  4,  PLANAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(420_OPAQUE,                 12,  2,  PLANAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(YUY2,                       32,  4,  PACKED,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(Y210,                       64,  8,  PACKED,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(Y216,                       64,  8,  PACKED,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(NV11,                       12,  4,  NV11,    UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(AI44,                       8,   0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(IA44,                       8,   0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(P8,                         8,   0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(A8P8,                       16,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+        DXGI_TRAITS(B4G4R4A4_UNORM,             16,  0,  LINEAR,  UNKNOWN,             UNKNOWN),
+    };
+
+#undef DXGI_TRAITS
+
+    constexpr size_t c_DXGIFormatTraitsCount = sizeof(c_DXGIFormatTraits) / sizeof(c_DXGIFormatTraits[0]);
+
+    // Anything past the end of the table gets the DXGI_FORMAT_UNKNOWN row
+    constexpr const DXGIFormatTraits& GetDXGIFormatTraits(DXGI_FORMAT format) noexcept
+    {
+        return c_DXGIFormatTraits[(static_cast<uint32_t>(format) < c_DXGIFormatTraitsCount) ? static_cast<uint32_t>(format) : 0];
+    }
+
+    // 0 for formats the loader can't size
+    constexpr size_t BitsPerPixel(DXGI_FORMAT format) noexcept
+    {
+        return GetDXGIFormatTraits(format).bitsPerPixel;
+    }
+
+    constexpr bool IsCompressed(DXGI_FORMAT format) noexcept
+    {
+        return GetDXGIFormatTraits(format).layout == DXGI_FORMAT_LAYOUT_BLOCK;
+    }
+
+    // The _SRGB twin of format, or format itself if it has none
+    constexpr DXGI_FORMAT MakeSRGB(DXGI_FORMAT format) noexcept
+    {
+        const DXGIFormatTraits& traits = GetDXGIFormatTraits(format);
+        return (traits.srgb != DXGI_FORMAT_UNKNOWN) ? traits.srgb : format;
+    }
+
+    // The _TYPELESS member of format's family, or format itself if it has none
+    constexpr DXGI_FORMAT MakeTypeless(DXGI_FORMAT format) noexcept
+    {
+        const DXGIFormatTraits& traits = GetDXGIFormatTraits(format);
+        return (traits.typeless != DXGI_FORMAT_UNKNOWN) ? traits.typeless : format;
+    }
+
+    namespace Internal
+    {
+        constexpr bool IsDXGIFormatTraitsInOrder() noexcept
+        {
+            for (size_t i = 0; i < c_DXGIFormatTraitsCount; i++)
+            {
+                if (static_cast<size_t>(c_DXGIFormatTraits[i].format) != i)
+                    return false;
+            }
+            return true;
+        }
+    }
+
+    // Rows are looked up by index, so a missing or misplaced row would shift every format after it
+    static_assert(Internal::IsDXGIFormatTraitsInOrder(), "DXGI format traits out of order");
+    static_assert(c_DXGIFormatTraitsCount == DXGI_FORMAT_B4G4R4A4_UNORM + 1, "DXGI format traits incomplete");
+
+    // The sizes and conversions the loader's switch statements used to give, one per case
+    static_assert(BitsPerPixel(DXGI_FORMAT_UNKNOWN) == 0, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_R32G32B32A32_FLOAT) == 128, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_R32G32B32_UINT) == 96, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_X32_TYPELESS_G8X24_UINT) == 64, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_Y416) == 64, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_Y210) == 64, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) == 32, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_R9G9B9E5_SHAREDEXP) == 32, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_YUY2) == 32, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_P016) == 24, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_A8P8) == 16, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_B4G4R4A4_UNORM) == 16, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_NV11) == 12, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_P8) == 8, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_R1_UNORM) == 1, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_BC4_SNORM) == 4, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_BC6H_SF16) == 8, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_P208) == 0, "");
+    static_assert(BitsPerPixel(DXGI_FORMAT_FORCE_UINT) == 0, "");
+
+    static_assert(GetDXGIFormatTraits(DXGI_FORMAT_BC1_UNORM_SRGB).elementBytes == 8, "");
+    static_assert(GetDXGIFormatTraits(DXGI_FORMAT_BC4_TYPELESS).elementBytes == 8, "");
+    static_assert(GetDXGIFormatTraits(DXGI_FORMAT_BC7_UNORM).elementBytes == 16, "");
+    static_assert(GetDXGIFormatTraits(DXGI_FORMAT_G8R8_G8B8_UNORM).layout == DXGI_FORMAT_LAYOUT_PACKED, "");
+    static_assert(GetDXGIFormatTraits(DXGI_FORMAT_Y216).elementBytes == 8, "");
+    static_assert(GetDXGIFormatTraits(DXGI_FORMAT_420_OPAQUE).layout == DXGI_FORMAT_LAYOUT_PLANAR, "");
+    static_assert(GetDXGIFormatTraits(DXGI_FORMAT_P010).elementBytes == 4, "");
+    static_assert(GetDXGIFormatTraits(DXGI_FORMAT_NV11).layout == DXGI_FORMAT_LAYOUT_NV11, "");
+    static_assert(GetDXGIFormatTraits(DXGI_FORMAT_AYUV).layout == DXGI_FORMAT_LAYOUT_LINEAR, "");
+
+    static_assert(MakeSRGB(DXGI_FORMAT_R8G8B8A8_UNORM) == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, "");
+    static_assert(MakeSRGB(DXGI_FORMAT_B8G8R8X8_UNORM) == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB, "");
+    static_assert(MakeSRGB(DXGI_FORMAT_BC7_UNORM) == DXGI_FORMAT_BC7_UNORM_SRGB, "");
+    static_assert(MakeSRGB(DXGI_FORMAT_BC3_UNORM_SRGB) == DXGI_FORMAT_BC3_UNORM_SRGB, "");
+    static_assert(MakeSRGB(DXGI_FORMAT_BC4_UNORM) == DXGI_FORMAT_BC4_UNORM, "");
+    static_assert(MakeSRGB(DXGI_FORMAT_R8G8B8A8_TYPELESS) == DXGI_FORMAT_R8G8B8A8_TYPELESS, "");
+
+    static_assert(MakeTypeless(DXGI_FORMAT_D24_UNORM_S8_UINT) == DXGI_FORMAT_R24G8_TYPELESS, "");
+    static_assert(MakeTypeless(DXGI_FORMAT_BC1_UNORM_SRGB) == DXGI_FORMAT_BC1_TYPELESS, "");
+    static_assert(MakeTypeless(DXGI_FORMAT_A8_UNORM) == DXGI_FORMAT_A8_UNORM, "");
+}
@@ -0,0 +1,917 @@
+//--------------------------------------------------------------------------------------
+// File: FileSource.cpp
+//
+// Win32, POSIX and io_uring file sources
+//
+// The io_uring source talks to the kernel directly rather than through liburing, so
+// nothing beyond the kernel headers is needed to build it.
+//--------------------------------------------------------------------------------------
+
+#include "FileSource.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <mutex>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    // Largest single read. Win32 reads take a DWORD and Linux caps pread at just under 2GB.
+    constexpr size_t c_MaxReadSize = 0x40000000;
+
+    // Clamps a request to the file and allocates its buffer
+    HRESULT PrepareRequest(FileReadRequest& request, uint64_t fileSize) noexcept
+    {
+        uint64_t available = (request.offset < fileSize) ? fileSize - request.offset : 0;
+        uint64_t size = (request.size == 0 || request.size > available) ? available : request.size;
+        if (size > SIZE_MAX)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        request.size = size_t(size);
+
+        // Never null, so an empty range still reads as success
+        request.data.reset(new (std::nothrow) uint8_t[std::max<size_t>(request.size, 1)]);
+        if (!request.data)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        return S_OK;
+    }
+
+#ifdef _WIN32
+    //----------------------------------------------------------------------------------
+    struct handle_closer { void operator()(HANDLE h) noexcept { if (h) CloseHandle(h); } };
+
+    using ScopedHandle = std::unique_ptr<void, handle_closer>;
+
+    inline HANDLE safe_handle(HANDLE h) noexcept { return (h == INVALID_HANDLE_VALUE) ? nullptr : h; }
+
+    class Win32File : public IFileSourceFile
+    {
+    public:
+        Win32File(HANDLE hFile, uint64_t size) noexcept : m_File(hFile), m_Size(size) {}
+
+        uint64_t GetSize() const noexcept override { return m_Size; }
+
+        HRESULT Read(uint64_t offset, void* buffer, size_t size, size_t* bytesRead) noexcept override
+        {
+            if (!bytesRead || (!buffer && size))
+            {
+                return E_INVALIDARG;
+            }
+
+            *bytesRead = 0;
+            auto dest = static_cast<uint8_t*>(buffer);
+            while (*bytesRead < size)
+            {
+                // On a handle opened for synchronous I/O the overlapped offset just positions the read
+                uint64_t position = offset + *bytesRead;
+                OVERLAPPED overlapped = {};
+                overlapped.Offset = static_cast<DWORD>(position);
+                overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+
+                DWORD chunk = static_cast<DWORD>(std::min(size - *bytesRead, c_MaxReadSize));
+                DWORD read = 0;
+                if (!ReadFile(m_File.get(), dest + *bytesRead, chunk, &read, &overlapped))
+                {
+                    DWORD error = GetLastError();
+                    if (error == ERROR_HANDLE_EOF)
+                        break;
+
+                    return HRESULT_FROM_WIN32(error);
+                }
+
+                if (read == 0)
+                    break;
+
+                *bytesRead += read;
+            }
+
+            return S_OK;
+        }
+
+    private:
+        ScopedHandle m_File;
+        uint64_t m_Size;
+    };
+
+    class Win32FileSource : public IFileSource
+    {
+    public:
+        HRESULT Open(const wchar_t* fileName, std::unique_ptr<IFileSourceFile>& file) noexcept override
+        {
+            file.reset();
+
+            if (!fileName)
+            {
+                return E_INVALIDARG;
+            }
+
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+            ScopedHandle hFile(safe_handle(CreateFile2(fileName,
+                GENERIC_READ,
+                FILE_SHARE_READ,
+                OPEN_EXISTING,
+                nullptr)));
+#else
+            ScopedHandle hFile(safe_handle(CreateFileW(fileName,
+                GENERIC_READ,
+                FILE_SHARE_READ,
+                nullptr,
+                OPEN_EXISTING,
+                FILE_ATTRIBUTE_NORMAL,
+                nullptr)));
+#endif
+
+            if (!hFile)
+            {
+                return HRESULT_FROM_WIN32(GetLastError());
+            }
+
+            FILE_STANDARD_INFO fileInfo;
+            if (!GetFileInformationByHandleEx(hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+            {
+                return HRESULT_FROM_WIN32(GetLastError());
+            }
+
+            file.reset(new (std::nothrow) Win32File(hFile.get(), static_cast<uint64_t>(fileInfo.EndOfFile.QuadPart)));
+            if (!file)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            hFile.release();
+            return S_OK;
+        }
+
+        const char* GetName() const noexcept override { return "Win32"; }
+    };
+#else
+    //----------------------------------------------------------------------------------
+    // wchar_t is UTF-32 everywhere but Windows. Returns false if the path doesn't fit.
+    bool WideToUTF8(const wchar_t* name, char* dest, size_t size) noexcept
+    {
+        size_t length = 0;
+        for (const wchar_t* c = name; *c; c++)
+        {
+            auto codePoint = static_cast<uint32_t>(*c);
+            size_t count = (codePoint < 0x80) ? 1 : (codePoint < 0x800) ? 2 : (codePoint < 0x10000) ? 3 : 4;
+            if (length + count >= size)
+                return false;
+
+            if (count == 1)
+            {
+                dest[length++] = char(codePoint);
+                continue;
+            }
+
+            static const uint8_t c_Lead[] = { 0, 0, 0xc0, 0xe0, 0xf0 };
+            for (size_t i = count - 1; i > 0; i--)
+            {
+                dest[length + i] = char(0x80 | (codePoint & 0x3f));
+                codePoint >>= 6;
+            }
+            dest[length] = char(c_Lead[count] | codePoint);
+            length += count;
+        }
+
+        dest[length] = 0;
+        return true;
+    }
+
+    HRESULT HResultFromErrno(int error) noexcept
+    {
+        switch (error)
+        {
+        case ENOENT:
+        case ENOTDIR:   return HRESULT_FROM_WIN32(2 /*ERROR_FILE_NOT_FOUND*/);
+        case EACCES:
+        case EPERM:     return HRESULT_FROM_WIN32(5 /*ERROR_ACCESS_DENIED*/);
+        case EMFILE:
+        case ENFILE:    return HRESULT_FROM_WIN32(4 /*ERROR_TOO_MANY_OPEN_FILES*/);
+        case ENOMEM:    return E_OUTOFMEMORY;
+        case EINVAL:    return E_INVALIDARG;
+        default:        return E_FAIL;
+        }
+    }
+
+    HRESULT OpenPosixFile(const wchar_t* fileName, int* file, uint64_t* size) noexcept
+    {
+        *file = -1;
+        *size = 0;
+
+        if (!fileName)
+        {
+            return E_INVALIDARG;
+        }
+
+        char path[4096];
+        if (!WideToUTF8(fileName, path, sizeof(path)))
+        {
+            return E_INVALIDARG;
+        }
+
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return HResultFromErrno(errno);
+        }
+
+        struct stat fileInfo = {};
+        if (fstat(fd, &fileInfo) != 0)
+        {
+            HRESULT hr = HResultFromErrno(errno);
+            close(fd);
+            return hr;
+        }
+
+        *file = fd;
+        *size = static_cast<uint64_t>(fileInfo.st_size);
+        return S_OK;
+    }
+
+    class PosixFile : public IFileSourceFile
+    {
+    public:
+        PosixFile(int file, uint64_t size) noexcept : m_File(file), m_Size(size) {}
+        ~PosixFile() override { close(m_File); }
+
+        PosixFile(const PosixFile&) = delete;
+        PosixFile& operator=(const PosixFile&) = delete;
+
+        uint64_t GetSize() const noexcept override { return m_Size; }
+
+        HRESULT Read(uint64_t offset, void* buffer, size_t size, size_t* bytesRead) noexcept override
+        {
+            if (!bytesRead || (!buffer && size))
+            {
+                return E_INVALIDARG;
+            }
+
+            *bytesRead = 0;
+            auto dest = static_cast<uint8_t*>(buffer);
+            while (*bytesRead < size)
+            {
+                ssize_t read = pread(m_File, dest + *bytesRead, std::min(size - *bytesRead, c_MaxReadSize),
+                    static_cast<off_t>(offset + *bytesRead));
+                if (read < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+
+                    return HResultFromErrno(errno);
+                }
+
+                if (read == 0)
+                    break;
+
+                *bytesRead += size_t(read);
+            }
+
+            return S_OK;
+        }
+
+    private:
+        int m_File;
+        uint64_t m_Size;
+    };
+
+    class PosixFileSource : public IFileSource
+    {
+    public:
+        HRESULT Open(const wchar_t* fileName, std::unique_ptr<IFileSourceFile>& file) noexcept override
+        {
+            file.reset();
+
+            int fd = -1;
+            uint64_t size = 0;
+            HRESULT hr = OpenPosixFile(fileName, &fd, &size);
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            file.reset(new (std::nothrow) PosixFile(fd, size));
+            if (!file)
+            {
+                close(fd);
+                return E_OUTOFMEMORY;
+            }
+
+            return S_OK;
+        }
+
+        const char* GetName() const noexcept override { return "POSIX"; }
+    };
+#endif
+
+#ifdef __linux__
+    //----------------------------------------------------------------------------------
+    // The rings are shared with the kernel: the kernel moves the submission head and the
+    // completion tail, this side the other two, each published with release ordering.
+    class IoUringFileSource : public PosixFileSource
+    {
+    public:
+        IoUringFileSource() noexcept = default;
+        ~IoUringFileSource() override
+        {
+            if (m_SQEntries)
+                munmap(m_SQEntries, m_SQEntriesSize);
+            if (m_CQRing && m_CQRing != m_SQRing)
+                munmap(m_CQRing, m_CQRingSize);
+            if (m_SQRing)
+                munmap(m_SQRing, m_SQRingSize);
+            if (m_Ring >= 0)
+                close(m_Ring);
+        }
+
+        IoUringFileSource(const IoUringFileSource&) = delete;
+        IoUringFileSource& operator=(const IoUringFileSource&) = delete;
+
+        HRESULT Initialize(size_t queueDepth) noexcept
+        {
+            io_uring_params params = {};
+            m_Ring = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queueDepth), &params));
+            if (m_Ring < 0)
+            {
+                return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+            }
+
+            m_SQRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+            m_CQRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+            // Since 5.4 both rings come from one mapping
+            bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (singleMap)
+            {
+                m_SQRingSize = m_CQRingSize = std::max(m_SQRingSize, m_CQRingSize);
+            }
+
+            m_SQRing = static_cast<uint8_t*>(MapRing(m_SQRingSize, IORING_OFF_SQ_RING));
+            if (!m_SQRing)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            m_CQRing = singleMap ? m_SQRing : static_cast<uint8_t*>(MapRing(m_CQRingSize, IORING_OFF_CQ_RING));
+            if (!m_CQRing)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            m_SQEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+            m_SQEntries = static_cast<io_uring_sqe*>(MapRing(m_SQEntriesSize, IORING_OFF_SQES));
+            if (!m_SQEntries)
+            {
+                return E_OUTOFMEMORY;
+            }
+
+            m_SQHead = reinterpret_cast<uint32_t*>(m_SQRing + params.sq_off.head);
+            m_SQTail = reinterpret_cast<uint32_t*>(m_SQRing + params.sq_off.tail);
+            m_SQMask = *reinterpret_cast<uint32_t*>(m_SQRing + params.sq_off.ring_mask);
+            m_SQArray = reinterpret_cast<uint32_t*>(m_SQRing + params.sq_off.array);
+            m_CQHead = reinterpret_cast<uint32_t*>(m_CQRing + params.cq_off.head);
+            m_CQTail = reinterpret_cast<uint32_t*>(m_CQRing + params.cq_off.tail);
+            m_CQMask = *reinterpret_cast<uint32_t*>(m_CQRing + params.cq_off.ring_mask);
+            m_CQEntries = reinterpret_cast<io_uring_cqe*>(m_CQRing + params.cq_off.cqes);
+
+            // Completions can't overflow as long as no more reads are in flight than the
+            // completion ring holds, which is at least as big as the submission ring
+            m_MaxInFlight = params.sq_entries;
+            return S_OK;
+        }
+
+        HRESULT ReadFiles(FileReadRequest* requests, size_t count) noexcept override;
+
+        const char* GetName() const noexcept override { return "io_uring"; }
+
+    private:
+        int m_Ring = -1;
+
+        uint8_t* m_SQRing = nullptr;
+        uint8_t* m_CQRing = nullptr;
+        io_uring_sqe* m_SQEntries = nullptr;
+        size_t m_SQRingSize = 0;
+        size_t m_CQRingSize = 0;
+        size_t m_SQEntriesSize = 0;
+
+        uint32_t* m_SQHead = nullptr;
+        uint32_t* m_SQTail = nullptr;
+        uint32_t m_SQMask = 0;
+        uint32_t* m_SQArray = nullptr;
+        uint32_t* m_CQHead = nullptr;
+        uint32_t* m_CQTail = nullptr;
+        uint32_t m_CQMask = 0;
+        io_uring_cqe* m_CQEntries = nullptr;
+
+        size_t m_MaxInFlight = 0;
+
+        // One batch at a time goes through the ring
+        std::mutex m_Mutex;
+
+        void* MapRing(size_t size, off_t offset) noexcept
+        {
+            void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Ring, offset);
+            return (ring == MAP_FAILED) ? nullptr : ring;
+        }
+    };
+
+    // Per request state while a batch is in flight
+    struct IoUringRead
+    {
+        int file;
+        size_t done;
+        bool inFlight;  // the kernel has an entry for it, so its buffer must stay put
+        iovec vector;
+    };
+
+    HRESULT IoUringFileSource::ReadFiles(FileReadRequest* requests, size_t count) noexcept
+    {
+        if (count > 0 && !requests)
+        {
+            return E_INVALIDARG;
+        }
+
+        std::unique_ptr<IoUringRead[]> reads(new (std::nothrow) IoUringRead[count]);
+        std::unique_ptr<size_t[]> queue(new (std::nothrow) size_t[count]);
+        if (count > 0 && (!reads || !queue))
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            requests[i].data.reset();
+            requests[i].result = S_OK;
+            reads[i] = { -1, 0, false, {} };
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        // Each open request sits in the queue, or has one read in flight, until it is done
+        size_t queueHead = 0;
+        size_t queueCount = 0;
+        size_t inFlight = 0;
+        size_t nextOpen = 0;
+        size_t openFiles = 0;
+
+        // Takes every completion there is. Short reads go back in the queue unless the ring is
+        // being drained; a request that is done with its file closes it.
+        auto collect = [&](bool draining)
+        {
+            uint32_t head = *m_CQHead;
+            uint32_t cqTail = __atomic_load_n(m_CQTail, __ATOMIC_ACQUIRE);
+            for (; head != cqTail; head++)
+            {
+                const io_uring_cqe& cqe = m_CQEntries[head & m_CQMask];
+                auto index = static_cast<size_t>(cqe.user_data);
+                inFlight--;
+
+                FileReadRequest& request = requests[index];
+                IoUringRead& read = reads[index];
+                read.inFlight = false;
+
+                bool again = false;
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+                {
+                    again = true;
+                }
+                else if (cqe.res < 0)
+                {
+                    request.result = HResultFromErrno(-cqe.res);
+                }
+                else if (cqe.res == 0)
+                {
+                    // The file shrank since it was sized
+                    request.size = read.done;
+                }
+                else
+                {
+                    read.done += static_cast<size_t>(cqe.res);
+                    again = read.done < request.size;
+                }
+
+                if (again && !draining)
+                {
+                    queue[(queueHead + queueCount++) % count] = index;
+                }
+                else
+                {
+                    close(read.file);
+                    read.file = -1;
+                    openFiles--;
+                }
+            }
+
+            __atomic_store_n(m_CQHead, head, __ATOMIC_RELEASE);
+        };
+
+        HRESULT ringResult = S_OK;
+        for (;;)
+        {
+            // Files are opened as others finish, so a batch never holds more open than the ring
+            // has entries, however many files it names. Opening stays synchronous; it is the
+            // reads that are worth overlapping.
+            while (nextOpen < count && openFiles < m_MaxInFlight)
+            {
+                FileReadRequest& request = requests[nextOpen];
+                IoUringRead& read = reads[nextOpen];
+
+                uint64_t fileSize = 0;
+                request.result = OpenPosixFile(request.fileName, &read.file, &fileSize);
+                if (SUCCEEDED(request.result))
+                {
+                    request.result = PrepareRequest(request, fileSize);
+                }
+
+                if (SUCCEEDED(request.result) && request.size > 0)
+                {
+                    queue[(queueHead + queueCount++) % count] = nextOpen;
+                    openFiles++;
+                }
+                else if (read.file >= 0)
+                {
+                    close(read.file);
+                    read.file = -1;
+                }
+
+                nextOpen++;
+            }
+
+            if (queueCount == 0 && inFlight == 0)
+            {
+                break;
+            }
+
+            // A read counts as in flight from the moment its entry is written; the ring and the
+            // completion queue are sized so that many can never overflow either
+            uint32_t tail = *m_SQTail;
+            while (queueCount > 0 && inFlight < m_MaxInFlight)
+            {
+                size_t index = queue[queueHead];
+                queueHead = (queueHead + 1) % count;
+                queueCount--;
+
+                FileReadRequest& request = requests[index];
+                IoUringRead& read = reads[index];
+                read.vector.iov_base = request.data.get() + read.done;
+                read.vector.iov_len = std::min(request.size - read.done, c_MaxReadSize);
+                read.inFlight = true;
+
+                io_uring_sqe& sqe = m_SQEntries[tail & m_SQMask];
+                memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = IORING_OP_READV;
+                sqe.fd = read.file;
+                sqe.off = request.offset + read.done;
+                sqe.addr = reinterpret_cast<uint64_t>(&read.vector);
+                sqe.len = 1;
+                sqe.user_data = index;
+
+                m_SQArray[tail & m_SQMask] = tail & m_SQMask;
+                tail++;
+                inFlight++;
+            }
+
+            __atomic_store_n(m_SQTail, tail, __ATOMIC_RELEASE);
+
+            // Submits every entry the kernel hasn't taken yet and waits for at least one read,
+            // in the same call. Entries left over after an interruption go with the next one.
+            unsigned int toSubmit = tail - __atomic_load_n(m_SQHead, __ATOMIC_ACQUIRE);
+            if (syscall(__NR_io_uring_enter, m_Ring, toSubmit, 1u, IORING_ENTER_GETEVENTS, nullptr, 0) < 0
+                && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                ringResult = HResultFromErrno(errno);
+                break;
+            }
+
+            collect(false);
+        }
+
+        if (FAILED(ringResult))
+        {
+            // The ring is unusable, but the kernel may still be reading into buffers it took
+            // entries for, so those reads are waited out before anything is freed. Entries it
+            // never took are taken back; without SQPOLL it only reads the tail when entered.
+            uint32_t sqHead = __atomic_load_n(m_SQHead, __ATOMIC_ACQUIRE);
+            for (uint32_t entry = sqHead; entry != *m_SQTail; entry++)
+            {
+                reads[static_cast<size_t>(m_SQEntries[entry & m_SQMask].user_data)].inFlight = false;
+                inFlight--;
+            }
+            __atomic_store_n(m_SQTail, sqHead, __ATOMIC_RELEASE);
+
+            for (;;)
+            {
+                collect(true);
+                if (inFlight == 0)
+                {
+                    break;
+                }
+
+                if (syscall(__NR_io_uring_enter, m_Ring, 0u, 1u, IORING_ENTER_GETEVENTS, nullptr, 0) < 0
+                    && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+                {
+                    break;
+                }
+            }
+
+            // Whatever hasn't finished fails, including requests that were never opened
+            for (size_t i = 0; i < count; i++)
+            {
+                if (SUCCEEDED(requests[i].result) && (i >= nextOpen || reads[i].done < requests[i].size))
+                {
+                    requests[i].result = ringResult;
+                }
+
+                // A read the kernel still holds can't have its buffer freed, so it is given up
+                // on instead; the kernel keeps its own reference to the file
+                if (reads[i].inFlight)
+                {
+                    (void)requests[i].data.release();
+                }
+            }
+        }
+
+        bool failed = false;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (reads[i].file >= 0)
+            {
+                close(reads[i].file);
+            }
+
+            if (FAILED(requests[i].result))
+            {
+                requests[i].data.reset();
+                requests[i].size = 0;
+                failed = true;
+            }
+        }
+
+        return failed ? S_FALSE : S_OK;
+    }
+#endif
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT IFileSource::ReadFiles(FileReadRequest* requests, size_t count) noexcept
+{
+    if (count > 0 && !requests)
+    {
+        return E_INVALIDARG;
+    }
+
+    bool failed = false;
+    for (size_t i = 0; i < count; i++)
+    {
+        FileReadRequest& request = requests[i];
+        request.data.reset();
+
+        std::unique_ptr<IFileSourceFile> file;
+        request.result = Open(request.fileName, file);
+        if (SUCCEEDED(request.result))
+        {
+            request.result = PrepareRequest(request, file->GetSize());
+        }
+
+        if (SUCCEEDED(request.result))
+        {
+            size_t bytesRead = 0;
+            request.result = file->Read(request.offset, request.data.get(), request.size, &bytesRead);
+            request.size = bytesRead;
+        }
+
+        if (FAILED(request.result))
+        {
+            request.data.reset();
+            request.size = 0;
+            failed = true;
+        }
+    }
+
+    return failed ? S_FALSE : S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+FileMapping::FileMapping(FileMapping&& other) noexcept :
+    m_Data(other.m_Data),
+    m_Size(other.m_Size)
+{
+    other.m_Data = nullptr;
+    other.m_Size = 0;
+}
+
+FileMapping& FileMapping::operator=(FileMapping&& other) noexcept
+{
+    if (this != &other)
+    {
+        Close();
+        std::swap(m_Data, other.m_Data);
+        std::swap(m_Size, other.m_Size);
+    }
+
+    return *this;
+}
+
+_Use_decl_annotations_
+HRESULT FileMapping::Open(const wchar_t* fileName) noexcept
+{
+    Close();
+
+    if (!fileName)
+    {
+        return E_INVALIDARG;
+    }
+
+#ifdef _WIN32
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    ScopedHandle hFile(safe_handle(CreateFile2(fileName,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        OPEN_EXISTING,
+        nullptr)));
+#else
+    ScopedHandle hFile(safe_handle(CreateFileW(fileName,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr)));
+#endif
+
+    if (!hFile)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    FILE_STANDARD_INFO fileInfo;
+    if (!GetFileInformationByHandleEx(hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    auto fileSize = static_cast<uint64_t>(fileInfo.EndOfFile.QuadPart);
+    if (fileSize == 0 || fileSize > SIZE_MAX)
+    {
+        return E_FAIL;
+    }
+
+    // The view keeps the mapping object alive, so the mapping handle can be closed right away
+    ScopedHandle hMapping(CreateFileMappingW(hFile.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+    if (!hMapping)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_Data = static_cast<const uint8_t*>(MapViewOfFile(hMapping.get(), FILE_MAP_READ, 0, 0, 0));
+    if (!m_Data)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+#else
+    int file = -1;
+    uint64_t fileSize = 0;
+    HRESULT hr = OpenPosixFile(fileName, &file, &fileSize);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    if (fileSize == 0 || fileSize > SIZE_MAX)
+    {
+        close(file);
+        return E_FAIL;
+    }
+
+    // The mapping holds its own reference to the file, so the descriptor can be closed now
+    void* view = mmap(nullptr, size_t(fileSize), PROT_READ, MAP_SHARED, file, 0);
+    int error = errno;
+    close(file);
+    if (view == MAP_FAILED)
+    {
+        return HResultFromErrno(error);
+    }
+
+    m_Data = static_cast<const uint8_t*>(view);
+#endif
+
+    m_Size = size_t(fileSize);
+    return S_OK;
+}
+
+void FileMapping::Close() noexcept
+{
+    if (m_Data)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_Data);
+#else
+        munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+    }
+
+    m_Data = nullptr;
+    m_Size = 0;
+}
+
+void FileMapping::Prefault() const noexcept
+{
+    if (!m_Data)
+        return;
+
+    // Ask for the whole view first, so the disk sees a few large reads rather than a fault
+    // per page, then wait for each page by touching it
+#ifdef _WIN32
+#if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+    WIN32_MEMORY_RANGE_ENTRY range = { const_cast<uint8_t*>(m_Data), m_Size };
+    (void)PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+#else
+    (void)madvise(const_cast<uint8_t*>(m_Data), m_Size, MADV_WILLNEED);
+#endif
+
+    // No platform the loaders run on has smaller pages
+    const size_t pageSize = 4096;
+    auto pages = static_cast<const volatile uint8_t*>(m_Data);
+    for (size_t offset = 0; offset < m_Size; offset += pageSize)
+        (void)pages[offset];
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::CreateDefaultFileSource(std::unique_ptr<IFileSource>& source) noexcept
+{
+#ifdef _WIN32
+    return CreateWin32FileSource(source);
+#else
+    return CreatePosixFileSource(source);
+#endif
+}
+
+#ifdef _WIN32
+_Use_decl_annotations_
+HRESULT DirectX::CreateWin32FileSource(std::unique_ptr<IFileSource>& source) noexcept
+{
+    source.reset(new (std::nothrow) Win32FileSource());
+    return source ? S_OK : E_OUTOFMEMORY;
+}
+#else
+_Use_decl_annotations_
+HRESULT DirectX::CreatePosixFileSource(std::unique_ptr<IFileSource>& source) noexcept
+{
+    source.reset(new (std::nothrow) PosixFileSource());
+    return source ? S_OK : E_OUTOFMEMORY;
+}
+#endif
+
+#ifdef __linux__
+_Use_decl_annotations_
+HRESULT DirectX::CreateIoUringFileSource(std::unique_ptr<IFileSource>& source, size_t queueDepth) noexcept
+{
+    source.reset();
+
+    if (queueDepth == 0 || queueDepth > 4096)
+    {
+        return E_INVALIDARG;
+    }
+
+    std::unique_ptr<IoUringFileSource> ring(new (std::nothrow) IoUringFileSource());
+    if (!ring)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    HRESULT hr = ring->Initialize(queueDepth);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    source = std::move(ring);
+    return S_OK;
+}
+#endif
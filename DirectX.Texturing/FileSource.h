@@ -0,0 +1,119 @@
+//--------------------------------------------------------------------------------------
+// File: FileSource.h
+//
+// Pluggable file access for the loaders, so the same parsing code can read through
+// Win32 handles, POSIX pread or a Linux io_uring that submits a whole batch of reads
+// with one system call.
+//
+//   IFileSource::Open       a file to read from at any offset, from any thread
+//   IFileSource::ReadFiles  many files, or the same range of each, into memory the
+//                           source allocates; the io_uring source overlaps them all
+//   FileMapping             a whole file mapped read-only, to parse without a copy
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <wsl/winadapter.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace DirectX
+{
+    class IFileSourceFile
+    {
+    public:
+        virtual ~IFileSourceFile() = default;
+
+        // Size when the file was opened
+        virtual uint64_t GetSize() const noexcept = 0;
+
+        // Positioned read, so it doesn't disturb other reads of the same file. bytesRead is
+        // only short of size at the end of the file.
+        virtual HRESULT Read(
+            _In_ uint64_t offset,
+            _Out_writes_bytes_(size) void* buffer,
+            _In_ size_t size,
+            _Out_ size_t* bytesRead) noexcept = 0;
+    };
+
+    struct FileReadRequest
+    {
+        const wchar_t* fileName;
+        uint64_t offset;
+        size_t size;                        // bytes to read, 0 for the rest of the file; on return, bytes read
+        std::unique_ptr<uint8_t[]> data;    // allocated by the source, size bytes
+        HRESULT result;
+    };
+
+    class IFileSource
+    {
+    public:
+        virtual ~IFileSource() = default;
+
+        virtual HRESULT Open(_In_z_ const wchar_t* fileName, _Out_ std::unique_ptr<IFileSourceFile>& file) noexcept = 0;
+
+        // Reads every request; each gets its own result, and the call returns S_FALSE if any
+        // failed. A range past the end of a file is cut short rather than failing. The base
+        // version opens and reads the files one after another.
+        virtual HRESULT ReadFiles(_Inout_updates_(count) FileReadRequest* requests, _In_ size_t count) noexcept;
+
+        virtual const char* GetName() const noexcept = 0;
+    };
+
+    // Read-only view of a whole file, so it can be parsed in place instead of read into a
+    // heap copy. MapViewOfFile on Windows and mmap elsewhere; unmapped by Close or on
+    // destruction. An empty file can't be mapped and fails with E_FAIL.
+    class FileMapping
+    {
+    public:
+        FileMapping() noexcept = default;
+        FileMapping(FileMapping&& other) noexcept;
+        FileMapping& operator=(FileMapping&& other) noexcept;
+        ~FileMapping() { Close(); }
+
+        FileMapping(const FileMapping&) = delete;
+        FileMapping& operator=(const FileMapping&) = delete;
+
+        HRESULT Open(_In_z_ const wchar_t* fileName) noexcept;
+        void Close() noexcept;
+
+        // Reads in every page of the view, so nothing reading from it later waits on the disk
+        void Prefault() const noexcept;
+
+        const uint8_t* GetData() const noexcept { return m_Data; }
+        size_t GetSize() const noexcept { return m_Size; }
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+    };
+
+    // Win32 on Windows, POSIX elsewhere
+    HRESULT CreateDefaultFileSource(_Out_ std::unique_ptr<IFileSource>& source) noexcept;
+
+#ifdef _WIN32
+    HRESULT CreateWin32FileSource(_Out_ std::unique_ptr<IFileSource>& source) noexcept;
+#else
+    HRESULT CreatePosixFileSource(_Out_ std::unique_ptr<IFileSource>& source) noexcept;
+#endif
+
+#ifdef __linux__
+    // Reads through a ring of queueDepth entries. ReadFiles opens files as earlier ones
+    // finish, so no more than queueDepth are open at once, submits up to queueDepth reads per
+    // system call and collects them as they complete; Open reads with pread. Running out of
+    // file descriptors fails a request with ERROR_TOO_MANY_OPEN_FILES. Fails with ERROR_NOT_SUPPORTED if the kernel doesn't have
+    // io_uring or it is blocked, in which case the POSIX source is the one to use.
+    HRESULT CreateIoUringFileSource(
+        _Out_ std::unique_ptr<IFileSource>& source,
+        _In_ size_t queueDepth = 64) noexcept;
+#endif
+}
@@ -1,80 +1,267 @@
 #include "GeometryGenerator.h"
 #include <DirectXMath.h>
 
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
 namespace
 {
-	void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, unsigned int sliceCount, unsigned int stackCount, MeshData* meshData)
+	const XMVECTORF32 g_Lanes = { { { 0.0f, 1.0f, 2.0f, 3.0f } } };
+
+	// Up to four vertices from their components. The transpose puts each vertex's x, y, z and u
+	// in one register, so it goes out in a single store, followed by its v.
+	void XM_CALLCONV StoreVertices(Vertex* vertices, unsigned int count, FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, GXMVECTOR u, HXMVECTOR v)
 	{
-		unsigned int baseIndex = (unsigned int)meshData->vertices.size();
+		XMMATRIX components;
+		components.r[0] = x;
+		components.r[1] = y;
+		components.r[2] = z;
+		components.r[3] = u;
+		XMMATRIX rows = XMMatrixTranspose(components);
+
+		XMFLOAT4A vs;
+		XMStoreFloat4A(&vs, v);
+		const float* vLanes = &vs.x;
+
+		for (unsigned int k = 0; k < count; ++k)
+		{
+			XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(&vertices[k].x), rows.r[k]);
+			vertices[k].v = vLanes[k];
+		}
+	}
 
-		float y = 0.5f * height;
-		float dTheta = 2.0f * DirectX::XM_PI / sliceCount;
+	// Radius changing linearly from the bottom ring to the top one; a cone has no top radius
+	struct TaperedProfile
+	{
+		float bottomRadius;
+		float topRadius;
+		float height;
 
-		// Duplicate cap ring vertices because the texture coordinates and normals differ.
-		for (unsigned int i = 0; i <= sliceCount; ++i)
+		void operator()(unsigned int ringCount, float* radii, float* heights) const
 		{
-			float x = topRadius * cosf(i * dTheta);
-			float z = topRadius * sinf(i * dTheta);
+			unsigned int stackCount = ringCount - 1;
+			float stackHeight = height / stackCount;
 
-			// Scale down by the height to try and make top cap texture coord area
-			// proportional to base.
-			float u = x / height + 0.5f;
-			float v = z / height + 0.5f;
+			// Amount to increment radius as we move up each stack level from bottom to top.
+			float radiusStep = (topRadius - bottomRadius) / stackCount;
 
-			meshData->vertices.push_back(Vertex(x, y, z, u, v));
+			for (unsigned int i = 0; i < stackCount; ++i)
+			{
+				radii[i] = bottomRadius + i * radiusStep;
+				heights[i] = -0.5f * height + i * stackHeight;
+			}
+
+			radii[stackCount] = topRadius;
+			heights[stackCount] = 0.5f * height;
 		}
+	};
 
-		// Cap center vertex.
-		meshData->vertices.push_back(Vertex(0.0f, y, 0.0f, 0.5f, 0.5f));
+	// From the bottom pole to the top one
+	struct SphereProfile
+	{
+		float radius;
 
-		// Index of center vertex.
-		unsigned int centerIndex = (unsigned int)meshData->vertices.size() - 1;
+		void operator()(unsigned int ringCount, float* radii, float* heights) const
+		{
+			unsigned int stackCount = ringCount - 1;
+
+			// The angle down from the top pole gives the ring's radius from its sine and its
+			// height from its cosine
+			Geometry::ComputeSinCos(XM_PI, -XM_PI / stackCount, ringCount, radii, heights);
+			for (unsigned int i = 0; i < ringCount; ++i)
+			{
+				radii[i] *= radius;
+				heights[i] *= radius;
+			}
+
+			radii[0] = 0.0f;
+			heights[0] = -radius;
+			radii[stackCount] = 0.0f;
+			heights[stackCount] = radius;
+		}
+	};
 
-		for (unsigned int i = 0; i < sliceCount; ++i)
+	// Once around the tube, starting and ending on the outside of the ring
+	struct TorusProfile
+	{
+		float radius;
+		float tubeRadius;
+
+		void operator()(unsigned int ringCount, float* radii, float* heights) const
 		{
-			meshData->indices.push_back(centerIndex);
-			meshData->indices.push_back(baseIndex + i + 1);
-			meshData->indices.push_back(baseIndex + i);
+			unsigned int stackCount = ringCount - 1;
+
+			Geometry::ComputeSinCos(0.0f, XM_2PI / stackCount, ringCount, heights, radii);
+			for (unsigned int i = 0; i < ringCount; ++i)
+			{
+				radii[i] = radius + tubeRadius * radii[i];
+				heights[i] *= tubeRadius;
+			}
+
+			radii[stackCount] = radii[0];
+			heights[stackCount] = heights[0];
 		}
-	}
+	};
+
+	// Icosahedron the geosphere is subdivided from
+	const float c_IcosahedronX = 0.525731f;
+	const float c_IcosahedronZ = 0.850651f;
 
-	void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, unsigned int sliceCount, unsigned int stackCount, MeshData* meshData)
+	const XMFLOAT3 c_IcosahedronVertices[12] =
 	{
-		// 
-		// Build bottom cap.
-		//
+		XMFLOAT3(-c_IcosahedronX, 0.0f, c_IcosahedronZ), XMFLOAT3(c_IcosahedronX, 0.0f, c_IcosahedronZ),
+		XMFLOAT3(-c_IcosahedronX, 0.0f, -c_IcosahedronZ), XMFLOAT3(c_IcosahedronX, 0.0f, -c_IcosahedronZ),
+		XMFLOAT3(0.0f, c_IcosahedronZ, c_IcosahedronX), XMFLOAT3(0.0f, c_IcosahedronZ, -c_IcosahedronX),
+		XMFLOAT3(0.0f, -c_IcosahedronZ, c_IcosahedronX), XMFLOAT3(0.0f, -c_IcosahedronZ, -c_IcosahedronX),
+		XMFLOAT3(c_IcosahedronZ, c_IcosahedronX, 0.0f), XMFLOAT3(-c_IcosahedronZ, c_IcosahedronX, 0.0f),
+		XMFLOAT3(c_IcosahedronZ, -c_IcosahedronX, 0.0f), XMFLOAT3(-c_IcosahedronZ, -c_IcosahedronX, 0.0f)
+	};
 
-		unsigned int baseIndex = (unsigned int)meshData->vertices.size();
-		float y = -0.5f * height;
+	const unsigned int c_IcosahedronFaces[20][3] =
+	{
+		{ 1, 4, 0 }, { 4, 9, 0 }, { 4, 5, 9 }, { 8, 5, 4 }, { 1, 8, 4 },
+		{ 1, 10, 8 }, { 10, 3, 8 }, { 8, 3, 5 }, { 3, 2, 5 }, { 3, 7, 2 },
+		{ 3, 10, 7 }, { 10, 6, 7 }, { 6, 11, 7 }, { 6, 0, 11 }, { 6, 1, 0 },
+		{ 10, 1, 6 }, { 11, 0, 9 }, { 2, 11, 9 }, { 5, 2, 9 }, { 11, 2, 7 }
+	};
 
-		// vertices of ring
-		float dTheta = 2.0f * DirectX::XM_PI / sliceCount;
-		for (unsigned int i = 0; i <= sliceCount; ++i)
+	// Every face of the icosahedron cut into a triangular grid of frequency rows, pushed out
+	// onto the sphere. Each face has its own vertices, so one that crosses the texture seam
+	// can keep its texture coordinates continuous; the vertices along its edges are copies.
+	class GeosphereSurface
+	{
+	public:
+		GeosphereSurface(float radius, unsigned int frequency)
+			: m_Radius(radius), m_Frequency(frequency)
 		{
-			float x = bottomRadius * cosf(i * dTheta);
-			float z = bottomRadius * sinf(i * dTheta);
+		}
 
-			// Scale down by the height to try and make top cap texture coord area
-			// proportional to base.
-			float u = x / height + 0.5f;
-			float v = z / height + 0.5f;
+		Geometry::SurfaceSize GetSize() const
+		{
+			Geometry::SurfaceSize size;
+			size.vertexCount = 20 * FaceVertexCount();
+			size.indexCount = 20 * m_Frequency * m_Frequency * 3;
+			return size;
+		}
 
-			meshData->vertices.push_back(Vertex(x, y, z, u, v));
+		void Generate(Vertex* vertices, unsigned int* indices) const
+		{
+			unsigned int faceVertexCount = FaceVertexCount();
+			unsigned int faceIndexCount = m_Frequency * m_Frequency * 3;
+
+			for (unsigned int face = 0; face < 20; ++face)
+			{
+				WriteFaceVertices(c_IcosahedronFaces[face], vertices + face * faceVertexCount);
+				WriteFaceIndices(face * faceVertexCount, indices + face * faceIndexCount);
+			}
 		}
 
-		// Cap center vertex.
-		meshData->vertices.push_back(Vertex(0.0f, y, 0.0f, 0.5f, 0.5f));
+	private:
+		unsigned int FaceVertexCount() const
+		{
+			return (m_Frequency + 1) * (m_Frequency + 2) / 2;
+		}
 
-		// Cache the index of center vertex.
-		unsigned int centerIndex = (unsigned int)meshData->vertices.size() - 1;
+		// Row i runs from corner 0 towards corner 1, i steps of the way towards corner 2
+		void WriteFaceVertices(const unsigned int corners[3], Vertex* vertices) const
+		{
+			XMVECTOR a = XMLoadFloat3(&c_IcosahedronVertices[corners[0]]);
+			XMVECTOR b = XMLoadFloat3(&c_IcosahedronVertices[corners[1]]);
+			XMVECTOR c = XMLoadFloat3(&c_IcosahedronVertices[corners[2]]);
+
+			// Every point is a weighted sum of the corners, with the weights worked out from whole
+			// steps. A point on an edge then has the same two nonzero terms in both faces that
+			// share it, and adding them in either order gives the same float, so the faces meet
+			// without cracks. Separate multiplies and adds, since a fused one would round differently.
+			XMVECTOR frequency = XMVectorReplicate((float)m_Frequency);
+
+			XMVECTOR aX = XMVectorSplatX(a), aY = XMVectorSplatY(a), aZ = XMVectorSplatZ(a);
+			XMVECTOR bX = XMVectorSplatX(b), bY = XMVectorSplatY(b), bZ = XMVectorSplatZ(b);
+			XMVECTOR cX = XMVectorSplatX(c), cY = XMVectorSplatY(c), cZ = XMVectorSplatZ(c);
+
+			XMVECTOR radius = XMVectorReplicate(m_Radius);
+			XMVECTOR inv2Pi = XMVectorReplicate(1.0f / XM_2PI);
+			XMVECTOR invPi = XMVectorReplicate(1.0f / XM_PI);
+			XMVECTOR one = XMVectorSplatOne();
+			XMVECTOR poleDistanceSq = XMVectorReplicate(1e-10f);
+
+			// u is kept within half a turn of the middle of the face. Across the seam that puts
+			// one side past 1 or below 0 rather than squeezing the whole texture into the face
+			// backwards, and a vertex on a pole, which has no u of its own, takes the middle's.
+			XMVECTOR middle = XMVectorAdd(XMVectorAdd(a, b), c);
+			float middleU = atan2f(XMVectorGetZ(middle), XMVectorGetX(middle)) / XM_2PI;
+			XMVECTOR faceU = XMVectorReplicate(middleU < 0.0f ? middleU + 1.0f : middleU);
+
+			Vertex* row = vertices;
+			for (unsigned int i = 0; i <= m_Frequency; ++i)
+			{
+				XMVECTOR rowSteps = XMVectorReplicate((float)i);
+				XMVECTOR weightC = XMVectorDivide(rowSteps, frequency);
+
+				unsigned int rowVertexCount = m_Frequency - i + 1;
+				for (unsigned int j = 0; j < rowVertexCount; j += 4)
+				{
+					XMVECTOR index = XMVectorAdd(XMVectorReplicate((float)j), g_Lanes);
+					XMVECTOR weightA = XMVectorDivide(XMVectorSubtract(XMVectorSubtract(frequency, rowSteps), index), frequency);
+					XMVECTOR weightB = XMVectorDivide(index, frequency);
+
+					XMVECTOR x = XMVectorAdd(XMVectorAdd(XMVectorMultiply(aX, weightA), XMVectorMultiply(bX, weightB)), XMVectorMultiply(cX, weightC));
+					XMVECTOR y = XMVectorAdd(XMVectorAdd(XMVectorMultiply(aY, weightA), XMVectorMultiply(bY, weightB)), XMVectorMultiply(cY, weightC));
+					XMVECTOR z = XMVectorAdd(XMVectorAdd(XMVectorMultiply(aZ, weightA), XMVectorMultiply(bZ, weightB)), XMVectorMultiply(cZ, weightC));
+
+					XMVECTOR lengthSq = XMVectorMultiplyAdd(x, x, XMVectorMultiplyAdd(y, y, XMVectorMultiply(z, z)));
+					XMVECTOR invLength = XMVectorReciprocalSqrt(lengthSq);
+					x = XMVectorMultiply(x, invLength);
+					y = XMVectorMultiply(y, invLength);
+					z = XMVectorMultiply(z, invLength);
+
+					// Spherical coordinates, theta around y and phi down from the top
+					XMVECTOR u = XMVectorMultiply(XMVectorATan2(z, x), inv2Pi);
+					u = XMVectorAdd(u, XMVectorRound(XMVectorSubtract(faceU, u)));
+					u = XMVectorSelect(u, faceU, XMVectorLess(XMVectorMultiplyAdd(x, x, XMVectorMultiply(z, z)), poleDistanceSq));
+					XMVECTOR v = XMVectorMultiply(XMVectorACos(XMVectorClamp(y, XMVectorNegate(one), one)), invPi);
+
+					StoreVertices(row + j, std::min(4u, rowVertexCount - j), XMVectorMultiply(x, radius), XMVectorMultiply(y, radius), XMVectorMultiply(z, radius), u, v);
+				}
+
+				row += rowVertexCount;
+			}
+		}
 
-		for (unsigned int i = 0; i < sliceCount; ++i)
+		// Each row has one more triangle pointing along the face than against it
+		void WriteFaceIndices(unsigned int baseIndex, unsigned int* indices) const
 		{
-			meshData->indices.push_back(centerIndex);
-			meshData->indices.push_back(baseIndex + i);
-			meshData->indices.push_back(baseIndex + i + 1);
+			unsigned int row = baseIndex;
+			for (unsigned int i = 0; i < m_Frequency; ++i)
+			{
+				unsigned int rowVertexCount = m_Frequency - i + 1;
+				unsigned int nextRow = row + rowVertexCount;
+
+				for (unsigned int j = 0; j + 1 < rowVertexCount; ++j)
+				{
+					indices[0] = row + j;
+					indices[1] = row + j + 1;
+					indices[2] = nextRow + j;
+					indices += 3;
+
+					if (j + 2 < rowVertexCount)
+					{
+						indices[0] = row + j + 1;
+						indices[1] = nextRow + j + 1;
+						indices[2] = nextRow + j;
+						indices += 3;
+					}
+				}
+
+				row = nextRow;
+			}
 		}
-	}
+
+		float m_Radius;
+		unsigned int m_Frequency;
+	};
 }
 
 void Geometry::CreateBox(float width, float height, float depth, MeshData* mesh)
@@ -193,67 +380,131 @@ void Geometry::CreateGrid(float width, float depth, unsigned int m, unsigned int
 
 void Geometry::CreateCylinder(float bottomRadius, float topRadius, float height, unsigned int sliceCount, unsigned int stackCount, MeshData* meshData)
 {
-	meshData->vertices.clear();
-	meshData->indices.clear();
+	TaperedProfile profile = { bottomRadius, topRadius, height };
 
-	//
-	// Build Stacks.
-	// 
+	// Scale the cap texture coordinates down by the height to try and make the top cap's
+	// texture coord area proportional to the base.
+	GenerateSurface(RevolvedSurface<TaperedProfile>(profile, sliceCount, stackCount, true, true, 1.0f / height), meshData);
+}
 
-	float stackHeight = height / stackCount;
+void Geometry::CreateCone(float radius, float height, unsigned int sliceCount, unsigned int stackCount, MeshData* meshData)
+{
+	TaperedProfile profile = { radius, 0.0f, height };
+	GenerateSurface(RevolvedSurface<TaperedProfile>(profile, sliceCount, stackCount, true, false, 1.0f / height), meshData);
+}
+
+void Geometry::CreateSphere(float radius, unsigned int sliceCount, unsigned int stackCount, MeshData* meshData)
+{
+	SphereProfile profile = { radius };
+	GenerateSurface(RevolvedSurface<SphereProfile>(profile, sliceCount, stackCount), meshData);
+}
+
+void Geometry::CreateGeosphere(float radius, unsigned int numSubdivisions, MeshData* meshData)
+{
+	// Put a cap on the number of subdivisions.
+	numSubdivisions = std::min(numSubdivisions, 8u);
+
+	GenerateSurface(GeosphereSurface(radius, 1u << numSubdivisions), meshData);
+}
 
-	// Amount to increment radius as we move up each stack level from bottom to top.
-	float radiusStep = (topRadius - bottomRadius) / stackCount;
+void Geometry::CreateTorus(float radius, float tubeRadius, unsigned int sliceCount, unsigned int stackCount, MeshData* meshData)
+{
+	TorusProfile profile = { radius, tubeRadius };
+	GenerateSurface(RevolvedSurface<TorusProfile>(profile, sliceCount, stackCount), meshData);
+}
 
-	unsigned int ringCount = stackCount + 1;
+void Geometry::ComputeSinCos(float start, float step, unsigned int count, float* sines, float* cosines)
+{
+	XMVECTOR first = XMVectorReplicate(start);
+	XMVECTOR steps = XMVectorReplicate(step);
 
-	// Compute vertices for each stack ring starting at the bottom and moving up.
-	for (unsigned int i = 0; i < ringCount; ++i)
+	// Each angle from its index rather than by adding up steps, which would drift
+	for (unsigned int i = 0; i < count; i += 4)
 	{
-		float y = -0.5f * height + i * stackHeight;
-		float r = bottomRadius + i * radiusStep;
+		XMVECTOR angles = XMVectorMultiplyAdd(XMVectorAdd(XMVectorReplicate((float)i), g_Lanes), steps, first);
 
-		// vertices of ring
-		float dTheta = 2.0f * DirectX::XM_PI / sliceCount;
-		for (unsigned int j = 0; j <= sliceCount; ++j)
-		{
-			Vertex vertex;
+		XMVECTOR s, c;
+		XMVectorSinCos(&s, &c, angles);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(sines + i), s);
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(cosines + i), c);
+	}
+}
 
-			float c = cosf(j * dTheta);
-			float s = sinf(j * dTheta);
+void Geometry::WriteRing(const float* sines, const float* cosines, unsigned int sliceCount, float radius, float y, float v, Vertex* vertices)
+{
+	XMVECTOR r = XMVectorReplicate(radius);
+	XMVECTOR ys = XMVectorReplicate(y);
+	XMVECTOR vs = XMVectorReplicate(v);
+	XMVECTOR slices = XMVectorReplicate((float)sliceCount);
 
-			DirectX::XMFLOAT3 position = DirectX::XMFLOAT3(r * c, y, r * s);
+	for (unsigned int j = 0; j < sliceCount; j += 4)
+	{
+		XMVECTOR c = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(cosines + j));
+		XMVECTOR s = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(sines + j));
+		XMVECTOR u = XMVectorDivide(XMVectorAdd(XMVectorReplicate((float)j), g_Lanes), slices);
 
-			vertex.x = position.x;
-			vertex.y = position.y;
-			vertex.z = position.z;
+		StoreVertices(vertices + j, std::min(4u, sliceCount - j), XMVectorMultiply(r, c), ys, XMVectorMultiply(r, s), u, vs);
+	}
 
-			vertex.u = (float)j / sliceCount;
-			vertex.v = 1.0f - (float)i / stackCount;
+	// Duplicate the first vertex of the ring, since the texture coordinates are different,
+	// exactly so the two sides of the seam meet.
+	vertices[sliceCount] = vertices[0];
+	vertices[sliceCount].u = 1.0f;
+}
 
-			meshData->vertices.push_back(vertex);
-		}
+void Geometry::WriteCap(const float* sines, const float* cosines, unsigned int sliceCount, float radius, float y, float texScale, bool facesUp,
+	unsigned int baseIndex, Vertex* vertices, unsigned int* indices)
+{
+	XMVECTOR r = XMVectorReplicate(radius);
+	XMVECTOR ys = XMVectorReplicate(y);
+	XMVECTOR scale = XMVectorReplicate(texScale);
+	XMVECTOR half = XMVectorReplicate(0.5f);
+
+	// Duplicate cap ring vertices because the texture coordinates and normals differ.
+	for (unsigned int j = 0; j < sliceCount; j += 4)
+	{
+		XMVECTOR x = XMVectorMultiply(r, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(cosines + j)));
+		XMVECTOR z = XMVectorMultiply(r, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(sines + j)));
+
+		StoreVertices(vertices + j, std::min(4u, sliceCount - j), x, ys, z, XMVectorMultiplyAdd(x, scale, half), XMVectorMultiplyAdd(z, scale, half));
 	}
 
-	// Add one because we duplicate the first and last vertex per ring
-	// since the texture coordinates are different.
-	unsigned int ringVertexCount = sliceCount + 1;
+	vertices[sliceCount] = vertices[0];
+
+	// Cap center vertex.
+	vertices[sliceCount + 1] = Vertex(0.0f, y, 0.0f, 0.5f, 0.5f);
 
-	// Compute indices for each stack.
-	for (unsigned int i = 0; i < stackCount; ++i)
+	unsigned int centerIndex = baseIndex + sliceCount + 1;
+
+	for (unsigned int i = 0; i < sliceCount; ++i)
 	{
+		indices[0] = centerIndex;
+		indices[1] = baseIndex + i + (facesUp ? 1 : 0);
+		indices[2] = baseIndex + i + (facesUp ? 0 : 1);
+		indices += 3;
+	}
+}
+
+void Geometry::WriteRingIndices(unsigned int ringCount, unsigned int ringVertexCount, unsigned int baseIndex, unsigned int* indices)
+{
+	unsigned int sliceCount = ringVertexCount - 1;
+
+	for (unsigned int i = 0; i + 1 < ringCount; ++i)
+	{
+		unsigned int ring = baseIndex + i * ringVertexCount;
+		unsigned int nextRing = ring + ringVertexCount;
+
 		for (unsigned int j = 0; j < sliceCount; ++j)
 		{
-			meshData->indices.push_back(i * ringVertexCount + j);
-			meshData->indices.push_back((i + 1) * ringVertexCount + j);
-			meshData->indices.push_back((i + 1) * ringVertexCount + j + 1);
+			indices[0] = ring + j;
+			indices[1] = nextRing + j;
+			indices[2] = nextRing + j + 1;
 
-			meshData->indices.push_back(i * ringVertexCount + j);
-			meshData->indices.push_back((i + 1) * ringVertexCount + j + 1);
-			meshData->indices.push_back(i * ringVertexCount + j + 1);
+			indices[3] = ring + j;
+			indices[4] = nextRing + j + 1;
+			indices[5] = ring + j + 1;
+
+			indices += 6;
 		}
 	}
-
-	BuildCylinderTopCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
-	BuildCylinderBottomCap(bottomRadius, topRadius, height, sliceCount, stackCount, meshData);
 }
@@ -2,6 +2,9 @@
 
 #include "Mesh.h"
 
+#include <DirectXMath.h>
+#include <vector>
+
 namespace Geometry
 {
 	void CreateBox(float width, float height, float depth, MeshData* mesh);
@@ -9,4 +12,131 @@ namespace Geometry
 	void CreateGrid(float width, float depth, unsigned int m, unsigned int n, MeshData* mesh);
 
 	void CreateCylinder(float bottomRadius, float topRadius, float height, unsigned int  sliceCount, unsigned int  stackCount, MeshData* meshData);
+
+	void CreateCone(float radius, float height, unsigned int sliceCount, unsigned int stackCount, MeshData* meshData);
+
+	void CreateSphere(float radius, unsigned int sliceCount, unsigned int stackCount, MeshData* meshData);
+
+	// An icosahedron with each face split into 4^numSubdivisions triangles, capped at 8
+	void CreateGeosphere(float radius, unsigned int numSubdivisions, MeshData* meshData);
+
+	// Around the y axis; sliceCount goes around the ring, stackCount around the tube
+	void CreateTorus(float radius, float tubeRadius, unsigned int sliceCount, unsigned int stackCount, MeshData* meshData);
+
+	//
+	// Surface generation. A surface works out exactly how many vertices and indices it makes,
+	// the mesh is sized for that once, and the surface then writes straight into it:
+	//
+	//   SurfaceSize GetSize() const;
+	//   void Generate(Vertex* vertices, unsigned int* indices) const;
+	//
+	// Regenerating into the same MeshData, for an LOD rebuild, reuses its storage.
+	//
+
+	struct SurfaceSize
+	{
+		unsigned int vertexCount;
+		unsigned int indexCount;
+	};
+
+	template<typename Surface>
+	void GenerateSurface(const Surface& surface, MeshData* meshData)
+	{
+		SurfaceSize size = surface.GetSize();
+		meshData->vertices.resize(size.vertexCount);
+		meshData->indices.resize(size.indexCount);
+		surface.Generate(meshData->vertices.data(), meshData->indices.data());
+	}
+
+	// Sines and cosines of start + i * step for i < count, four at a time. The arrays need
+	// room for count rounded up to a multiple of 4.
+	void ComputeSinCos(float start, float step, unsigned int count, float* sines, float* cosines);
+
+	// One ring of sliceCount + 1 vertices around the y axis, from the angles ComputeSinCos
+	// gave. u goes from 0 to 1 around the ring; the last vertex is the first one again.
+	void WriteRing(const float* sines, const float* cosines, unsigned int sliceCount, float radius, float y, float v, Vertex* vertices);
+
+	// A flat cap at y: a ring with texture coordinates scaled from its position, then the
+	// center vertex, fanned with the winding that faces up or down.
+	void WriteCap(const float* sines, const float* cosines, unsigned int sliceCount, float radius, float y, float texScale, bool facesUp,
+		unsigned int baseIndex, Vertex* vertices, unsigned int* indices);
+
+	// Quads between ringCount rings of ringVertexCount vertices, starting at baseIndex
+	void WriteRingIndices(unsigned int ringCount, unsigned int ringVertexCount, unsigned int baseIndex, unsigned int* indices);
+
+	// A surface of revolution around the y axis: stackCount + 1 rings from the bottom up,
+	// with flat caps where asked for. The profile gives the radius and height of every ring:
+	//
+	//   void operator()(unsigned int ringCount, float* radii, float* heights) const;
+	//
+	// with room in both arrays for ringCount rounded up to a multiple of 4.
+	template<typename Profile>
+	class RevolvedSurface
+	{
+	public:
+		RevolvedSurface(const Profile& profile, unsigned int sliceCount, unsigned int stackCount, bool bottomCap = false, bool topCap = false, float capTexScale = 1.0f)
+			: m_Profile(profile), m_SliceCount(sliceCount), m_StackCount(stackCount), m_BottomCap(bottomCap), m_TopCap(topCap), m_CapTexScale(capTexScale)
+		{
+		}
+
+		SurfaceSize GetSize() const
+		{
+			unsigned int ringVertexCount = m_SliceCount + 1;
+			unsigned int capCount = (m_BottomCap ? 1 : 0) + (m_TopCap ? 1 : 0);
+
+			SurfaceSize size;
+			size.vertexCount = (m_StackCount + 1) * ringVertexCount + capCount * (ringVertexCount + 1);
+			size.indexCount = m_StackCount * m_SliceCount * 6 + capCount * m_SliceCount * 3;
+			return size;
+		}
+
+		void Generate(Vertex* vertices, unsigned int* indices) const
+		{
+			unsigned int ringCount = m_StackCount + 1;
+			unsigned int ringVertexCount = m_SliceCount + 1;
+
+			// Every ring shares the same angles, so they are worked out once
+			std::vector<float> angles(2 * RoundUp(ringVertexCount));
+			float* sines = angles.data();
+			float* cosines = sines + RoundUp(ringVertexCount);
+			ComputeSinCos(0.0f, DirectX::XM_2PI / m_SliceCount, ringVertexCount, sines, cosines);
+
+			std::vector<float> rings(2 * RoundUp(ringCount));
+			float* radii = rings.data();
+			float* heights = radii + RoundUp(ringCount);
+			m_Profile(ringCount, radii, heights);
+
+			for (unsigned int i = 0; i < ringCount; ++i)
+				WriteRing(sines, cosines, m_SliceCount, radii[i], heights[i], 1.0f - (float)i / m_StackCount, vertices + i * ringVertexCount);
+
+			WriteRingIndices(ringCount, ringVertexCount, 0, indices);
+
+			unsigned int baseIndex = ringCount * ringVertexCount;
+			indices += m_StackCount * m_SliceCount * 6;
+
+			// Same order as the cylinder always had: top cap, then bottom
+			if (m_TopCap)
+			{
+				WriteCap(sines, cosines, m_SliceCount, radii[ringCount - 1], heights[ringCount - 1], m_CapTexScale, true, baseIndex, vertices + baseIndex, indices);
+				baseIndex += ringVertexCount + 1;
+				indices += m_SliceCount * 3;
+			}
+
+			if (m_BottomCap)
+				WriteCap(sines, cosines, m_SliceCount, radii[0], heights[0], m_CapTexScale, false, baseIndex, vertices + baseIndex, indices);
+		}
+
+	private:
+		static unsigned int RoundUp(unsigned int count)
+		{
+			return (count + 3) & ~3u;
+		}
+
+		Profile m_Profile;
+		unsigned int m_SliceCount;
+		unsigned int m_StackCount;
+		bool m_BottomCap;
+		bool m_TopCap;
+		float m_CapTexScale;
+	};
 }
\ No newline at end of file
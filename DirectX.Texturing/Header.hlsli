@@ -3,6 +3,8 @@ struct Material
 	float4 mDiffuse;
 	float4 mAmbient;
 	float4 mSpecular;
+
+	float mTextureSlice;
 };
 
 cbuffer WorldBuffer : register(b0)
@@ -30,4 +32,5 @@ struct PixelInput
 
 SamplerState SamplerAnisotropic : register(s0);
 
-Texture2D TextureDiffuse : register(t0);
\ No newline at end of file
+// Objects pick their texture with mMaterial.mTextureSlice
+Texture2DArray TextureDiffuse : register(t0);
\ No newline at end of file
@@ -0,0 +1,865 @@
+//--------------------------------------------------------------------------------------
+// File: LZ4Frame.cpp
+//
+// LZ4 frame compression for DDS files
+//
+// The compressor is the greedy single-probe matcher from the reference "fast" mode: a
+// hash of the next four bytes finds the last position that started with the same hash,
+// and a match is taken whenever the bytes really agree. Blocks are linked, so matches
+// can reach back into the previous block; the decoder writes every block into one
+// contiguous buffer, which makes that free to decode.
+//--------------------------------------------------------------------------------------
+
+#include "LZ4Frame.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr size_t c_MinMatch = 4;
+    constexpr size_t c_LastLiterals = 5;  // a block always ends in at least this many literals
+    constexpr size_t c_MatchFindLimit = 12; // and its last match starts at least this far from the end
+    constexpr size_t c_MaxOffset = 65535;
+    constexpr size_t c_WildCopy = 16;       // copies run in steps of this many bytes when there is room
+
+    constexpr unsigned int c_HashBits = 16;
+
+    constexpr uint8_t c_FlagVersion = 0x40;
+    constexpr uint8_t c_FlagBlockIndependence = 0x20;
+    constexpr uint8_t c_FlagBlockChecksum = 0x10;
+    constexpr uint8_t c_FlagContentSize = 0x08;
+    constexpr uint8_t c_FlagContentChecksum = 0x04;
+    constexpr uint8_t c_FlagDictionaryId = 0x01;
+
+    constexpr uint32_t c_BlockUncompressed = 0x80000000u;
+
+    // Block maximum sizes by the BD byte's 3-bit code, 4 to 7
+    constexpr size_t c_BlockMaxSizes[] = { 64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+
+    static_assert(LZ4_FRAME_BLOCK_SIZE == c_BlockMaxSizes[0], "CompressLZ4Frame writes block size code 4");
+
+    // The format is little-endian, like every platform Direct3D runs on, so fields are
+    // loaded directly; assembling them a byte at a time halves the checksum's speed
+    inline uint16_t ReadLE16(const uint8_t* p) noexcept
+    {
+        uint16_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t ReadLE32(const uint8_t* p) noexcept
+    {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline void WriteLE32(uint8_t* p, uint32_t value) noexcept
+    {
+        memcpy(p, &value, sizeof(value));
+    }
+
+    //----------------------------------------------------------------------------------
+    // xxHash32, which the frame format uses for its header, block and content checksums
+    //----------------------------------------------------------------------------------
+    constexpr uint32_t c_Prime1 = 2654435761u;
+    constexpr uint32_t c_Prime2 = 2246822519u;
+    constexpr uint32_t c_Prime3 = 3266489917u;
+    constexpr uint32_t c_Prime4 = 668265263u;
+    constexpr uint32_t c_Prime5 = 374761393u;
+
+    inline uint32_t RotateLeft(uint32_t value, int bits) noexcept
+    {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    inline uint32_t XXH32Round(uint32_t accumulator, uint32_t input) noexcept
+    {
+        return RotateLeft(accumulator + input * c_Prime2, 13) * c_Prime1;
+    }
+
+    class XXH32
+    {
+    public:
+        void Update(const uint8_t* data, size_t size) noexcept
+        {
+            if (size == 0)
+                return;
+
+            m_Total += size;
+
+            if (m_BufferSize + size < sizeof(m_Buffer))
+            {
+                memcpy(m_Buffer + m_BufferSize, data, size);
+                m_BufferSize += size;
+                return;
+            }
+
+            if (m_BufferSize > 0)
+            {
+                size_t fill = sizeof(m_Buffer) - m_BufferSize;
+                memcpy(m_Buffer + m_BufferSize, data, fill);
+                Consume(m_Buffer);
+                data += fill;
+                size -= fill;
+                m_BufferSize = 0;
+            }
+
+            uint32_t v0 = m_V[0], v1 = m_V[1], v2 = m_V[2], v3 = m_V[3];
+            for (; size >= sizeof(m_Buffer); data += sizeof(m_Buffer), size -= sizeof(m_Buffer))
+            {
+                v0 = XXH32Round(v0, ReadLE32(data));
+                v1 = XXH32Round(v1, ReadLE32(data + 4));
+                v2 = XXH32Round(v2, ReadLE32(data + 8));
+                v3 = XXH32Round(v3, ReadLE32(data + 12));
+            }
+            m_V[0] = v0;
+            m_V[1] = v1;
+            m_V[2] = v2;
+            m_V[3] = v3;
+
+            memcpy(m_Buffer, data, size);
+            m_BufferSize = size;
+        }
+
+        uint32_t Digest() const noexcept
+        {
+            uint32_t hash = (m_Total >= sizeof(m_Buffer))
+                ? RotateLeft(m_V[0], 1) + RotateLeft(m_V[1], 7) + RotateLeft(m_V[2], 12) + RotateLeft(m_V[3], 18)
+                : m_V[2] + c_Prime5;
+
+            hash += uint32_t(m_Total);
+
+            const uint8_t* p = m_Buffer;
+            const uint8_t* end = m_Buffer + m_BufferSize;
+            for (; p + 4 <= end; p += 4)
+                hash = RotateLeft(hash + ReadLE32(p) * c_Prime3, 17) * c_Prime4;
+            for (; p < end; p++)
+                hash = RotateLeft(hash + *p * c_Prime5, 11) * c_Prime1;
+
+            hash ^= hash >> 15;
+            hash *= c_Prime2;
+            hash ^= hash >> 13;
+            hash *= c_Prime3;
+            hash ^= hash >> 16;
+            return hash;
+        }
+
+        static uint32_t Hash(const uint8_t* data, size_t size) noexcept
+        {
+            XXH32 state;
+            state.Update(data, size);
+            return state.Digest();
+        }
+
+    private:
+        // Seed 0
+        uint32_t m_V[4] = { c_Prime1 + c_Prime2, c_Prime2, 0, 0u - c_Prime1 };
+        uint8_t m_Buffer[16] = {};
+        size_t m_BufferSize = 0;
+        uint64_t m_Total = 0;
+
+        void Consume(const uint8_t* stripe) noexcept
+        {
+            for (int i = 0; i < 4; i++)
+                m_V[i] = XXH32Round(m_V[i], ReadLE32(stripe + i * 4));
+        }
+    };
+
+    //----------------------------------------------------------------------------------
+    // Block compression
+    //----------------------------------------------------------------------------------
+    inline uint32_t HashSequence(uint32_t sequence) noexcept
+    {
+        return (sequence * c_Prime1) >> (32 - c_HashBits);
+    }
+
+    inline uint8_t* WriteLength(uint8_t* op, size_t length) noexcept
+    {
+        for (; length >= 255; length -= 255)
+            *op++ = 255;
+        *op++ = uint8_t(length);
+        return op;
+    }
+
+    // Compresses source[begin, end) into output, with matches allowed back to the start of
+    // source. Returns the compressed size, or 0 if it would not be smaller than capacity.
+    size_t CompressBlock(const uint8_t* source, size_t begin, size_t end, uint32_t* table, uint8_t* output, size_t capacity) noexcept
+    {
+        const uint8_t* ip = source + begin;
+        const uint8_t* anchor = ip;
+        const uint8_t* blockEnd = source + end;
+        const uint8_t* matchLimit = blockEnd - c_LastLiterals;
+        const uint8_t* findLimit = (end - begin > c_MatchFindLimit) ? blockEnd - c_MatchFindLimit : ip;
+
+        uint8_t* op = output;
+        uint8_t* outputEnd = output + capacity;
+
+        // Sequence lengths can add a byte per 255, so check against the worst case before writing
+        auto emit = [&](const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) -> bool
+        {
+            size_t worst = 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+            if (size_t(outputEnd - op) < worst)
+                return false;
+
+            uint8_t* token = op++;
+            *token = uint8_t(std::min<size_t>(literalLength, 15) << 4);
+            if (literalLength >= 15)
+                op = WriteLength(op, literalLength - 15);
+
+            memcpy(op, literals, literalLength);
+            op += literalLength;
+
+            if (matchLength == 0)
+                return true;
+
+            *op++ = uint8_t(offset);
+            *op++ = uint8_t(offset >> 8);
+
+            size_t code = matchLength - c_MinMatch;
+            *token |= uint8_t(std::min<size_t>(code, 15));
+            if (code >= 15)
+                op = WriteLength(op, code - 15);
+
+            return true;
+        };
+
+        unsigned int misses = 0;
+        while (ip < findLimit)
+        {
+            uint32_t sequence = ReadLE32(ip);
+            uint32_t hash = HashSequence(sequence);
+            const uint8_t* ref = source + table[hash];
+            table[hash] = uint32_t(ip - source);
+
+            if (ref >= ip || size_t(ip - ref) > c_MaxOffset || ReadLE32(ref) != sequence)
+            {
+                // Skip ahead faster through data that doesn't compress
+                ip += 1 + (misses++ >> 6);
+                continue;
+            }
+
+            misses = 0;
+
+            // Grow the match back over literals that also match
+            while (ip > anchor && ref > source && ip[-1] == ref[-1])
+            {
+                ip--;
+                ref--;
+            }
+
+            size_t length = c_MinMatch;
+            while (ip + length < matchLimit && ref[length] == ip[length])
+                length++;
+
+            if (!emit(anchor, size_t(ip - anchor), size_t(ip - ref), length))
+                return 0;
+
+            ip += length;
+            anchor = ip;
+
+            // Index the position just before the new anchor too; it often starts the next match
+            if (ip - 2 >= source + begin && ip < findLimit)
+                table[HashSequence(ReadLE32(ip - 2))] = uint32_t(ip - 2 - source);
+        }
+
+        if (!emit(anchor, size_t(blockEnd - anchor), 0, 0))
+            return 0;
+
+        return size_t(op - output);
+    }
+
+    //----------------------------------------------------------------------------------
+    // Block decompression
+    //----------------------------------------------------------------------------------
+
+    // Copies length bytes in whole steps, so it can write up to c_WildCopy - 1 bytes past
+    // dst + length and read as far past src + length
+    inline void WildCopy(uint8_t* dst, const uint8_t* src, size_t length) noexcept
+    {
+        uint8_t* end = dst + length;
+        do
+        {
+            memcpy(dst, src, c_WildCopy);
+            dst += c_WildCopy;
+            src += c_WildCopy;
+        } while (dst < end);
+    }
+
+    // Adds the 255-continued bytes of a long literal or match length; nullptr if the input runs out
+    inline const uint8_t* ReadLength(const uint8_t* ip, const uint8_t* inputEnd, size_t& length) noexcept
+    {
+        uint8_t byte;
+        do
+        {
+            if (ip >= inputEnd)
+                return nullptr;
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return ip;
+    }
+
+    // Decodes one block to base + *position, never writing past base + limit. Offsets can
+    // reach back to base. The input needs c_WildCopy readable bytes past its end. Returns
+    // S_FALSE if the output filled up before the block ended.
+    HRESULT DecompressBlock(const uint8_t* input, size_t inputSize, uint8_t* base, size_t* position, size_t limit) noexcept
+    {
+        const uint8_t* ip = input;
+        const uint8_t* inputEnd = input + inputSize;
+        uint8_t* op = base + *position;
+        uint8_t* outputEnd = base + limit;
+
+        for (;;)
+        {
+            if (ip >= inputEnd)
+                return E_FAIL;
+
+            uint8_t token = *ip++;
+            size_t literalLength = token >> 4;
+
+            // Most sequences have under 15 literals and a match of at most 18 bytes. Far enough
+            // from either end, those are copied in fixed 16 and 18-byte moves that may run past
+            // the sequence; whatever comes next overwrites the extra bytes. Having 32 bytes of
+            // input left also means this can't be the last, literal-only, sequence.
+            if (literalLength != 15 && size_t(inputEnd - ip) >= 32 && size_t(outputEnd - op) >= 32)
+            {
+                memcpy(op, ip, 16);
+                op += literalLength;
+                ip += literalLength;
+
+                size_t offset = ReadLE16(ip);
+                if ((token & 15) != 15 && offset >= 8 && offset <= size_t(op - base))
+                {
+                    ip += 2;
+
+                    const uint8_t* match = op - offset;
+                    memcpy(op, match, 8);
+                    memcpy(op + 8, match + 8, 8);
+                    memcpy(op + 16, match + 16, 2);
+                    op += (token & 15) + c_MinMatch;
+                    continue;
+                }
+            }
+            else
+            {
+                if (literalLength == 15 && (ip = ReadLength(ip, inputEnd, literalLength)) == nullptr)
+                    return E_FAIL;
+
+                if (literalLength > size_t(inputEnd - ip))
+                    return E_FAIL;
+
+                if (literalLength > size_t(outputEnd - op))
+                {
+                    memcpy(op, ip, size_t(outputEnd - op));
+                    *position = limit;
+                    return S_FALSE;
+                }
+
+                // Bytes written past the literals are overwritten by what comes next
+                if (size_t(outputEnd - op) - literalLength >= c_WildCopy)
+                    WildCopy(op, ip, literalLength);
+                else
+                    memcpy(op, ip, literalLength);
+                op += literalLength;
+                ip += literalLength;
+
+                // The last sequence is literals only
+                if (ip == inputEnd)
+                    break;
+            }
+
+            if (inputEnd - ip < 2)
+                return E_FAIL;
+
+            size_t offset = ReadLE16(ip);
+            ip += 2;
+
+            if (offset == 0 || offset > size_t(op - base))
+                return E_FAIL;
+
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && (ip = ReadLength(ip, inputEnd, matchLength)) == nullptr)
+                return E_FAIL;
+            matchLength += c_MinMatch;
+
+            bool full = false;
+            if (matchLength > size_t(outputEnd - op))
+            {
+                matchLength = size_t(outputEnd - op);
+                full = true;
+            }
+
+            const uint8_t* match = op - offset;
+            if (offset >= c_WildCopy && size_t(outputEnd - op) - matchLength >= c_WildCopy)
+            {
+                // Even when the match overlaps its source, each step only reads bytes already written
+                WildCopy(op, match, matchLength);
+            }
+            else if (offset >= matchLength)
+            {
+                memcpy(op, match, matchLength);
+            }
+            else
+            {
+                // A short repeating pattern: copy what is written so far, doubling each time,
+                // so every copy is a whole number of periods and never overlaps itself
+                size_t copied = 0;
+                while (copied < matchLength)
+                {
+                    size_t size = std::min(copied + offset, matchLength - copied);
+                    memcpy(op + copied, match, size);
+                    copied += size;
+                }
+            }
+            op += matchLength;
+
+            if (full)
+            {
+                *position = limit;
+                return S_FALSE;
+            }
+        }
+
+        *position = size_t(op - base);
+        return S_OK;
+    }
+
+    //----------------------------------------------------------------------------------
+    struct MemoryReader
+    {
+        const uint8_t* data;
+        size_t size;
+    };
+
+    HRESULT ReadFromMemory(void* context, uint8_t* buffer, size_t size) noexcept
+    {
+        auto reader = static_cast<MemoryReader*>(context);
+        if (size > reader->size)
+            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+        memcpy(buffer, reader->data, size);
+        reader->data += size;
+        reader->size -= size;
+        return S_OK;
+    }
+
+    // Decodes the blocks that follow the header into destination. A prefix stops once
+    // destination is full; anything else has to reach the end mark within it.
+    HRESULT DecodeBlocks(LZ4_READ_CALLBACK read, void* context, const LZ4FrameInfo& info, uint8_t* destination, size_t destinationSize, bool prefix, size_t* decompressedSize) noexcept
+    {
+        if (!decompressedSize)
+        {
+            return E_POINTER;
+        }
+
+        *decompressedSize = 0;
+
+        if (!read || (!destination && destinationSize > 0) || info.blockMaxSize == 0)
+        {
+            return E_INVALIDARG;
+        }
+
+        if (!prefix && info.contentSize > destinationSize)
+        {
+            return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+        }
+
+        // Compressed blocks are staged here; stored blocks are read straight into destination
+        std::unique_ptr<uint8_t[]> block;
+
+        XXH32 checksum;
+        size_t position = 0;
+
+        for (;;)
+        {
+            uint8_t word[4];
+            HRESULT hr = read(context, word, sizeof(word));
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            uint32_t blockSize = ReadLE32(word);
+            if (blockSize == 0)
+                break;
+
+            bool stored = (blockSize & c_BlockUncompressed) != 0;
+            blockSize &= ~c_BlockUncompressed;
+            if (blockSize > info.blockMaxSize)
+            {
+                return E_FAIL;
+            }
+
+            size_t start = position;
+            bool full = false;
+
+            if (stored && blockSize > destinationSize - position && !prefix)
+            {
+                return E_FAIL;
+            }
+
+            if (stored && blockSize <= destinationSize - position)
+            {
+                hr = read(context, destination + position, blockSize);
+                if (FAILED(hr))
+                {
+                    return hr;
+                }
+
+                if (info.blockChecksum)
+                {
+                    hr = read(context, word, sizeof(word));
+                    if (FAILED(hr))
+                    {
+                        return hr;
+                    }
+
+                    if (ReadLE32(word) != XXH32::Hash(destination + position, blockSize))
+                    {
+                        return HRESULT_FROM_WIN32(ERROR_CRC);
+                    }
+                }
+
+                position += blockSize;
+            }
+            else
+            {
+                if (!block)
+                {
+                    block.reset(new (std::nothrow) uint8_t[info.blockMaxSize + c_WildCopy]);
+                    if (!block)
+                    {
+                        return E_OUTOFMEMORY;
+                    }
+                }
+
+                hr = read(context, block.get(), blockSize);
+                if (FAILED(hr))
+                {
+                    return hr;
+                }
+
+                if (info.blockChecksum)
+                {
+                    hr = read(context, word, sizeof(word));
+                    if (FAILED(hr))
+                    {
+                        return hr;
+                    }
+
+                    if (ReadLE32(word) != XXH32::Hash(block.get(), blockSize))
+                    {
+                        return HRESULT_FROM_WIN32(ERROR_CRC);
+                    }
+                }
+
+                if (stored)
+                {
+                    size_t size = std::min<size_t>(blockSize, destinationSize - position);
+                    memcpy(destination + position, block.get(), size);
+                    position += size;
+                    full = (size < blockSize);
+                }
+                else
+                {
+                    // Independent blocks only ever reference their own output, so a bad offset
+                    // is caught against the block start rather than the whole buffer
+                    uint8_t* base = info.blockIndependence ? destination + start : destination;
+                    size_t blockPosition = position - size_t(base - destination);
+                    hr = DecompressBlock(block.get(), blockSize, base, &blockPosition, destinationSize - size_t(base - destination));
+                    if (FAILED(hr))
+                    {
+                        return hr;
+                    }
+
+                    position = blockPosition + size_t(base - destination);
+                    full = (hr == S_FALSE);
+                }
+            }
+
+            // Only a prefix may stop short of the end mark; a whole frame that doesn't fit is corrupt
+            if (full)
+            {
+                if (!prefix)
+                {
+                    return E_FAIL;
+                }
+
+                *decompressedSize = position;
+                return S_OK;
+            }
+
+            if (info.contentChecksum)
+                checksum.Update(destination + start, position - start);
+
+            if (info.contentSize != 0 && position > info.contentSize)
+            {
+                return E_FAIL;
+            }
+        }
+
+        if (info.contentSize != 0 && position != info.contentSize)
+        {
+            return E_FAIL;
+        }
+
+        if (info.contentChecksum)
+        {
+            uint8_t word[4];
+            HRESULT hr = read(context, word, sizeof(word));
+            if (FAILED(hr))
+            {
+                return hr;
+            }
+
+            if (ReadLE32(word) != checksum.Digest())
+            {
+                return HRESULT_FROM_WIN32(ERROR_CRC);
+            }
+        }
+
+        *decompressedSize = position;
+        return S_OK;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+bool DirectX::IsLZ4Frame(const uint8_t* data, size_t size) noexcept
+{
+    return data && size >= sizeof(uint32_t) && ReadLE32(data) == LZ4_FRAME_MAGIC;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t DirectX::GetLZ4FrameBound(size_t sourceSize) noexcept
+{
+    // Magic and descriptor with content size, a size word per block, end mark and checksum
+    size_t blocks = (sourceSize + LZ4_FRAME_BLOCK_SIZE - 1) / LZ4_FRAME_BLOCK_SIZE;
+    return 4 + 11 + blocks * 4 + sourceSize + 4 + 4;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::CompressLZ4Frame(
+    const uint8_t* source,
+    size_t sourceSize,
+    uint8_t* frame,
+    size_t frameCapacity,
+    size_t* frameSize) noexcept
+{
+    if (!frameSize)
+    {
+        return E_POINTER;
+    }
+
+    *frameSize = 0;
+
+    if ((!source && sourceSize > 0) || !frame)
+    {
+        return E_INVALIDARG;
+    }
+
+    // Positions are kept as 32 bits
+    if (uint64_t(sourceSize) > UINT32_MAX)
+    {
+        return HRESULT_FROM_WIN32(ERROR_ARITHMETIC_OVERFLOW);
+    }
+
+    if (frameCapacity < GetLZ4FrameBound(sourceSize))
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    std::unique_ptr<uint32_t[]> table(new (std::nothrow) uint32_t[size_t(1) << c_HashBits]);
+    if (!table)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    memset(table.get(), 0, sizeof(uint32_t) << c_HashBits);
+
+    uint8_t* op = frame;
+    WriteLE32(op, LZ4_FRAME_MAGIC);
+    op += 4;
+
+    uint8_t* descriptor = op;
+    *op++ = c_FlagVersion | c_FlagContentSize | c_FlagContentChecksum;
+    *op++ = 4 << 4; // 64KB blocks
+    for (int i = 0; i < 8; i++)
+        *op++ = uint8_t(uint64_t(sourceSize) >> (i * 8));
+    *op = uint8_t(XXH32::Hash(descriptor, size_t(op - descriptor)) >> 8);
+    op++;
+
+    for (size_t begin = 0; begin < sourceSize; begin += LZ4_FRAME_BLOCK_SIZE)
+    {
+        size_t end = std::min(begin + LZ4_FRAME_BLOCK_SIZE, sourceSize);
+        size_t size = end - begin;
+
+        size_t compressed = CompressBlock(source, begin, end, table.get(), op + 4, size - 1);
+        if (compressed != 0)
+        {
+            WriteLE32(op, uint32_t(compressed));
+            op += 4 + compressed;
+        }
+        else
+        {
+            WriteLE32(op, uint32_t(size) | c_BlockUncompressed);
+            memcpy(op + 4, source + begin, size);
+            op += 4 + size;
+        }
+    }
+
+    WriteLE32(op, 0);
+    op += 4;
+    WriteLE32(op, XXH32::Hash(source, sourceSize));
+    op += 4;
+
+    *frameSize = size_t(op - frame);
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::ReadLZ4FrameHeader(
+    LZ4_READ_CALLBACK read,
+    void* context,
+    LZ4FrameInfo& info) noexcept
+{
+    info = {};
+
+    if (!read)
+    {
+        return E_INVALIDARG;
+    }
+
+    // Magic, FLG and BD; the rest of the descriptor depends on FLG
+    uint8_t header[19];
+    HRESULT hr = read(context, header, 6);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    if (ReadLE32(header) != LZ4_FRAME_MAGIC)
+    {
+        return E_FAIL;
+    }
+
+    uint8_t flags = header[4];
+    uint8_t blockDescriptor = header[5];
+    if ((flags & 0xC0) != c_FlagVersion || (flags & 0x02) || (blockDescriptor & 0x8F))
+    {
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    }
+
+    // Dictionaries aren't supported, since a DDS file is never compressed against one
+    if (flags & c_FlagDictionaryId)
+    {
+        return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+    }
+
+    unsigned int sizeCode = (blockDescriptor >> 4) & 7;
+    if (sizeCode < 4)
+    {
+        return E_FAIL;
+    }
+
+    size_t rest = ((flags & c_FlagContentSize) ? 8 : 0) + 1;
+    hr = read(context, header + 6, rest);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    size_t descriptorSize = 2 + rest - 1;
+    if (header[4 + descriptorSize] != uint8_t(XXH32::Hash(header + 4, descriptorSize) >> 8))
+    {
+        return HRESULT_FROM_WIN32(ERROR_CRC);
+    }
+
+    if (flags & c_FlagContentSize)
+    {
+        for (int i = 0; i < 8; i++)
+            info.contentSize |= uint64_t(header[6 + i]) << (i * 8);
+    }
+
+    info.blockMaxSize = c_BlockMaxSizes[sizeCode - 4];
+    info.blockIndependence = (flags & c_FlagBlockIndependence) != 0;
+    info.blockChecksum = (flags & c_FlagBlockChecksum) != 0;
+    info.contentChecksum = (flags & c_FlagContentChecksum) != 0;
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::DecompressLZ4Frame(
+    LZ4_READ_CALLBACK read,
+    void* context,
+    const LZ4FrameInfo& info,
+    uint8_t* destination,
+    size_t destinationSize,
+    size_t* decompressedSize) noexcept
+{
+    return DecodeBlocks(read, context, info, destination, destinationSize, false, decompressedSize);
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::DecompressLZ4FramePrefix(
+    LZ4_READ_CALLBACK read,
+    void* context,
+    const LZ4FrameInfo& info,
+    uint8_t* destination,
+    size_t destinationSize,
+    size_t* decompressedSize) noexcept
+{
+    return DecodeBlocks(read, context, info, destination, destinationSize, true, decompressedSize);
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::DecompressLZ4FrameFromMemory(
+    const uint8_t* frame,
+    size_t frameSize,
+    uint8_t* destination,
+    size_t destinationSize,
+    size_t* decompressedSize) noexcept
+{
+    if (!decompressedSize)
+    {
+        return E_POINTER;
+    }
+
+    *decompressedSize = 0;
+
+    if (!frame)
+    {
+        return E_INVALIDARG;
+    }
+
+    MemoryReader reader = { frame, frameSize };
+
+    LZ4FrameInfo info;
+    HRESULT hr = ReadLZ4FrameHeader(ReadFromMemory, &reader, info);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    return DecompressLZ4Frame(ReadFromMemory, &reader, info, destination, destinationSize, decompressedSize);
+}
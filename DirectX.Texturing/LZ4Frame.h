@@ -0,0 +1,99 @@
+//--------------------------------------------------------------------------------------
+// File: LZ4Frame.h
+//
+// LZ4 frame compression for DDS files (.dds.lz4). Frames follow the LZ4 frame format,
+// so files written by the lz4 command line tool load as long as they record their
+// content size (lz4 --content-size), and files written here decompress with it.
+//
+// The decoder pulls the frame through a callback one block at a time and decodes each
+// block straight into the caller's buffer, so loading a compressed file never needs more
+// than one block of staging on top of the decompressed texture.
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <wsl/winadapter.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    constexpr uint32_t LZ4_FRAME_MAGIC = 0x184D2204;
+
+    // Blocks written by CompressLZ4Frame; a 64KB block is also the most the loader stages
+    constexpr size_t LZ4_FRAME_BLOCK_SIZE = 64 * 1024;
+
+    struct LZ4FrameInfo
+    {
+        uint64_t contentSize;    // 0 if the frame doesn't record it
+        size_t blockMaxSize;
+        bool blockIndependence;  // blocks don't reference earlier ones
+        bool blockChecksum;
+        bool contentChecksum;
+    };
+
+    // Supplies the next size bytes of the frame. Anything but S_OK stops decoding and is
+    // returned to the caller.
+    typedef HRESULT (*LZ4_READ_CALLBACK)(_In_opt_ void* context, _Out_writes_bytes_(size) uint8_t* buffer, _In_ size_t size);
+
+    // Checks the magic number only
+    bool IsLZ4Frame(_In_reads_bytes_(size) const uint8_t* data, _In_ size_t size) noexcept;
+
+    // Largest frame CompressLZ4Frame can write for sourceSize bytes
+    size_t GetLZ4FrameBound(_In_ size_t sourceSize) noexcept;
+
+    // Writes one frame with linked 64KB blocks, the content size and a content checksum.
+    // Blocks that don't shrink are stored as they are.
+    HRESULT CompressLZ4Frame(
+        _In_reads_bytes_(sourceSize) const uint8_t* source,
+        _In_ size_t sourceSize,
+        _Out_writes_bytes_(frameCapacity) uint8_t* frame,
+        _In_ size_t frameCapacity,
+        _Out_ size_t* frameSize) noexcept;
+
+    // Reads and checks the frame descriptor, leaving the callback at the first block
+    HRESULT ReadLZ4FrameHeader(
+        _In_ LZ4_READ_CALLBACK read,
+        _In_opt_ void* context,
+        _Out_ LZ4FrameInfo& info) noexcept;
+
+    // Decodes the blocks that follow the header into destination, up to the end mark, and
+    // checks the content size and checksum the frame records. A frame that decodes to more
+    // than destinationSize is corrupt and fails with E_FAIL; one that records a content size
+    // larger than destinationSize fails up front with ERROR_INSUFFICIENT_BUFFER.
+    HRESULT DecompressLZ4Frame(
+        _In_ LZ4_READ_CALLBACK read,
+        _In_opt_ void* context,
+        _In_ const LZ4FrameInfo& info,
+        _Out_writes_bytes_(destinationSize) uint8_t* destination,
+        _In_ size_t destinationSize,
+        _Out_ size_t* decompressedSize) noexcept;
+
+    // Decodes only the first destinationSize bytes of the frame, or all of it if it is
+    // shorter, so the DDS headers can be read without decoding the whole file. Blocks read
+    // are checked against their block checksums; the content size and checksum only if the
+    // frame ended within destination.
+    HRESULT DecompressLZ4FramePrefix(
+        _In_ LZ4_READ_CALLBACK read,
+        _In_opt_ void* context,
+        _In_ const LZ4FrameInfo& info,
+        _Out_writes_bytes_(destinationSize) uint8_t* destination,
+        _In_ size_t destinationSize,
+        _Out_ size_t* decompressedSize) noexcept;
+
+    // Both steps over a frame that is already in memory
+    HRESULT DecompressLZ4FrameFromMemory(
+        _In_reads_bytes_(frameSize) const uint8_t* frame,
+        _In_ size_t frameSize,
+        _Out_writes_bytes_(destinationSize) uint8_t* destination,
+        _In_ size_t destinationSize,
+        _Out_ size_t* decompressedSize) noexcept;
+}
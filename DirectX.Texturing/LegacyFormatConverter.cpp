@@ -0,0 +1,594 @@
+//--------------------------------------------------------------------------------------
+// File: LegacyFormatConverter.cpp
+//
+// Converts Direct3D 9 pixel layouts that no DXGI format matches
+//
+// Every conversion is either a byte shuffle (24-bit to 32-bit, L8A8 to A8L8), an OR that
+// makes an X channel opaque, or a nibble expansion, which the vector paths do 16 or 32
+// bytes at a time. The 3:3:2 layouts index a 256 entry table on every path.
+//--------------------------------------------------------------------------------------
+
+#include "LegacyFormatConverter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define LEGACY_CONVERTER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC allows any intrinsic anywhere, GCC and Clang need the functions that use them marked
+#if defined(LEGACY_CONVERTER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LEGACY_TARGET(isa) __attribute__((target(isa)))
+#else
+#define LEGACY_TARGET(isa)
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    // Surfaces with fewer pixels than this per thread are not worth splitting
+    const size_t MinPixelsPerThread = 64 * 1024;
+
+    //----------------------------------------------------------------------------------
+    // 3:3:2 colours expanded to B8G8R8A8 with opaque alpha, by replicating the bits
+    //----------------------------------------------------------------------------------
+    struct R3G3B2Table
+    {
+        uint32_t colors[256];
+
+        R3G3B2Table() noexcept
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                uint32_t r = (i >> 5) & 7;
+                uint32_t g = (i >> 2) & 7;
+                uint32_t b = i & 3;
+
+                r = (r << 5) | (r << 2) | (r >> 1);
+                g = (g << 5) | (g << 2) | (g >> 1);
+                b = b * 0x55;
+
+                colors[i] = b | (g << 8) | (r << 16) | 0xff000000;
+            }
+        }
+    };
+
+    const R3G3B2Table s_R3G3B2;
+
+    //----------------------------------------------------------------------------------
+    // Row kernels. Each converts width pixels of one row; the vector ones convert as many
+    // as whole registers cover and leave the rest to the scalar ones.
+    //----------------------------------------------------------------------------------
+    struct ScalarKernels
+    {
+        static void ExpandRGB24(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            for (size_t x = 0; x < width; x++, src += 3, dst += 4)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = 0xff;
+            }
+        }
+
+        static void SetAlpha32(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            for (size_t x = 0; x < width; x++, src += 4, dst += 4)
+            {
+                uint32_t pixel;
+                memcpy(&pixel, src, sizeof(pixel));
+                pixel |= 0xff000000;
+                memcpy(dst, &pixel, sizeof(pixel));
+            }
+        }
+
+        template<uint16_t alpha>
+        static void SetAlpha16(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            for (size_t x = 0; x < width; x++, src += 2, dst += 2)
+            {
+                uint16_t pixel;
+                memcpy(&pixel, src, sizeof(pixel));
+                pixel = uint16_t(pixel | alpha);
+                memcpy(dst, &pixel, sizeof(pixel));
+            }
+        }
+
+        static void ExpandA4L4(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            for (size_t x = 0; x < width; x++, dst += 2)
+            {
+                dst[0] = uint8_t((src[x] & 0xf) * 17);
+                dst[1] = uint8_t((src[x] >> 4) * 17);
+            }
+        }
+
+        static void SwapL8A8(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            for (size_t x = 0; x < width; x++, src += 2, dst += 2)
+            {
+                uint8_t alpha = src[0];
+                dst[0] = src[1];
+                dst[1] = alpha;
+            }
+        }
+    };
+
+    void ExpandR3G3B2(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+    {
+        for (size_t x = 0; x < width; x++, dst += 4)
+            memcpy(dst, &s_R3G3B2.colors[src[x]], sizeof(uint32_t));
+    }
+
+    void ExpandA8R3G3B2(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+    {
+        for (size_t x = 0; x < width; x++, src += 2, dst += 4)
+        {
+            uint32_t pixel = (s_R3G3B2.colors[src[0]] & 0x00ffffff) | (uint32_t(src[1]) << 24);
+            memcpy(dst, &pixel, sizeof(pixel));
+        }
+    }
+
+#ifdef LEGACY_CONVERTER_X86
+    struct SSSE3Kernels
+    {
+        LEGACY_TARGET("ssse3")
+        static void ExpandRGB24(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+
+            // Three loads hold 16 pixels exactly; each 4 pixel group is aligned down to the
+            // bottom of a register before the shuffle spreads it out
+            size_t x = 0;
+            for (; x + 16 <= width; x += 16)
+            {
+                const uint8_t* in = src + x * 3;
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+                __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 32));
+
+                __m128i* out = reinterpret_cast<__m128i*>(dst + x * 4);
+                _mm_storeu_si128(out, _mm_or_si128(_mm_shuffle_epi8(a, shuffle), alpha));
+                _mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle), alpha));
+                _mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle), alpha));
+                _mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle), alpha));
+            }
+
+            ScalarKernels::ExpandRGB24(src + x * 3, dst + x * 4, width - x);
+        }
+
+        LEGACY_TARGET("ssse3")
+        static void SetAlpha32(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+
+            size_t x = 0;
+            for (; x + 4 <= width; x += 4)
+            {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_or_si128(pixels, alpha));
+            }
+
+            ScalarKernels::SetAlpha32(src + x * 4, dst + x * 4, width - x);
+        }
+
+        template<uint16_t alpha>
+        LEGACY_TARGET("ssse3")
+        static void SetAlpha16(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            const __m128i mask = _mm_set1_epi16(short(alpha));
+
+            size_t x = 0;
+            for (; x + 8 <= width; x += 8)
+            {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 2));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2), _mm_or_si128(pixels, mask));
+            }
+
+            ScalarKernels::SetAlpha16<alpha>(src + x * 2, dst + x * 2, width - x);
+        }
+
+        LEGACY_TARGET("ssse3")
+        static void ExpandA4L4(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            const __m128i nibble = _mm_set1_epi8(0x0f);
+
+            size_t x = 0;
+            for (; x + 16 <= width; x += 16)
+            {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+                __m128i luminance = _mm_and_si128(pixels, nibble);
+                __m128i alpha = _mm_and_si128(_mm_srli_epi16(pixels, 4), nibble);
+
+                // n * 17 copies the nibble into the top half; nothing crosses into the next byte
+                luminance = _mm_or_si128(luminance, _mm_slli_epi16(luminance, 4));
+                alpha = _mm_or_si128(alpha, _mm_slli_epi16(alpha, 4));
+
+                __m128i* out = reinterpret_cast<__m128i*>(dst + x * 2);
+                _mm_storeu_si128(out, _mm_unpacklo_epi8(luminance, alpha));
+                _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(luminance, alpha));
+            }
+
+            ScalarKernels::ExpandA4L4(src + x, dst + x * 2, width - x);
+        }
+
+        LEGACY_TARGET("ssse3")
+        static void SwapL8A8(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            size_t x = 0;
+            for (; x + 8 <= width; x += 8)
+            {
+                __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 2));
+                pixels = _mm_or_si128(_mm_slli_epi16(pixels, 8), _mm_srli_epi16(pixels, 8));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2), pixels);
+            }
+
+            ScalarKernels::SwapL8A8(src + x * 2, dst + x * 2, width - x);
+        }
+    };
+
+    struct AVX2Kernels
+    {
+        LEGACY_TARGET("avx2")
+        static void ExpandRGB24(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            // Dwords 3-6 hold pixels 4-7 once bytes 12-27 are moved to the upper lane
+            const __m256i spread = _mm256_setr_epi32(0, 1, 2, 3, 3, 4, 5, 6);
+            const __m256i shuffle = _mm256_setr_epi8(
+                0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+
+            // Each load covers 8 pixels but reads 32 bytes, so stop while the last one fits
+            size_t x = 0;
+            for (; x + 11 <= width; x += 8)
+            {
+                __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 3));
+                pixels = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(pixels, spread), shuffle);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), _mm256_or_si256(pixels, alpha));
+            }
+
+            SSSE3Kernels::ExpandRGB24(src + x * 3, dst + x * 4, width - x);
+        }
+
+        LEGACY_TARGET("avx2")
+        static void SetAlpha32(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+
+            size_t x = 0;
+            for (; x + 8 <= width; x += 8)
+            {
+                __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 4));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 4), _mm256_or_si256(pixels, alpha));
+            }
+
+            ScalarKernels::SetAlpha32(src + x * 4, dst + x * 4, width - x);
+        }
+
+        template<uint16_t alpha>
+        LEGACY_TARGET("avx2")
+        static void SetAlpha16(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            const __m256i mask = _mm256_set1_epi16(short(alpha));
+
+            size_t x = 0;
+            for (; x + 16 <= width; x += 16)
+            {
+                __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 2));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 2), _mm256_or_si256(pixels, mask));
+            }
+
+            ScalarKernels::SetAlpha16<alpha>(src + x * 2, dst + x * 2, width - x);
+        }
+
+        LEGACY_TARGET("avx2")
+        static void ExpandA4L4(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            const __m256i nibble = _mm256_set1_epi8(0x0f);
+
+            size_t x = 0;
+            for (; x + 32 <= width; x += 32)
+            {
+                // Unpacking works within each lane, so put quadwords 0 and 1 in the lower one
+                // first; the low unpack then covers pixels 0-15 and the high one 16-31
+                __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+                pixels = _mm256_permute4x64_epi64(pixels, 0xd8);
+
+                __m256i luminance = _mm256_and_si256(pixels, nibble);
+                __m256i alpha = _mm256_and_si256(_mm256_srli_epi16(pixels, 4), nibble);
+                luminance = _mm256_or_si256(luminance, _mm256_slli_epi16(luminance, 4));
+                alpha = _mm256_or_si256(alpha, _mm256_slli_epi16(alpha, 4));
+
+                __m256i* out = reinterpret_cast<__m256i*>(dst + x * 2);
+                _mm256_storeu_si256(out, _mm256_unpacklo_epi8(luminance, alpha));
+                _mm256_storeu_si256(out + 1, _mm256_unpackhi_epi8(luminance, alpha));
+            }
+
+            ScalarKernels::ExpandA4L4(src + x, dst + x * 2, width - x);
+        }
+
+        LEGACY_TARGET("avx2")
+        static void SwapL8A8(const uint8_t* src, uint8_t* dst, size_t width) noexcept
+        {
+            size_t x = 0;
+            for (; x + 16 <= width; x += 16)
+            {
+                __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x * 2));
+                pixels = _mm256_or_si256(_mm256_slli_epi16(pixels, 8), _mm256_srli_epi16(pixels, 8));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x * 2), pixels);
+            }
+
+            ScalarKernels::SwapL8A8(src + x * 2, dst + x * 2, width - x);
+        }
+    };
+#endif
+
+    //----------------------------------------------------------------------------------
+    // Dispatch
+    //----------------------------------------------------------------------------------
+    typedef void (*RowConverter)(const uint8_t* src, uint8_t* dst, size_t width);
+
+    template<class Kernels>
+    RowConverter GetRowConverter(LegacyFormat format) noexcept
+    {
+        switch (format)
+        {
+        case LegacyFormat::R8G8B8:
+        case LegacyFormat::B8G8R8:
+            return Kernels::ExpandRGB24;
+
+        case LegacyFormat::X8B8G8R8:
+            return Kernels::SetAlpha32;
+
+        case LegacyFormat::X1R5G5B5:
+            return Kernels::template SetAlpha16<0x8000>;
+
+        case LegacyFormat::X4R4G4B4:
+            return Kernels::template SetAlpha16<0xf000>;
+
+        case LegacyFormat::A4L4:
+            return Kernels::ExpandA4L4;
+
+        case LegacyFormat::L8A8:
+            return Kernels::SwapL8A8;
+
+        case LegacyFormat::R3G3B2:
+            return ExpandR3G3B2;
+
+        case LegacyFormat::A8R3G3B2:
+            return ExpandA8R3G3B2;
+
+        default:
+            return nullptr;
+        }
+    }
+
+    RowConverter GetRowConverter(LegacyFormat format, LegacyConverterPath path) noexcept
+    {
+#ifdef LEGACY_CONVERTER_X86
+        if (path == LegacyConverterPath::AVX2)
+            return GetRowConverter<AVX2Kernels>(format);
+
+        if (path == LegacyConverterPath::SSSE3)
+            return GetRowConverter<SSSE3Kernels>(format);
+#else
+        (void)path;
+#endif
+        return GetRowConverter<ScalarKernels>(format);
+    }
+
+    LegacyConverterPath DetectPath() noexcept
+    {
+#if defined(LEGACY_CONVERTER_X86) && defined(_MSC_VER)
+        int info[4] = {};
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool ssse3 = (info[2] & (1 << 9)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        // AVX2 also needs the OS to save the YMM registers
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+
+        if (avx2)
+            return LegacyConverterPath::AVX2;
+        if (ssse3)
+            return LegacyConverterPath::SSSE3;
+#elif defined(LEGACY_CONVERTER_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return LegacyConverterPath::AVX2;
+        if (__builtin_cpu_supports("ssse3"))
+            return LegacyConverterPath::SSSE3;
+#endif
+        return LegacyConverterPath::Scalar;
+    }
+
+    const LegacyConverterPath s_SupportedPath = DetectPath();
+    std::atomic<LegacyConverterPath> s_Path(s_SupportedPath);
+
+    size_t ConvertedBytesPerPixel(LegacyFormat format) noexcept
+    {
+        switch (GetLegacyConvertedFormat(format))
+        {
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+            return 4;
+
+        default:
+            return 2;
+        }
+    }
+
+    void ConvertRows(
+        RowConverter convert,
+        size_t width,
+        const uint8_t* source,
+        size_t sourceRowPitch,
+        uint8_t* dest,
+        size_t destRowPitch,
+        size_t firstRow,
+        size_t lastRow) noexcept
+    {
+        for (size_t y = firstRow; y < lastRow; y++)
+            convert(source + y * sourceRowPitch, dest + y * destRowPitch, width);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+DXGI_FORMAT DirectX::GetLegacyConvertedFormat(LegacyFormat format) noexcept
+{
+    switch (format)
+    {
+    case LegacyFormat::R8G8B8:
+    case LegacyFormat::R3G3B2:
+    case LegacyFormat::A8R3G3B2:
+        return DXGI_FORMAT_B8G8R8A8_UNORM;
+
+    case LegacyFormat::B8G8R8:
+    case LegacyFormat::X8B8G8R8:
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+
+    case LegacyFormat::X1R5G5B5:
+        return DXGI_FORMAT_B5G5R5A1_UNORM;
+
+    case LegacyFormat::X4R4G4B4:
+        return DXGI_FORMAT_B4G4R4A4_UNORM;
+
+    case LegacyFormat::A4L4:
+    case LegacyFormat::L8A8:
+        return DXGI_FORMAT_R8G8_UNORM;
+
+    default:
+        return DXGI_FORMAT_UNKNOWN;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t DirectX::GetLegacyBitsPerPixel(LegacyFormat format) noexcept
+{
+    switch (format)
+    {
+    case LegacyFormat::R8G8B8:
+    case LegacyFormat::B8G8R8:
+        return 24;
+
+    case LegacyFormat::X8B8G8R8:
+        return 32;
+
+    case LegacyFormat::X1R5G5B5:
+    case LegacyFormat::X4R4G4B4:
+    case LegacyFormat::L8A8:
+    case LegacyFormat::A8R3G3B2:
+        return 16;
+
+    case LegacyFormat::A4L4:
+    case LegacyFormat::R3G3B2:
+        return 8;
+
+    default:
+        return 0;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+LegacyConverterPath DirectX::GetLegacyConverterPath() noexcept
+{
+    return s_Path.load();
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::SetLegacyConverterPath(LegacyConverterPath path) noexcept
+{
+    s_Path.store(std::min(path, s_SupportedPath));
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::ConvertLegacySurface(
+    LegacyFormat format,
+    size_t width,
+    size_t height,
+    const uint8_t* source,
+    size_t sourceRowPitch,
+    uint8_t* dest,
+    size_t destRowPitch,
+    unsigned int threadCount) noexcept
+{
+    RowConverter convert = GetRowConverter(format, s_Path.load());
+    if (!convert || !source || !dest || width == 0 || height == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    size_t sourceRowBytes = (width * GetLegacyBitsPerPixel(format) + 7) / 8;
+    size_t destRowBytes = width * ConvertedBytesPerPixel(format);
+    if (sourceRowPitch < sourceRowBytes || destRowPitch < destRowBytes)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    size_t chunks = std::max<size_t>(1, std::min<size_t>({ threadCount, (width * height) / MinPixelsPerThread, height }));
+    size_t rowsPerChunk = (height + chunks - 1) / chunks;
+
+    // The calling thread takes the first chunk; if a thread can't be started its chunk is
+    // converted here as well
+    std::vector<std::thread> workers;
+    for (size_t chunk = 1; chunk < chunks; chunk++)
+    {
+        size_t firstRow = chunk * rowsPerChunk;
+        size_t lastRow = std::min(height, firstRow + rowsPerChunk);
+        if (firstRow >= lastRow)
+            break;
+
+        try
+        {
+            workers.emplace_back(ConvertRows, convert, width, source, sourceRowPitch, dest, destRowPitch, firstRow, lastRow);
+        }
+        catch (...)
+        {
+            ConvertRows(convert, width, source, sourceRowPitch, dest, destRowPitch, firstRow, lastRow);
+        }
+    }
+
+    ConvertRows(convert, width, source, sourceRowPitch, dest, destRowPitch, 0, std::min(height, rowsPerChunk));
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+
+    return S_OK;
+}
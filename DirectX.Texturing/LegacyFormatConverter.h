@@ -0,0 +1,71 @@
+//--------------------------------------------------------------------------------------
+// File: LegacyFormatConverter.h
+//
+// Converts the Direct3D 9 pixel layouts that no DXGI format matches into ones that do,
+// so old DDS files load without being exported again. Uses AVX2 or SSSE3 when the CPU
+// has them and splits large surfaces across threads by row.
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <dxgiformat.h>
+#else
+#include <wsl/winadapter.h>
+#include <directx/dxgiformat.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    // Named after their D3DFORMAT, most significant channel first
+    enum class LegacyFormat
+    {
+        None,
+        R8G8B8,     // 24-bit, to B8G8R8A8 with opaque alpha
+        B8G8R8,     // 24-bit with red in the low byte, to R8G8B8A8 with opaque alpha
+        X8B8G8R8,   // to R8G8B8A8 with opaque alpha
+        X1R5G5B5,   // to B5G5R5A1 with opaque alpha
+        X4R4G4B4,   // to B4G4R4A4 with opaque alpha
+        A4L4,       // to R8G8, luminance in red and alpha in green
+        L8A8,       // alpha in the low byte, to R8G8 the same way as A8L8
+        R3G3B2,     // to B8G8R8A8 with opaque alpha
+        A8R3G3B2,   // to B8G8R8A8
+    };
+
+    enum class LegacyConverterPath
+    {
+        Scalar,
+        SSSE3,
+        AVX2,
+    };
+
+    // Format the pixels are converted to, DXGI_FORMAT_UNKNOWN for None
+    DXGI_FORMAT GetLegacyConvertedFormat(_In_ LegacyFormat format) noexcept;
+
+    // Bits per pixel of the layout converted from, 0 for None
+    size_t GetLegacyBitsPerPixel(_In_ LegacyFormat format) noexcept;
+
+    // Fastest path the CPU supports, unless overridden. Forcing Scalar is useful for checking
+    // the vector paths; paths the CPU can't run are clamped to the best one it can.
+    LegacyConverterPath GetLegacyConverterPath() noexcept;
+    void SetLegacyConverterPath(_In_ LegacyConverterPath path) noexcept;
+
+    // Converts one surface into the layout of GetLegacyConvertedFormat. The 3:3:2 layouts go
+    // through a lookup table on every path. threadCount 0 uses every hardware thread.
+    HRESULT ConvertLegacySurface(
+        _In_ LegacyFormat format,
+        _In_ size_t width,
+        _In_ size_t height,
+        _In_ const uint8_t* source,
+        _In_ size_t sourceRowPitch,
+        _Out_ uint8_t* dest,
+        _In_ size_t destRowPitch,
+        _In_ unsigned int threadCount = 0) noexcept;
+}
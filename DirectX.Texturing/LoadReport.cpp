@@ -0,0 +1,187 @@
+#include "LoadReport.h"
+
+#ifdef DDS_LOADER_STATS
+
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+	std::string ToUTF8(const wchar_t* text)
+	{
+		int size = WideCharToMultiByte(CP_UTF8, 0, text, -1, nullptr, 0, nullptr, nullptr);
+		if (size <= 1)
+			return std::string();
+
+		std::string result(size - 1, '\0');
+		WideCharToMultiByte(CP_UTF8, 0, text, -1, &result[0], size, nullptr, nullptr);
+		return result;
+	}
+
+	// File names only ever need quotes and backslashes escaped, and CSV has no backslash escape
+	std::string Escape(const std::string& text, bool json)
+	{
+		std::string result;
+		for (char c : text)
+		{
+			if (c == '"')
+				result += json ? "\\\"" : "\"\"";
+			else if (c == '\\' && json)
+				result += "\\\\";
+			else
+				result += c;
+		}
+
+		return result;
+	}
+
+	double TotalMs(const DirectX::DDSLoadStats& stats)
+	{
+		return stats.openMs + stats.readMs + stats.validateMs + stats.layoutMs + stats.createMs;
+	}
+
+	// Adds one row into another, for the totals
+	void Accumulate(DirectX::DDSLoadStats& total, const DirectX::DDSLoadStats& row)
+	{
+		total.openMs += row.openMs;
+		total.readMs += row.readMs;
+		total.validateMs += row.validateMs;
+		total.layoutMs += row.layoutMs;
+		total.createMs += row.createMs;
+		total.bytesRead += row.bytesRead;
+		total.skippedMips += row.skippedMips;
+	}
+}
+
+LoadReport::LoadReport()
+{
+	DirectX::SetDDSLoadStatsSink(this);
+}
+
+LoadReport::~LoadReport()
+{
+	DirectX::SetDDSLoadStatsSink(nullptr);
+}
+
+void LoadReport::OnDDSLoadStats(const DirectX::DDSLoadStats& stats) noexcept
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	try
+	{
+		// Creating data loaded earlier reports only its own time; it goes on the row of the load
+		bool createOnly = stats.fileName[0] != L'\0' && stats.bytesRead == 0 && !stats.isMapped
+			&& stats.openMs == 0.0 && stats.readMs == 0.0;
+		if (createOnly)
+		{
+			for (auto it = m_Rows.rbegin(); it != m_Rows.rend(); ++it)
+			{
+				if (it->createMs == 0.0 && SUCCEEDED(it->result) && wcscmp(it->fileName, stats.fileName) == 0)
+				{
+					it->createMs = stats.createMs;
+					it->result = stats.result;
+					it->format = stats.format;
+					return;
+				}
+			}
+		}
+
+		m_Rows.push_back(stats);
+	}
+	catch (...)
+	{
+		// A report that is short of memory just misses rows
+	}
+}
+
+bool LoadReport::Write(const std::wstring& path)
+{
+	std::vector<DirectX::DDSLoadStats> rows;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		rows = m_Rows;
+	}
+
+	std::ofstream out(path, std::ios::out | std::ios::trunc);
+	if (!out)
+		return false;
+
+	out << std::fixed << std::setprecision(3);
+
+	bool json = path.size() >= 5 && _wcsicmp(path.c_str() + path.size() - 5, L".json") == 0;
+
+	return json ? WriteJSON(out, rows) : WriteCSV(out, rows);
+}
+
+bool LoadReport::WriteCSV(std::ostream& out, const std::vector<DirectX::DDSLoadStats>& rows)
+{
+	out << "file,result,open_ms,read_ms,validate_ms,layout_ms,create_ms,total_ms,bytes_read,skipped_mips,width,height,mips,format,lz4,mapped\n";
+
+	DirectX::DDSLoadStats total = {};
+	for (const DirectX::DDSLoadStats& row : rows)
+	{
+		out << '"' << Escape(ToUTF8(row.fileName), false) << "\","
+			<< "0x" << std::hex << std::setw(8) << std::setfill('0') << (unsigned int)row.result << std::dec << std::setfill(' ') << ','
+			<< row.openMs << ',' << row.readMs << ',' << row.validateMs << ',' << row.layoutMs << ',' << row.createMs << ','
+			<< TotalMs(row) << ','
+			<< row.bytesRead << ',' << row.skippedMips << ','
+			<< row.width << ',' << row.height << ',' << row.mipCount << ',' << (int)row.format << ','
+			<< (row.isLZ4Frame ? 1 : 0) << ',' << (row.isMapped ? 1 : 0) << '\n';
+
+		Accumulate(total, row);
+	}
+
+	out << "\"total\",,"
+		<< total.openMs << ',' << total.readMs << ',' << total.validateMs << ',' << total.layoutMs << ',' << total.createMs << ','
+		<< TotalMs(total) << ','
+		<< total.bytesRead << ',' << total.skippedMips << ",,,,,,\n";
+
+	return !out.fail();
+}
+
+bool LoadReport::WriteJSON(std::ostream& out, const std::vector<DirectX::DDSLoadStats>& rows)
+{
+	out << "{\n  \"textures\": [";
+
+	DirectX::DDSLoadStats total = {};
+	for (size_t i = 0; i < rows.size(); i++)
+	{
+		const DirectX::DDSLoadStats& row = rows[i];
+
+		out << (i == 0 ? "\n" : ",\n")
+			<< "    { \"file\": \"" << Escape(ToUTF8(row.fileName), true) << "\""
+			<< ", \"result\": \"0x" << std::hex << std::setw(8) << std::setfill('0') << (unsigned int)row.result << std::dec << std::setfill(' ') << "\""
+			<< ", \"openMs\": " << row.openMs
+			<< ", \"readMs\": " << row.readMs
+			<< ", \"validateMs\": " << row.validateMs
+			<< ", \"layoutMs\": " << row.layoutMs
+			<< ", \"createMs\": " << row.createMs
+			<< ", \"totalMs\": " << TotalMs(row)
+			<< ", \"bytesRead\": " << row.bytesRead
+			<< ", \"skippedMips\": " << row.skippedMips
+			<< ", \"width\": " << row.width
+			<< ", \"height\": " << row.height
+			<< ", \"mips\": " << row.mipCount
+			<< ", \"format\": " << (int)row.format
+			<< ", \"lz4\": " << (row.isLZ4Frame ? "true" : "false")
+			<< ", \"mapped\": " << (row.isMapped ? "true" : "false")
+			<< " }";
+
+		Accumulate(total, row);
+	}
+
+	out << "\n  ],\n  \"total\": {"
+		<< " \"openMs\": " << total.openMs
+		<< ", \"readMs\": " << total.readMs
+		<< ", \"validateMs\": " << total.validateMs
+		<< ", \"layoutMs\": " << total.layoutMs
+		<< ", \"createMs\": " << total.createMs
+		<< ", \"totalMs\": " << TotalMs(total)
+		<< ", \"bytesRead\": " << total.bytesRead
+		<< ", \"skippedMips\": " << total.skippedMips
+		<< " }\n}\n";
+
+	return !out.fail();
+}
+
+#endif
\ No newline at end of file
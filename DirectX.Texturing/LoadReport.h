@@ -0,0 +1,36 @@
+#pragma once
+
+#include "DDSTextureLoader.h"
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef DDS_LOADER_STATS
+
+// Collects the DDS loader's timings while it exists, one row per file: the record of loading
+// a texture's data and the record of creating it later are merged into the same row. Rows
+// are kept in the order the loads finished, which with worker threads isn't the order asked.
+class LoadReport : public DirectX::IDDSLoadStatsSink
+{
+public:
+	// Starts receiving the loader's records straight away
+	LoadReport();
+
+	// Stops receiving them; loads still running must have finished
+	~LoadReport();
+
+	void OnDDSLoadStats(const DirectX::DDSLoadStats& stats) noexcept override;
+
+	// JSON when the path ends in .json, CSV otherwise. Both end with the totals of every stage.
+	bool Write(const std::wstring& path);
+
+private:
+	std::mutex m_Mutex;
+	std::vector<DirectX::DDSLoadStats> m_Rows;
+
+	bool WriteCSV(std::ostream& out, const std::vector<DirectX::DDSLoadStats>& rows);
+	bool WriteJSON(std::ostream& out, const std::vector<DirectX::DDSLoadStats>& rows);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "MeshCompactor.h"
+
+#include <cfloat>
+#include <cstring>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace Geometry
+{
+	void CompactMesh(const MeshData& mesh, CompactMeshData* compact)
+	{
+		// Bounding box
+		XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+		for (const Vertex& vertex : mesh.vertices)
+		{
+			XMVECTOR position = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&vertex.x));
+			minimum = XMVectorMin(minimum, position);
+			maximum = XMVectorMax(maximum, position);
+		}
+
+		if (mesh.vertices.empty())
+		{
+			minimum = XMVectorZero();
+			maximum = XMVectorZero();
+		}
+
+		// A flat axis quantizes to 0 everywhere rather than dividing by nothing
+		XMVECTOR extent = XMVectorSubtract(maximum, minimum);
+		XMVECTOR flat = XMVectorLessOrEqual(extent, XMVectorZero());
+		XMVECTOR toUnit = XMVectorSelect(XMVectorReciprocal(extent), XMVectorZero(), flat);
+
+		XMStoreFloat3(&compact->positionScale, extent);
+		XMStoreFloat3(&compact->positionOffset, minimum);
+
+		// Vertices. XMStoreUShortN4 saturates and rounds to the nearest step.
+		compact->vertices.resize(mesh.vertices.size());
+		for (size_t i = 0; i < mesh.vertices.size(); ++i)
+		{
+			const Vertex& vertex = mesh.vertices[i];
+			PackedVertex& packed = compact->vertices[i];
+
+			XMVECTOR position = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&vertex.x));
+			XMStoreUShortN4(&packed.position, XMVectorMultiply(XMVectorSubtract(position, minimum), toUnit));
+			XMStoreHalf2(&packed.texture, XMLoadFloat2(reinterpret_cast<const XMFLOAT2*>(&vertex.u)));
+		}
+
+		// Indices. Triangle lists have no strip cut value, so 0xffff is as good as any other index.
+		compact->indexCount = (unsigned int)mesh.indices.size();
+		compact->indexSize = mesh.vertices.size() <= 0x10000 ? 2 : 4;
+		compact->indices.resize(mesh.indices.size() * compact->indexSize);
+
+		if (compact->indexSize == 2)
+		{
+			unsigned short* indices = reinterpret_cast<unsigned short*>(compact->indices.data());
+			for (size_t i = 0; i < mesh.indices.size(); ++i)
+				indices[i] = (unsigned short)mesh.indices[i];
+		}
+		else if (!mesh.indices.empty())
+		{
+			memcpy(compact->indices.data(), mesh.indices.data(), compact->indices.size());
+		}
+	}
+
+	XMMATRIX GetDequantizeTransform(const CompactMeshData& compact)
+	{
+		return XMMatrixMultiply(XMMatrixScalingFromVector(XMLoadFloat3(&compact.positionScale)),
+			XMMatrixTranslationFromVector(XMLoadFloat3(&compact.positionOffset)));
+	}
+
+	XMFLOAT3 GetPositionErrorBound(const CompactMeshData& compact)
+	{
+		// Quantizing rounds to the nearest of 65535 steps. Working out which step, and the
+		// multiply-add back, are each good to within a float epsilon of the largest value
+		// involved; two of those covers both.
+		XMVECTOR scale = XMLoadFloat3(&compact.positionScale);
+		XMVECTOR offset = XMLoadFloat3(&compact.positionOffset);
+		XMVECTOR largest = XMVectorAdd(XMVectorAbs(offset), scale);
+
+		XMFLOAT3 bound;
+		XMStoreFloat3(&bound, XMVectorAdd(XMVectorScale(scale, 0.5f / 65535.0f), XMVectorScale(largest, 2.0f * FLT_EPSILON)));
+		return bound;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <vector>
+
+namespace Geometry
+{
+	// The vertex layouts the shader can be created for
+	enum class VertexFormat
+	{
+		Float,  // Vertex: float3 position, float2 texture coordinates, 20 bytes
+		Packed, // PackedVertex: 16-bit position within the mesh's bounds, half texture coordinates, 12 bytes
+	};
+
+	// Position is R16G16B16A16_UNORM, 0 to 1 across the mesh's bounding box on each axis, with w
+	// unused. Texture coordinates are R16G16_FLOAT.
+	struct PackedVertex
+	{
+		DirectX::PackedVector::XMUSHORTN4 position;
+		DirectX::PackedVector::XMHALF2 texture;
+	};
+
+	struct CompactMeshData
+	{
+		std::vector<PackedVertex> vertices;
+
+		// indexCount indices of indexSize bytes each: 2 when every vertex can be numbered in
+		// 16 bits, otherwise 4
+		std::vector<unsigned char> indices;
+		unsigned int indexCount = 0;
+		unsigned int indexSize = 4;
+
+		// A packed position p, read as 0 to 1, is p * positionScale + positionOffset
+		DirectX::XMFLOAT3 positionScale;
+		DirectX::XMFLOAT3 positionOffset;
+	};
+
+	// Quantizes positions to the mesh's bounding box, converts texture coordinates to half
+	// floats and picks the smallest index size that fits. The triangles keep their order.
+	void CompactMesh(const MeshData& mesh, CompactMeshData* compact);
+
+	// Scales and offsets packed positions back to the mesh's own space, to be put in front of
+	// the world matrix
+	DirectX::XMMATRIX GetDequantizeTransform(const CompactMeshData& compact);
+
+	// The most a dequantized position can be off by on each axis: half a quantization step,
+	// plus what rounding the dequantize in float adds
+	DirectX::XMFLOAT3 GetPositionErrorBound(const CompactMeshData& compact);
+
+	// Index i of the compact mesh, whichever size it was stored at
+	inline unsigned int GetIndex(const CompactMeshData& compact, unsigned int i)
+	{
+		if (compact.indexSize == 2)
+			return reinterpret_cast<const unsigned short*>(compact.indices.data())[i];
+
+		return reinterpret_cast<const unsigned int*>(compact.indices.data())[i];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,516 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	const unsigned int c_NoIndex = ~0u;
+
+	// FIFO cache simulation. A vertex is still in the cache if fewer than cacheSize others
+	// have been loaded since it was; starting the clock past cacheSize makes everything miss.
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t entryCount, unsigned int cacheSize)
+			: m_LoadedAt(entryCount, 0), m_CacheSize(cacheSize), m_Time(cacheSize + 1)
+		{
+		}
+
+		// Returns 1 if entry had to be loaded
+		unsigned int Touch(unsigned int entry)
+		{
+			if (m_Time - m_LoadedAt[entry] <= m_CacheSize)
+				return 0;
+
+			m_LoadedAt[entry] = m_Time++;
+			return 1;
+		}
+
+		unsigned int TouchTriangle(const unsigned int* indices)
+		{
+			return Touch(indices[0]) + Touch(indices[1]) + Touch(indices[2]);
+		}
+
+		void Flush()
+		{
+			m_Time += m_CacheSize + 1;
+		}
+
+	private:
+		std::vector<unsigned int> m_LoadedAt;
+		unsigned int m_CacheSize;
+		unsigned int m_Time;
+	};
+
+	uint32_t FloatBits(float value)
+	{
+		// So that 0 and -0, which compare equal, also hash the same
+		if (value == 0.0f)
+			return 0;
+
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	uint32_t HashVertex(const Vertex& vertex)
+	{
+		uint32_t hash = 2166136261u;
+		for (float value : { vertex.x, vertex.y, vertex.z, vertex.u, vertex.v })
+			hash = (hash ^ FloatBits(value)) * 16777619u;
+		return hash ^ (hash >> 15);
+	}
+
+	bool SameVertex(const Vertex& a, const Vertex& b)
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z && a.u == b.u && a.v == b.v;
+	}
+
+	//
+	// Forsyth's scoring: the three vertices of the last triangle score a flat amount, the
+	// rest of the cache less the older they are, and a vertex with few triangles left gets
+	// a boost so it is finished off rather than left to come back for.
+	//
+
+	const unsigned int c_ForsythCacheSize = 32;
+	const unsigned int c_ForsythMaxValence = 32;
+
+	struct ForsythScores
+	{
+		float cachePosition[c_ForsythCacheSize];
+		float valence[c_ForsythMaxValence + 1];
+
+		ForsythScores()
+		{
+			for (unsigned int i = 0; i < c_ForsythCacheSize; ++i)
+			{
+				if (i < 3)
+					cachePosition[i] = 0.75f;
+				else
+					cachePosition[i] = powf(1.0f - float(i - 3) / float(c_ForsythCacheSize - 3), 1.5f);
+			}
+
+			valence[0] = 0.0f;
+			for (unsigned int i = 1; i <= c_ForsythMaxValence; ++i)
+				valence[i] = 2.0f / sqrtf(float(i));
+		}
+
+		float Score(int position, unsigned int remaining) const
+		{
+			// Nothing left to draw with it
+			if (remaining == 0)
+				return -1.0f;
+
+			float score = position >= 0 ? cachePosition[position] : 0.0f;
+			return score + valence[std::min(remaining, c_ForsythMaxValence)];
+		}
+	};
+
+	// Area-weighted middle and facing of a run of triangles
+	struct TriangleSums
+	{
+		double center[3] = {};
+		double normal[3] = {};
+		double area = 0.0;
+
+		void Add(const Vertex& a, const Vertex& b, const Vertex& c)
+		{
+			double e1[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+			double e2[3] = { c.x - a.x, c.y - a.y, c.z - a.z };
+			double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			double twiceArea = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			center[0] += twiceArea * (a.x + b.x + c.x) / 3.0;
+			center[1] += twiceArea * (a.y + b.y + c.y) / 3.0;
+			center[2] += twiceArea * (a.z + b.z + c.z) / 3.0;
+			for (int k = 0; k < 3; ++k)
+				normal[k] += n[k];
+			area += twiceArea;
+		}
+
+		void Center(double* result) const
+		{
+			for (int k = 0; k < 3; ++k)
+				result[k] = area > 0.0 ? center[k] / area : 0.0;
+		}
+	};
+}
+
+float Geometry::ComputeCacheMissRatio(const MeshData& mesh, unsigned int cacheSize)
+{
+	size_t triangleCount = mesh.indices.size() / 3;
+	if (triangleCount == 0)
+		return 0.0f;
+
+	FifoCache cache(mesh.vertices.size(), cacheSize);
+
+	size_t misses = 0;
+	for (size_t t = 0; t < triangleCount; ++t)
+		misses += cache.TouchTriangle(&mesh.indices[t * 3]);
+
+	return float(misses) / float(triangleCount);
+}
+
+float Geometry::ComputeOverfetchRatio(const MeshData& mesh)
+{
+	const size_t lineSize = 64;
+	const unsigned int lineCacheSize = 16384 / lineSize;
+
+	size_t vertexBytes = mesh.vertices.size() * sizeof(Vertex);
+	if (vertexBytes == 0)
+		return 0.0f;
+
+	FifoCache lines((vertexBytes + lineSize - 1) / lineSize, lineCacheSize);
+
+	size_t linesRead = 0;
+	for (unsigned int index : mesh.indices)
+	{
+		size_t first = index * sizeof(Vertex) / lineSize;
+		size_t last = ((index + 1) * sizeof(Vertex) - 1) / lineSize;
+		for (size_t line = first; line <= last; ++line)
+			linesRead += lines.Touch((unsigned int)line);
+	}
+
+	return float(linesRead * lineSize) / float(vertexBytes);
+}
+
+unsigned int Geometry::WeldVertices(MeshData* mesh)
+{
+	size_t vertexCount = mesh->vertices.size();
+
+	// Open addressing, at most half full
+	size_t tableSize = 16;
+	while (tableSize < vertexCount * 2)
+		tableSize *= 2;
+	std::vector<unsigned int> table(tableSize, c_NoIndex);
+
+	std::vector<Vertex> welded;
+	welded.reserve(vertexCount);
+	std::vector<unsigned int> remap(vertexCount);
+
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		const Vertex& vertex = mesh->vertices[i];
+
+		size_t slot = HashVertex(vertex) & (tableSize - 1);
+		while (table[slot] != c_NoIndex && !SameVertex(welded[table[slot]], vertex))
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == c_NoIndex)
+		{
+			table[slot] = (unsigned int)welded.size();
+			welded.push_back(vertex);
+		}
+
+		remap[i] = table[slot];
+	}
+
+	// Triangles whose corners welded together are no longer triangles
+	size_t kept = 0;
+	for (size_t i = 0; i + 2 < mesh->indices.size(); i += 3)
+	{
+		unsigned int a = remap[mesh->indices[i]];
+		unsigned int b = remap[mesh->indices[i + 1]];
+		unsigned int c = remap[mesh->indices[i + 2]];
+		if (a == b || b == c || c == a)
+			continue;
+
+		mesh->indices[kept++] = a;
+		mesh->indices[kept++] = b;
+		mesh->indices[kept++] = c;
+	}
+
+	mesh->indices.resize(kept);
+	mesh->vertices.swap(welded);
+	return (unsigned int)mesh->vertices.size();
+}
+
+void Geometry::OptimizeVertexCache(MeshData* mesh)
+{
+	static const ForsythScores scores;
+
+	size_t vertexCount = mesh->vertices.size();
+	size_t triangleCount = mesh->indices.size() / 3;
+	const std::vector<unsigned int>& indices = mesh->indices;
+
+	// Triangles of each vertex; the ones still to draw are kept at the front of its range
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; ++i)
+		remaining[indices[i]]++;
+
+	std::vector<unsigned int> offsets(vertexCount + 1, 0);
+	for (size_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + remaining[v];
+
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	{
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < triangleCount * 3; ++i)
+			adjacency[fill[indices[i]]++] = (unsigned int)(i / 3);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+		vertexScore[v] = scores.Score(-1, remaining[v]);
+
+	std::vector<float> triangleScore(triangleCount);
+	for (size_t t = 0; t < triangleCount; ++t)
+		triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> ordered(triangleCount * 3);
+
+	// Room for the three vertices of a triangle pushing out the oldest
+	unsigned int cache[c_ForsythCacheSize + 3];
+	unsigned int cacheCount = 0;
+
+	unsigned int best = c_NoIndex;
+	float bestScore = -1.0f;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		if (triangleScore[t] > bestScore)
+		{
+			bestScore = triangleScore[t];
+			best = (unsigned int)t;
+		}
+	}
+
+	size_t nextUnemitted = 0;
+	for (size_t drawn = 0; drawn < triangleCount; ++drawn)
+	{
+		// Nothing in the cache has triangles left, so start again somewhere new
+		if (best == c_NoIndex)
+		{
+			while (emitted[nextUnemitted])
+				nextUnemitted++;
+			best = (unsigned int)nextUnemitted;
+		}
+
+		const unsigned int* corners = &indices[best * 3];
+		memcpy(&ordered[drawn * 3], corners, 3 * sizeof(unsigned int));
+		emitted[best] = true;
+
+		for (int k = 0; k < 3; ++k)
+		{
+			unsigned int v = corners[k];
+			unsigned int* triangles = &adjacency[offsets[v]];
+			unsigned int* end = triangles + remaining[v];
+			unsigned int* found = std::find(triangles, end, best);
+			std::swap(*found, *(end - 1));
+			remaining[v]--;
+		}
+
+		// The triangle's vertices go to the front, everything else moves back
+		unsigned int updated[c_ForsythCacheSize + 3];
+		unsigned int updatedCount = 0;
+		for (int k = 0; k < 3; ++k)
+		{
+			if (std::find(updated, updated + updatedCount, corners[k]) == updated + updatedCount)
+				updated[updatedCount++] = corners[k];
+		}
+
+		for (unsigned int i = 0; i < cacheCount; ++i)
+		{
+			if (std::find(updated, updated + updatedCount, cache[i]) == updated + updatedCount)
+				updated[updatedCount++] = cache[i];
+		}
+
+		for (unsigned int i = 0; i < updatedCount; ++i)
+		{
+			unsigned int v = updated[i];
+			cachePosition[v] = i < c_ForsythCacheSize ? int(i) : -1;
+			vertexScore[v] = scores.Score(cachePosition[v], remaining[v]);
+		}
+
+		// Rescore everything the cache touched, and draw the best of it next
+		best = c_NoIndex;
+		bestScore = -1.0f;
+		for (unsigned int i = 0; i < updatedCount; ++i)
+		{
+			unsigned int v = updated[i];
+			for (unsigned int j = 0; j < remaining[v]; ++j)
+			{
+				unsigned int t = adjacency[offsets[v] + j];
+				triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+				if (i < c_ForsythCacheSize && triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					best = t;
+				}
+			}
+		}
+
+		cacheCount = std::min(updatedCount, c_ForsythCacheSize);
+		memcpy(cache, updated, cacheCount * sizeof(unsigned int));
+	}
+
+	mesh->indices.swap(ordered);
+}
+
+void Geometry::OptimizeOverdraw(MeshData* mesh, float threshold)
+{
+	size_t triangleCount = mesh->indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	const unsigned int* indices = mesh->indices.data();
+	FifoCache cache(mesh->vertices.size(), c_MeasuredCacheSize);
+
+	// A triangle that misses on all three vertices starts a new patch of the mesh; the
+	// order can't get any worse for cutting there
+	std::vector<unsigned int> patches;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		if (cache.TouchTriangle(&indices[t * 3]) == 3 || t == 0)
+			patches.push_back((unsigned int)t);
+	}
+	patches.push_back((unsigned int)triangleCount);
+
+	// Patches are cut again as soon as a cluster, starting from an empty cache, gets its
+	// miss ratio down to within threshold of the whole patch's
+	std::vector<unsigned int> clusters;
+	for (size_t p = 0; p + 1 < patches.size(); ++p)
+	{
+		unsigned int start = patches[p];
+		unsigned int end = patches[p + 1];
+
+		cache.Flush();
+		unsigned int patchMisses = 0;
+		for (unsigned int t = start; t < end; ++t)
+			patchMisses += cache.TouchTriangle(&indices[t * 3]);
+		float target = threshold * float(patchMisses) / float(end - start);
+
+		size_t first = clusters.size();
+		clusters.push_back(start);
+
+		cache.Flush();
+		unsigned int misses = 0;
+		unsigned int triangles = 0;
+		for (unsigned int t = start; t < end; ++t)
+		{
+			misses += cache.TouchTriangle(&indices[t * 3]);
+			triangles++;
+
+			if (t + 1 < end && float(misses) <= target * float(triangles))
+			{
+				clusters.push_back(t + 1);
+				cache.Flush();
+				misses = 0;
+				triangles = 0;
+			}
+		}
+
+		// The tail never got down to the target, so it stays with the cluster before it
+		if (triangles > 0 && float(misses) > target * float(triangles) && clusters.size() > first + 1)
+			clusters.pop_back();
+	}
+
+	size_t clusterCount = clusters.size();
+	clusters.push_back((unsigned int)triangleCount);
+
+	const std::vector<Vertex>& vertices = mesh->vertices;
+
+	TriangleSums whole;
+	std::vector<TriangleSums> sums(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		for (unsigned int t = clusters[c]; t < clusters[c + 1]; ++t)
+			sums[c].Add(vertices[indices[t * 3]], vertices[indices[t * 3 + 1]], vertices[indices[t * 3 + 2]]);
+
+		for (int k = 0; k < 3; ++k)
+		{
+			whole.center[k] += sums[c].center[k];
+			whole.normal[k] += sums[c].normal[k];
+		}
+		whole.area += sums[c].area;
+	}
+
+	double middle[3];
+	whole.Center(middle);
+
+	// How far out each cluster sits along the way it faces
+	std::vector<double> keys(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		double center[3];
+		sums[c].Center(center);
+
+		const double* n = sums[c].normal;
+		double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		keys[c] = length > 0.0 ? ((center[0] - middle[0]) * n[0] + (center[1] - middle[1]) * n[1] + (center[2] - middle[2]) * n[2]) / length : 0.0;
+	}
+
+	std::vector<unsigned int> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c)
+		order[c] = (unsigned int)c;
+	std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return keys[a] > keys[b]; });
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(mesh->indices.size());
+	for (unsigned int c : order)
+		sorted.insert(sorted.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+
+	mesh->indices.swap(sorted);
+}
+
+void Geometry::OptimizeVertexFetch(MeshData* mesh)
+{
+	std::vector<unsigned int> remap(mesh->vertices.size(), c_NoIndex);
+	std::vector<Vertex> ordered;
+	ordered.reserve(mesh->vertices.size());
+
+	for (unsigned int& index : mesh->indices)
+	{
+		if (remap[index] == c_NoIndex)
+		{
+			remap[index] = (unsigned int)ordered.size();
+			ordered.push_back(mesh->vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	mesh->vertices.swap(ordered);
+}
+
+void Geometry::OptimizeMesh(MeshData* mesh, MeshOptimizeReport* report)
+{
+	struct Stage
+	{
+		const char* name;
+		void (*run)(MeshData* mesh);
+	};
+
+	const Stage stages[4] =
+	{
+		{ "weld", [](MeshData* target) { WeldVertices(target); } },
+		{ "vertex cache", [](MeshData* target) { OptimizeVertexCache(target); } },
+		{ "overdraw", [](MeshData* target) { OptimizeOverdraw(target); } },
+		{ "vertex fetch", [](MeshData* target) { OptimizeVertexFetch(target); } },
+	};
+
+	for (int i = 0; i < 4; ++i)
+	{
+		if (!report)
+		{
+			stages[i].run(mesh);
+			continue;
+		}
+
+		MeshOptimizeStage& stage = report->stages[i];
+		stage.name = stages[i].name;
+		stage.cacheMissRatioBefore = ComputeCacheMissRatio(*mesh);
+		stage.overfetchBefore = ComputeOverfetchRatio(*mesh);
+
+		stages[i].run(mesh);
+
+		stage.cacheMissRatioAfter = ComputeCacheMissRatio(*mesh);
+		stage.overfetchAfter = ComputeOverfetchRatio(*mesh);
+		stage.vertexCount = (unsigned int)mesh->vertices.size();
+		stage.triangleCount = (unsigned int)(mesh->indices.size() / 3);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Mesh.h"
+
+namespace Geometry
+{
+	// The post-transform cache meshes are measured against: a FIFO of this many vertices,
+	// which is how most hardware behaves whatever it was optimized for
+	const unsigned int c_MeasuredCacheSize = 16;
+
+	// Vertices transformed per triangle drawn: 3 at worst, and approaching 0.5 for a large
+	// regular grid in the best order
+	float ComputeCacheMissRatio(const MeshData& mesh, unsigned int cacheSize = c_MeasuredCacheSize);
+
+	// Bytes read from the vertex buffer per byte of vertices it holds, through a 16 KB cache
+	// of 64-byte lines. 1 when every vertex is read once.
+	float ComputeOverfetchRatio(const MeshData& mesh);
+
+	// Merges vertices with the same position and texture coordinates, and drops triangles
+	// that lose a corner to it. Returns how many vertices are left.
+	unsigned int WeldVertices(MeshData* mesh);
+
+	// Reorders triangles for the post-transform cache with Forsyth's linear-speed algorithm
+	void OptimizeVertexCache(MeshData* mesh);
+
+	// Splits a cache-ordered index list into clusters wherever that keeps the cache miss
+	// ratio within threshold of what it was, then draws the clusters that face out from the
+	// middle of the mesh first, since they are the likeliest to hide the rest. The winding
+	// the generators use is taken to face out.
+	void OptimizeOverdraw(MeshData* mesh, float threshold = 1.05f);
+
+	// Renumbers vertices in the order the indices first use them, dropping any they don't
+	void OptimizeVertexFetch(MeshData* mesh);
+
+	struct MeshOptimizeStage
+	{
+		const char* name;
+		float cacheMissRatioBefore;
+		float cacheMissRatioAfter;
+		float overfetchBefore;
+		float overfetchAfter;
+		unsigned int vertexCount;   // after the stage
+		unsigned int triangleCount;
+	};
+
+	struct MeshOptimizeReport
+	{
+		MeshOptimizeStage stages[4];
+	};
+
+	// Welds, orders for the vertex cache, then for overdraw, then for vertex fetch. The
+	// report, if there is one, has the ratios before and after every stage.
+	void OptimizeMesh(MeshData* mesh, MeshOptimizeReport* report = nullptr);
+}
\ No newline at end of file
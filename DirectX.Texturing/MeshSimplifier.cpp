@@ -0,0 +1,665 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	const unsigned int c_NoIndex = ~0u;
+
+	// Open edges, at seams and borders, are held in place by a plane through them at right
+	// angles to their triangle, weighted this many times their length squared
+	const double c_EdgeWeight = 10.0;
+
+	// Each pass collapses every edge it can without two collapses touching, so a handful
+	// is usually enough; this only guards against one that can't finish
+	const unsigned int c_MaxPasses = 64;
+
+	enum class VertexKind
+	{
+		Manifold, // free to collapse along any edge
+		Border,   // on one open border, and only collapses along it
+		Seam,     // on one texture seam, and only collapses along it, with its twin on the other side
+		Locked,   // where seams or borders end or meet, or the surface is more tangled; never moves
+	};
+
+	void Subtract(const Vertex& a, const Vertex& b, double* result)
+	{
+		result[0] = double(a.x) - b.x;
+		result[1] = double(a.y) - b.y;
+		result[2] = double(a.z) - b.z;
+	}
+
+	void Cross(const double* a, const double* b, double* result)
+	{
+		result[0] = a[1] * b[2] - a[2] * b[1];
+		result[1] = a[2] * b[0] - a[0] * b[2];
+		result[2] = a[0] * b[1] - a[1] * b[0];
+	}
+
+	double Dot(const double* a, const double* b)
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	double PlaneDistance(const double* normal, const Vertex& point)
+	{
+		return -(normal[0] * point.x + normal[1] * point.y + normal[2] * point.z);
+	}
+
+	// Twice the triangle's area, along its normal
+	void TriangleNormal(const Vertex& a, const Vertex& b, const Vertex& c, double* result)
+	{
+		double ab[3], ac[3];
+		Subtract(b, a, ab);
+		Subtract(c, a, ac);
+		Cross(ab, ac, result);
+	}
+
+	// The sum of squared distances to a set of planes, each weighted by the area it stands
+	// for. Divided by the total weight, that is a mean squared distance.
+	struct Quadric
+	{
+		double a00 = 0.0, a11 = 0.0, a22 = 0.0;
+		double a01 = 0.0, a02 = 0.0, a12 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		// The plane n.p + d = 0, with n of unit length
+		void AddPlane(const double* n, double d, double w)
+		{
+			a00 += w * n[0] * n[0];
+			a11 += w * n[1] * n[1];
+			a22 += w * n[2] * n[2];
+			a01 += w * n[0] * n[1];
+			a02 += w * n[0] * n[2];
+			a12 += w * n[1] * n[2];
+			b0 += w * n[0] * d;
+			b1 += w * n[1] * d;
+			b2 += w * n[2] * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a00 += q.a00;
+			a11 += q.a11;
+			a22 += q.a22;
+			a01 += q.a01;
+			a02 += q.a02;
+			a12 += q.a12;
+			b0 += q.b0;
+			b1 += q.b1;
+			b2 += q.b2;
+			c += q.c;
+			weight += q.weight;
+		}
+
+		double Error(const Vertex& p) const
+		{
+			double x = p.x, y = p.y, z = p.z;
+			double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return weight > 0.0 ? fabs(e) / weight : 0.0;
+		}
+	};
+
+	struct EdgeCollapse
+	{
+		unsigned int from;
+		unsigned int to;
+		double cost;
+	};
+
+	// Vertices are told apart two ways. By index, as the triangles use them, and by
+	// position, which joins the wedges a texture seam splits a point into. The topology that
+	// decides what may collapse is by position; the collapse itself moves every wedge.
+	class Simplifier
+	{
+	public:
+		Simplifier(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+			: m_Vertices(vertices), m_Indices(indices)
+		{
+			BuildPositions();
+			BuildAdjacency();
+			ClassifyVertices();
+			ComputeQuadrics();
+		}
+
+		float Run(unsigned int targetIndexCount, float maxError)
+		{
+			size_t vertexCount = m_Vertices.size();
+			double maxCost = double(maxError) * maxError;
+			double reached = 0.0;
+
+			std::vector<EdgeCollapse> collapses;
+			std::vector<bool> moved(vertexCount);
+			m_Collapse.resize(vertexCount);
+
+			for (unsigned int pass = 0; pass < c_MaxPasses && m_Indices.size() > targetIndexCount; ++pass)
+			{
+				if (pass > 0)
+					BuildAdjacency();
+
+				// The cheaper way along every edge, of the ways the ends allow
+				collapses.clear();
+				for (size_t i = 0; i < m_Indices.size(); ++i)
+				{
+					unsigned int a = m_Indices[i];
+					unsigned int b = m_Indices[i - i % 3 + (i % 3 + 1) % 3];
+
+					double costAB = CanCollapse(a, b) ? m_Quadrics[m_Position[a]].Error(m_Vertices[b]) : DBL_MAX;
+					double costBA = CanCollapse(b, a) ? m_Quadrics[m_Position[b]].Error(m_Vertices[a]) : DBL_MAX;
+					if (costAB == DBL_MAX && costBA == DBL_MAX)
+						continue;
+
+					if (costAB <= costBA)
+						collapses.push_back({ a, b, costAB });
+					else
+						collapses.push_back({ b, a, costBA });
+				}
+
+				if (collapses.empty())
+					break;
+
+				std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.cost < b.cost; });
+
+				// Most collapses take two triangles with them. Going much past the cost of the last
+				// one the target needs would take expensive collapses this pass that cheap ones,
+				// freed up by the next, could have made instead.
+				size_t goal = (m_Indices.size() - targetIndexCount) / 6;
+				double passCost = maxCost;
+				if (goal < collapses.size())
+					passCost = std::min(passCost, collapses[goal].cost * 1.5);
+
+				// Cheapest first, leaving alone anything a collapse this pass has already touched
+				for (size_t v = 0; v < vertexCount; ++v)
+					m_Collapse[v] = (unsigned int)v;
+				std::fill(moved.begin(), moved.end(), false);
+
+				size_t triangleCount = m_Indices.size() / 3;
+				unsigned int collapsed = 0;
+				for (const EdgeCollapse& collapse : collapses)
+				{
+					if (collapse.cost > passCost || triangleCount * 3 <= targetIndexCount)
+						break;
+
+					unsigned int from = m_Position[collapse.from];
+					unsigned int to = m_Position[collapse.to];
+					if (moved[from] || moved[to])
+						continue;
+
+					// Across a seam the other wedge goes to the other side of the seam at the target
+					unsigned int twin = c_NoIndex;
+					unsigned int twinTarget = c_NoIndex;
+					if (m_Kind[from] == VertexKind::Seam)
+					{
+						twin = FindTwin(collapse.from);
+						twinTarget = twin != c_NoIndex ? FindNeighbor(twin, to) : c_NoIndex;
+						if (twinTarget == c_NoIndex || twinTarget == collapse.to)
+							continue;
+					}
+
+					if (FlipsTriangle(collapse.from, collapse.to))
+						continue;
+
+					triangleCount -= CountSharedTriangles(from, to);
+
+					m_Collapse[collapse.from] = collapse.to;
+					if (twin != c_NoIndex)
+						m_Collapse[twin] = twinTarget;
+
+					m_Quadrics[to].Add(m_Quadrics[from]);
+					moved[from] = true;
+					moved[to] = true;
+
+					reached = std::max(reached, collapse.cost);
+					collapsed++;
+				}
+
+				if (collapsed == 0)
+					break;
+
+				// Triangles that lost a corner are gone
+				size_t kept = 0;
+				for (size_t i = 0; i + 2 < m_Indices.size(); i += 3)
+				{
+					unsigned int a = m_Collapse[m_Indices[i]];
+					unsigned int b = m_Collapse[m_Indices[i + 1]];
+					unsigned int c = m_Collapse[m_Indices[i + 2]];
+					if (m_Position[a] == m_Position[b] || m_Position[b] == m_Position[c] || m_Position[c] == m_Position[a])
+						continue;
+
+					m_Indices[kept++] = a;
+					m_Indices[kept++] = b;
+					m_Indices[kept++] = c;
+				}
+				m_Indices.resize(kept);
+			}
+
+			return float(sqrt(reached));
+		}
+
+	private:
+		const std::vector<Vertex>& m_Vertices;
+		std::vector<unsigned int>& m_Indices;
+
+		// The first vertex with the same position, and the next one round, in a loop of all of them
+		std::vector<unsigned int> m_Position;
+		std::vector<unsigned int> m_NextWedge;
+		std::vector<bool> m_Referenced;
+
+		// By position, as m_Position gives it
+		std::vector<VertexKind> m_Kind;
+		std::vector<Quadric> m_Quadrics;
+
+		// Triangles touching each position
+		std::vector<unsigned int> m_TriangleOffsets;
+		std::vector<unsigned int> m_Triangles;
+
+		// Where each vertex goes in the current pass
+		std::vector<unsigned int> m_Collapse;
+
+		void BuildPositions()
+		{
+			size_t vertexCount = m_Vertices.size();
+
+			std::vector<unsigned int> order(vertexCount);
+			for (size_t v = 0; v < vertexCount; ++v)
+				order[v] = (unsigned int)v;
+
+			auto samePosition = [&](unsigned int a, unsigned int b)
+			{
+				return m_Vertices[a].x == m_Vertices[b].x && m_Vertices[a].y == m_Vertices[b].y && m_Vertices[a].z == m_Vertices[b].z;
+			};
+
+			std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b)
+			{
+				const Vertex& va = m_Vertices[a];
+				const Vertex& vb = m_Vertices[b];
+				if (va.x != vb.x)
+					return va.x < vb.x;
+				if (va.y != vb.y)
+					return va.y < vb.y;
+				if (va.z != vb.z)
+					return va.z < vb.z;
+				return a < b;
+			});
+
+			m_Position.resize(vertexCount);
+			m_NextWedge.resize(vertexCount);
+			for (size_t i = 0; i < vertexCount; )
+			{
+				size_t end = i + 1;
+				while (end < vertexCount && samePosition(order[i], order[end]))
+					end++;
+
+				for (size_t k = i; k < end; ++k)
+				{
+					m_Position[order[k]] = order[i];
+					m_NextWedge[order[k]] = order[k + 1 < end ? k + 1 : i];
+				}
+
+				i = end;
+			}
+
+			m_Referenced.assign(vertexCount, false);
+			for (unsigned int index : m_Indices)
+				m_Referenced[index] = true;
+		}
+
+		void BuildAdjacency()
+		{
+			size_t vertexCount = m_Vertices.size();
+
+			m_TriangleOffsets.assign(vertexCount + 1, 0);
+			for (unsigned int index : m_Indices)
+				m_TriangleOffsets[m_Position[index] + 1]++;
+
+			for (size_t v = 0; v < vertexCount; ++v)
+				m_TriangleOffsets[v + 1] += m_TriangleOffsets[v];
+
+			std::vector<unsigned int> filled(m_TriangleOffsets.begin(), m_TriangleOffsets.end() - 1);
+			m_Triangles.resize(m_Indices.size());
+			for (size_t i = 0; i < m_Indices.size(); ++i)
+				m_Triangles[filled[m_Position[m_Indices[i]]]++] = (unsigned int)(i / 3);
+		}
+
+		// Whether a triangle runs from a to b, comparing by index or by position
+		bool HasEdge(unsigned int a, unsigned int b, bool byPosition) const
+		{
+			unsigned int position = m_Position[a];
+			for (unsigned int i = m_TriangleOffsets[position]; i < m_TriangleOffsets[position + 1]; ++i)
+			{
+				const unsigned int* corners = &m_Indices[m_Triangles[i] * 3];
+				for (int k = 0; k < 3; ++k)
+				{
+					unsigned int corner = corners[k];
+					unsigned int next = corners[(k + 1) % 3];
+					if (byPosition ? m_Position[corner] == position && m_Position[next] == m_Position[b] : corner == a && next == b)
+						return true;
+				}
+			}
+
+			return false;
+		}
+
+		void ClassifyVertices()
+		{
+			size_t vertexCount = m_Vertices.size();
+
+			// Open edges by index are at seams or borders; open edges by position only at borders
+			std::vector<unsigned int> openOut(vertexCount, 0), openIn(vertexCount, 0);
+			std::vector<unsigned int> borderOut(vertexCount, 0), borderIn(vertexCount, 0);
+			for (size_t i = 0; i < m_Indices.size(); ++i)
+			{
+				unsigned int a = m_Indices[i];
+				unsigned int b = m_Indices[i - i % 3 + (i % 3 + 1) % 3];
+
+				if (!HasEdge(b, a, false))
+				{
+					openOut[a]++;
+					openIn[b]++;
+				}
+
+				if (!HasEdge(b, a, true))
+				{
+					borderOut[m_Position[a]]++;
+					borderIn[m_Position[b]]++;
+				}
+			}
+
+			std::vector<unsigned int> wedges(vertexCount, 0), openWedges(vertexCount, 0), seamWedges(vertexCount, 0);
+			for (size_t v = 0; v < vertexCount; ++v)
+			{
+				if (!m_Referenced[v])
+					continue;
+
+				unsigned int position = m_Position[v];
+				wedges[position]++;
+				if (openOut[v] || openIn[v])
+					openWedges[position]++;
+				if (openOut[v] == 1 && openIn[v] == 1)
+					seamWedges[position]++;
+			}
+
+			m_Kind.assign(vertexCount, VertexKind::Locked);
+			for (size_t p = 0; p < vertexCount; ++p)
+			{
+				if (m_Position[p] != p || wedges[p] == 0)
+					continue;
+
+				if (borderOut[p] || borderIn[p])
+					m_Kind[p] = wedges[p] == 1 && borderOut[p] == 1 && borderIn[p] == 1 ? VertexKind::Border : VertexKind::Locked;
+				else if (wedges[p] == 1)
+					m_Kind[p] = openWedges[p] == 0 ? VertexKind::Manifold : VertexKind::Locked;
+				else if (wedges[p] == 2 && seamWedges[p] == 2)
+					m_Kind[p] = VertexKind::Seam;
+			}
+		}
+
+		void ComputeQuadrics()
+		{
+			m_Quadrics.assign(m_Vertices.size(), Quadric());
+
+			for (size_t t = 0; t + 2 < m_Indices.size(); t += 3)
+			{
+				const unsigned int* corners = &m_Indices[t];
+
+				double normal[3];
+				TriangleNormal(m_Vertices[corners[0]], m_Vertices[corners[1]], m_Vertices[corners[2]], normal);
+				double twiceArea = sqrt(Dot(normal, normal));
+				if (twiceArea == 0.0)
+					continue;
+
+				for (int k = 0; k < 3; ++k)
+					normal[k] /= twiceArea;
+
+				double d = PlaneDistance(normal, m_Vertices[corners[0]]);
+				for (int k = 0; k < 3; ++k)
+					m_Quadrics[m_Position[corners[k]]].AddPlane(normal, d, twiceArea * 0.5);
+
+				for (int k = 0; k < 3; ++k)
+				{
+					unsigned int a = corners[k];
+					unsigned int b = corners[(k + 1) % 3];
+					if (HasEdge(b, a, false))
+						continue;
+
+					double edge[3], side[3];
+					Subtract(m_Vertices[b], m_Vertices[a], edge);
+					Cross(edge, normal, side);
+					double length = sqrt(Dot(side, side));
+					if (length == 0.0)
+						continue;
+
+					for (int j = 0; j < 3; ++j)
+						side[j] /= length;
+
+					double sideDistance = PlaneDistance(side, m_Vertices[a]);
+					double weight = c_EdgeWeight * Dot(edge, edge);
+					m_Quadrics[m_Position[a]].AddPlane(side, sideDistance, weight);
+					m_Quadrics[m_Position[b]].AddPlane(side, sideDistance, weight);
+				}
+			}
+		}
+
+		bool CanCollapse(unsigned int from, unsigned int to) const
+		{
+			if (m_Position[from] == m_Position[to])
+				return false;
+
+			switch (m_Kind[m_Position[from]])
+			{
+			case VertexKind::Manifold:
+				return true;
+
+			case VertexKind::Border:
+				return !HasEdge(from, to, true) || !HasEdge(to, from, true);
+
+			case VertexKind::Seam:
+				return !HasEdge(from, to, false) || !HasEdge(to, from, false);
+
+			default:
+				return false;
+			}
+		}
+
+		// The other wedge at a seam vertex
+		unsigned int FindTwin(unsigned int vertex) const
+		{
+			for (unsigned int wedge = m_NextWedge[vertex]; wedge != vertex; wedge = m_NextWedge[wedge])
+			{
+				if (m_Referenced[wedge])
+					return wedge;
+			}
+
+			return c_NoIndex;
+		}
+
+		// The wedge at position that shares a triangle with vertex
+		unsigned int FindNeighbor(unsigned int vertex, unsigned int position) const
+		{
+			unsigned int own = m_Position[vertex];
+			for (unsigned int i = m_TriangleOffsets[own]; i < m_TriangleOffsets[own + 1]; ++i)
+			{
+				const unsigned int* corners = &m_Indices[m_Triangles[i] * 3];
+				for (int k = 0; k < 3; ++k)
+				{
+					if (corners[k] != vertex)
+						continue;
+
+					for (int j = 1; j < 3; ++j)
+					{
+						unsigned int other = m_Collapse[corners[(k + j) % 3]];
+						if (m_Position[other] == position)
+							return other;
+					}
+				}
+			}
+
+			return c_NoIndex;
+		}
+
+		// Triangles at from's position that also have a corner at to's
+		size_t CountSharedTriangles(unsigned int from, unsigned int to) const
+		{
+			size_t count = 0;
+			for (unsigned int i = m_TriangleOffsets[from]; i < m_TriangleOffsets[from + 1]; ++i)
+			{
+				const unsigned int* corners = &m_Indices[m_Triangles[i] * 3];
+				for (int k = 0; k < 3; ++k)
+				{
+					if (m_Position[m_Collapse[corners[k]]] == to)
+					{
+						count++;
+						break;
+					}
+				}
+			}
+
+			return count;
+		}
+
+		// Whether moving from onto to turns any triangle that survives it over
+		bool FlipsTriangle(unsigned int from, unsigned int to) const
+		{
+			unsigned int fromPosition = m_Position[from];
+			unsigned int toPosition = m_Position[to];
+
+			for (unsigned int i = m_TriangleOffsets[fromPosition]; i < m_TriangleOffsets[fromPosition + 1]; ++i)
+			{
+				const unsigned int* corners = &m_Indices[m_Triangles[i] * 3];
+
+				unsigned int current[3];
+				unsigned int positions[3];
+				for (int k = 0; k < 3; ++k)
+				{
+					current[k] = m_Collapse[corners[k]];
+					positions[k] = m_Position[current[k]];
+				}
+
+				// Gone already, or going with this collapse
+				if (positions[0] == positions[1] || positions[1] == positions[2] || positions[2] == positions[0])
+					continue;
+				if (positions[0] == toPosition || positions[1] == toPosition || positions[2] == toPosition)
+					continue;
+
+				const Vertex* points[3] = { &m_Vertices[current[0]], &m_Vertices[current[1]], &m_Vertices[current[2]] };
+
+				double before[3];
+				TriangleNormal(*points[0], *points[1], *points[2], before);
+
+				for (int k = 0; k < 3; ++k)
+				{
+					if (positions[k] == fromPosition)
+						points[k] = &m_Vertices[to];
+				}
+
+				double after[3];
+				TriangleNormal(*points[0], *points[1], *points[2], after);
+
+				if (Dot(before, after) <= 0.0)
+					return true;
+			}
+
+			return false;
+		}
+	};
+}
+
+float Geometry::SimplifyMesh(MeshData* mesh, unsigned int targetIndexCount, float maxError)
+{
+	if (mesh->indices.size() <= targetIndexCount)
+		return 0.0f;
+
+	Simplifier simplifier(mesh->vertices, mesh->indices);
+	return simplifier.Run(targetIndexCount, maxError);
+}
+
+void Geometry::BuildLodChain(const MeshData& mesh, unsigned int maxLodCount, float maxError, MeshLodChain* chain)
+{
+	chain->mesh = mesh;
+	chain->lods.clear();
+	chain->lods.push_back({ 0, (unsigned int)mesh.indices.size(), 0.0f });
+
+	// Around the middle of the bounding box, which is close enough to the smallest sphere
+	DirectX::XMVECTOR minimum = DirectX::XMVectorReplicate(FLT_MAX);
+	DirectX::XMVECTOR maximum = DirectX::XMVectorReplicate(-FLT_MAX);
+	for (const Vertex& vertex : mesh.vertices)
+	{
+		DirectX::XMVECTOR position = DirectX::XMVectorSet(vertex.x, vertex.y, vertex.z, 0.0f);
+		minimum = DirectX::XMVectorMin(minimum, position);
+		maximum = DirectX::XMVectorMax(maximum, position);
+	}
+
+	DirectX::XMVECTOR center = mesh.vertices.empty() ? DirectX::XMVectorZero() : DirectX::XMVectorScale(DirectX::XMVectorAdd(minimum, maximum), 0.5f);
+	DirectX::XMStoreFloat3(&chain->center, center);
+
+	chain->radius = 0.0f;
+	for (const Vertex& vertex : mesh.vertices)
+	{
+		DirectX::XMVECTOR offset = DirectX::XMVectorSubtract(DirectX::XMVectorSet(vertex.x, vertex.y, vertex.z, 0.0f), center);
+		chain->radius = std::max(chain->radius, DirectX::XMVectorGetX(DirectX::XMVector3Length(offset)));
+	}
+
+	if (maxLodCount < 2 || mesh.indices.size() < 6)
+		return;
+
+	// One simplifier carries on from each LOD to the next. The quadrics it keeps still
+	// measure from the full mesh's surface, so the errors do too.
+	std::vector<unsigned int> simplified = mesh.indices;
+	Simplifier simplifier(mesh.vertices, simplified);
+
+	MeshData lod;
+	lod.vertices = mesh.vertices;
+
+	while (chain->lods.size() < maxLodCount)
+	{
+		const MeshLod previous = chain->lods.back();
+		unsigned int target = previous.indexCount / 6 * 3;
+		if (target == 0)
+			break;
+
+		float error = simplifier.Run(target, maxError);
+		if (simplified.size() * 4 > size_t(previous.indexCount) * 3)
+			break;
+
+		lod.indices = simplified;
+		OptimizeVertexCache(&lod);
+
+		MeshLod next;
+		next.indexOffset = (unsigned int)chain->mesh.indices.size();
+		next.indexCount = (unsigned int)lod.indices.size();
+		next.error = std::max(error, previous.error);
+		chain->lods.push_back(next);
+
+		chain->mesh.indices.insert(chain->mesh.indices.end(), lod.indices.begin(), lod.indices.end());
+	}
+}
+
+float Geometry::ComputeScreenError(float error, DirectX::FXMMATRIX projection, float viewportHeight, float distance)
+{
+	if (distance <= 0.0f)
+		return FLT_MAX;
+
+	// The projection scales y by the cotangent of half the vertical field of view, and the
+	// viewport maps -1 to 1 onto its height
+	float scale = DirectX::XMVectorGetY(projection.r[1]) * 0.5f * viewportHeight;
+	return error * scale / distance;
+}
+
+unsigned int Geometry::SelectLod(const MeshLodChain& chain, DirectX::FXMMATRIX projection, float viewportHeight, float distance, float maxPixels)
+{
+	for (size_t i = chain.lods.size(); i-- > 1; )
+	{
+		if (ComputeScreenError(chain.lods[i].error, projection, viewportHeight, distance) <= maxPixels)
+			return (unsigned int)i;
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Geometry
+{
+	// Collapses edges, cheapest first by quadric error, until the mesh has at most
+	// targetIndexCount indices or the next collapse would cost more than maxError. Vertices
+	// only collapse onto other vertices, so only the indices change.
+	//
+	// Where texture coordinates split along a seam, both sides of it collapse together along
+	// the seam, so it stays closed and keeps its coordinates; open borders only collapse
+	// along themselves. Vertices where more than two seams or borders meet never move. The
+	// mesh should be welded first.
+	//
+	// Returns the largest error reached, in mesh units. It is the root mean square distance
+	// from the planes each collapsed vertex had taken in, which is what decides the order;
+	// the furthest single point tends to have moved a few times that.
+	float SimplifyMesh(MeshData* mesh, unsigned int targetIndexCount, float maxError);
+
+	struct MeshLod
+	{
+		unsigned int indexOffset; // into the chain's indices
+		unsigned int indexCount;
+		float error;              // from the full mesh's surface, in mesh units, as SimplifyMesh gives it
+	};
+
+	struct MeshLodChain
+	{
+		// The vertices every LOD draws from, and each LOD's indices one after the other, full
+		// detail first
+		MeshData mesh;
+		std::vector<MeshLod> lods;
+
+		// A sphere around every vertex, to measure the distance to the camera from
+		DirectX::XMFLOAT3 center;
+		float radius;
+	};
+
+	// Up to maxLodCount LODs, each simplified on from the one before to half its triangles
+	// and reordered for the vertex cache. Errors are all from the full mesh. The chain stops early once an LOD can't
+	// get below 3/4 of the one before within maxError.
+	void BuildLodChain(const MeshData& mesh, unsigned int maxLodCount, float maxError, MeshLodChain* chain);
+
+	// How many pixels high error at distance in front of the camera comes out as, on a
+	// viewport viewportHeight pixels high under projection
+	float ComputeScreenError(float error, DirectX::FXMMATRIX projection, float viewportHeight, float distance);
+
+	// The coarsest LOD whose error, at the given distance to the nearest point of the mesh,
+	// covers no more than maxPixels
+	unsigned int SelectLod(const MeshLodChain& chain, DirectX::FXMMATRIX projection, float viewportHeight, float distance, float maxPixels = 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,418 @@
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	const unsigned int c_NoIndex = ~0u;
+
+	XMVECTOR LoadPosition(const Vertex& vertex)
+	{
+		return XMVectorSet(vertex.x, vertex.y, vertex.z, 0.0f);
+	}
+
+	// Unit normal of a triangle, facing the side it is drawn from, or zero if it has no area
+	XMVECTOR ComputeTriangleNormal(const MeshData& mesh, const unsigned int* corners)
+	{
+		XMVECTOR a = LoadPosition(mesh.vertices[corners[0]]);
+		XMVECTOR b = LoadPosition(mesh.vertices[corners[1]]);
+		XMVECTOR c = LoadPosition(mesh.vertices[corners[2]]);
+
+		XMVECTOR normal = XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a));
+		float length = XMVectorGetX(XMVector3Length(normal));
+		return length > 0.0f ? XMVectorScale(normal, 1.0f / length) : XMVectorZero();
+	}
+
+	// The triangles around each vertex, as one list with where each vertex's begin
+	struct VertexTriangles
+	{
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> triangles;
+
+		explicit VertexTriangles(const MeshData& mesh)
+			: offsets(mesh.vertices.size() + 1, 0), triangles(mesh.indices.size())
+		{
+			for (unsigned int index : mesh.indices)
+				offsets[index + 1]++;
+			for (size_t v = 0; v < mesh.vertices.size(); ++v)
+				offsets[v + 1] += offsets[v];
+
+			std::vector<unsigned int> filled(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < mesh.indices.size(); ++i)
+				triangles[filled[mesh.indices[i]]++] = (unsigned int)(i / 3);
+		}
+	};
+
+	void SetLane(XMFLOAT4A& vector, unsigned int lane, float value)
+	{
+		(&vector.x)[lane] = value;
+	}
+
+	// Sphere and normal cone of the meshlet's triangles, into its lane of the block
+	void ComputeBounds(const MeshData& mesh, const Geometry::MeshletMesh& meshlets, const Geometry::Meshlet& meshlet,
+		Geometry::MeshletBoundsBlock& block, unsigned int lane)
+	{
+		const unsigned int* indices = &meshlets.indices[meshlet.indexOffset];
+		unsigned int indexCount = meshlet.triangleCount * 3;
+
+		// Around the middle of the bounding box, which is close enough to the smallest sphere
+		XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+		for (unsigned int i = 0; i < indexCount; ++i)
+		{
+			XMVECTOR position = LoadPosition(mesh.vertices[indices[i]]);
+			minimum = XMVectorMin(minimum, position);
+			maximum = XMVectorMax(maximum, position);
+		}
+
+		XMVECTOR center = XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f);
+		float radius = 0.0f;
+		for (unsigned int i = 0; i < indexCount; ++i)
+		{
+			XMVECTOR offset = XMVectorSubtract(LoadPosition(mesh.vertices[indices[i]]), center);
+			radius = std::max(radius, XMVectorGetX(XMVector3Length(offset)));
+		}
+
+		// The cone's axis is the average normal, and it is as wide as the normal furthest from
+		// that. Triangles with no area face nowhere and are never drawn, so they don't count.
+		XMVECTOR axis = XMVectorZero();
+		for (unsigned int i = 0; i < indexCount; i += 3)
+			axis = XMVectorAdd(axis, ComputeTriangleNormal(mesh, &indices[i]));
+
+		float cutoff = 1.0f;
+		float axisLength = XMVectorGetX(XMVector3Length(axis));
+		if (axisLength > 0.0f)
+		{
+			axis = XMVectorScale(axis, 1.0f / axisLength);
+
+			float minimumDot = 1.0f;
+			for (unsigned int i = 0; i < indexCount; i += 3)
+			{
+				XMVECTOR normal = ComputeTriangleNormal(mesh, &indices[i]);
+				if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f)
+					minimumDot = std::min(minimumDot, XMVectorGetX(XMVector3Dot(normal, axis)));
+			}
+
+			// Wider than a hemisphere some triangle always faces the eye
+			if (minimumDot > 0.0f)
+				cutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+		}
+
+		XMFLOAT3 c, a;
+		XMStoreFloat3(&c, center);
+		XMStoreFloat3(&a, axis);
+		SetLane(block.centerX, lane, c.x);
+		SetLane(block.centerY, lane, c.y);
+		SetLane(block.centerZ, lane, c.z);
+		SetLane(block.radius, lane, radius);
+		SetLane(block.axisX, lane, a.x);
+		SetLane(block.axisY, lane, a.y);
+		SetLane(block.axisZ, lane, a.z);
+		SetLane(block.cutoff, lane, cutoff);
+	}
+}
+
+void Geometry::BuildMeshlets(const MeshData& mesh, MeshletMesh* meshlets)
+{
+	meshlets->indices.clear();
+	meshlets->meshlets.clear();
+	meshlets->bounds.clear();
+	meshlets->indices.reserve(mesh.indices.size());
+
+	size_t triangleCount = mesh.indices.size() / 3;
+	VertexTriangles adjacency(mesh);
+
+	// Distances while growing are measured in average edge lengths, so they weigh the same
+	// against the normals however big the mesh is
+	std::vector<XMFLOAT3> normals(triangleCount);
+	std::vector<XMFLOAT3> centers(triangleCount);
+	float edgeLength = 0.0f;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		const unsigned int* corners = &mesh.indices[t * 3];
+		XMVECTOR a = LoadPosition(mesh.vertices[corners[0]]);
+		XMVECTOR b = LoadPosition(mesh.vertices[corners[1]]);
+		XMVECTOR c = LoadPosition(mesh.vertices[corners[2]]);
+
+		XMStoreFloat3(&normals[t], ComputeTriangleNormal(mesh, corners));
+		XMStoreFloat3(&centers[t], XMVectorScale(XMVectorAdd(a, XMVectorAdd(b, c)), 1.0f / 3.0f));
+		edgeLength += XMVectorGetX(XMVector3Length(XMVectorSubtract(b, a)));
+	}
+
+	float toEdges = edgeLength > 0.0f ? float(triangleCount) / edgeLength : 1.0f;
+
+	std::vector<bool> assigned(triangleCount, false);
+	std::vector<unsigned int> inMeshlet(mesh.vertices.size(), c_NoIndex);
+	std::vector<unsigned int> candidateOf(triangleCount, c_NoIndex);
+	std::vector<unsigned int> candidates;
+
+	size_t nextUnassigned = 0;
+	unsigned int seed = c_NoIndex;
+
+	while (true)
+	{
+		if (seed == c_NoIndex)
+		{
+			while (nextUnassigned < triangleCount && assigned[nextUnassigned])
+				nextUnassigned++;
+			if (nextUnassigned == triangleCount)
+				break;
+			seed = (unsigned int)nextUnassigned;
+		}
+
+		unsigned int id = (unsigned int)meshlets->meshlets.size();
+		Meshlet meshlet = { (unsigned int)meshlets->indices.size(), 0, 0 };
+		XMVECTOR normalSum = XMVectorZero();
+		XMVECTOR centerSum = XMVectorZero();
+		candidates.clear();
+
+		auto addTriangle = [&](unsigned int t)
+		{
+			assigned[t] = true;
+			meshlet.triangleCount++;
+			normalSum = XMVectorAdd(normalSum, XMLoadFloat3(&normals[t]));
+			centerSum = XMVectorAdd(centerSum, XMLoadFloat3(&centers[t]));
+
+			for (unsigned int k = 0; k < 3; ++k)
+			{
+				unsigned int v = mesh.indices[t * 3 + k];
+				meshlets->indices.push_back(v);
+				if (inMeshlet[v] == id)
+					continue;
+
+				inMeshlet[v] = id;
+				meshlet.vertexCount++;
+				for (unsigned int i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; ++i)
+				{
+					unsigned int neighbor = adjacency.triangles[i];
+					if (!assigned[neighbor] && candidateOf[neighbor] != id)
+					{
+						candidateOf[neighbor] = id;
+						candidates.push_back(neighbor);
+					}
+				}
+			}
+		};
+
+		addTriangle(seed);
+		seed = c_NoIndex;
+
+		while (meshlet.triangleCount < c_MeshletMaxTriangles)
+		{
+			XMVECTOR normal = XMVectorScale(normalSum, 1.0f / meshlet.triangleCount);
+			XMVECTOR center = XMVectorScale(centerSum, 1.0f / meshlet.triangleCount);
+
+			unsigned int best = c_NoIndex;
+			unsigned int bestAdded = 4;
+			float bestScore = -FLT_MAX;
+
+			for (size_t i = 0; i < candidates.size();)
+			{
+				unsigned int t = candidates[i];
+				if (assigned[t])
+				{
+					candidates[i] = candidates.back();
+					candidates.pop_back();
+					continue;
+				}
+				++i;
+
+				const unsigned int* corners = &mesh.indices[t * 3];
+				unsigned int added = (inMeshlet[corners[0]] != id) + (inMeshlet[corners[1]] != id) + (inMeshlet[corners[2]] != id);
+				if (meshlet.vertexCount + added > c_MeshletMaxVertices || added > bestAdded)
+					continue;
+
+				float facing = XMVectorGetX(XMVector3Dot(XMLoadFloat3(&normals[t]), normal));
+				float distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&centers[t]), center)));
+				float score = facing - distance * toEdges;
+				if (added < bestAdded || score > bestScore)
+				{
+					best = t;
+					bestAdded = added;
+					bestScore = score;
+				}
+			}
+
+			// Out of neighbors with room to spare, as on a mesh in pieces or a pocket hemmed in
+			// by other meshlets. Rather than leave the meshlet short, carry on from whichever
+			// triangle left anywhere is nearest its middle and still fits.
+			if (best == c_NoIndex)
+			{
+				float nearest = FLT_MAX;
+				for (size_t t = nextUnassigned; t < triangleCount; ++t)
+				{
+					if (assigned[t])
+						continue;
+
+					const unsigned int* corners = &mesh.indices[t * 3];
+					unsigned int added = (inMeshlet[corners[0]] != id) + (inMeshlet[corners[1]] != id) + (inMeshlet[corners[2]] != id);
+					if (meshlet.vertexCount + added > c_MeshletMaxVertices)
+						continue;
+
+					float distance = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&centers[t]), center)));
+					if (distance < nearest)
+					{
+						nearest = distance;
+						best = (unsigned int)t;
+					}
+				}
+
+				if (best == c_NoIndex)
+					break;
+			}
+
+			addTriangle(best);
+		}
+
+		// The next meshlet starts beside this one, from the triangle with the fewest others
+		// left around it. Starting in corners rather than along the middle of an edge leaves
+		// fewer pockets too small for anything but scraps.
+		unsigned int fewestOpen = ~0u;
+		for (unsigned int t : candidates)
+		{
+			if (assigned[t])
+				continue;
+
+			unsigned int open = 0;
+			for (unsigned int k = 0; k < 3; ++k)
+			{
+				unsigned int v = mesh.indices[t * 3 + k];
+				for (unsigned int i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; ++i)
+					open += assigned[adjacency.triangles[i]] ? 0 : 1;
+			}
+
+			if (open < fewestOpen)
+			{
+				fewestOpen = open;
+				seed = t;
+			}
+		}
+
+		meshlets->meshlets.push_back(meshlet);
+	}
+
+	// Bounds four meshlets to a block, with the lanes past the last left unable to cull by cone
+	size_t meshletCount = meshlets->meshlets.size();
+	MeshletBoundsBlock empty = {};
+	empty.cutoff = XMFLOAT4A(1.0f, 1.0f, 1.0f, 1.0f);
+	meshlets->bounds.assign((meshletCount + 3) / 4, empty);
+
+	for (size_t i = 0; i < meshletCount; ++i)
+		ComputeBounds(mesh, *meshlets, meshlets->meshlets[i], meshlets->bounds[i / 4], (unsigned int)(i % 4));
+}
+
+void Geometry::ComputeMeshletCullView(FXMMATRIX world, CXMMATRIX view, CXMMATRIX projection, MeshletCullView* cullView)
+{
+	// A point is inside when its clip space position has -w <= x <= w, -w <= y <= w and
+	// 0 <= z <= w, and each of those is a plane in the columns of the whole transform
+	XMMATRIX worldView = XMMatrixMultiply(world, view);
+	XMMATRIX columns = XMMatrixTranspose(XMMatrixMultiply(worldView, projection));
+
+	const XMVECTOR planes[6] =
+	{
+		XMVectorAdd(columns.r[3], columns.r[0]),
+		XMVectorSubtract(columns.r[3], columns.r[0]),
+		XMVectorAdd(columns.r[3], columns.r[1]),
+		XMVectorSubtract(columns.r[3], columns.r[1]),
+		columns.r[2],
+		XMVectorSubtract(columns.r[3], columns.r[2]),
+	};
+
+	for (int i = 0; i < 6; ++i)
+		XMStoreFloat4(&cullView->planes[i], XMPlaneNormalize(planes[i]));
+
+	// Where the view's origin lands back in the mesh's space
+	XMVECTOR determinant;
+	XMMATRIX viewToMesh = XMMatrixInverse(&determinant, worldView);
+	XMStoreFloat3(&cullView->eye, viewToMesh.r[3]);
+}
+
+unsigned int Geometry::CullMeshlets(const MeshletMesh& meshlets, const MeshletCullView& cullView, unsigned int* visible)
+{
+	XMVECTOR planeX[6], planeY[6], planeZ[6], planeW[6];
+	for (int i = 0; i < 6; ++i)
+	{
+		XMVECTOR plane = XMLoadFloat4(&cullView.planes[i]);
+		planeX[i] = XMVectorSplatX(plane);
+		planeY[i] = XMVectorSplatY(plane);
+		planeZ[i] = XMVectorSplatZ(plane);
+		planeW[i] = XMVectorSplatW(plane);
+	}
+
+	XMVECTOR eye = XMLoadFloat3(&cullView.eye);
+	XMVECTOR eyeX = XMVectorSplatX(eye);
+	XMVECTOR eyeY = XMVectorSplatY(eye);
+	XMVECTOR eyeZ = XMVectorSplatZ(eye);
+	XMVECTOR one = XMVectorSplatOne();
+
+	unsigned int meshletCount = (unsigned int)meshlets.meshlets.size();
+	unsigned int visibleCount = 0;
+
+	for (size_t b = 0; b < meshlets.bounds.size(); ++b)
+	{
+		const MeshletBoundsBlock& block = meshlets.bounds[b];
+		XMVECTOR centerX = XMLoadFloat4A(&block.centerX);
+		XMVECTOR centerY = XMLoadFloat4A(&block.centerY);
+		XMVECTOR centerZ = XMLoadFloat4A(&block.centerZ);
+		XMVECTOR radius = XMLoadFloat4A(&block.radius);
+
+		// Wholly behind any one plane
+		XMVECTOR negativeRadius = XMVectorNegate(radius);
+		XMVECTOR culled = XMVectorFalseInt();
+		for (int i = 0; i < 6; ++i)
+		{
+			XMVECTOR distance = XMVectorMultiplyAdd(centerX, planeX[i],
+				XMVectorMultiplyAdd(centerY, planeY[i], XMVectorMultiplyAdd(centerZ, planeZ[i], planeW[i])));
+			culled = XMVectorOrInt(culled, XMVectorLess(distance, negativeRadius));
+		}
+
+		// Every triangle faces away when the direction to any point of the sphere is within
+		// 90 degrees less the cone's half angle of its axis, which holds for the whole sphere
+		// once the direction to the center clears cutoff * |v| + radius * (1 + cutoff).
+		XMVECTOR toCenterX = XMVectorSubtract(centerX, eyeX);
+		XMVECTOR toCenterY = XMVectorSubtract(centerY, eyeY);
+		XMVECTOR toCenterZ = XMVectorSubtract(centerZ, eyeZ);
+		XMVECTOR cutoff = XMLoadFloat4A(&block.cutoff);
+
+		XMVECTOR along = XMVectorMultiplyAdd(toCenterX, XMLoadFloat4A(&block.axisX),
+			XMVectorMultiplyAdd(toCenterY, XMLoadFloat4A(&block.axisY), XMVectorMultiply(toCenterZ, XMLoadFloat4A(&block.axisZ))));
+		XMVECTOR distance = XMVectorSqrt(XMVectorMultiplyAdd(toCenterX, toCenterX,
+			XMVectorMultiplyAdd(toCenterY, toCenterY, XMVectorMultiply(toCenterZ, toCenterZ))));
+		XMVECTOR limit = XMVectorMultiplyAdd(cutoff, distance, XMVectorMultiply(radius, XMVectorAdd(one, cutoff)));
+		culled = XMVectorOrInt(culled, XMVectorGreater(along, limit));
+
+		if (XMComparisonAllTrue(XMVector4EqualIntR(culled, XMVectorTrueInt())))
+			continue;
+
+		uint32_t lanes[4];
+		XMStoreInt4(lanes, culled);
+
+		unsigned int first = (unsigned int)b * 4;
+		for (unsigned int lane = 0; lane < 4 && first + lane < meshletCount; ++lane)
+		{
+			if (lanes[lane] == 0)
+				visible[visibleCount++] = first + lane;
+		}
+	}
+
+	return visibleCount;
+}
+
+unsigned int Geometry::CompactMeshlets(const MeshletMesh& meshlets, const unsigned int* visible, unsigned int visibleCount, unsigned int* indices)
+{
+	unsigned int indexCount = 0;
+	for (unsigned int i = 0; i < visibleCount; ++i)
+	{
+		const Meshlet& meshlet = meshlets.meshlets[visible[i]];
+		memcpy(indices + indexCount, &meshlets.indices[meshlet.indexOffset], meshlet.triangleCount * 3 * sizeof(unsigned int));
+		indexCount += meshlet.triangleCount * 3;
+	}
+
+	return indexCount;
+}
\ No newline at end of file
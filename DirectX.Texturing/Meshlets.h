@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include <DirectXMath.h>
+#include <vector>
+
+namespace Geometry
+{
+	// Small enough for a mesh shader's output, and for a cluster to be mostly flat
+	const unsigned int c_MeshletMaxVertices = 64;
+	const unsigned int c_MeshletMaxTriangles = 124;
+
+	struct Meshlet
+	{
+		unsigned int indexOffset; // into the meshlet mesh's indices
+		unsigned int triangleCount;
+		unsigned int vertexCount; // different vertices its triangles use
+	};
+
+	// Bounds of four meshlets, a component of each to a vector, so culling tests four at once
+	// straight from memory. Past the last meshlet the lanes are zero, with a cutoff of 1.
+	struct MeshletBoundsBlock
+	{
+		// Sphere around every vertex
+		DirectX::XMFLOAT4A centerX;
+		DirectX::XMFLOAT4A centerY;
+		DirectX::XMFLOAT4A centerZ;
+		DirectX::XMFLOAT4A radius;
+
+		// Every triangle's normal is within the cone around axis. The cutoff is the sine of the
+		// cone's half angle, or 1 if the triangles face too many ways to ever cull.
+		DirectX::XMFLOAT4A axisX;
+		DirectX::XMFLOAT4A axisY;
+		DirectX::XMFLOAT4A axisZ;
+		DirectX::XMFLOAT4A cutoff;
+	};
+
+	struct MeshletMesh
+	{
+		// The mesh's triangles reordered so each meshlet's are together; the vertices are the mesh's own
+		std::vector<unsigned int> indices;
+		std::vector<Meshlet> meshlets;
+		std::vector<MeshletBoundsBlock> bounds; // meshlet i is lane i % 4 of block i / 4
+	};
+
+	// Grows each meshlet from a triangle through its neighbors, taking the one that adds the
+	// fewest vertices and, of those, faces most like the meshlet so far and is nearest its
+	// middle, so it stays flat and round. Out of neighbors, it carries on from the nearest
+	// triangle left that fits. A meshlet ends when it is full, and the next starts beside it.
+	void BuildMeshlets(const MeshData& mesh, MeshletMesh* meshlets);
+
+	// Frustum planes, facing in, and the eye, in the mesh's own space
+	struct MeshletCullView
+	{
+		DirectX::XMFLOAT4 planes[6];
+		DirectX::XMFLOAT3 eye;
+	};
+
+	void ComputeMeshletCullView(DirectX::FXMMATRIX world, DirectX::CXMMATRIX view, DirectX::CXMMATRIX projection, MeshletCullView* cullView);
+
+	// Writes the meshlets that could have a triangle on screen to visible, in order, and
+	// returns how many. A meshlet is culled when its sphere is wholly outside a frustum plane,
+	// or when its cone says every triangle faces away from the eye.
+	unsigned int CullMeshlets(const MeshletMesh& meshlets, const MeshletCullView& cullView, unsigned int* visible);
+
+	// Copies the indices of the visible meshlets one after another, for a single draw, and
+	// returns how many. indices needs room for all of the mesh's.
+	unsigned int CompactMeshlets(const MeshletMesh& meshlets, const unsigned int* visible, unsigned int visibleCount, unsigned int* indices);
+}
\ No newline at end of file
@@ -0,0 +1,576 @@
+//--------------------------------------------------------------------------------------
+// File: MipGenerator.cpp
+//
+// CPU mip chain generation for 8-bit RGBA surfaces
+//
+// Each destination row is made in two passes: the source rows under the vertical filter
+// are converted to linear floats and summed into one row, which is then filtered
+// horizontally. Both filters are precomputed as lists of taps, so odd sizes, clamping and
+// wrapping all come down to which source pixels a tap points at. A pixel is one 4-wide
+// vector, so the passes are the same multiply-adds whatever the channel order.
+//--------------------------------------------------------------------------------------
+
+#include "MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MIP_GENERATOR_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    // Levels with fewer rows than this per thread are not worth splitting
+    const size_t MinRowsPerThread = 32;
+
+    // The Kaiser filter reaches this many destination pixels either side of the centre
+    const float KaiserWidth = 3.0f;
+    const float KaiserAlpha = 4.0f;
+
+    //----------------------------------------------------------------------------------
+    // Pixel helpers
+    //----------------------------------------------------------------------------------
+#ifdef MIP_GENERATOR_SSE
+    typedef __m128 Pixel;
+
+    inline Pixel PixelZero() noexcept { return _mm_setzero_ps(); }
+    inline Pixel PixelSet(float r, float g, float b, float a) noexcept { return _mm_setr_ps(r, g, b, a); }
+    inline Pixel PixelLoad(const float* source) noexcept { return _mm_loadu_ps(source); }
+    inline void PixelStore(float* dest, Pixel value) noexcept { _mm_storeu_ps(dest, value); }
+
+    inline Pixel PixelMultiplyAdd(Pixel value, float weight, Pixel sum) noexcept
+    {
+        return _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(weight)));
+    }
+
+    // Clamps to [0, 1], then scales and rounds each channel
+    inline void PixelQuantize(Pixel value, Pixel scale, int32_t result[4]) noexcept
+    {
+        value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm_cvtps_epi32(_mm_mul_ps(value, scale)));
+    }
+#else
+    struct Pixel
+    {
+        float v[4];
+    };
+
+    inline Pixel PixelZero() noexcept { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+    inline Pixel PixelSet(float r, float g, float b, float a) noexcept { return { { r, g, b, a } }; }
+
+    inline Pixel PixelLoad(const float* source) noexcept
+    {
+        Pixel result;
+        memcpy(result.v, source, sizeof(result.v));
+        return result;
+    }
+
+    inline void PixelStore(float* dest, Pixel value) noexcept
+    {
+        memcpy(dest, value.v, sizeof(value.v));
+    }
+
+    inline Pixel PixelMultiplyAdd(Pixel value, float weight, Pixel sum) noexcept
+    {
+        for (size_t i = 0; i < 4; i++)
+            sum.v[i] += value.v[i] * weight;
+        return sum;
+    }
+
+    // Rounds halves to even like the SSE conversion, so both paths give the same bytes
+    inline void PixelQuantize(Pixel value, Pixel scale, int32_t result[4]) noexcept
+    {
+        for (size_t i = 0; i < 4; i++)
+            result[i] = int32_t(std::nearbyint(std::min(std::max(value.v[i], 0.0f), 1.0f) * scale.v[i]));
+    }
+#endif
+
+    //----------------------------------------------------------------------------------
+    // Colour conversion tables, built on first use
+    //----------------------------------------------------------------------------------
+    const size_t LinearSteps = 65536;
+
+    struct ColorTables
+    {
+        float unorm[256];
+        float srgbToLinear[256];
+
+        // Indexed by linear value * (LinearSteps - 1); fine enough to round the steep dark end
+        // of the curve the same way as the exact formula
+        uint8_t linearToSRGB[LinearSteps];
+
+        ColorTables() noexcept
+        {
+            for (size_t i = 0; i < 256; i++)
+            {
+                float value = float(i) / 255.0f;
+                unorm[i] = value;
+                srgbToLinear[i] = (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+            }
+
+            for (size_t i = 0; i < LinearSteps; i++)
+            {
+                float value = float(i) / float(LinearSteps - 1);
+                float srgb = (value <= 0.0031308f) ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+                linearToSRGB[i] = uint8_t(std::min(255.0f, srgb * 255.0f + 0.5f));
+            }
+        }
+    };
+
+    const ColorTables& GetColorTables() noexcept
+    {
+        static const ColorTables s_Tables;
+        return s_Tables;
+    }
+
+    bool IsSRGB(DXGI_FORMAT format) noexcept
+    {
+        return format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+            || format == DXGI_FORMAT_B8G8R8A8_UNORM_SRGB
+            || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB;
+    }
+
+    //----------------------------------------------------------------------------------
+    // Filter taps
+    //----------------------------------------------------------------------------------
+    struct FilterTaps
+    {
+        std::vector<size_t> first; // destination pixel x uses taps first[x] to first[x + 1]
+        std::vector<size_t> index;
+        std::vector<float> weight;
+    };
+
+    // Zeroth order modified Bessel function of the first kind, for the Kaiser window
+    float BesselI0(float x) noexcept
+    {
+        float sum = 1.0f;
+        float term = 1.0f;
+        float halfX = x * 0.5f;
+        for (int k = 1; k < 32; k++)
+        {
+            term *= (halfX / float(k)) * (halfX / float(k));
+            sum += term;
+            if (term < sum * 1e-7f)
+                break;
+        }
+        return sum;
+    }
+
+    // x is in destination pixels from the centre of the destination pixel
+    float KaiserKernel(float x) noexcept
+    {
+        if (std::fabs(x) >= KaiserWidth)
+            return 0.0f;
+
+        float t = x / KaiserWidth;
+        float window = BesselI0(KaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(KaiserAlpha);
+
+        const float pi = 3.14159265358979f;
+        float sinc = (x == 0.0f) ? 1.0f : std::sin(pi * x) / (pi * x);
+        return sinc * window;
+    }
+
+    size_t AddressPixel(ptrdiff_t index, size_t size, bool wrap) noexcept
+    {
+        ptrdiff_t count = ptrdiff_t(size);
+        if (wrap)
+            return size_t(((index % count) + count) % count);
+
+        return size_t(std::min(std::max<ptrdiff_t>(index, 0), count - 1));
+    }
+
+    void BuildTaps(size_t sourceSize, size_t destSize, MIP_FILTER filter, bool wrap, FilterTaps& taps)
+    {
+        taps.first.clear();
+        taps.index.clear();
+        taps.weight.clear();
+
+        double scale = double(sourceSize) / double(destSize);
+        for (size_t x = 0; x < destSize; x++)
+        {
+            size_t first = taps.index.size();
+            taps.first.push_back(first);
+
+            double low = 0.0;
+            double high = 0.0;
+            double centre = (double(x) + 0.5) * scale;
+            if (filter == MIP_FILTER_BOX)
+            {
+                low = double(x) * scale;
+                high = double(x + 1) * scale;
+            }
+            else
+            {
+                low = centre - KaiserWidth * scale;
+                high = centre + KaiserWidth * scale;
+            }
+
+            float total = 0.0f;
+            for (ptrdiff_t i = ptrdiff_t(std::floor(low)); i < ptrdiff_t(std::ceil(high)); i++)
+            {
+                float weight;
+                if (filter == MIP_FILTER_BOX)
+                {
+                    // How much of source pixel i the destination pixel covers
+                    weight = float(std::min(high, double(i + 1)) - std::max(low, double(i)));
+                }
+                else
+                {
+                    weight = KaiserKernel(float((double(i) + 0.5 - centre) / scale));
+                }
+
+                if (weight == 0.0f)
+                    continue;
+
+                taps.index.push_back(AddressPixel(i, sourceSize, wrap));
+                taps.weight.push_back(weight);
+                total += weight;
+            }
+
+            for (size_t i = first; i < taps.weight.size(); i++)
+            {
+                taps.weight[i] /= total;
+            }
+        }
+
+        taps.first.push_back(taps.index.size());
+    }
+
+    //----------------------------------------------------------------------------------
+    // Level generation
+    //----------------------------------------------------------------------------------
+    struct LevelJob
+    {
+        const uint8_t* source;
+        size_t sourceWidth;
+        size_t sourcePitch;
+        uint8_t* dest;
+        size_t destWidth;
+        const FilterTaps* tapsX;
+        const FilterTaps* tapsY;
+        bool srgb;
+    };
+
+    // row is scratch space for sourceWidth linear pixels
+    void FilterRows(const LevelJob& job, float* row, size_t firstRow, size_t lastRow) noexcept
+    {
+        const ColorTables& tables = GetColorTables();
+        const float* decode = job.srgb ? tables.srgbToLinear : tables.unorm;
+
+        // sRGB colour is quantized finely and looked up; alpha is always linear
+        Pixel scale = job.srgb
+            ? PixelSet(float(LinearSteps - 1), float(LinearSteps - 1), float(LinearSteps - 1), 255.0f)
+            : PixelSet(255.0f, 255.0f, 255.0f, 255.0f);
+
+        const FilterTaps& tapsX = *job.tapsX;
+        const FilterTaps& tapsY = *job.tapsY;
+
+        for (size_t y = firstRow; y < lastRow; y++)
+        {
+            // Vertical pass, a source row at a time so the reads stay sequential
+            memset(row, 0, job.sourceWidth * 4 * sizeof(float));
+            for (size_t tap = tapsY.first[y]; tap < tapsY.first[y + 1]; tap++)
+            {
+                const uint8_t* source = job.source + tapsY.index[tap] * job.sourcePitch;
+                float weight = tapsY.weight[tap];
+
+                for (size_t x = 0; x < job.sourceWidth; x++, source += 4)
+                {
+                    Pixel value = PixelSet(decode[source[0]], decode[source[1]], decode[source[2]], tables.unorm[source[3]]);
+                    PixelStore(row + x * 4, PixelMultiplyAdd(value, weight, PixelLoad(row + x * 4)));
+                }
+            }
+
+            // Horizontal pass
+            uint8_t* dest = job.dest + y * job.destWidth * 4;
+            for (size_t x = 0; x < job.destWidth; x++, dest += 4)
+            {
+                Pixel sum = PixelZero();
+                for (size_t tap = tapsX.first[x]; tap < tapsX.first[x + 1]; tap++)
+                {
+                    sum = PixelMultiplyAdd(PixelLoad(row + tapsX.index[tap] * 4), tapsX.weight[tap], sum);
+                }
+
+                int32_t value[4];
+                PixelQuantize(sum, scale, value);
+                if (job.srgb)
+                {
+                    dest[0] = tables.linearToSRGB[value[0]];
+                    dest[1] = tables.linearToSRGB[value[1]];
+                    dest[2] = tables.linearToSRGB[value[2]];
+                }
+                else
+                {
+                    dest[0] = uint8_t(value[0]);
+                    dest[1] = uint8_t(value[1]);
+                    dest[2] = uint8_t(value[2]);
+                }
+                dest[3] = uint8_t(value[3]);
+            }
+        }
+    }
+
+    HRESULT GenerateLevel(const LevelJob& job, size_t destHeight, unsigned int threadCount, std::vector<float>& scratch) noexcept
+    {
+        size_t chunks = std::max<size_t>(1, std::min<size_t>(threadCount, destHeight / MinRowsPerThread));
+        size_t rowsPerChunk = (destHeight + chunks - 1) / chunks;
+        size_t rowFloats = job.sourceWidth * 4;
+
+        try
+        {
+            scratch.resize(chunks * rowFloats);
+        }
+        catch (...)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        // The calling thread takes the first chunk; if a thread can't be started its chunk is
+        // filtered here as well
+        std::vector<std::thread> workers;
+        for (size_t chunk = 1; chunk < chunks; chunk++)
+        {
+            size_t firstRow = chunk * rowsPerChunk;
+            size_t lastRow = std::min(destHeight, firstRow + rowsPerChunk);
+            if (firstRow >= lastRow)
+                break;
+
+            float* row = scratch.data() + chunk * rowFloats;
+            try
+            {
+                workers.emplace_back(FilterRows, std::cref(job), row, firstRow, lastRow);
+            }
+            catch (...)
+            {
+                FilterRows(job, row, firstRow, lastRow);
+            }
+        }
+
+        FilterRows(job, scratch.data(), 0, std::min(destHeight, rowsPerChunk));
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+
+        return S_OK;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+bool DirectX::IsMipGeneratable(DXGI_FORMAT format) noexcept
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8A8_UNORM:
+    case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+    case DXGI_FORMAT_B8G8R8X8_UNORM:
+    case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t DirectX::CountMips(size_t width, size_t height) noexcept
+{
+    size_t count = 1;
+    while (width > 1 || height > 1)
+    {
+        width = std::max<size_t>(width / 2, 1);
+        height = std::max<size_t>(height / 2, 1);
+        count++;
+    }
+    return count;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t DirectX::GetMipChainSize(size_t width, size_t height, size_t mipCount) noexcept
+{
+    size_t size = 0;
+    for (size_t mip = 1; mip < mipCount; mip++)
+    {
+        width = std::max<size_t>(width / 2, 1);
+        height = std::max<size_t>(height / 2, 1);
+        size += width * height * 4;
+    }
+    return size;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GenerateMipChain(
+    DXGI_FORMAT format,
+    size_t width,
+    size_t height,
+    const uint8_t* image,
+    size_t rowPitch,
+    size_t mipCount,
+    MIP_FILTER filter,
+    unsigned int flags,
+    uint8_t* mips,
+    size_t mipsSize,
+    unsigned int threadCount) noexcept
+{
+    if (!IsMipGeneratable(format) || !image || width == 0 || height == 0 || rowPitch < width * 4)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (filter != MIP_FILTER_BOX && filter != MIP_FILTER_KAISER)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (mipCount == 0 || mipCount > CountMips(width, height) || mipsSize < GetMipChainSize(width, height, mipCount))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (mipCount > 1 && !mips)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    FilterTaps tapsX;
+    FilterTaps tapsY;
+    std::vector<float> scratch;
+
+    LevelJob job = {};
+    job.source = image;
+    job.sourceWidth = width;
+    job.sourcePitch = rowPitch;
+    job.dest = mips;
+    job.tapsX = &tapsX;
+    job.tapsY = &tapsY;
+    job.srgb = (flags & MIP_FLAGS_SRGB) || IsSRGB(format);
+
+    size_t sourceHeight = height;
+    for (size_t mip = 1; mip < mipCount; mip++)
+    {
+        job.destWidth = std::max<size_t>(job.sourceWidth / 2, 1);
+        size_t destHeight = std::max<size_t>(sourceHeight / 2, 1);
+
+        try
+        {
+            BuildTaps(job.sourceWidth, job.destWidth, filter, (flags & MIP_FLAGS_WRAP_U) != 0, tapsX);
+            BuildTaps(sourceHeight, destHeight, filter, (flags & MIP_FLAGS_WRAP_V) != 0, tapsY);
+        }
+        catch (...)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        HRESULT hr = GenerateLevel(job, destHeight, threadCount, scratch);
+        if (FAILED(hr))
+            return hr;
+
+        // Each mip is filtered from the one just written
+        job.source = job.dest;
+        job.sourceWidth = job.destWidth;
+        job.sourcePitch = job.destWidth * 4;
+        job.dest += job.destWidth * destHeight * 4;
+        sourceHeight = destHeight;
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t DirectX::GetLoadedMipCount(size_t width, size_t height, size_t mipCount, DXGI_FORMAT format) noexcept
+{
+    if (mipCount != 1 || !IsMipGeneratable(format))
+    {
+        return mipCount;
+    }
+
+    return CountMips(width, height);
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GenerateMissingMips(
+    DXGI_FORMAT format,
+    size_t width,
+    size_t height,
+    size_t mipCount,
+    size_t arraySize,
+    const uint8_t* bitData,
+    size_t bitSize,
+    std::unique_ptr<uint8_t[]>& mipData,
+    size_t& mipDataSize,
+    size_t& loadedMipCount) noexcept
+{
+    mipData.reset();
+    mipDataSize = 0;
+    loadedMipCount = GetLoadedMipCount(width, height, mipCount, format);
+
+    if (loadedMipCount == mipCount)
+    {
+        return S_FALSE;
+    }
+
+    // Every format that can be generated is 4 bytes a pixel
+    const size_t rowBytes = width * 4;
+    const size_t numBytes = rowBytes * height;
+    if (!bitData || numBytes * arraySize > bitSize)
+    {
+        return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+    }
+
+    const size_t chainBytes = GetMipChainSize(width, height, loadedMipCount);
+    const size_t itemBytes = numBytes + chainBytes;
+
+    std::unique_ptr<uint8_t[]> data(new (std::nothrow) uint8_t[itemBytes * arraySize]);
+    if (!data)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    for (size_t item = 0; item < arraySize; item++)
+    {
+        const uint8_t* pSrcBits = bitData + item * numBytes;
+        uint8_t* pDestBits = data.get() + item * itemBytes;
+        memcpy(pDestBits, pSrcBits, numBytes);
+
+        HRESULT hr = GenerateMipChain(format, width, height, pSrcBits, rowBytes,
+            loadedMipCount, MIP_FILTER_BOX, MIP_FLAGS_NONE,
+            pDestBits + numBytes, chainBytes);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    mipData = std::move(data);
+    mipDataSize = itemBytes * arraySize;
+    return S_OK;
+}
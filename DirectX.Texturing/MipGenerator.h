@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------------------------
+// File: MipGenerator.h
+//
+// CPU mip chain generation for 8-bit RGBA surfaces, for DDS files saved without mips and
+// for the texture cooker. Filtering is done in linear light for sRGB formats, can wrap
+// around the edges of tiling textures, uses SSE where available and splits large levels
+// across threads by row.
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <dxgiformat.h>
+#else
+#include <wsl/winadapter.h>
+#include <directx/dxgiformat.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace DirectX
+{
+    enum MIP_FILTER
+    {
+        MIP_FILTER_BOX    = 0, // averages the source pixels each destination pixel covers
+        MIP_FILTER_KAISER = 1, // Kaiser-windowed sinc; sharper, at the cost of 12 taps per axis
+    };
+
+    enum MIP_FLAGS : unsigned int
+    {
+        MIP_FLAGS_NONE   = 0x0,
+        MIP_FLAGS_SRGB   = 0x1, // filter in linear light even if the format isn't _SRGB
+        MIP_FLAGS_WRAP_U = 0x2, // sample across the left and right edges instead of clamping
+        MIP_FLAGS_WRAP_V = 0x4,
+        MIP_FLAGS_WRAP   = MIP_FLAGS_WRAP_U | MIP_FLAGS_WRAP_V,
+    };
+
+    // RGBA8 and BGRA8/BGRX8, UNORM and SRGB
+    bool IsMipGeneratable(_In_ DXGI_FORMAT format) noexcept;
+
+    // Length of the full chain down to 1x1, including the top level
+    size_t CountMips(_In_ size_t width, _In_ size_t height) noexcept;
+
+    // Bytes needed for mips 1 to mipCount - 1, tightly packed one after another
+    size_t GetMipChainSize(_In_ size_t width, _In_ size_t height, _In_ size_t mipCount) noexcept;
+
+    // Generates mips 1 to mipCount - 1 from the top level in image. Each mip is made from the
+    // one above it and written to mips with rows of width * 4 bytes, which is how a DDS file
+    // lays them out. threadCount 0 uses every hardware thread.
+    HRESULT GenerateMipChain(
+        _In_ DXGI_FORMAT format,
+        _In_ size_t width,
+        _In_ size_t height,
+        _In_ const uint8_t* image,
+        _In_ size_t rowPitch,
+        _In_ size_t mipCount,
+        _In_ MIP_FILTER filter,
+        _In_ unsigned int flags,
+        _Out_writes_bytes_(mipsSize) uint8_t* mips,
+        _In_ size_t mipsSize,
+        _In_ unsigned int threadCount = 0) noexcept;
+
+    // Mips a 2D texture saved with mipCount of them has once the DDS loaders are done with it:
+    // one saved without any, in a format GenerateMipChain takes, gets its full chain
+    size_t GetLoadedMipCount(
+        _In_ size_t width,
+        _In_ size_t height,
+        _In_ size_t mipCount,
+        _In_ DXGI_FORMAT format) noexcept;
+
+    // Builds that chain for each of arraySize items of a 2D texture in bitData, with clamped
+    // box filtering, since the loaders don't know how it will be addressed. mipData receives
+    // each item's top level followed by its new mips, the layout of a file saved with them.
+    // Returns S_FALSE, leaving mipData empty, for a texture GetLoadedMipCount leaves alone.
+    HRESULT GenerateMissingMips(
+        _In_ DXGI_FORMAT format,
+        _In_ size_t width,
+        _In_ size_t height,
+        _In_ size_t mipCount,
+        _In_ size_t arraySize,
+        _In_reads_bytes_(bitSize) const uint8_t* bitData,
+        _In_ size_t bitSize,
+        _Out_ std::unique_ptr<uint8_t[]>& mipData,
+        _Out_ size_t& mipDataSize,
+        _Out_ size_t& loadedMipCount) noexcept;
+}
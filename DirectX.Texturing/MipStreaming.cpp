@@ -0,0 +1,176 @@
+//--------------------------------------------------------------------------------------
+// File: MipStreaming.cpp
+//
+// The mip streaming schedule of TextureLoader, worked out apart from the resources
+//--------------------------------------------------------------------------------------
+
+#include "MipStreaming.h"
+#include "DXGIFormatTraits.h"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+bool DirectX::CanBeBaseMip(const StreamedMip* mips, size_t mip, DXGI_FORMAT format) noexcept
+{
+    if (mip == 0 || !IsCompressed(format))
+    {
+        return true;
+    }
+
+    return mips[mip].width % 4 == 0 && mips[mip].height % 4 == 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t DirectX::GetMipTailStart(const StreamedMip* mips, size_t mipCount, DXGI_FORMAT format, size_t maxBytes) noexcept
+{
+    if (mipCount == 0)
+    {
+        return 0;
+    }
+
+    // The smallest mips sit together at the end of the file, so the tail is one contiguous read
+    size_t first = mipCount - 1;
+    size_t tailBytes = mips[first].size;
+    while (first > 0 && (tailBytes + mips[first - 1].size <= maxBytes || !CanBeBaseMip(mips, first, format)))
+    {
+        first--;
+        tailBytes += mips[first].size;
+    }
+
+    return first;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::PlanMipStreaming(
+    const StreamedTexture* textures,
+    size_t count,
+    size_t budget,
+    uint64_t frame,
+    size_t* residentBytes,
+    MipStreamingStep* shrinks,
+    size_t* shrinkCount,
+    MipStreamingStep* reads,
+    size_t* readCount) noexcept
+{
+    if (shrinkCount)
+    {
+        *shrinkCount = 0;
+    }
+    if (readCount)
+    {
+        *readCount = 0;
+    }
+
+    if (!residentBytes || !shrinkCount || !readCount)
+    {
+        return E_POINTER;
+    }
+
+    if (count == 0)
+    {
+        return S_OK;
+    }
+
+    if (!textures || !shrinks || !reads)
+    {
+        return E_INVALIDARG;
+    }
+
+    // Least recently used first; ties keep the order they were given in, so a run is repeatable
+    std::unique_ptr<size_t[]> order(new (std::nothrow) size_t[count]);
+    std::unique_ptr<size_t[]> baseMips(new (std::nothrow) size_t[count]);
+    if (!order || !baseMips)
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        order[i] = i;
+        baseMips[i] = textures[i].baseMip;
+    }
+
+    std::stable_sort(order.get(), order.get() + count, [textures](size_t a, size_t b) { return textures[a].lastUsed < textures[b].lastUsed; });
+
+    size_t resident = *residentBytes;
+
+    // Drops mips off one texture until what is resident plus needed fits, or it can't shrink further
+    auto shrink = [&](size_t index, size_t needed)
+    {
+        const StreamedTexture& texture = textures[index];
+        while (resident + needed > budget && baseMips[index] + 1 < texture.mipCount && CanBeBaseMip(texture.mips, baseMips[index] + 1, texture.format))
+        {
+            resident -= texture.mips[baseMips[index]].size;
+            baseMips[index]++;
+        }
+    };
+
+    // Over the budget, each stale texture goes down as far as it can before a fresher one
+    // loses anything
+    for (size_t i = 0; i < count && budget != 0 && resident > budget; i++)
+    {
+        if (!textures[order[i]].locked)
+        {
+            shrink(order[i], 0);
+        }
+    }
+
+    // The next larger mip of everything drawn last frame, most recently used first. Room is
+    // made for it from textures that weren't drawn, stalest first, but never from ones that
+    // were; a mip that still doesn't fit waits. Textures that just shrank wait a frame too,
+    // so a mip is never dropped and read back at once.
+    for (size_t i = count; i-- > 0;)
+    {
+        const size_t index = order[i];
+        const StreamedTexture& texture = textures[index];
+        if (texture.locked || baseMips[index] != texture.baseMip || texture.baseMip == 0 || texture.lastUsed + 1 < frame)
+        {
+            continue;
+        }
+
+        const size_t size = texture.mips[texture.baseMip - 1].size;
+        for (size_t j = 0; j < count && budget != 0 && resident + size > budget; j++)
+        {
+            const StreamedTexture& stale = textures[order[j]];
+            if (stale.lastUsed + 1 >= frame)
+            {
+                break;
+            }
+
+            if (!stale.locked)
+            {
+                shrink(order[j], size);
+            }
+        }
+
+        if (budget != 0 && resident + size > budget)
+        {
+            continue;
+        }
+
+        reads[(*readCount)++] = { index, texture.baseMip - 1 };
+        resident += size;
+    }
+
+    // Each texture that shrank is recreated once, at the mip it ended up on
+    for (size_t i = 0; i < count; i++)
+    {
+        if (baseMips[order[i]] != textures[order[i]].baseMip)
+        {
+            shrinks[(*shrinkCount)++] = { order[i], baseMips[order[i]] };
+        }
+    }
+
+    *residentBytes = resident;
+    return S_OK;
+}
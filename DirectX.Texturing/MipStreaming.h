@@ -0,0 +1,90 @@
+//--------------------------------------------------------------------------------------
+// File: MipStreaming.h
+//
+// The schedule TextureLoader streams mips by: which of a texture's mips are read with
+// its header, which are dropped when the textures go over the budget, and which are read
+// back in once a texture is drawn again. The loader applies the plan to its Direct3D
+// resources; the plan itself needs none, so a run of frames can be simulated anywhere.
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <dxgiformat.h>
+#else
+#include <wsl/winadapter.h>
+#include <directx/dxgiformat.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    // One mip of a streamed texture; mips are listed largest first
+    struct StreamedMip
+    {
+        size_t size;
+        size_t width;
+        size_t height;
+    };
+
+    // A streamed texture that has been created, as the schedule sees it
+    struct StreamedTexture
+    {
+        const StreamedMip* mips;
+        size_t mipCount;
+        DXGI_FORMAT format;
+        size_t baseMip;         // most detailed resident mip
+        uint64_t lastUsed;      // frame it was last drawn in
+        bool locked;            // a read is in flight or has failed, so its size can't change
+    };
+
+    // A texture to recreate with a new base mip, or the next larger mip to read for it
+    struct MipStreamingStep
+    {
+        size_t texture;         // index into the textures planned for
+        size_t mip;
+    };
+
+    // Whether a texture can be created with mip as its top level. Block compressed
+    // textures need it to be a whole number of blocks; any other texture can start anywhere.
+    bool CanBeBaseMip(
+        _In_reads_(mip + 1) const StreamedMip* mips,
+        _In_ size_t mip,
+        _In_ DXGI_FORMAT format) noexcept;
+
+    // First mip of the tail read along with the header: the smallest mips that fit in
+    // maxBytes together, grown past that if needed to start on a mip CanBeBaseMip allows
+    size_t GetMipTailStart(
+        _In_reads_(mipCount) const StreamedMip* mips,
+        _In_ size_t mipCount,
+        _In_ DXGI_FORMAT format,
+        _In_ size_t maxBytes) noexcept;
+
+    // One frame of residency. residentBytes is what every texture holds, ones that aren't
+    // streamed included; a budget of 0 means no limit.
+    //
+    // While over the budget, the least recently used texture loses a mip at a time until
+    // it can't shrink further, then the next one does. Then each texture drawn in the last
+    // frame gets its next larger mip read, most recently used first. Room is made for it by
+    // shrinking textures that weren't drawn, stalest first; if that isn't enough, it waits.
+    //
+    // shrinks gets the new base mip of each texture that shrank, stalest first, and reads
+    // the mips to read. Both arrays must hold count steps. residentBytes comes back with the
+    // shrinking done and the reads reserved, so a frame can never queue more than the budget.
+    HRESULT PlanMipStreaming(
+        _In_reads_(count) const StreamedTexture* textures,
+        _In_ size_t count,
+        _In_ size_t budget,
+        _In_ uint64_t frame,
+        _Inout_ size_t* residentBytes,
+        _Out_writes_(count) MipStreamingStep* shrinks,
+        _Out_ size_t* shrinkCount,
+        _Out_writes_(count) MipStreamingStep* reads,
+        _Out_ size_t* readCount) noexcept;
+}
@@ -1,6 +1,8 @@
 #include "Pillar.h"
 #include "GeometryGenerator.h"
-#include "DDSTextureLoader.h"
+#include "MeshCompactor.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
 #include "ShaderData.h"
 
 Pillar::Pillar(Renderer* renderer) : m_Renderer(renderer)
@@ -8,31 +10,36 @@ Pillar::Pillar(Renderer* renderer) : m_Renderer(renderer)
     m_Material.mDiffuse = DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
 }
 
-bool Pillar::Load()
+bool Pillar::Load(TextureArrayBuilder* textureArrays)
 {
     Geometry::CreateCylinder(0.5f, 0.5f, 4.0f, 8, 8, &m_MeshData);
+    Geometry::OptimizeMesh(&m_MeshData);
+
+    // Coarser versions share the vertex buffer and follow the full one in the index buffer
+    Geometry::BuildLodChain(m_MeshData, 4, 0.25f, &m_Lods);
+    Geometry::CompactMesh(m_Lods.mesh, &m_CompactMesh);
 
     // Create vertex buffer
     D3D11_BUFFER_DESC vbd = {};
     vbd.Usage = D3D11_USAGE_DEFAULT;
-    vbd.ByteWidth = (UINT)(sizeof(Vertex) * m_MeshData.vertices.size());
+    vbd.ByteWidth = (UINT)(sizeof(Geometry::PackedVertex) * m_CompactMesh.vertices.size());
     vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vbd.CPUAccessFlags = 0;
 
     D3D11_SUBRESOURCE_DATA vInitData = {};
-    vInitData.pSysMem = &m_MeshData.vertices[0];
+    vInitData.pSysMem = &m_CompactMesh.vertices[0];
 
     DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateBuffer(&vbd, &vInitData, &m_VertexBuffer));
 
     // Create index buffer
     D3D11_BUFFER_DESC ibd = {};
     ibd.Usage = D3D11_USAGE_DEFAULT;
-    ibd.ByteWidth = (UINT)(sizeof(UINT) * m_MeshData.indices.size());
+    ibd.ByteWidth = (UINT)m_CompactMesh.indices.size();
     ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
     ibd.CPUAccessFlags = 0;
 
     D3D11_SUBRESOURCE_DATA iInitData = {};
-    iInitData.pSysMem = &m_MeshData.indices[0];
+    iInitData.pSysMem = &m_CompactMesh.indices[0];
 
     DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateBuffer(&ibd, &iInitData, &m_IndexBuffer));
 
@@ -44,10 +51,8 @@ bool Pillar::Load()
     bd.CPUAccessFlags = 0;
     DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateBuffer(&bd, nullptr, &m_ConstantBuffer));
 
-    // Load texture
-    ID3D11Resource* resource = nullptr;
-    DX::ThrowIfFailed(DirectX::CreateDDSTextureFromFile(m_Renderer->GetDevice(), L"Textures\\rock_diffuse.dds", &resource, &m_DiffuseTexture));
-    resource->Release();
+    // Reserve a slice for the texture, the builder packs it into an array once every object is loaded
+    m_DiffuseTexture = textureArrays->Add(L"Textures\\rock_diffuse.dds");
 
     return true;
 }
@@ -55,13 +60,13 @@ bool Pillar::Load()
 void Pillar::Render(Camera* camera)
 {
     // Bind the vertex buffer
-    UINT stride = sizeof(Vertex);
+    UINT stride = sizeof(Geometry::PackedVertex);
     UINT offset = 0;
 
     m_Renderer->GetDeviceContext()->IASetVertexBuffers(0, 1, &m_VertexBuffer, &stride, &offset);
 
     // Bind the index buffer
-    m_Renderer->GetDeviceContext()->IASetIndexBuffer(m_IndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    m_Renderer->GetDeviceContext()->IASetIndexBuffer(m_IndexBuffer, m_CompactMesh.indexSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
 
     // Set topology
     m_Renderer->GetDeviceContext()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -71,19 +76,25 @@ void Pillar::Render(Camera* camera)
     DirectX::XMMATRIX world = DirectX::XMMatrixTranslation(Position.x, Position.y, Position.z);
     DirectX::XMMATRIX textureTransform = DirectX::XMMatrixIdentity();
 
+    // The coarsest LOD whose error stays under a pixel at the nearest point of the pillar
+    DirectX::XMVECTOR center = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&m_Lods.center), world * camera->GetView());
+    float distance = DirectX::XMVectorGetZ(center) - m_Lods.radius;
+    const Geometry::MeshLod& lod = m_Lods.lods[Geometry::SelectLod(m_Lods, camera->GetProjection(), (float)camera->GetHeight(), distance)];
+
     ConstantBuffer cb;
-    cb.mWorld = DirectX::XMMatrixTranspose(world);
+    cb.mWorld = DirectX::XMMatrixTranspose(Geometry::GetDequantizeTransform(m_CompactMesh) * world);
     cb.mView = DirectX::XMMatrixTranspose(camera->GetView());
     cb.mProjection = DirectX::XMMatrixTranspose(camera->GetProjection());
     cb.mTextureTransform = DirectX::XMMatrixTranspose(textureTransform);
+    m_Material.mTextureSlice = (float)m_DiffuseTexture->index;
     cb.mMaterial = m_Material;
 
     m_Renderer->GetDeviceContext()->VSSetConstantBuffers(0, 1, &m_ConstantBuffer);
     m_Renderer->GetDeviceContext()->PSSetConstantBuffers(0, 1, &m_ConstantBuffer);
     m_Renderer->GetDeviceContext()->UpdateSubresource(m_ConstantBuffer, 0, nullptr, &cb, 0, 0);
 
-    m_Renderer->GetDeviceContext()->PSSetShaderResources(0, 1, &m_DiffuseTexture);
+    m_Renderer->SetDiffuseTexture(m_DiffuseTexture->array->GetView());
 
     // Render geometry
-    m_Renderer->GetDeviceContext()->DrawIndexed((UINT)m_MeshData.indices.size(), 0, 0);
+    m_Renderer->GetDeviceContext()->DrawIndexed(lod.indexCount, lod.indexOffset, 0);
 }
@@ -3,14 +3,17 @@
 #include "Renderer.h"
 #include "Camera.h"
 #include "Mesh.h"
+#include "MeshCompactor.h"
+#include "MeshSimplifier.h"
 #include "ShaderData.h"
+#include "TextureArrayBuilder.h"
 
 class Pillar
 {
 public:
 	Pillar(Renderer* renderer);
 
-	bool Load();
+	bool Load(TextureArrayBuilder* textureArrays);
 	void Render(Camera* camera);
 
 	DirectX::XMFLOAT3 Position;
@@ -19,6 +22,8 @@ private:
 	Renderer* m_Renderer = nullptr;
 
 	MeshData m_MeshData;
+	Geometry::MeshLodChain m_Lods;
+	Geometry::CompactMeshData m_CompactMesh;
 	Material m_Material;
 
 	ID3D11Buffer* m_VertexBuffer = nullptr;
@@ -26,5 +31,5 @@ private:
 
 	ID3D11Buffer* m_ConstantBuffer = nullptr;
 
-	ID3D11ShaderResourceView* m_DiffuseTexture = nullptr;
+	std::shared_ptr<TextureArraySlice> m_DiffuseTexture;
 };
\ No newline at end of file
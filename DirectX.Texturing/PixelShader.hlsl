@@ -2,7 +2,7 @@
 
 float4 main(PixelInput input) : SV_TARGET
 {
-	float4 diffuse_texture = TextureDiffuse.Sample(SamplerAnisotropic, input.Texture);
+	float4 diffuse_texture = TextureDiffuse.Sample(SamplerAnisotropic, float3(input.Texture, mMaterial.mTextureSlice));
 
 	float4 finalColour = diffuse_texture * mMaterial.mDiffuse;
 	finalColour.a = mMaterial.mDiffuse.a;
@@ -67,6 +67,8 @@ void Renderer::Clear()
 {
 	m_DeviceContext->ClearRenderTargetView(m_RenderTargetView, reinterpret_cast<const float*>(&DirectX::Colors::SteelBlue));
 	m_DeviceContext->ClearDepthStencilView(m_DepthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+	m_DiffuseTexture = nullptr;
 }
 
 void Renderer::Render()
@@ -281,3 +283,12 @@ void Renderer::CreateLinearFilter()
 
 	DX::ThrowIfFailed(m_Device->CreateSamplerState(&samplerDesc, &m_AnisotropicSampler));
 }
+
+void Renderer::SetDiffuseTexture(ID3D11ShaderResourceView* view)
+{
+	if (view == m_DiffuseTexture)
+		return;
+
+	m_DeviceContext->PSSetShaderResources(0, 1, &view);
+	m_DiffuseTexture = view;
+}
@@ -26,6 +26,10 @@ public:
 	void SetAnisotropicFilter();
 	void SetLinearFilter();
 
+	// Binds the view to pixel shader slot t0 unless it is already there. Objects that share a
+	// texture array only cost one bind between them; Clear forgets the binding each frame.
+	void SetDiffuseTexture(ID3D11ShaderResourceView* view);
+
 private:
 	SDL_Window* m_SdlWindow = nullptr;
 
@@ -38,6 +42,8 @@ private:
 	ID3D11RenderTargetView* m_RenderTargetView = nullptr;
 	ID3D11DepthStencilView* m_DepthStencilView = nullptr;
 
+	ID3D11ShaderResourceView* m_DiffuseTexture = nullptr;
+
 	void CreateDevice();
 	void CreateSwapChain(int width, int height);
 
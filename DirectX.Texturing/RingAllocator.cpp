@@ -0,0 +1,133 @@
+//--------------------------------------------------------------------------------------
+// File: RingAllocator.cpp
+//
+// Offset bookkeeping for a fence-recycled staging ring
+//
+// The live region runs from the tail to the head, possibly wrapping past the end. The
+// used byte count tells a full ring from an empty one when the two meet.
+//--------------------------------------------------------------------------------------
+
+#include "RingAllocator.h"
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT RingAllocator::Initialize(size_t size) noexcept
+{
+    if (size == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    *this = RingAllocator();
+    m_Size = size;
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT RingAllocator::Allocate(size_t size, size_t alignment, size_t* offset) noexcept
+{
+    if (!offset)
+    {
+        return E_POINTER;
+    }
+
+    *offset = 0;
+
+    if (size == 0 || size > m_Size || alignment == 0 || (alignment & (alignment - 1)))
+    {
+        return E_INVALIDARG;
+    }
+
+    // Nothing live, so the next allocation may as well start from the beginning
+    if (m_Used == 0)
+    {
+        m_Head = 0;
+        m_Tail = 0;
+    }
+    else if (m_Head == m_Tail)
+    {
+        return S_FALSE;
+    }
+
+    size_t aligned = (m_Head + alignment - 1) & ~(alignment - 1);
+    size_t start = 0;
+    if (m_Head >= m_Tail)
+    {
+        // Free space is after the head and before the tail; try the end first
+        if (aligned <= m_Size && size <= m_Size - aligned)
+        {
+            start = aligned;
+        }
+        else if (size <= m_Tail)
+        {
+            start = 0;
+        }
+        else
+        {
+            return S_FALSE;
+        }
+    }
+    else if (aligned <= m_Tail && size <= m_Tail - aligned)
+    {
+        start = aligned;
+    }
+    else
+    {
+        return S_FALSE;
+    }
+
+    // Padding and any skipped tail are held by this frame along with the allocation
+    size_t taken = (start >= m_Head) ? start + size - m_Head : (m_Size - m_Head) + size;
+
+    m_Head = start + size;
+    m_Used += taken;
+    m_FrameUsed += taken;
+
+    *offset = start;
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void RingAllocator::FinishFrame(uint64_t fence) noexcept
+{
+    if (m_FrameUsed == 0)
+        return;
+
+    if (m_FrameCount == RING_ALLOCATOR_MAX_FRAMES)
+    {
+        Frame& newest = m_Frames[(m_FirstFrame + m_FrameCount - 1) % RING_ALLOCATOR_MAX_FRAMES];
+        newest.fence = fence;
+        newest.end = m_Head;
+        newest.used += m_FrameUsed;
+    }
+    else
+    {
+        m_Frames[(m_FirstFrame + m_FrameCount) % RING_ALLOCATOR_MAX_FRAMES] = { fence, m_Head, m_FrameUsed };
+        m_FrameCount++;
+    }
+
+    m_FrameUsed = 0;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void RingAllocator::Retire(uint64_t completedFence) noexcept
+{
+    while (m_FrameCount > 0 && m_Frames[m_FirstFrame].fence <= completedFence)
+    {
+        const Frame& frame = m_Frames[m_FirstFrame];
+        m_Tail = frame.end;
+        m_Used -= frame.used;
+
+        m_FirstFrame = (m_FirstFrame + 1) % RING_ALLOCATOR_MAX_FRAMES;
+        m_FrameCount--;
+    }
+}
@@ -0,0 +1,73 @@
+//--------------------------------------------------------------------------------------
+// File: RingAllocator.h
+//
+// Offset bookkeeping for a staging ring: allocations are carved from the head, and the
+// space behind them is handed back a frame at a time, once the fence that frame was
+// submitted with has completed. The ring never owns memory, so the same logic serves a
+// GPU buffer or a CPU array and can be run without a device.
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <wsl/winadapter.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    // Frames waiting on their fence; past this the newest one absorbs the next, which only
+    // holds its space a little longer
+    constexpr size_t RING_ALLOCATOR_MAX_FRAMES = 64;
+
+    class RingAllocator
+    {
+    public:
+        RingAllocator() noexcept = default;
+
+        // Size in bytes of the memory being managed
+        HRESULT Initialize(_In_ size_t size) noexcept;
+
+        // Offset of size bytes aligned to alignment, a power of two. An allocation never wraps
+        // around the end; the tail it skips is held until the frame is retired. S_FALSE, with
+        // no offset, if there isn't room until more frames retire.
+        HRESULT Allocate(_In_ size_t size, _In_ size_t alignment, _Out_ size_t* offset) noexcept;
+
+        // Closes the frame: everything allocated since the last call is freed once fence has
+        // completed. Fences must increase from one frame to the next.
+        void FinishFrame(_In_ uint64_t fence) noexcept;
+
+        // Frees the frames whose fence is at or below completedFence, oldest first
+        void Retire(_In_ uint64_t completedFence) noexcept;
+
+        size_t GetSize() const noexcept { return m_Size; }
+
+        // Bytes allocated and not yet retired, alignment padding and skipped tails included
+        size_t GetUsed() const noexcept { return m_Used; }
+
+    private:
+        struct Frame
+        {
+            uint64_t fence;
+            size_t end;   // head when the frame was finished
+            size_t used;  // bytes the frame holds
+        };
+
+        size_t m_Size = 0;
+        size_t m_Head = 0;
+        size_t m_Tail = 0;
+        size_t m_Used = 0;
+        size_t m_FrameUsed = 0;
+
+        Frame m_Frames[RING_ALLOCATOR_MAX_FRAMES] = {};
+        size_t m_FirstFrame = 0;
+        size_t m_FrameCount = 0;
+    };
+}
@@ -1,14 +1,15 @@
 #include "Shader.h"
 #include <SDL_messagebox.h>
+#include <cstddef>
 #include <fstream>
 
 Shader::Shader(Renderer* renderer) : m_Renderer(renderer)
 {
 }
 
-bool Shader::Create()
+bool Shader::Create(Geometry::VertexFormat format)
 {
-	if (!CreateVertexShader("VertexShader.cso"))
+	if (!CreateVertexShader("VertexShader.cso", format))
 		return false;
 
 	if (!CreatePixelShader("PixelShader.cso"))
@@ -24,7 +25,7 @@ void Shader::Use()
 	m_Renderer->GetDeviceContext()->PSSetShader(m_PixelShader, nullptr, 0);
 }
 
-bool Shader::CreateVertexShader(const std::string& vertex_shader_path)
+bool Shader::CreateVertexShader(const std::string& vertex_shader_path, Geometry::VertexFormat format)
 {
 	std::ifstream vertexFile(vertex_shader_path, std::fstream::in | std::fstream::binary);
 	if (!vertexFile.is_open())
@@ -48,6 +49,15 @@ bool Shader::CreateVertexShader(const std::string& vertex_shader_path)
 		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
 	};
 
+	// Packed positions come in as 0 to 1 across the mesh's bounds, and each mesh puts the
+	// dequantize in front of its world matrix, so the shader is the same for both
+	if (format == Geometry::VertexFormat::Packed)
+	{
+		layout[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+		layout[1].Format = DXGI_FORMAT_R16G16_FLOAT;
+		layout[1].AlignedByteOffset = offsetof(Geometry::PackedVertex, texture);
+	}
+
 	UINT numElements = ARRAYSIZE(layout);
 	m_Renderer->GetDevice()->CreateInputLayout(layout, numElements, vertexbuffer, vertexsize, &m_VertexLayout);
 
@@ -1,13 +1,15 @@
 #pragma once
 
 #include "Renderer.h"
+#include "MeshCompactor.h"
 
 class Shader
 {
 public:
 	Shader(Renderer* renderer);
 
-	bool Create();
+	// The input layout is made for the vertex format every mesh is drawn with
+	bool Create(Geometry::VertexFormat format = Geometry::VertexFormat::Float);
 	void Use();
 
 private:
@@ -17,6 +19,6 @@ private:
 	ID3D11VertexShader* m_VertexShader = nullptr;
 	ID3D11PixelShader* m_PixelShader = nullptr;
 
-	bool CreateVertexShader(const std::string& vertex_shader_path);
+	bool CreateVertexShader(const std::string& vertex_shader_path, Geometry::VertexFormat format);
 	bool CreatePixelShader(const std::string& pixel_shader_path);
 };
\ No newline at end of file
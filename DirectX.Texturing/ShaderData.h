@@ -7,6 +7,9 @@ __declspec(align(16)) struct Material
     DirectX::XMFLOAT4 mDiffuse;
     DirectX::XMFLOAT4 mAmbient;
     DirectX::XMFLOAT4 mSpecular;
+
+    // Slice of the bound diffuse array; a float because that is what Texture2DArray.Sample takes
+    float mTextureSlice;
 };
 
 _declspec(align(16)) struct ConstantBuffer
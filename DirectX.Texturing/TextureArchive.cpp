@@ -0,0 +1,375 @@
+//--------------------------------------------------------------------------------------
+// File: TextureArchive.cpp
+//
+// Reader for packed texture archives
+//--------------------------------------------------------------------------------------
+
+#include "TextureArchive.h"
+
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+    const uint64_t FnvOffsetBasis = 14695981039346656037ull;
+    const uint64_t FnvPrime = 1099511628211ull;
+
+    // Appends one code point as UTF-8; false if it doesn't fit in size bytes plus a null
+    bool AppendUTF8(uint32_t codePoint, char* dest, size_t& length, size_t size) noexcept
+    {
+        char bytes[4];
+        size_t count;
+        if (codePoint < 0x80)
+        {
+            bytes[0] = char(codePoint);
+            count = 1;
+        }
+        else if (codePoint < 0x800)
+        {
+            bytes[0] = char(0xc0 | (codePoint >> 6));
+            bytes[1] = char(0x80 | (codePoint & 0x3f));
+            count = 2;
+        }
+        else if (codePoint < 0x10000)
+        {
+            bytes[0] = char(0xe0 | (codePoint >> 12));
+            bytes[1] = char(0x80 | ((codePoint >> 6) & 0x3f));
+            bytes[2] = char(0x80 | (codePoint & 0x3f));
+            count = 3;
+        }
+        else
+        {
+            bytes[0] = char(0xf0 | (codePoint >> 18));
+            bytes[1] = char(0x80 | ((codePoint >> 12) & 0x3f));
+            bytes[2] = char(0x80 | ((codePoint >> 6) & 0x3f));
+            bytes[3] = char(0x80 | (codePoint & 0x3f));
+            count = 4;
+        }
+
+        if (length + count >= size)
+            return false;
+
+        memcpy(dest + length, bytes, count);
+        length += count;
+        return true;
+    }
+
+    // UTF-16 on Windows, UTF-32 elsewhere. Returns the length, 0 if it doesn't fit.
+    size_t WideToUTF8(const wchar_t* name, char* dest, size_t size) noexcept
+    {
+        size_t length = 0;
+        for (const wchar_t* c = name; *c; c++)
+        {
+            uint32_t codePoint = uint32_t(*c);
+            if (sizeof(wchar_t) == 2 && codePoint >= 0xd800 && codePoint < 0xdc00 && c[1] >= 0xdc00 && c[1] < 0xe000)
+            {
+                codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (uint32_t(c[1]) - 0xdc00);
+                c++;
+            }
+
+            if (!AppendUTF8(codePoint, dest, length, size))
+                return 0;
+        }
+
+        dest[length] = 0;
+        return length;
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+uint64_t DirectX::TextureArchiveChecksum(const void* data, size_t size) noexcept
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+
+    uint64_t hash = FnvOffsetBasis;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FnvPrime;
+    }
+    return hash;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t DirectX::NormalizeTextureArchiveName(const char* name, char* normalized) noexcept
+{
+    if (!name || !normalized)
+        return 0;
+
+    // Leading "./" would make the same file match under two names
+    while (name[0] == '.' && (name[1] == '/' || name[1] == '\\'))
+        name += 2;
+
+    size_t length = 0;
+    for (; name[length]; length++)
+    {
+        if (length + 1 >= TEXTURE_ARCHIVE_MAX_NAME)
+            return 0;
+
+        char c = name[length];
+        if (c == '\\')
+            c = '/';
+        else if (c >= 'A' && c <= 'Z')
+            c = char(c - 'A' + 'a');
+
+        normalized[length] = c;
+    }
+
+    normalized[length] = 0;
+    return length;
+}
+
+_Use_decl_annotations_
+size_t DirectX::NormalizeTextureArchiveName(const wchar_t* name, char* normalized) noexcept
+{
+    if (!name || !normalized)
+        return 0;
+
+    char utf8[TEXTURE_ARCHIVE_MAX_NAME];
+    if (!WideToUTF8(name, utf8, sizeof(utf8)))
+        return 0;
+
+    return NormalizeTextureArchiveName(utf8, normalized);
+}
+
+
+//--------------------------------------------------------------------------------------
+TextureArchive::~TextureArchive()
+{
+    Close();
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT TextureArchive::Open(const wchar_t* fileName) noexcept
+{
+    Close();
+
+    if (!fileName)
+    {
+        return E_INVALIDARG;
+    }
+
+#ifdef _WIN32
+    HANDLE hFile = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(hFile, &fileSize))
+    {
+        HRESULT hr = HRESULT_FROM_WIN32(GetLastError());
+        CloseHandle(hFile);
+        return hr;
+    }
+
+    if (uint64_t(fileSize.QuadPart) > SIZE_MAX || uint64_t(fileSize.QuadPart) < sizeof(TEXTURE_ARCHIVE_HEADER))
+    {
+        CloseHandle(hFile);
+        return E_FAIL;
+    }
+
+    // The view keeps the mapping object alive, so both handles can be closed right away
+    HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(hFile);
+    if (!hMapping)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_Data = static_cast<const uint8_t*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(hMapping);
+    if (!m_Data)
+    {
+        return HRESULT_FROM_WIN32(GetLastError());
+    }
+
+    m_Size = size_t(fileSize.QuadPart);
+#else
+    char path[4096];
+    if (!WideToUTF8(fileName, path, sizeof(path)))
+    {
+        return E_INVALIDARG;
+    }
+
+    int file = open(path, O_RDONLY);
+    if (file < 0)
+    {
+        return E_FAIL;
+    }
+
+    struct stat fileInfo = {};
+    if (fstat(file, &fileInfo) != 0 || size_t(fileInfo.st_size) < sizeof(TEXTURE_ARCHIVE_HEADER))
+    {
+        close(file);
+        return E_FAIL;
+    }
+
+    void* view = mmap(nullptr, size_t(fileInfo.st_size), PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+    if (view == MAP_FAILED)
+    {
+        return E_FAIL;
+    }
+
+    m_Data = static_cast<const uint8_t*>(view);
+    m_Size = size_t(fileInfo.st_size);
+#endif
+
+    HRESULT hr = ValidateIndex();
+    if (FAILED(hr))
+    {
+        Close();
+        return hr;
+    }
+
+    auto header = reinterpret_cast<const TEXTURE_ARCHIVE_HEADER*>(m_Data);
+    m_Entries = reinterpret_cast<const TEXTURE_ARCHIVE_ENTRY*>(m_Data + sizeof(TEXTURE_ARCHIVE_HEADER));
+    m_EntryCount = header->entryCount;
+    m_Names = reinterpret_cast<const char*>(m_Entries + m_EntryCount);
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+void TextureArchive::Close() noexcept
+{
+    if (m_Data)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_Data);
+#else
+        munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+    }
+
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Entries = nullptr;
+    m_EntryCount = 0;
+    m_Names = nullptr;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Only the index is touched here; payloads are checked by Verify when they are used
+//--------------------------------------------------------------------------------------
+HRESULT TextureArchive::ValidateIndex() const noexcept
+{
+    auto header = reinterpret_cast<const TEXTURE_ARCHIVE_HEADER*>(m_Data);
+    if (header->magic != TEXTURE_ARCHIVE_MAGIC || header->version != TEXTURE_ARCHIVE_VERSION)
+    {
+        return E_FAIL;
+    }
+
+    uint64_t indexSize = uint64_t(header->entryCount) * sizeof(TEXTURE_ARCHIVE_ENTRY) + header->nameTableSize;
+    if (sizeof(TEXTURE_ARCHIVE_HEADER) + indexSize > m_Size)
+    {
+        return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+    }
+
+    const uint8_t* index = m_Data + sizeof(TEXTURE_ARCHIVE_HEADER);
+    if (TextureArchiveChecksum(index, size_t(indexSize)) != header->indexChecksum)
+    {
+        return E_FAIL;
+    }
+
+    auto entries = reinterpret_cast<const TEXTURE_ARCHIVE_ENTRY*>(index);
+    auto names = reinterpret_cast<const char*>(entries + header->entryCount);
+
+    for (size_t i = 0; i < header->entryCount; i++)
+    {
+        const TEXTURE_ARCHIVE_ENTRY& entry = entries[i];
+
+        // Each name must be terminated inside the table, and the entries sorted and unique
+        if (uint64_t(entry.nameOffset) + entry.nameLength >= header->nameTableSize
+            || entry.nameLength == 0
+            || entry.nameLength >= TEXTURE_ARCHIVE_MAX_NAME
+            || names[entry.nameOffset + entry.nameLength] != 0)
+        {
+            return E_FAIL;
+        }
+
+        if (i > 0 && strcmp(names + entries[i - 1].nameOffset, names + entry.nameOffset) >= 0)
+        {
+            return E_FAIL;
+        }
+
+        if (entry.offset % TEXTURE_ARCHIVE_ALIGNMENT != 0 || entry.offset > m_Size || entry.size > m_Size - entry.offset)
+        {
+            return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+        }
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+const TEXTURE_ARCHIVE_ENTRY* TextureArchive::FindNormalized(const char* name) const noexcept
+{
+    size_t low = 0;
+    size_t high = m_EntryCount;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        int order = strcmp(m_Names + m_Entries[middle].nameOffset, name);
+        if (order == 0)
+            return &m_Entries[middle];
+
+        if (order < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return nullptr;
+}
+
+_Use_decl_annotations_
+const TEXTURE_ARCHIVE_ENTRY* TextureArchive::Find(const char* name) const noexcept
+{
+    char normalized[TEXTURE_ARCHIVE_MAX_NAME];
+    if (!IsOpen() || !NormalizeTextureArchiveName(name, normalized))
+        return nullptr;
+
+    return FindNormalized(normalized);
+}
+
+_Use_decl_annotations_
+const TEXTURE_ARCHIVE_ENTRY* TextureArchive::Find(const wchar_t* name) const noexcept
+{
+    char normalized[TEXTURE_ARCHIVE_MAX_NAME];
+    if (!IsOpen() || !NormalizeTextureArchiveName(name, normalized))
+        return nullptr;
+
+    return FindNormalized(normalized);
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+bool TextureArchive::Verify(const TEXTURE_ARCHIVE_ENTRY& entry) const noexcept
+{
+    if (!IsOpen())
+        return false;
+
+    return TextureArchiveChecksum(GetData(entry), size_t(entry.size)) == entry.checksum;
+}
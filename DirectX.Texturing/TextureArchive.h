@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------------------
+// File: TextureArchive.h
+//
+// Packed archive of DDS files, written by the texture packer and mapped whole at runtime,
+// so loading every texture costs one open instead of one per file.
+//
+// Layout, little-endian:
+//   TEXTURE_ARCHIVE_HEADER
+//   TEXTURE_ARCHIVE_ENTRY[entryCount], sorted by name
+//   Name table: each entry's name, null terminated
+//   Payloads, each starting on a TEXTURE_ARCHIVE_ALIGNMENT boundary
+//
+// Names are stored normalized (ASCII lower case, '/' separators) so that lookups match
+// paths written either way.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <wsl/winadapter.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    const uint32_t TEXTURE_ARCHIVE_MAGIC = 0x52415854; // "TXAR"
+    const uint32_t TEXTURE_ARCHIVE_VERSION = 1;
+
+    // Payload alignment; matches the page size, so each payload maps from its own pages
+    const uint64_t TEXTURE_ARCHIVE_ALIGNMENT = 4096;
+
+    // Longest name, including its null
+    const size_t TEXTURE_ARCHIVE_MAX_NAME = 260;
+
+    struct TEXTURE_ARCHIVE_HEADER
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t nameTableSize;
+        uint64_t indexChecksum; // of the entries and name table
+    };
+
+    struct TEXTURE_ARCHIVE_ENTRY
+    {
+        uint32_t nameOffset; // into the name table
+        uint32_t nameLength; // without the null
+        uint64_t offset;     // from the start of the archive
+        uint64_t size;
+        uint64_t checksum;   // of the payload
+    };
+
+    static_assert(sizeof(TEXTURE_ARCHIVE_HEADER) == 24, "TEXTURE_ARCHIVE_HEADER size mismatch");
+    static_assert(sizeof(TEXTURE_ARCHIVE_ENTRY) == 32, "TEXTURE_ARCHIVE_ENTRY size mismatch");
+
+    // 64-bit FNV-1a
+    uint64_t TextureArchiveChecksum(
+        _In_reads_bytes_(size) const void* data,
+        _In_ size_t size) noexcept;
+
+    // Writes the stored form of a name. Wide names are converted to UTF-8. Returns the length,
+    // or 0 if the name is empty or doesn't fit in TEXTURE_ARCHIVE_MAX_NAME.
+    size_t NormalizeTextureArchiveName(
+        _In_z_ const char* name,
+        _Out_writes_(TEXTURE_ARCHIVE_MAX_NAME) char* normalized) noexcept;
+
+    size_t NormalizeTextureArchiveName(
+        _In_z_ const wchar_t* name,
+        _Out_writes_(TEXTURE_ARCHIVE_MAX_NAME) char* normalized) noexcept;
+
+    // Read-only view of an archive. The whole file is mapped and the index validated when it
+    // is opened; payload pages are only read in when they are touched. Lookups don't modify
+    // the archive, so any thread can make them while it stays open.
+    class TextureArchive
+    {
+    public:
+        TextureArchive() noexcept = default;
+        ~TextureArchive();
+
+        TextureArchive(const TextureArchive&) = delete;
+        TextureArchive& operator=(const TextureArchive&) = delete;
+
+        HRESULT Open(_In_z_ const wchar_t* fileName) noexcept;
+        void Close() noexcept;
+
+        bool IsOpen() const noexcept { return m_Data != nullptr; }
+
+        size_t GetEntryCount() const noexcept { return m_EntryCount; }
+        const TEXTURE_ARCHIVE_ENTRY& GetEntry(_In_ size_t index) const noexcept { return m_Entries[index]; }
+        const char* GetName(_In_ const TEXTURE_ARCHIVE_ENTRY& entry) const noexcept { return m_Names + entry.nameOffset; }
+
+        // Binary search of the index, nullptr if the name isn't in the archive
+        const TEXTURE_ARCHIVE_ENTRY* Find(_In_z_ const char* name) const noexcept;
+        const TEXTURE_ARCHIVE_ENTRY* Find(_In_z_ const wchar_t* name) const noexcept;
+
+        // Points into the mapping, valid until the archive is closed
+        const uint8_t* GetData(_In_ const TEXTURE_ARCHIVE_ENTRY& entry) const noexcept { return m_Data + entry.offset; }
+
+        // Checks the payload against its checksum, which also faults all of its pages in
+        bool Verify(_In_ const TEXTURE_ARCHIVE_ENTRY& entry) const noexcept;
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+        const TEXTURE_ARCHIVE_ENTRY* m_Entries = nullptr;
+        size_t m_EntryCount = 0;
+        const char* m_Names = nullptr;
+
+        const TEXTURE_ARCHIVE_ENTRY* FindNormalized(_In_z_ const char* name) const noexcept;
+        HRESULT ValidateIndex() const noexcept;
+    };
+}
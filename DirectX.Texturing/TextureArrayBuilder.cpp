@@ -0,0 +1,59 @@
+#include "TextureArrayBuilder.h"
+#include "TextureArrayPacker.h"
+
+TextureArrayBuilder::TextureArrayBuilder(TextureLoader* textureLoader) : m_TextureLoader(textureLoader)
+{
+}
+
+std::shared_ptr<TextureArraySlice> TextureArrayBuilder::Add(const std::wstring& path)
+{
+	std::wstring canonical = TextureCache::CanonicalPath(path);
+	for (size_t i = 0; i < m_Paths.size(); i++)
+	{
+		if (TextureCache::CanonicalPath(m_Paths[i]) == canonical)
+			return m_Slices[i];
+	}
+
+	m_Paths.push_back(path);
+	m_Slices.push_back(std::make_shared<TextureArraySlice>());
+	return m_Slices.back();
+}
+
+bool TextureArrayBuilder::Build()
+{
+	std::vector<DirectX::TextureArraySource> sources(m_Paths.size());
+	for (size_t i = 0; i < m_Paths.size(); i++)
+	{
+		DirectX::DDSTextureDesc desc = {};
+		if (!m_TextureLoader->GetDesc(m_Paths[i], desc))
+			return false;
+
+		if (desc.resDim != D3D11_RESOURCE_DIMENSION_TEXTURE2D || desc.arraySize != 1 || desc.isCubeMap)
+			return false;
+
+		sources[i] = { desc.width, desc.height, desc.mipCount, desc.format };
+	}
+
+	std::vector<DirectX::TextureArraySlot> slots(m_Paths.size());
+	size_t arrayCount = 0;
+	if (FAILED(DirectX::PackTextureArrays(sources.data(), sources.size(), DirectX::TEXTURE_ARRAY_MAX_SLICES, slots.data(), &arrayCount)))
+		return false;
+
+	// Slices are numbered in the order they were added, so each array's paths come out in slice order
+	std::vector<std::vector<std::wstring>> arrayPaths(arrayCount);
+	for (size_t i = 0; i < m_Paths.size(); i++)
+		arrayPaths[slots[i].array].push_back(m_Paths[i]);
+
+	// A texture that shares with nothing is streamed and cached like any other, only viewed as an array
+	m_Arrays.clear();
+	for (auto& paths : arrayPaths)
+		m_Arrays.push_back(paths.size() > 1 ? m_TextureLoader->LoadArray(paths) : m_TextureLoader->StreamSlice(paths[0]));
+
+	for (size_t i = 0; i < m_Paths.size(); i++)
+	{
+		m_Slices[i]->array = m_Arrays[slots[i].array];
+		m_Slices[i]->index = (unsigned int)slots[i].slice;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "TextureLoader.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+// Where a texture ended up once the arrays are built: the array to bind and the slice to sample
+struct TextureArraySlice
+{
+	std::shared_ptr<Texture> array;
+	unsigned int index = 0;
+};
+
+// Packs the textures objects ask for into Texture2DArrays, so objects drawn one after another
+// can keep the same view bound and pick their texture with a slice index instead. Textures
+// share an array when their size, mip count and format all match. The rest are streamed on their
+// own, as one slice arrays, so they keep the loader's mip streaming and cache.
+class TextureArrayBuilder
+{
+public:
+	TextureArrayBuilder(TextureLoader* textureLoader);
+
+	// The slice is filled in by Build. Adding a file twice returns the same slice.
+	std::shared_ptr<TextureArraySlice> Add(const std::wstring& path);
+
+	// Reads the headers, groups the textures and queues the arrays on the loader. Returns false
+	// if a header can't be read or isn't a plain 2D texture.
+	bool Build();
+
+	size_t GetArrayCount() const { return m_Arrays.size(); }
+
+private:
+	TextureLoader* m_TextureLoader = nullptr;
+
+	std::vector<std::wstring> m_Paths;
+	std::vector<std::shared_ptr<TextureArraySlice>> m_Slices;
+	std::vector<std::shared_ptr<Texture>> m_Arrays;
+};
\ No newline at end of file
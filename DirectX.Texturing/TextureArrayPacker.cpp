@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------------------
+// File: TextureArrayPacker.cpp
+//
+// Groups textures that can share one Texture2DArray
+//
+// Scenes hold tens of textures, not thousands, so each source is matched against the
+// ones before it instead of being hashed; that needs no allocation and keeps the result
+// independent of anything but the input order.
+//--------------------------------------------------------------------------------------
+
+#include "TextureArrayPacker.h"
+
+using namespace DirectX;
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+bool DirectX::IsTextureArrayCompatible(const TextureArraySource& a, const TextureArraySource& b) noexcept
+{
+    return a.width == b.width
+        && a.height == b.height
+        && a.mipCount == b.mipCount
+        && a.format == b.format;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::PackTextureArrays(
+    const TextureArraySource* sources,
+    size_t count,
+    size_t maxSlices,
+    TextureArraySlot* slots,
+    size_t* arrayCount) noexcept
+{
+    if (arrayCount)
+    {
+        *arrayCount = 0;
+    }
+
+    if ((count > 0 && (!sources || !slots)) || maxSlices == 0 || maxSlices > TEXTURE_ARRAY_MAX_SLICES)
+    {
+        return E_INVALIDARG;
+    }
+
+    size_t arrays = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const TextureArraySource& source = sources[i];
+        if (source.width == 0 || source.height == 0 || source.mipCount == 0 || source.format == DXGI_FORMAT_UNKNOWN)
+        {
+            return E_INVALIDARG;
+        }
+
+        // The latest match holds the newest array of this kind, the only one that can still have room
+        size_t match = i;
+        for (size_t j = i; j-- > 0; )
+        {
+            if (IsTextureArrayCompatible(sources[j], source))
+            {
+                match = j;
+                break;
+            }
+        }
+
+        if (match != i && slots[match].slice + 1 < maxSlices)
+        {
+            slots[i].array = slots[match].array;
+            slots[i].slice = slots[match].slice + 1;
+        }
+        else
+        {
+            slots[i].array = arrays++;
+            slots[i].slice = 0;
+        }
+    }
+
+    if (arrayCount)
+    {
+        *arrayCount = arrays;
+    }
+
+    return S_OK;
+}
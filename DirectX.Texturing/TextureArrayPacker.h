@@ -0,0 +1,56 @@
+//--------------------------------------------------------------------------------------
+// File: TextureArrayPacker.h
+//
+// Groups textures that can share one Texture2DArray and assigns each its slice. The
+// Direct3D side lives in the texture loader; the packing only looks at sizes and formats,
+// so it can be run and checked on the CPU.
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <dxgiformat.h>
+#else
+#include <wsl/winadapter.h>
+#include <directx/dxgiformat.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DirectX
+{
+    // Every slice of an array has the same size, mip count and format
+    struct TextureArraySource
+    {
+        size_t width;
+        size_t height;
+        size_t mipCount;
+        DXGI_FORMAT format;
+    };
+
+    struct TextureArraySlot
+    {
+        size_t array;
+        size_t slice;
+    };
+
+    // D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION
+    constexpr size_t TEXTURE_ARRAY_MAX_SLICES = 2048;
+
+    bool IsTextureArrayCompatible(_In_ const TextureArraySource& a, _In_ const TextureArraySource& b) noexcept;
+
+    // Gives every source a slot. Sources that match share an array, with slices in the order
+    // the sources are given; arrays are numbered by their first source, and a group is split
+    // once it reaches maxSlices. Sources that match nothing get an array of their own.
+    HRESULT PackTextureArrays(
+        _In_reads_(count) const TextureArraySource* sources,
+        _In_ size_t count,
+        _In_ size_t maxSlices,
+        _Out_writes_(count) TextureArraySlot* slots,
+        _Out_opt_ size_t* arrayCount) noexcept;
+}
@@ -0,0 +1,167 @@
+#include "TextureCache.h"
+#include "TextureLoader.h"
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+
+namespace
+{
+	const uint64_t FnvOffsetBasis = 14695981039346656037ull;
+	const uint64_t FnvPrime = 1099511628211ull;
+
+	uint64_t Fnv1a(uint64_t hash, const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FnvPrime;
+		}
+
+		return hash;
+	}
+
+	// Bytes of subresource i, in D3D11CalcSubresource order; volume mips hold depth slices
+	size_t SubresourceSize(const DirectX::DDSTextureData& data, size_t i)
+	{
+		size_t depth = std::max<size_t>(data.desc.depth >> (i % data.desc.mipCount), 1);
+		return data.initData[i].SysMemSlicePitch * depth;
+	}
+}
+
+std::shared_ptr<Texture> TextureCache::Find(const std::wstring& path)
+{
+	auto it = m_Paths.find(CanonicalPath(path));
+	if (it == m_Paths.end())
+	{
+		m_Misses++;
+		return nullptr;
+	}
+
+	m_Hits++;
+	return it->second;
+}
+
+void TextureCache::Add(const std::wstring& path, const std::shared_ptr<Texture>& texture)
+{
+	m_Paths[CanonicalPath(path)] = texture;
+}
+
+std::shared_ptr<Texture> TextureCache::FindContent(uint64_t hash)
+{
+	std::lock_guard<std::mutex> lock(m_ContentMutex);
+
+	auto it = m_Contents.find(hash);
+	if (it == m_Contents.end())
+		return nullptr;
+
+	auto texture = it->second.lock();
+	if (texture == nullptr)
+	{
+		m_Contents.erase(it);
+		return nullptr;
+	}
+
+	return texture;
+}
+
+void TextureCache::AddContent(uint64_t hash, const std::shared_ptr<Texture>& texture)
+{
+	std::lock_guard<std::mutex> lock(m_ContentMutex);
+	m_Contents[hash] = texture;
+}
+
+size_t TextureCache::Purge()
+{
+	size_t count = 0;
+	for (auto it = m_Paths.begin(); it != m_Paths.end();)
+	{
+		if (it->second.use_count() == 1)
+		{
+			it = m_Paths.erase(it);
+			count++;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_ContentMutex);
+	for (auto it = m_Contents.begin(); it != m_Contents.end();)
+	{
+		if (it->second.expired())
+			it = m_Contents.erase(it);
+		else
+			++it;
+	}
+
+	return count;
+}
+
+void TextureCache::Clear()
+{
+	m_Paths.clear();
+
+	std::lock_guard<std::mutex> lock(m_ContentMutex);
+	m_Contents.clear();
+}
+
+std::wstring TextureCache::CanonicalPath(const std::wstring& path)
+{
+	std::wstring canonical = path;
+
+	DWORD length = GetFullPathNameW(path.c_str(), 0, nullptr, nullptr);
+	if (length != 0)
+	{
+		canonical.resize(length);
+		length = GetFullPathNameW(path.c_str(), length, &canonical[0], nullptr);
+		canonical.resize(length);
+	}
+
+	// Windows paths are case insensitive, "water_diffuse.DDS" is the same file as "water_diffuse.dds"
+	std::replace(canonical.begin(), canonical.end(), L'/', L'\\');
+	std::transform(canonical.begin(), canonical.end(), canonical.begin(), [](wchar_t c) { return (wchar_t)std::towlower(c); });
+
+	return canonical;
+}
+
+uint64_t TextureCache::HashContent(const DirectX::DDSTextureData& data)
+{
+	const DirectX::DDSTextureDesc& desc = data.desc;
+
+	uint64_t hash = FnvOffsetBasis;
+	hash = Fnv1a(hash, &desc.resDim, sizeof(desc.resDim));
+	hash = Fnv1a(hash, &desc.width, sizeof(desc.width));
+	hash = Fnv1a(hash, &desc.height, sizeof(desc.height));
+	hash = Fnv1a(hash, &desc.depth, sizeof(desc.depth));
+	hash = Fnv1a(hash, &desc.mipCount, sizeof(desc.mipCount));
+	hash = Fnv1a(hash, &desc.arraySize, sizeof(desc.arraySize));
+	hash = Fnv1a(hash, &desc.format, sizeof(desc.format));
+	hash = Fnv1a(hash, &desc.isCubeMap, sizeof(desc.isCubeMap));
+
+	size_t count = desc.mipCount * desc.arraySize;
+	for (size_t i = 0; i < count; i++)
+		hash = Fnv1a(hash, data.initData[i].pSysMem, SubresourceSize(data, i));
+
+	return hash;
+}
+
+bool TextureCache::SameContent(const DirectX::DDSTextureData& a, const DirectX::DDSTextureData& b)
+{
+	const DirectX::DDSTextureDesc& descA = a.desc;
+	const DirectX::DDSTextureDesc& descB = b.desc;
+	if (descA.resDim != descB.resDim || descA.width != descB.width || descA.height != descB.height || descA.depth != descB.depth
+		|| descA.mipCount != descB.mipCount || descA.arraySize != descB.arraySize || descA.format != descB.format || descA.isCubeMap != descB.isCubeMap)
+		return false;
+
+	size_t count = descA.mipCount * descA.arraySize;
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t size = SubresourceSize(a, i);
+		if (size != SubresourceSize(b, i) || memcmp(a.initData[i].pSysMem, b.initData[i].pSysMem, size) != 0)
+			return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "DDSTextureLoader.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class Texture;
+
+// Shares textures between everything that asks for the same file. Entries are found by canonical
+// path first; whole-file loads are also matched by a hash of their contents, so a copy of a file
+// under another name still shares the first one's view. Paths are only used from the render
+// thread; contents are also looked up from the loader's workers, which confirm a match byte for
+// byte before sharing anything.
+class TextureCache
+{
+public:
+	// Counts a hit or a miss
+	std::shared_ptr<Texture> Find(const std::wstring& path);
+	void Add(const std::wstring& path, const std::shared_ptr<Texture>& texture);
+
+	// The texture created from contents with this hash, nullptr if none is alive. Only a
+	// candidate until SameContent says so.
+	std::shared_ptr<Texture> FindContent(uint64_t hash);
+	void AddContent(uint64_t hash, const std::shared_ptr<Texture>& texture);
+
+	// Counts a texture that shared another's view
+	void CountContentHit() { m_ContentHits++; }
+
+	// Drops the textures nothing outside the cache references any more and returns how many went
+	size_t Purge();
+	void Clear();
+
+	unsigned int GetHits() const { return m_Hits; }
+	unsigned int GetMisses() const { return m_Misses; }
+	unsigned int GetContentHits() const { return m_ContentHits; }
+	size_t GetCount() const { return m_Paths.size(); }
+
+	// Absolute, lower case path with backslashes
+	static std::wstring CanonicalPath(const std::wstring& path);
+
+	// FNV-1a over the description and every subresource, for loose files and archive entries alike
+	static uint64_t HashContent(const DirectX::DDSTextureData& data);
+
+	// Same description, and every subresource the same size with the same bytes
+	static bool SameContent(const DirectX::DDSTextureData& a, const DirectX::DDSTextureData& b);
+
+private:
+	std::unordered_map<std::wstring, std::shared_ptr<Texture>> m_Paths;
+
+	std::mutex m_ContentMutex;
+	std::unordered_map<uint64_t, std::weak_ptr<Texture>> m_Contents;
+
+	unsigned int m_Hits = 0;
+	unsigned int m_Misses = 0;
+	unsigned int m_ContentHits = 0;
+};
\ No newline at end of file
@@ -0,0 +1,748 @@
+#include "TextureLoader.h"
+#include "MipGenerator.h"
+#include <algorithm>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+
+#ifdef DDS_LOADER_STATS
+#include <chrono>
+
+namespace
+{
+	using StatsClock = std::chrono::steady_clock;
+
+	// Time since mark, which moves on to now, the same way the DDS loader charges its stages
+	double EndStage(StatsClock::time_point& mark)
+	{
+		StatsClock::time_point now = StatsClock::now();
+		double ms = std::chrono::duration<double, std::milli>(now - mark).count();
+		mark = now;
+		return ms;
+	}
+
+	// A longer path keeps its end, as in the loader's own records
+	void SetFileName(DirectX::DDSLoadStats& stats, const std::wstring& path)
+	{
+		size_t length = std::min<size_t>(path.size(), MAX_PATH - 1);
+		memcpy(stats.fileName, path.c_str() + (path.size() - length), length * sizeof(wchar_t));
+		stats.fileName[length] = L'\0';
+	}
+}
+#endif
+
+Texture::Texture(ID3D11ShaderResourceView* placeholder, const uint64_t* frame) : m_Placeholder(placeholder), m_Frame(frame)
+{
+}
+
+Texture::~Texture()
+{
+	if (m_View != nullptr)
+		m_View->Release();
+
+	if (m_Resource != nullptr)
+		m_Resource->Release();
+}
+
+TextureLoader::TextureLoader(Renderer* renderer, UploadManager* uploads, unsigned int threadCount) : m_Renderer(renderer), m_Uploads(uploads)
+{
+	m_Threads.resize(threadCount > 0 ? threadCount : 1);
+}
+
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_RequestReady.notify_all();
+
+	for (auto& thread : m_Threads)
+	{
+		if (thread.joinable())
+			thread.join();
+	}
+
+	if (m_Placeholder != nullptr)
+		m_Placeholder->Release();
+
+	if (m_ArrayPlaceholder != nullptr)
+		m_ArrayPlaceholder->Release();
+}
+
+bool TextureLoader::Init()
+{
+	CreatePlaceholder();
+
+	for (auto& thread : m_Threads)
+	{
+		thread = std::thread(&TextureLoader::WorkerThread, this);
+	}
+
+	return true;
+}
+
+bool TextureLoader::OpenArchive(const std::wstring& path)
+{
+	return SUCCEEDED(m_Archive.Open(path.c_str()));
+}
+
+std::shared_ptr<Texture> TextureLoader::Load(const std::wstring& path)
+{
+	std::shared_ptr<Texture> cached = m_Cache.Find(path);
+	if (cached != nullptr && !cached->m_ArrayView)
+		return cached;
+
+	auto request = std::make_unique<Request>();
+	request->path = path;
+	request->texture = CreateTexture(path, false);
+
+	std::shared_ptr<Texture> texture = request->texture;
+	Queue(std::move(request));
+
+	return texture;
+}
+
+std::shared_ptr<Texture> TextureLoader::Stream(const std::wstring& path)
+{
+	return Stream(path, false);
+}
+
+std::shared_ptr<Texture> TextureLoader::StreamSlice(const std::wstring& path)
+{
+	return Stream(path, true);
+}
+
+std::shared_ptr<Texture> TextureLoader::Stream(const std::wstring& path, bool arrayView)
+{
+	// A file cached with the other kind of view is loaded again, and the new one is cached instead
+	std::shared_ptr<Texture> cached = m_Cache.Find(path);
+	if (cached != nullptr && cached->m_ArrayView == arrayView)
+		return cached;
+
+	auto request = std::make_unique<Request>();
+	request->path = path;
+	request->texture = CreateTexture(path, arrayView);
+	request->streaming = true;
+
+	std::shared_ptr<Texture> texture = request->texture;
+	Queue(std::move(request));
+
+	return texture;
+}
+
+std::shared_ptr<Texture> TextureLoader::LoadArray(const std::vector<std::wstring>& paths)
+{
+	auto texture = std::make_shared<Texture>(m_ArrayPlaceholder, &m_Frame);
+	texture->m_ArrayView = true;
+	m_Textures.push_back(texture);
+
+	auto request = std::make_unique<Request>();
+	request->texture = texture;
+	request->slicePaths = paths;
+	Queue(std::move(request));
+
+	return texture;
+}
+
+bool TextureLoader::GetDesc(const std::wstring& path, DirectX::DDSTextureDesc& desc)
+{
+	const DirectX::TEXTURE_ARCHIVE_ENTRY* entry = m_Archive.Find(path.c_str());
+	HRESULT hr = (entry != nullptr)
+		? DirectX::GetDDSTextureDescFromMemory(m_Archive.GetData(*entry), (size_t)entry->size, desc)
+		: DirectX::GetDDSTextureDescFromFile(path.c_str(), desc);
+	if (FAILED(hr))
+		return false;
+
+	// Files saved without mips come back with a generated chain, from the archive or not
+	if (desc.resDim == D3D11_RESOURCE_DIMENSION_TEXTURE2D)
+		desc.mipCount = DirectX::GetLoadedMipCount(desc.width, desc.height, desc.mipCount, desc.format);
+
+	return true;
+}
+
+std::shared_ptr<Texture> TextureLoader::CreateTexture(const std::wstring& path, bool arrayView)
+{
+	auto texture = std::make_shared<Texture>(arrayView ? m_ArrayPlaceholder : m_Placeholder, &m_Frame);
+	texture->m_ArrayView = arrayView;
+	texture->m_Path = path;
+	texture->m_ArchiveEntry = m_Archive.Find(path.c_str());
+
+	m_Cache.Add(path, texture);
+	m_Textures.push_back(texture);
+	return texture;
+}
+
+void TextureLoader::Queue(std::unique_ptr<Request> request)
+{
+	request->texture->m_Loading = true;
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Pending.push_back(std::move(request));
+		m_InFlight++;
+	}
+	m_RequestReady.notify_one();
+}
+
+void TextureLoader::Update()
+{
+	std::deque<std::unique_ptr<Request>> loaded;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		loaded.swap(m_Loaded);
+		m_InFlight -= (unsigned int)loaded.size();
+	}
+
+	// A request that fails leaves its texture as it was, on the placeholder if nothing of it
+	// was created yet, and the rest are created regardless
+	for (auto& request : loaded)
+	{
+		Texture& texture = *request->texture;
+		texture.m_Loading = false;
+
+		HRESULT hr = request->result;
+		if (SUCCEEDED(hr))
+			hr = CreateLoaded(*request);
+
+		if (FAILED(hr))
+		{
+			texture.m_Failed = true;
+			ReportFailure(*request, hr);
+		}
+	}
+
+	UpdateResidency();
+	m_Frame++;
+}
+
+HRESULT TextureLoader::CreateLoaded(Request& request)
+{
+	Texture& texture = *request.texture;
+
+	if (request.streaming)
+		return UploadStreamingMips(request);
+
+	if (!request.slicePaths.empty())
+		return CreateArray(request);
+
+	// Same pixels under another name, share the view that is already on the GPU
+	const std::shared_ptr<Texture>& same = request.sameContent;
+	if (same != nullptr && same->m_View != nullptr && same->m_Resource == nullptr && same->m_ArrayView == texture.m_ArrayView)
+	{
+		texture.m_View = same->m_View;
+		texture.m_View->AddRef();
+		m_Cache.CountContentHit();
+		return S_OK;
+	}
+
+	// Archive entries point into the mapping, unless they had to be converted or given mips
+	ID3D11Resource* resource = nullptr;
+	HRESULT hr = DirectX::CreateDDSTextureFromData(m_Renderer->GetDevice(), request.data, &resource, nullptr);
+	if (FAILED(hr))
+		return hr;
+
+	hr = CreateView(texture, resource, &texture.m_View);
+	resource->Release();
+	if (FAILED(hr))
+		return hr;
+
+	hr = DirectX::GetDDSSubresourceSizes(request.data.desc, nullptr, 0, &texture.m_ResidentBytes);
+	if (FAILED(hr))
+		return hr;
+
+	if (request.contentHash != 0)
+		m_Cache.AddContent(request.contentHash, request.texture);
+	return S_OK;
+}
+
+void TextureLoader::ReportFailure(const Request& request, HRESULT hr)
+{
+	std::wstring path = request.slicePaths.empty() ? request.path : request.slicePaths[0];
+	if (request.slicePaths.size() > 1)
+		path += L" and " + std::to_wstring(request.slicePaths.size() - 1) + L" more slices";
+
+	wchar_t message[64];
+	swprintf_s(message, L": load failed (0x%08X)\n", (unsigned int)hr);
+	OutputDebugStringW((path + message).c_str());
+}
+
+void TextureLoader::Flush()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_RequestLoaded.wait(lock, [this] { return !m_Loaded.empty() || m_InFlight == 0; });
+
+			if (m_InFlight == 0)
+				return;
+		}
+
+		Update();
+	}
+}
+
+bool TextureLoader::IsIdle()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_InFlight == 0;
+}
+
+void TextureLoader::WorkerThread()
+{
+	for (;;)
+	{
+		std::unique_ptr<Request> request;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_RequestReady.wait(lock, [this] { return m_Stopping || !m_Pending.empty(); });
+
+			if (m_Stopping)
+				return;
+
+			request = std::move(m_Pending.front());
+			m_Pending.pop_front();
+		}
+
+		// File read, header validation and subresource layout all happen here, off the render thread
+		if (request->streaming)
+			request->result = ReadStreamingMips(*request);
+		else if (!request->slicePaths.empty())
+			request->result = LoadArraySlices(*request);
+		else
+			request->result = LoadWhole(*request);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Loaded.push_back(std::move(request));
+		}
+		m_RequestLoaded.notify_all();
+	}
+}
+
+HRESULT TextureLoader::LoadWhole(Request& request)
+{
+	// Archive entries are converted and given mips the same way as loose files, so a texture
+	// hashes and compares the same whichever of the two it is read from
+	const DirectX::TEXTURE_ARCHIVE_ENTRY* entry = request.texture->m_ArchiveEntry;
+	HRESULT hr = (entry != nullptr)
+		? LoadArchiveEntry(request.path, *entry, request.data)
+		: DirectX::LoadDDSTextureDataFromFile(request.path.c_str(), 0, request.data);
+	if (FAILED(hr))
+		return hr;
+
+	request.contentHash = TextureCache::HashContent(request.data);
+	request.sameContent = FindSameContent(request);
+	return S_OK;
+}
+
+HRESULT TextureLoader::LoadArchiveEntry(const std::wstring& path, const DirectX::TEXTURE_ARCHIVE_ENTRY& entry, DirectX::DDSTextureData& data)
+{
+#ifdef DDS_LOADER_STATS
+	StatsClock::time_point mark = StatsClock::now();
+#endif
+	// Checking the checksum faults the pages in before the render thread reads them
+	HRESULT hr = m_Archive.Verify(entry) ? S_OK : HRESULT_FROM_WIN32(ERROR_CRC);
+#ifdef DDS_LOADER_STATS
+	double readMs = EndStage(mark);
+#endif
+	if (SUCCEEDED(hr))
+		hr = GetArchiveData(entry, data);
+#ifdef DDS_LOADER_STATS
+	// The DDS loader has no name to report these under, so their record is sent from here.
+	// The checksum is what faults the pages in, so it counts as the read.
+	DirectX::DDSLoadStats& stats = data.loadStats;
+	SetFileName(stats, path);
+	stats.result = hr;
+	stats.readMs = readMs;
+	stats.bytesRead = entry.size;
+	stats.isMapped = true;
+	DirectX::ReportDDSLoadStats(stats);
+#else
+	(void)path;
+#endif
+	return hr;
+}
+
+HRESULT TextureLoader::GetArchiveData(const DirectX::TEXTURE_ARCHIVE_ENTRY& entry, DirectX::DDSTextureData& data)
+{
+	return DirectX::LoadDDSTextureDataFromMemory(m_Archive.GetData(entry), (size_t)entry.size, 0, data);
+}
+
+std::shared_ptr<Texture> TextureLoader::FindSameContent(const Request& request)
+{
+	std::shared_ptr<Texture> same = m_Cache.FindContent(request.contentHash);
+	if (same == nullptr || same == request.texture || same->m_ArrayView != request.texture->m_ArrayView)
+		return nullptr;
+
+	// A matching hash only makes it a candidate. Its source is read again to compare against,
+	// which only happens for files that really are copies, or for a collision.
+	DirectX::DDSTextureData other;
+	HRESULT hr = (same->m_ArchiveEntry != nullptr)
+		? GetArchiveData(*same->m_ArchiveEntry, other)
+		: DirectX::LoadDDSTextureDataFromFile(same->m_Path.c_str(), 0, other);
+	if (FAILED(hr) || !TextureCache::SameContent(request.data, other))
+		return nullptr;
+
+	return same;
+}
+
+HRESULT TextureLoader::ReadStreamingMips(Request& request)
+{
+	// The texture is in flight, so the render thread leaves its description alone until this returns
+	Texture& texture = *request.texture;
+
+	if (texture.m_Layouts.empty())
+	{
+		// First visit: parse the header and work out the mip tail
+		HRESULT hr = (texture.m_ArchiveEntry != nullptr)
+			? DirectX::GetDDSTextureDescFromMemory(m_Archive.GetData(*texture.m_ArchiveEntry), (size_t)texture.m_ArchiveEntry->size, texture.m_Desc)
+			: DirectX::GetDDSTextureDescFromFile(request.path.c_str(), texture.m_Desc);
+		if (FAILED(hr))
+			return hr;
+
+		// Compressed files, and ones converted as they load, can't be read a mip at a time
+		const DirectX::DDSTextureDesc& desc = texture.m_Desc;
+		if (desc.resDim != D3D11_RESOURCE_DIMENSION_TEXTURE2D || desc.arraySize != 1 || desc.isCubeMap || desc.mipCount <= 1 || desc.isLZ4Frame
+			|| desc.legacyFormat != DirectX::LegacyFormat::None)
+		{
+			request.streaming = false;
+			return LoadWhole(request);
+		}
+
+		texture.m_Layouts.resize(desc.mipCount);
+		hr = DirectX::GetDDSSubresourceLayout(desc, texture.m_Layouts.data(), texture.m_Layouts.size());
+		if (FAILED(hr))
+			return hr;
+
+		texture.m_Mips.resize(desc.mipCount);
+		for (size_t mip = 0; mip < desc.mipCount; mip++)
+			texture.m_Mips[mip] = { texture.m_Layouts[mip].size, texture.m_Layouts[mip].width, texture.m_Layouts[mip].height };
+
+		request.lastMip = desc.mipCount - 1;
+		request.firstMip = DirectX::GetMipTailStart(texture.m_Mips.data(), texture.m_Mips.size(), desc.format, MipTailBytes);
+	}
+
+	const DirectX::DDSSubresourceLayout& first = texture.m_Layouts[request.firstMip];
+	const DirectX::DDSSubresourceLayout& last = texture.m_Layouts[request.lastMip];
+	size_t size = last.offset + last.size - first.offset;
+
+	if (texture.m_ArchiveEntry != nullptr)
+	{
+		if (last.offset + last.size > texture.m_ArchiveEntry->size)
+			return HRESULT_FROM_WIN32(ERROR_HANDLE_EOF);
+
+		request.mipData.reset(new (std::nothrow) uint8_t[size]);
+		if (!request.mipData)
+			return E_OUTOFMEMORY;
+
+		memcpy(request.mipData.get(), m_Archive.GetData(*texture.m_ArchiveEntry) + first.offset, size);
+		return S_OK;
+	}
+
+	std::ifstream file(request.path, std::ios::binary);
+	if (!file.is_open())
+		return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+	request.mipData.reset(new (std::nothrow) uint8_t[size]);
+	if (!request.mipData)
+		return E_OUTOFMEMORY;
+
+	file.seekg((std::streamoff)first.offset);
+	file.read((char*)request.mipData.get(), (std::streamsize)size);
+	if ((size_t)file.gcount() != size)
+		return E_FAIL;
+
+	return S_OK;
+}
+
+HRESULT TextureLoader::UploadStreamingMips(Request& request)
+{
+	Texture& texture = *request.texture;
+
+	if (texture.m_Resource == nullptr || request.firstMip < texture.m_BaseMip)
+	{
+		HRESULT hr = ResizeTexture(texture, request.firstMip);
+		if (FAILED(hr))
+			return hr;
+	}
+
+	const uint8_t* base = request.mipData.get();
+	size_t baseOffset = texture.m_Layouts[request.firstMip].offset;
+
+	for (size_t mip = request.firstMip; mip <= request.lastMip; mip++)
+	{
+		const DirectX::DDSSubresourceLayout& layout = texture.m_Layouts[mip];
+		m_Uploads->UploadTexture(texture.m_Resource, (UINT)(mip - texture.m_BaseMip),
+			base + (layout.offset - baseOffset), (UINT)layout.rowPitch, (UINT)layout.slicePitch);
+	}
+
+	request.mipData.reset();
+	return S_OK;
+}
+
+HRESULT TextureLoader::LoadArraySlices(Request& request)
+{
+	request.slices.resize(request.slicePaths.size());
+
+	for (size_t i = 0; i < request.slicePaths.size(); i++)
+	{
+		DirectX::DDSTextureData& slice = request.slices[i];
+
+		const DirectX::TEXTURE_ARCHIVE_ENTRY* entry = m_Archive.Find(request.slicePaths[i].c_str());
+		HRESULT hr = (entry != nullptr)
+			? LoadArchiveEntry(request.slicePaths[i], *entry, slice)
+			: DirectX::LoadDDSTextureDataFromFile(request.slicePaths[i].c_str(), 0, slice);
+		if (FAILED(hr))
+			return hr;
+
+		// The header could have changed since the builder grouped it
+		const DirectX::DDSTextureDesc& desc = slice.desc;
+		const DirectX::DDSTextureDesc& first = request.slices[0].desc;
+		if (desc.resDim != D3D11_RESOURCE_DIMENSION_TEXTURE2D || desc.arraySize != 1 || desc.isCubeMap
+			|| desc.width != first.width || desc.height != first.height || desc.mipCount != first.mipCount || desc.format != first.format)
+			return HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED);
+	}
+
+	return S_OK;
+}
+
+HRESULT TextureLoader::CreateArray(Request& request)
+{
+	const DirectX::DDSTextureDesc& first = request.slices[0].desc;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = (UINT)first.width;
+	desc.Height = (UINT)first.height;
+	desc.MipLevels = (UINT)first.mipCount;
+	desc.ArraySize = (UINT)request.slices.size();
+	desc.Format = first.format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	// Subresources go mip by mip within each slice, which is how every slice's own data is laid out
+	std::vector<D3D11_SUBRESOURCE_DATA> initData;
+	initData.reserve(desc.MipLevels * desc.ArraySize);
+	for (auto& slice : request.slices)
+		initData.insert(initData.end(), slice.initData.get(), slice.initData.get() + slice.desc.mipCount);
+
+#ifdef DDS_LOADER_STATS
+	StatsClock::time_point mark = StatsClock::now();
+#endif
+	Texture& texture = *request.texture;
+	ID3D11Texture2D* resource = nullptr;
+	HRESULT hr = m_Renderer->GetDevice()->CreateTexture2D(&desc, initData.data(), &resource);
+	if (SUCCEEDED(hr))
+	{
+		hr = CreateView(texture, resource, &texture.m_View);
+		resource->Release();
+	}
+
+#ifdef DDS_LOADER_STATS
+	// One create record per slice, each with its share of the array, so they join the rows of
+	// their loads and the rows still add up to the time taken
+	double createMs = EndStage(mark) / request.slices.size();
+	for (auto& slice : request.slices)
+	{
+		DirectX::DDSLoadStats stats = {};
+		memcpy(stats.fileName, slice.loadStats.fileName, sizeof(stats.fileName));
+		stats.result = hr;
+		stats.createMs = createMs;
+		stats.width = desc.Width;
+		stats.height = desc.Height;
+		stats.mipCount = desc.MipLevels;
+		stats.format = desc.Format;
+		stats.isLZ4Frame = slice.loadStats.isLZ4Frame;
+		DirectX::ReportDDSLoadStats(stats);
+	}
+#endif
+
+	if (FAILED(hr))
+		return hr;
+
+	size_t sliceBytes = 0;
+	hr = DirectX::GetDDSSubresourceSizes(first, nullptr, 0, &sliceBytes);
+	if (FAILED(hr))
+		return hr;
+
+	texture.m_ResidentBytes = sliceBytes * request.slices.size();
+	return S_OK;
+}
+
+void TextureLoader::UpdateResidency()
+{
+	// Textures only the cache still holds are let go here, and expire with the rest below
+	m_Cache.Purge();
+
+	m_Textures.erase(std::remove_if(m_Textures.begin(), m_Textures.end(), [](const std::weak_ptr<Texture>& texture) { return texture.expired(); }), m_Textures.end());
+
+	std::vector<std::shared_ptr<Texture>> textures;
+	std::vector<DirectX::StreamedTexture> streamed;
+	textures.reserve(m_Textures.size());
+	streamed.reserve(m_Textures.size());
+
+	m_ResidentBytes = 0;
+	for (auto& weak : m_Textures)
+	{
+		auto texture = weak.lock();
+		m_ResidentBytes += texture->m_ResidentBytes;
+
+		// Only streamed textures that are not waiting on a read can change size
+		if (texture->m_Resource != nullptr)
+		{
+			textures.push_back(texture);
+			streamed.push_back({ texture->m_Mips.data(), texture->m_Mips.size(), texture->m_Desc.format, texture->m_BaseMip, texture->m_LastUsed, texture->m_Loading || texture->m_Failed });
+		}
+	}
+
+	std::vector<DirectX::MipStreamingStep> shrinks(streamed.size());
+	std::vector<DirectX::MipStreamingStep> reads(streamed.size());
+	size_t shrinkCount = 0;
+	size_t readCount = 0;
+	size_t plannedBytes = m_ResidentBytes;
+	if (FAILED(DirectX::PlanMipStreaming(streamed.data(), streamed.size(), m_Budget, m_Frame, &plannedBytes, shrinks.data(), &shrinkCount, reads.data(), &readCount)))
+		return;
+
+	// A texture that can't be recreated keeps its size and is not tried again
+	for (size_t i = 0; i < shrinkCount; i++)
+	{
+		Texture& texture = *textures[shrinks[i].texture];
+		m_ResidentBytes -= texture.m_ResidentBytes;
+		if (FAILED(ResizeTexture(texture, shrinks[i].mip)))
+			texture.m_Failed = true;
+		m_ResidentBytes += texture.m_ResidentBytes;
+	}
+
+	for (size_t i = 0; i < readCount; i++)
+	{
+		Texture& texture = *textures[reads[i].texture];
+
+		auto request = std::make_unique<Request>();
+		request->path = texture.m_Path;
+		request->texture = textures[reads[i].texture];
+		request->streaming = true;
+		request->firstMip = reads[i].mip;
+		request->lastMip = reads[i].mip;
+		Queue(std::move(request));
+
+		// Reserve the space now so one frame can't queue more than the budget allows
+		m_ResidentBytes += texture.m_Mips[reads[i].mip].size;
+	}
+}
+
+HRESULT TextureLoader::ResizeTexture(Texture& texture, size_t baseMip)
+{
+	const DirectX::DDSTextureDesc& source = texture.m_Desc;
+	const DirectX::DDSSubresourceLayout& top = texture.m_Layouts[baseMip];
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = (UINT)top.width;
+	desc.Height = (UINT)top.height;
+	desc.MipLevels = (UINT)(source.mipCount - baseMip);
+	desc.ArraySize = 1;
+	desc.Format = source.format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	ID3D11Texture2D* resource = nullptr;
+	HRESULT hr = m_Renderer->GetDevice()->CreateTexture2D(&desc, nullptr, &resource);
+	if (FAILED(hr))
+		return hr;
+
+	// The new view is made first, so a failure leaves the texture as it was
+	ID3D11ShaderResourceView* view = nullptr;
+	hr = CreateView(texture, resource, &view);
+	if (FAILED(hr))
+	{
+		resource->Release();
+		return hr;
+	}
+
+	// Carry over the mips both sizes share; this is a GPU copy, nothing is read back from disk.
+	// Mips still waiting in the upload manager have to be in the old texture first.
+	if (texture.m_Resource != nullptr)
+	{
+		m_Uploads->Flush(texture.m_Resource);
+
+		for (size_t mip = std::max(baseMip, texture.m_BaseMip); mip < source.mipCount; mip++)
+		{
+			m_Renderer->GetDeviceContext()->CopySubresourceRegion(resource, (UINT)(mip - baseMip), 0, 0, 0,
+				texture.m_Resource, (UINT)(mip - texture.m_BaseMip), nullptr);
+		}
+
+		texture.m_Resource->Release();
+	}
+
+	if (texture.m_View != nullptr)
+		texture.m_View->Release();
+
+	texture.m_View = view;
+	texture.m_Resource = resource;
+
+	texture.m_BaseMip = baseMip;
+	texture.m_ResidentBytes = 0;
+	for (size_t mip = baseMip; mip < source.mipCount; mip++)
+		texture.m_ResidentBytes += texture.m_Layouts[mip].size;
+
+	return S_OK;
+}
+
+HRESULT TextureLoader::CreateView(const Texture& texture, ID3D11Resource* resource, ID3D11ShaderResourceView** view)
+{
+	if (!texture.m_ArrayView)
+		return m_Renderer->GetDevice()->CreateShaderResourceView(resource, nullptr, view);
+
+	ID3D11Texture2D* texture2D = nullptr;
+	HRESULT hr = resource->QueryInterface(__uuidof(ID3D11Texture2D), (void**)&texture2D);
+	if (FAILED(hr))
+		return hr;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	texture2D->GetDesc(&desc);
+	texture2D->Release();
+
+	// Spelled out, as a default view of a one slice texture would be a plain Texture2D view
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+	viewDesc.Format = desc.Format;
+	viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	viewDesc.Texture2DArray.MipLevels = desc.MipLevels;
+	viewDesc.Texture2DArray.ArraySize = desc.ArraySize;
+	return m_Renderer->GetDevice()->CreateShaderResourceView(resource, &viewDesc, view);
+}
+
+void TextureLoader::CreatePlaceholder()
+{
+	// 1x1 white texture, so untextured objects show their material colour while loading
+	const uint32_t white = 0xffffffff;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = 1;
+	desc.Height = 1;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	D3D11_SUBRESOURCE_DATA initData = {};
+	initData.pSysMem = &white;
+	initData.SysMemPitch = sizeof(white);
+
+	ID3D11Texture2D* texture = nullptr;
+	DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateTexture2D(&desc, &initData, &texture));
+	DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateShaderResourceView(texture, nullptr, &m_Placeholder));
+
+	// The same texel viewed as a one slice array, for shaders that sample arrays. Reads of
+	// any other slice are clamped to it.
+	D3D11_SHADER_RESOURCE_VIEW_DESC arrayDesc = {};
+	arrayDesc.Format = desc.Format;
+	arrayDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	arrayDesc.Texture2DArray.MipLevels = 1;
+	arrayDesc.Texture2DArray.ArraySize = 1;
+	DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateShaderResourceView(texture, &arrayDesc, &m_ArrayPlaceholder));
+	texture->Release();
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "Renderer.h"
+#include "DDSTextureLoader.h"
+#include "MipStreaming.h"
+#include "TextureArchive.h"
+#include "TextureCache.h"
+#include "UploadManager.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A texture that is loaded in the background. Until its data arrives GetView returns the
+// loader's placeholder, so objects can bind it and render straight away.
+class Texture
+{
+public:
+	Texture(ID3D11ShaderResourceView* placeholder, const uint64_t* frame);
+	~Texture();
+
+	// Also marks the texture as used this frame, for the loader's residency tracking
+	ID3D11ShaderResourceView* GetView() const
+	{
+		m_LastUsed = *m_Frame;
+		return m_View != nullptr ? m_View : m_Placeholder;
+	}
+
+	bool IsReady() const { return m_View != nullptr; }
+
+	static const unsigned int NoResidentMip = ~0u;
+
+	// Most detailed mip that is in memory, 0 once the whole chain is resident and NoResidentMip
+	// until any of it is
+	unsigned int GetResidentMip() const { return m_View != nullptr ? (unsigned int)m_BaseMip : NoResidentMip; }
+
+	size_t GetResidentBytes() const { return m_ResidentBytes; }
+
+private:
+	friend class TextureLoader;
+
+	ID3D11Texture2D* m_Resource = nullptr;
+	ID3D11ShaderResourceView* m_View = nullptr;
+	ID3D11ShaderResourceView* m_Placeholder = nullptr;
+
+	// Viewed as a one slice Texture2DArray, for shaders that sample arrays
+	bool m_ArrayView = false;
+
+	// Streamed textures are sized to their resident mips: resource mip 0 is file mip m_BaseMip
+	std::wstring m_Path;
+	const DirectX::TEXTURE_ARCHIVE_ENTRY* m_ArchiveEntry = nullptr;
+	DirectX::DDSTextureDesc m_Desc = {};
+	std::vector<DirectX::DDSSubresourceLayout> m_Layouts;
+	std::vector<DirectX::StreamedMip> m_Mips;
+	size_t m_BaseMip = 0;
+	size_t m_ResidentBytes = 0;
+	bool m_Loading = false;
+
+	// A read or create failed; the texture is left as it is, and is neither grown nor shrunk
+	bool m_Failed = false;
+
+	const uint64_t* m_Frame = nullptr;
+	mutable uint64_t m_LastUsed = 0;
+};
+
+// Reads and parses DDS files on a pool of worker threads. The Direct3D resources are created
+// on the render thread when Update is called, so the device context is never shared.
+// Asking for a file that is already loaded returns the same texture through the cache.
+// Files found in the packed archive, when one is open, are read from it instead of from disk.
+//
+// The loader also keeps streamed textures within a memory budget. When the textures it has
+// handed out go over the budget, the least recently used ones are shrunk a mip at a time. Their
+// top mips are read back in once they are drawn again, taking room from textures that aren't.
+// MipStreaming has the schedule.
+class TextureLoader
+{
+public:
+	// Streamed mips go through the upload manager, so they are spread over frames
+	TextureLoader(Renderer* renderer, UploadManager* uploads, unsigned int threadCount = 2);
+	~TextureLoader();
+
+	bool Init();
+
+	// Call before loading anything; returns false if the archive can't be opened, in which case
+	// every texture is read from its own file
+	bool OpenArchive(const std::wstring& path);
+
+	std::shared_ptr<Texture> Load(const std::wstring& path);
+
+	// Streams a 2D texture smallest mips first. The mip tail is made resident in one small
+	// read, then each larger mip is read while the texture is being drawn and fits the budget.
+	// Textures that can't be streamed (arrays, cube maps, volumes, .dds.lz4 files) are loaded as a whole.
+	std::shared_ptr<Texture> Stream(const std::wstring& path);
+
+	// Streams a 2D texture as Stream does, but views it as a one slice Texture2DArray, so it
+	// can be bound where arrays are sampled. TextureArrayBuilder uses it for textures that
+	// share an array with nothing.
+	std::shared_ptr<Texture> StreamSlice(const std::wstring& path);
+
+	// Loads the files as the slices of one Texture2DArray, in order. They must all be 2D
+	// textures of the same size, mip count and format; TextureArrayBuilder sorts that out.
+	// Until the array is created its view is a one slice white array. Arrays are not cached
+	// or streamed, but they count against the budget.
+	std::shared_ptr<Texture> LoadArray(const std::vector<std::wstring>& paths);
+
+	// Reads just the header, from the archive if the file is in it
+	bool GetDesc(const std::wstring& path, DirectX::DDSTextureDesc& desc);
+
+	// Creates the textures whose data has finished loading and applies the budget; call once per frame.
+	// A texture that fails to load keeps its placeholder, and the failure goes to the debugger output.
+	void Update();
+
+	// 0 means no limit. Textures loaded as a whole count against the budget but are never shrunk.
+	void SetBudget(size_t bytes) { m_Budget = bytes; }
+	size_t GetBudget() const { return m_Budget; }
+	size_t GetResidentBytes() const { return m_ResidentBytes; }
+
+	// Purged every Update, so a texture stays cached only while something outside the cache holds it
+	TextureCache& GetCache() { return m_Cache; }
+
+	// Blocks until every queued texture has been created
+	void Flush();
+
+	bool IsIdle();
+
+private:
+	// Largest mip tail read before the texture is created
+	static const size_t MipTailBytes = 64 * 1024;
+
+	struct Request
+	{
+		std::wstring path;
+		std::shared_ptr<Texture> texture;
+		DirectX::DDSTextureData data;
+
+		// TextureCache::HashContent of data, 0 if it wasn't hashed, and a texture confirmed
+		// to have the same contents
+		uint64_t contentHash = 0;
+		std::shared_ptr<Texture> sameContent;
+		HRESULT result = E_PENDING;
+
+		// Streaming requests cover file mips firstMip to lastMip
+		bool streaming = false;
+		size_t firstMip = 0;
+		size_t lastMip = 0;
+		std::unique_ptr<uint8_t[]> mipData;
+
+		// Array requests load one file per slice instead of path
+		std::vector<std::wstring> slicePaths;
+		std::vector<DirectX::DDSTextureData> slices;
+	};
+
+	Renderer* m_Renderer = nullptr;
+	UploadManager* m_Uploads = nullptr;
+
+	ID3D11ShaderResourceView* m_Placeholder = nullptr;
+	ID3D11ShaderResourceView* m_ArrayPlaceholder = nullptr;
+
+	TextureCache m_Cache;
+	DirectX::TextureArchive m_Archive;
+
+	// Every texture handed out, for residency; expired entries are dropped in Update
+	std::vector<std::weak_ptr<Texture>> m_Textures;
+	uint64_t m_Frame = 1;
+	size_t m_Budget = 0;
+	size_t m_ResidentBytes = 0;
+
+	std::vector<std::thread> m_Threads;
+	std::mutex m_Mutex;
+	std::condition_variable m_RequestReady;
+	std::condition_variable m_RequestLoaded;
+	std::deque<std::unique_ptr<Request>> m_Pending;
+	std::deque<std::unique_ptr<Request>> m_Loaded;
+	unsigned int m_InFlight = 0;
+	bool m_Stopping = false;
+
+	std::shared_ptr<Texture> Stream(const std::wstring& path, bool arrayView);
+	std::shared_ptr<Texture> CreateTexture(const std::wstring& path, bool arrayView);
+
+	// A default view, or a one slice array view for textures that want one
+	HRESULT CreateView(const Texture& texture, ID3D11Resource* resource, ID3D11ShaderResourceView** view);
+	void Queue(std::unique_ptr<Request> request);
+
+	void WorkerThread();
+	HRESULT LoadWhole(Request& request);
+
+	// Checks an entry and loads it, reporting the load under path when the loader keeps stats
+	HRESULT LoadArchiveEntry(const std::wstring& path, const DirectX::TEXTURE_ARCHIVE_ENTRY& entry, DirectX::DDSTextureData& data);
+
+	// Loads an entry the way a loose file is loaded; subresources point into the archive mapping
+	// unless they had to be converted or given mips
+	HRESULT GetArchiveData(const DirectX::TEXTURE_ARCHIVE_ENTRY& entry, DirectX::DDSTextureData& data);
+	std::shared_ptr<Texture> FindSameContent(const Request& request);
+	HRESULT ReadStreamingMips(Request& request);
+	HRESULT UploadStreamingMips(Request& request);
+	HRESULT LoadArraySlices(Request& request);
+	HRESULT CreateArray(Request& request);
+
+	// Render thread half of a request that loaded; the texture keeps its placeholder if this fails
+	HRESULT CreateLoaded(Request& request);
+	void ReportFailure(const Request& request, HRESULT hr);
+
+	void UpdateResidency();
+	HRESULT ResizeTexture(Texture& texture, size_t baseMip);
+
+	void CreatePlaceholder();
+};
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "UploadManager.h"
+#include "DXGIFormatTraits.h"
+#include <algorithm>
+#include <cstring>
+
+UploadManager::UploadManager(Renderer* renderer, size_t bufferRingBytes, size_t textureRingBytes)
+	: m_Renderer(renderer), m_BufferRingBytes(bufferRingBytes), m_TextureRingBytes(textureRingBytes)
+{
+}
+
+UploadManager::~UploadManager()
+{
+	for (auto& copy : m_BufferCopies)
+		copy.dest->Release();
+
+	for (auto& copy : m_TextureCopies)
+		copy.dest->Release();
+
+	for (auto& ring : m_StagingRings)
+	{
+		for (auto& staging : ring->textures)
+		{
+			for (auto& copy : staging.copies)
+				copy.dest->Release();
+
+			if (staging.isMapped)
+				m_Renderer->GetDeviceContext()->Unmap(staging.texture, 0);
+
+			if (staging.fence != nullptr)
+				staging.fence->Release();
+
+			if (staging.texture != nullptr)
+				staging.texture->Release();
+		}
+	}
+
+	for (auto& fence : m_Fences)
+		fence.query->Release();
+
+	for (auto query : m_FreeQueries)
+		query->Release();
+
+	if (m_BufferRing != nullptr)
+		m_BufferRing->Release();
+}
+
+bool UploadManager::Init()
+{
+	if (FAILED(m_BufferAllocator.Initialize(m_BufferRingBytes)) || FAILED(m_TextureAllocator.Initialize(m_TextureRingBytes)))
+		return false;
+
+	// Only a source for copies, but dynamic buffers need a bind flag and vertex buffers can be
+	// mapped with NO_OVERWRITE on every feature level
+	D3D11_BUFFER_DESC desc = {};
+	desc.ByteWidth = (UINT)m_BufferRingBytes;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	if (FAILED(m_Renderer->GetDevice()->CreateBuffer(&desc, nullptr, &m_BufferRing)))
+		return false;
+
+	// The first map of a dynamic resource discards it; every later one promises not to touch
+	// what the GPU may still be reading
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(m_Renderer->GetDeviceContext()->Map(m_BufferRing, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return false;
+	m_Renderer->GetDeviceContext()->Unmap(m_BufferRing, 0);
+
+	m_TextureRing.reset(new uint8_t[m_TextureRingBytes]);
+	return true;
+}
+
+void UploadManager::UploadBuffer(ID3D11Buffer* dest, UINT destOffset, const void* data, UINT size)
+{
+	if (size == 0)
+		return;
+
+	ID3D11DeviceContext* context = m_Renderer->GetDeviceContext();
+
+	size_t offset = 0;
+	HRESULT hr = m_BufferAllocator.Allocate(size, Alignment, &offset);
+	if (hr == S_FALSE)
+	{
+		RetireFences();
+		hr = m_BufferAllocator.Allocate(size, Alignment, &offset);
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (hr != S_OK || FAILED(context->Map(m_BufferRing, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapped)))
+	{
+		// Queued copies into dest must land first, or they would overwrite this one
+		SubmitBufferCopies();
+
+		D3D11_BOX box = { destOffset, 0, 0, destOffset + size, 1, 1 };
+		context->UpdateSubresource(dest, 0, &box, data, 0, 0);
+		return;
+	}
+
+	memcpy((uint8_t*)mapped.pData + offset, data, size);
+	context->Unmap(m_BufferRing, 0);
+
+	dest->AddRef();
+	m_BufferCopies.push_back({ dest, destOffset, (UINT)offset, size });
+}
+
+void UploadManager::UploadTexture(ID3D11Resource* dest, UINT subresource, const void* data, UINT rowPitch, UINT slicePitch, UINT depth)
+{
+	size_t size = (size_t)slicePitch * depth;
+	if (size == 0)
+		return;
+
+	if (StageTexture(dest, subresource, data, rowPitch, slicePitch, depth))
+		return;
+
+	size_t offset = 0;
+	if (m_TextureAllocator.Allocate(size, Alignment, &offset) != S_OK)
+	{
+		Flush(dest);
+		m_Renderer->GetDeviceContext()->UpdateSubresource(dest, subresource, nullptr, data, rowPitch, slicePitch);
+		return;
+	}
+
+	memcpy(m_TextureRing.get() + offset, data, size);
+	m_TextureAllocator.FinishFrame(++m_TextureSequence);
+
+	dest->AddRef();
+	m_TextureCopies.push_back({ dest, subresource, offset, rowPitch, slicePitch, size, m_TextureSequence, false });
+}
+
+bool UploadManager::IsIdle() const
+{
+	for (auto& ring : m_StagingRings)
+	{
+		if (!ring->textures[ring->current].copies.empty())
+			return false;
+	}
+
+	return m_BufferCopies.empty() && m_TextureCopies.empty();
+}
+
+void UploadManager::Submit()
+{
+	RetireFences();
+	SubmitBufferCopies();
+	SubmitStagedCopies();
+
+	size_t updated = 0;
+	while (!m_TextureCopies.empty())
+	{
+		TextureCopy& copy = m_TextureCopies.front();
+		if (!copy.done)
+		{
+			if (m_FrameBudget != 0 && updated != 0 && updated + copy.size > m_FrameBudget)
+				break;
+
+			UpdateTexture(copy);
+			updated += copy.size;
+		}
+
+		copy.dest->Release();
+		m_TextureAllocator.Retire(copy.sequence);
+		m_TextureCopies.pop_front();
+	}
+}
+
+void UploadManager::Flush(ID3D11Resource* dest)
+{
+	// Staged copies can only be recorded once their texture is unmapped, which closes it for
+	// the frame; that only happens when one of them is for dest
+	for (auto& ring : m_StagingRings)
+	{
+		for (auto& copy : ring->textures[ring->current].copies)
+		{
+			if (copy.dest == dest)
+			{
+				SubmitStagedCopies();
+				break;
+			}
+		}
+	}
+
+	// Made in queue order, so later updates to a subresource still win; the ring space is given
+	// back when Submit reaches them
+	for (auto& copy : m_TextureCopies)
+	{
+		if (copy.dest == dest && !copy.done)
+			UpdateTexture(copy);
+	}
+}
+
+void UploadManager::RetireFences()
+{
+	ID3D11DeviceContext* context = m_Renderer->GetDeviceContext();
+
+	while (!m_Fences.empty())
+	{
+		Fence& fence = m_Fences.front();
+		if (context->GetData(fence.query, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			break;
+
+		m_BufferAllocator.Retire(fence.value);
+		m_FreeQueries.push_back(fence.query);
+		m_Fences.pop_front();
+	}
+}
+
+void UploadManager::SubmitBufferCopies()
+{
+	if (m_BufferCopies.empty())
+		return;
+
+	ID3D11DeviceContext* context = m_Renderer->GetDeviceContext();
+
+	for (auto& copy : m_BufferCopies)
+	{
+		D3D11_BOX box = { copy.offset, 0, 0, copy.offset + copy.size, 1, 1 };
+		context->CopySubresourceRegion(copy.dest, 0, copy.destOffset, 0, 0, m_BufferRing, 0, &box);
+		copy.dest->Release();
+	}
+	m_BufferCopies.clear();
+
+	ID3D11Query* query = nullptr;
+	if (!m_FreeQueries.empty())
+	{
+		query = m_FreeQueries.back();
+		m_FreeQueries.pop_back();
+	}
+	else
+	{
+		D3D11_QUERY_DESC desc = {};
+		desc.Query = D3D11_QUERY_EVENT;
+		DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateQuery(&desc, &query));
+	}
+
+	context->End(query);
+	m_Fences.push_back({ query, ++m_FenceValue });
+	m_BufferAllocator.FinishFrame(m_FenceValue);
+}
+
+void UploadManager::UpdateTexture(TextureCopy& copy)
+{
+	m_Renderer->GetDeviceContext()->UpdateSubresource(copy.dest, copy.subresource, nullptr,
+		m_TextureRing.get() + copy.offset, copy.rowPitch, copy.slicePitch);
+	copy.done = true;
+}
+
+bool UploadManager::StageTexture(ID3D11Resource* dest, UINT subresource, const void* data, UINT rowPitch, UINT slicePitch, UINT depth)
+{
+	// Updates already waiting in system memory for dest have to go in first
+	for (auto& copy : m_TextureCopies)
+	{
+		if (copy.dest == dest && !copy.done)
+			return false;
+	}
+
+	ID3D11Texture2D* texture = nullptr;
+	if (depth != 1 || FAILED(dest->QueryInterface(__uuidof(ID3D11Texture2D), (void**)&texture)))
+		return false;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	texture->GetDesc(&desc);
+	texture->Release();
+
+	UINT mip = subresource % desc.MipLevels;
+	UINT width = std::max(desc.Width >> mip, 1u);
+	UINT height = std::max(desc.Height >> mip, 1u);
+	UINT rows = slicePitch / rowPitch;
+
+	// A box into a block compressed texture has to be whole blocks, so mips that aren't stay
+	// on the system memory path, as do formats that pack more than one texel into an element
+	UINT blockHeight = DirectX::IsCompressed(desc.Format) ? 4 : 1;
+	if (width > StagingSize || height > StagingSize || width % blockHeight != 0 || height % blockHeight != 0
+		|| rows != height / blockHeight || rowPitch % (width / blockHeight) != 0)
+		return false;
+
+	StagingTexture* staging = GetStagingTexture(desc.Format);
+	if (staging == nullptr)
+		return false;
+
+	if (staging->x + width > StagingSize)
+	{
+		staging->shelfY += staging->shelfHeight;
+		staging->x = 0;
+		staging->shelfHeight = 0;
+	}
+
+	if (staging->shelfY + height > StagingSize)
+		return false;
+
+	UINT x = staging->x;
+	UINT y = staging->shelfY;
+	staging->x += width;
+	staging->shelfHeight = std::max(staging->shelfHeight, height);
+
+	// rowPitch is a packed row of blocks, so each texel across is rowPitch / width bytes
+	uint8_t* target = (uint8_t*)staging->mapped.pData + (size_t)(y / blockHeight) * staging->mapped.RowPitch + (size_t)x * rowPitch / width;
+	for (UINT row = 0; row < rows; row++)
+		memcpy(target + (size_t)row * staging->mapped.RowPitch, (const uint8_t*)data + (size_t)row * rowPitch, rowPitch);
+
+	dest->AddRef();
+	staging->copies.push_back({ dest, subresource, { x, y, 0, x + width, y + height, 1 } });
+	return true;
+}
+
+UploadManager::StagingTexture* UploadManager::GetStagingTexture(DXGI_FORMAT format)
+{
+	StagingRing* ring = nullptr;
+	for (auto& r : m_StagingRings)
+	{
+		if (r->format == format)
+		{
+			ring = r.get();
+			break;
+		}
+	}
+
+	if (ring == nullptr)
+	{
+		m_StagingRings.push_back(std::make_unique<StagingRing>());
+		ring = m_StagingRings.back().get();
+		ring->format = format;
+	}
+
+	StagingTexture& staging = ring->textures[ring->current];
+	if (staging.isMapped)
+		return &staging;
+
+	ID3D11DeviceContext* context = m_Renderer->GetDeviceContext();
+
+	if (staging.texture == nullptr)
+	{
+		D3D11_TEXTURE2D_DESC desc = {};
+		desc.Width = StagingSize;
+		desc.Height = StagingSize;
+		desc.MipLevels = 1;
+		desc.ArraySize = 1;
+		desc.Format = format;
+		desc.SampleDesc.Count = 1;
+		desc.Usage = D3D11_USAGE_STAGING;
+		desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+		if (FAILED(m_Renderer->GetDevice()->CreateTexture2D(&desc, nullptr, &staging.texture)))
+			return nullptr;
+	}
+
+	// Still being copied out of, so it can't be written without waiting for the GPU
+	if (staging.fence != nullptr && context->GetData(staging.fence, nullptr, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+		return nullptr;
+
+	if (FAILED(context->Map(staging.texture, 0, D3D11_MAP_WRITE, D3D11_MAP_FLAG_DO_NOT_WAIT, &staging.mapped)))
+		return nullptr;
+
+	staging.isMapped = true;
+	staging.x = 0;
+	staging.shelfY = 0;
+	staging.shelfHeight = 0;
+	return &staging;
+}
+
+void UploadManager::SubmitStagedCopies()
+{
+	ID3D11DeviceContext* context = m_Renderer->GetDeviceContext();
+
+	for (auto& ring : m_StagingRings)
+	{
+		StagingTexture& staging = ring->textures[ring->current];
+		if (!staging.isMapped)
+			continue;
+
+		context->Unmap(staging.texture, 0);
+		staging.isMapped = false;
+
+		// A texture mapped for nothing is written again next time, as it is
+		if (staging.copies.empty())
+			continue;
+
+		for (auto& copy : staging.copies)
+		{
+			context->CopySubresourceRegion(copy.dest, copy.subresource, 0, 0, 0, staging.texture, 0, &copy.box);
+			copy.dest->Release();
+		}
+		staging.copies.clear();
+
+		if (staging.fence == nullptr)
+		{
+			D3D11_QUERY_DESC desc = {};
+			desc.Query = D3D11_QUERY_EVENT;
+			DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateQuery(&desc, &staging.fence));
+		}
+
+		context->End(staging.fence);
+		ring->current = (ring->current + 1) % StagingTextures;
+	}
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "Renderer.h"
+#include "RingAllocator.h"
+#include <deque>
+#include <memory>
+#include <vector>
+
+// Stages updates to resources that already exist and records them once per frame, so
+// streaming doesn't put one driver allocation and copy behind every mip it reads.
+//
+// Buffer data is written into a persistent dynamic buffer and copied out with
+// CopySubresourceRegion; an event query issued after each frame's copies tells when that part
+// of the ring can be written again. Direct3D 11 can't copy from a buffer into a texture, so
+// texture data is written into STAGING textures of the destination's format instead, packed
+// in rows of rectangles, and copied out the same way. Each format has a ring of them: one
+// is written during the frame, and it is only mapped again once the query issued after its
+// copies has completed, so the CPU never waits on the GPU. Updates that can't be staged,
+// because the ring is busy or full, the texture isn't 2D or a block compressed mip isn't
+// whole blocks, wait in a ring in system memory and go in with UpdateSubresource, at most
+// the frame budget's worth per frame so a burst of streaming doesn't land in one frame.
+//
+// Everything runs on the render thread, since it uses the device context.
+class UploadManager
+{
+public:
+	UploadManager(Renderer* renderer, size_t bufferRingBytes = 8 * 1024 * 1024, size_t textureRingBytes = 64 * 1024 * 1024);
+	~UploadManager();
+
+	bool Init();
+
+	// Writes the data into the staging ring now; Submit records the copy into dest, which must
+	// be a DEFAULT usage buffer. When the ring is full the update is made straight away.
+	void UploadBuffer(ID3D11Buffer* dest, UINT destOffset, const void* data, UINT size);
+
+	// Copies depth slices of one subresource into a staging texture, or else the texture ring;
+	// Submit makes the update. When both are full the update is made straight away, after
+	// any queued for dest.
+	void UploadTexture(ID3D11Resource* dest, UINT subresource, const void* data, UINT rowPitch, UINT slicePitch, UINT depth = 1);
+
+	// Records the queued buffer and staged texture copies, and the texture updates that fit the
+	// budget; call once per frame
+	void Submit();
+
+	// Makes the texture updates queued for dest now, for when it is about to be copied from
+	void Flush(ID3D11Resource* dest);
+
+	// Texture bytes updated from system memory per frame; 0 means no limit. One update is
+	// always made, however large. Staged copies are limited by the staging textures instead.
+	void SetFrameBudget(size_t bytes) { m_FrameBudget = bytes; }
+	size_t GetFrameBudget() const { return m_FrameBudget; }
+
+	bool IsIdle() const;
+
+private:
+	// Ring offsets are aligned for SSE copies
+	static const size_t Alignment = 16;
+
+	// Texels along each side of a staging texture, and how many each format cycles through
+	static const UINT StagingSize = 1024;
+	static const size_t StagingTextures = 3;
+
+	struct BufferCopy
+	{
+		ID3D11Buffer* dest;
+		UINT destOffset;
+		UINT offset;
+		UINT size;
+	};
+
+	struct TextureCopy
+	{
+		ID3D11Resource* dest;
+		UINT subresource;
+		size_t offset;
+		UINT rowPitch;
+		UINT slicePitch;
+		size_t size;
+		uint64_t sequence;
+		bool done;
+	};
+
+	struct StagedCopy
+	{
+		ID3D11Resource* dest;
+		UINT subresource;
+		D3D11_BOX box;
+	};
+
+	// Rectangles are packed left to right in shelves, each as tall as its tallest rectangle
+	struct StagingTexture
+	{
+		ID3D11Texture2D* texture = nullptr;
+		ID3D11Query* fence = nullptr;
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		bool isMapped = false;
+		UINT x = 0;
+		UINT shelfY = 0;
+		UINT shelfHeight = 0;
+		std::vector<StagedCopy> copies;
+	};
+
+	struct StagingRing
+	{
+		DXGI_FORMAT format;
+		StagingTexture textures[StagingTextures];
+		size_t current = 0;
+	};
+
+	struct Fence
+	{
+		ID3D11Query* query;
+		uint64_t value;
+	};
+
+	Renderer* m_Renderer = nullptr;
+	size_t m_FrameBudget = 16 * 1024 * 1024;
+
+	ID3D11Buffer* m_BufferRing = nullptr;
+	size_t m_BufferRingBytes = 0;
+	DirectX::RingAllocator m_BufferAllocator;
+	std::vector<BufferCopy> m_BufferCopies;
+	std::deque<Fence> m_Fences;
+	std::vector<ID3D11Query*> m_FreeQueries;
+	uint64_t m_FenceValue = 0;
+
+	// Each update is a frame of its own to the allocator, retired by its sequence number once made
+	std::unique_ptr<uint8_t[]> m_TextureRing;
+	size_t m_TextureRingBytes = 0;
+	DirectX::RingAllocator m_TextureAllocator;
+	std::deque<TextureCopy> m_TextureCopies;
+	uint64_t m_TextureSequence = 0;
+
+	// One ring per format, created the first time a texture of that format is updated
+	std::vector<std::unique_ptr<StagingRing>> m_StagingRings;
+
+	void RetireFences();
+	void SubmitBufferCopies();
+	void UpdateTexture(TextureCopy& copy);
+
+	// False if the update can't be staged this frame, and nothing was written
+	bool StageTexture(ID3D11Resource* dest, UINT subresource, const void* data, UINT rowPitch, UINT slicePitch, UINT depth);
+	StagingTexture* GetStagingTexture(DXGI_FORMAT format);
+
+	// Unmaps the staging textures written this frame, records their copies and moves each ring on
+	void SubmitStagedCopies();
+};
\ No newline at end of file
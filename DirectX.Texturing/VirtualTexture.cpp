@@ -0,0 +1,609 @@
+//--------------------------------------------------------------------------------------
+// File: VirtualTexture.cpp
+//
+// Tile layout and cooking, page table, tile cache and feedback analysis for sparse
+// virtual textures
+//
+// Everything here is sized once, when the texture is set up: the page table and
+// feedback counters hold an entry per tile, the cache an entry per page, and nothing is
+// allocated per frame.
+//--------------------------------------------------------------------------------------
+
+#include "VirtualTexture.h"
+#include "DXGIFormatTraits.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace DirectX;
+
+namespace
+{
+    // Tiles are cut in whole blocks for compressed formats and whole texels otherwise
+    bool GetTileUnit(DXGI_FORMAT format, size_t& unitTexels, size_t& unitBytes) noexcept
+    {
+        const DXGIFormatTraits& traits = GetDXGIFormatTraits(format);
+        switch (traits.layout)
+        {
+        case DXGI_FORMAT_LAYOUT_LINEAR:
+            if (traits.bitsPerPixel % 8)
+                return false;
+            unitTexels = 1;
+            unitBytes = traits.bitsPerPixel / 8;
+            return true;
+
+        case DXGI_FORMAT_LAYOUT_BLOCK:
+            unitTexels = 4;
+            unitBytes = traits.elementBytes;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    size_t MipSize(size_t size, size_t mip) noexcept
+    {
+        return std::max<size_t>(size >> mip, 1);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+// Layout
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GetVirtualTextureLayout(
+    size_t width,
+    size_t height,
+    size_t mipCount,
+    DXGI_FORMAT format,
+    size_t tileSize,
+    size_t border,
+    VirtualTextureLayout& layout) noexcept
+{
+    layout = {};
+
+    size_t unitTexels = 0;
+    size_t unitBytes = 0;
+    if (!GetTileUnit(format, unitTexels, unitBytes))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (width == 0 || height == 0 || mipCount == 0 || mipCount > VIRTUAL_TEXTURE_MAX_MIPS)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (tileSize < unitTexels || (tileSize & (tileSize - 1)) || border > tileSize || border % unitTexels)
+    {
+        return E_INVALIDARG;
+    }
+
+    // Past the 1x1 mip there is nothing left to halve
+    if ((std::max(width, height) >> (mipCount - 1)) == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    layout.width = width;
+    layout.height = height;
+    layout.mipCount = mipCount;
+    layout.format = format;
+    layout.tileSize = tileSize;
+    layout.border = border;
+
+    for (size_t mip = 0; mip < mipCount; mip++)
+    {
+        size_t tilesX = (MipSize(width, mip) + tileSize - 1) / tileSize;
+        size_t tilesY = (MipSize(height, mip) + tileSize - 1) / tileSize;
+        if (tilesX > VIRTUAL_TEXTURE_MAX_TILES || tilesY > VIRTUAL_TEXTURE_MAX_TILES)
+        {
+            layout = {};
+            return E_INVALIDARG;
+        }
+
+        layout.tilesX[mip] = tilesX;
+        layout.tilesY[mip] = tilesY;
+        layout.firstTile[mip] = layout.tileCount;
+        layout.tileCount += tilesX * tilesY;
+    }
+
+    size_t units = (tileSize + 2 * border) / unitTexels;
+    layout.tileRowBytes = units * unitBytes;
+    layout.tileRows = units;
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+size_t DirectX::GetVirtualTextureTileIndex(const VirtualTextureLayout& layout, uint32_t tile) noexcept
+{
+    if (tile == VIRTUAL_TEXTURE_NO_TILE)
+    {
+        return SIZE_MAX;
+    }
+
+    size_t mip = GetVirtualTextureTileMip(tile);
+    size_t x = GetVirtualTextureTileX(tile);
+    size_t y = GetVirtualTextureTileY(tile);
+    if (mip >= layout.mipCount || x >= layout.tilesX[mip] || y >= layout.tilesY[mip])
+    {
+        return SIZE_MAX;
+    }
+
+    return layout.firstTile[mip] + y * layout.tilesX[mip] + x;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+uint32_t DirectX::GetVirtualTextureParentTile(const VirtualTextureLayout& layout, uint32_t tile) noexcept
+{
+    size_t mip = GetVirtualTextureTileMip(tile) + size_t(1);
+    if (tile == VIRTUAL_TEXTURE_NO_TILE || mip >= layout.mipCount)
+    {
+        return VIRTUAL_TEXTURE_NO_TILE;
+    }
+
+    // Halving an odd size rounds down, which can leave the last tile of a row without a
+    // parent of its own; it falls under the last tile of the next mip instead
+    size_t x = std::min<size_t>(GetVirtualTextureTileX(tile) / 2, layout.tilesX[mip] - 1);
+    size_t y = std::min<size_t>(GetVirtualTextureTileY(tile) / 2, layout.tilesY[mip] - 1);
+    return MakeVirtualTextureTile(uint32_t(x), uint32_t(y), uint32_t(mip));
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::CopyVirtualTextureTile(
+    const VirtualTextureLayout& layout,
+    uint32_t tile,
+    const uint8_t* mipData,
+    size_t mipRowPitch,
+    size_t mipRows,
+    uint8_t* dest,
+    size_t destRowPitch) noexcept
+{
+    if (!mipData || !dest)
+    {
+        return E_POINTER;
+    }
+
+    size_t unitTexels = 0;
+    size_t unitBytes = 0;
+    if (GetVirtualTextureTileIndex(layout, tile) == SIZE_MAX || !GetTileUnit(layout.format, unitTexels, unitBytes))
+    {
+        return E_INVALIDARG;
+    }
+
+    size_t mip = GetVirtualTextureTileMip(tile);
+    size_t mipUnitsX = (MipSize(layout.width, mip) + unitTexels - 1) / unitTexels;
+    size_t mipUnitsY = (MipSize(layout.height, mip) + unitTexels - 1) / unitTexels;
+    if (mipRowPitch < mipUnitsX * unitBytes || mipRows < mipUnitsY || destRowPitch < layout.tileRowBytes)
+    {
+        return E_INVALIDARG;
+    }
+
+    // First unit of the tile, border included, relative to the mip; it and the last can be
+    // outside the mip
+    size_t units = layout.tileRows;
+    ptrdiff_t borderUnits = ptrdiff_t(layout.border / unitTexels);
+    ptrdiff_t startX = ptrdiff_t(GetVirtualTextureTileX(tile) * layout.tileSize / unitTexels) - borderUnits;
+    ptrdiff_t startY = ptrdiff_t(GetVirtualTextureTileY(tile) * layout.tileSize / unitTexels) - borderUnits;
+
+    // Units [copyBegin, copyEnd) of each row are inside the mip and copied in one go; the
+    // rest repeat the edge unit
+    size_t copyBegin = size_t(std::min<ptrdiff_t>(std::max<ptrdiff_t>(-startX, 0), ptrdiff_t(units)));
+    size_t copyEnd = size_t(std::max<ptrdiff_t>(std::min<ptrdiff_t>(ptrdiff_t(mipUnitsX) - startX, ptrdiff_t(units)), ptrdiff_t(copyBegin)));
+
+    for (size_t row = 0; row < units; row++)
+    {
+        ptrdiff_t sourceRow = std::min<ptrdiff_t>(std::max<ptrdiff_t>(startY + ptrdiff_t(row), 0), ptrdiff_t(mipUnitsY) - 1);
+        const uint8_t* source = mipData + size_t(sourceRow) * mipRowPitch;
+        uint8_t* target = dest + row * destRowPitch;
+
+        if (copyEnd > copyBegin)
+        {
+            memcpy(target + copyBegin * unitBytes, source + (startX + ptrdiff_t(copyBegin)) * unitBytes, (copyEnd - copyBegin) * unitBytes);
+        }
+
+        for (size_t unit = 0; unit < copyBegin; unit++)
+        {
+            memcpy(target + unit * unitBytes, source, unitBytes);
+        }
+
+        const uint8_t* last = source + (mipUnitsX - 1) * unitBytes;
+        for (size_t unit = copyEnd; unit < units; unit++)
+        {
+            memcpy(target + unit * unitBytes, last, unitBytes);
+        }
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Page table
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT VirtualTexturePageTable::Initialize(const VirtualTextureLayout& layout) noexcept
+{
+    if (layout.tileCount == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    m_Pages.reset(new (std::nothrow) uint16_t[layout.tileCount]);
+    m_Entries.reset(new (std::nothrow) VirtualTexturePageEntry[layout.tileCount]);
+    if (!m_Pages || !m_Entries)
+    {
+        m_Pages.reset();
+        m_Entries.reset();
+        return E_OUTOFMEMORY;
+    }
+
+    std::fill_n(m_Pages.get(), layout.tileCount, VIRTUAL_TEXTURE_NO_PAGE);
+
+    m_Layout = layout;
+    m_DirtyLevels = layout.mipCount;
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+uint16_t VirtualTexturePageTable::GetPage(uint32_t tile) const noexcept
+{
+    size_t index = GetVirtualTextureTileIndex(m_Layout, tile);
+    return (index != SIZE_MAX) ? m_Pages[index] : VIRTUAL_TEXTURE_NO_PAGE;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void VirtualTexturePageTable::Map(uint32_t tile, uint16_t page) noexcept
+{
+    size_t index = GetVirtualTextureTileIndex(m_Layout, tile);
+    if (index == SIZE_MAX)
+        return;
+
+    m_Pages[index] = page;
+    m_DirtyLevels = std::max<size_t>(m_DirtyLevels, GetVirtualTextureTileMip(tile) + size_t(1));
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void VirtualTexturePageTable::Unmap(uint32_t tile) noexcept
+{
+    Map(tile, VIRTUAL_TEXTURE_NO_PAGE);
+}
+
+
+//--------------------------------------------------------------------------------------
+size_t VirtualTexturePageTable::Update() noexcept
+{
+    size_t levels = m_DirtyLevels;
+
+    // Coarse to fine, so each tile can take its parent's entry when it isn't resident
+    for (size_t mip = levels; mip-- > 0; )
+    {
+        size_t tilesX = m_Layout.tilesX[mip];
+        size_t tilesY = m_Layout.tilesY[mip];
+        const uint16_t* pages = m_Pages.get() + m_Layout.firstTile[mip];
+        VirtualTexturePageEntry* entries = m_Entries.get() + m_Layout.firstTile[mip];
+
+        bool coarsest = (mip + 1 == m_Layout.mipCount);
+        const VirtualTexturePageEntry* parents = coarsest ? nullptr : m_Entries.get() + m_Layout.firstTile[mip + 1];
+        size_t parentTilesX = coarsest ? 0 : m_Layout.tilesX[mip + 1];
+        size_t parentTilesY = coarsest ? 0 : m_Layout.tilesY[mip + 1];
+
+        for (size_t y = 0; y < tilesY; y++)
+        {
+            for (size_t x = 0; x < tilesX; x++)
+            {
+                uint16_t page = pages[y * tilesX + x];
+                VirtualTexturePageEntry& entry = entries[y * tilesX + x];
+
+                if (page != VIRTUAL_TEXTURE_NO_PAGE)
+                {
+                    entry = { page, uint16_t(mip) };
+                }
+                else if (parents)
+                {
+                    entry = parents[std::min(y / 2, parentTilesY - 1) * parentTilesX + std::min(x / 2, parentTilesX - 1)];
+                }
+                else
+                {
+                    entry = { VIRTUAL_TEXTURE_NO_PAGE, uint16_t(m_Layout.mipCount) };
+                }
+            }
+        }
+    }
+
+    m_DirtyLevels = 0;
+    return levels;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Tile cache
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT VirtualTextureTileCache::Initialize(size_t pageCount) noexcept
+{
+    if (pageCount == 0 || pageCount >= VIRTUAL_TEXTURE_NO_PAGE)
+    {
+        return E_INVALIDARG;
+    }
+
+    m_Tiles.reset(new (std::nothrow) uint32_t[pageCount]);
+    m_LastUsed.reset(new (std::nothrow) uint64_t[pageCount]);
+    m_Pinned.reset(new (std::nothrow) bool[pageCount]);
+    m_Prev.reset(new (std::nothrow) uint16_t[pageCount + 1]);
+    m_Next.reset(new (std::nothrow) uint16_t[pageCount + 1]);
+    if (!m_Tiles || !m_LastUsed || !m_Pinned || !m_Prev || !m_Next)
+    {
+        m_Tiles.reset();
+        m_LastUsed.reset();
+        m_Pinned.reset();
+        m_Prev.reset();
+        m_Next.reset();
+        m_PageCount = 0;
+        return E_OUTOFMEMORY;
+    }
+
+    m_PageCount = pageCount;
+
+    // Every page starts free, in order
+    for (size_t page = 0; page <= pageCount; page++)
+    {
+        m_Prev[page] = uint16_t((page == 0) ? pageCount : page - 1);
+        m_Next[page] = uint16_t((page == pageCount) ? 0 : page + 1);
+    }
+
+    std::fill_n(m_Tiles.get(), pageCount, VIRTUAL_TEXTURE_NO_TILE);
+    std::fill_n(m_LastUsed.get(), pageCount, uint64_t(0));
+    std::fill_n(m_Pinned.get(), pageCount, false);
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void VirtualTextureTileCache::Touch(uint16_t page, uint64_t frame) noexcept
+{
+    if (page >= m_PageCount || m_Tiles[page] == VIRTUAL_TEXTURE_NO_TILE || m_LastUsed[page] == frame)
+        return;
+
+    m_LastUsed[page] = frame;
+
+    if (!m_Pinned[page])
+    {
+        uint16_t head = uint16_t(m_PageCount);
+        Unlink(page);
+        InsertAfter(m_Prev[head], page);
+    }
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT VirtualTextureTileCache::Allocate(
+    uint32_t tile,
+    uint64_t frame,
+    bool pin,
+    uint16_t* page,
+    uint32_t* evicted) noexcept
+{
+    if (!page || !evicted)
+    {
+        return E_POINTER;
+    }
+
+    *page = VIRTUAL_TEXTURE_NO_PAGE;
+    *evicted = VIRTUAL_TEXTURE_NO_TILE;
+
+    if (tile == VIRTUAL_TEXTURE_NO_TILE || m_PageCount == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    // Free pages are kept at the least recent end, so the first page is the one to take
+    uint16_t head = uint16_t(m_PageCount);
+    uint16_t candidate = m_Next[head];
+    if (candidate == head || (m_Tiles[candidate] != VIRTUAL_TEXTURE_NO_TILE && m_LastUsed[candidate] == frame))
+    {
+        return S_FALSE;
+    }
+
+    *page = candidate;
+    *evicted = m_Tiles[candidate];
+
+    m_Tiles[candidate] = tile;
+    m_LastUsed[candidate] = frame;
+
+    Unlink(candidate);
+    if (pin)
+    {
+        m_Pinned[candidate] = true;
+    }
+    else
+    {
+        InsertAfter(m_Prev[head], candidate);
+    }
+
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void VirtualTextureTileCache::Free(uint16_t page) noexcept
+{
+    if (page >= m_PageCount || m_Tiles[page] == VIRTUAL_TEXTURE_NO_TILE)
+        return;
+
+    if (m_Pinned[page])
+    {
+        m_Pinned[page] = false;
+    }
+    else
+    {
+        Unlink(page);
+    }
+
+    m_Tiles[page] = VIRTUAL_TEXTURE_NO_TILE;
+    m_LastUsed[page] = 0;
+    InsertAfter(uint16_t(m_PageCount), page);
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void VirtualTextureTileCache::Unlink(uint16_t page) noexcept
+{
+    m_Next[m_Prev[page]] = m_Next[page];
+    m_Prev[m_Next[page]] = m_Prev[page];
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void VirtualTextureTileCache::InsertAfter(uint16_t at, uint16_t page) noexcept
+{
+    m_Prev[page] = at;
+    m_Next[page] = m_Next[at];
+    m_Prev[m_Next[at]] = page;
+    m_Next[at] = page;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Feedback
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT VirtualTextureFeedback::Initialize(const VirtualTextureLayout& layout) noexcept
+{
+    if (layout.tileCount == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    m_Counts.reset(new (std::nothrow) uint32_t[layout.tileCount]);
+    m_Candidates.reset(new (std::nothrow) uint32_t[layout.tileCount]);
+    if (!m_Counts || !m_Candidates)
+    {
+        m_Counts.reset();
+        m_Candidates.reset();
+        return E_OUTOFMEMORY;
+    }
+
+    std::fill_n(m_Counts.get(), layout.tileCount, 0u);
+
+    m_Layout = layout;
+    return S_OK;
+}
+
+
+//--------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT VirtualTextureFeedback::Analyze(
+    const uint32_t* feedback,
+    size_t count,
+    const VirtualTexturePageTable& pageTable,
+    VirtualTextureTileCache& cache,
+    uint64_t frame,
+    VirtualTextureRequest* requests,
+    size_t maxRequests,
+    size_t* requestCount) noexcept
+{
+    if (!requestCount)
+    {
+        return E_POINTER;
+    }
+
+    *requestCount = 0;
+
+    if ((count > 0 && !feedback) || (maxRequests > 0 && !requests))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (!m_Counts || pageTable.GetLayout().tileCount != m_Layout.tileCount)
+    {
+        return E_UNEXPECTED;
+    }
+
+    size_t candidates = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t tile = feedback[i];
+        if (GetVirtualTextureTileIndex(m_Layout, tile) == SIZE_MAX)
+            continue;
+
+        // Walk up to the coarsest mip, touching every resident page on the way; the last
+        // missing tile before the first resident one is the next to load
+        uint32_t missing = VIRTUAL_TEXTURE_NO_TILE;
+        bool resident = false;
+        for (uint32_t t = tile; t != VIRTUAL_TEXTURE_NO_TILE; t = GetVirtualTextureParentTile(m_Layout, t))
+        {
+            uint16_t page = pageTable.GetPage(t);
+            if (page != VIRTUAL_TEXTURE_NO_PAGE)
+            {
+                cache.Touch(page, frame);
+                resident = true;
+            }
+            else if (!resident)
+            {
+                missing = t;
+            }
+        }
+
+        if (missing != VIRTUAL_TEXTURE_NO_TILE && m_Counts[GetVirtualTextureTileIndex(m_Layout, missing)]++ == 0)
+        {
+            m_Candidates[candidates++] = missing;
+        }
+    }
+
+    const VirtualTextureLayout& layout = m_Layout;
+    const uint32_t* counts = m_Counts.get();
+    auto before = [&](uint32_t a, uint32_t b) noexcept
+    {
+        uint32_t mipA = GetVirtualTextureTileMip(a);
+        uint32_t mipB = GetVirtualTextureTileMip(b);
+        if (mipA != mipB)
+            return mipA > mipB;
+
+        uint32_t countA = counts[GetVirtualTextureTileIndex(layout, a)];
+        uint32_t countB = counts[GetVirtualTextureTileIndex(layout, b)];
+        if (countA != countB)
+            return countA > countB;
+
+        return a < b;
+    };
+
+    size_t accepted = std::min(candidates, maxRequests);
+    std::partial_sort(m_Candidates.get(), m_Candidates.get() + accepted, m_Candidates.get() + candidates, before);
+
+    for (size_t i = 0; i < accepted; i++)
+    {
+        uint32_t tile = m_Candidates[i];
+        requests[i] = { tile, m_Counts[GetVirtualTextureTileIndex(m_Layout, tile)] };
+    }
+
+    for (size_t i = 0; i < candidates; i++)
+    {
+        m_Counts[GetVirtualTextureTileIndex(m_Layout, m_Candidates[i])] = 0;
+    }
+
+    *requestCount = accepted;
+    return S_OK;
+}
@@ -0,0 +1,236 @@
+//--------------------------------------------------------------------------------------
+// File: VirtualTexture.h
+//
+// Sparse virtual texturing: a texture too large to create whole is cut into fixed-size
+// tiles, and only the tiles the camera needs are kept in a physical texture of
+// pageCount pages. What stays on the GPU is bounded by the page count, not by the size
+// of the source imagery.
+//
+//   VirtualTextureLayout      the tile grid of every mip, and tile cooking from DDS mips
+//   VirtualTexturePageTable   which page holds each tile, resolved into indirection
+//                             entries that fall back to the nearest resident ancestor
+//   VirtualTextureTileCache   the physical pages, recycled least recently used first
+//   VirtualTextureFeedback    turns the tiles the shader reported into load requests
+//
+// Each frame the renderer reads back the feedback buffer and then:
+//
+//   feedback.Analyze(data, count, pageTable, cache, frame, requests, maxRequests, &n);
+//   for each request: cook the tile, cache.Allocate(), pageTable.Unmap() the tile it
+//                     evicted, pageTable.Map() the new one, copy the tile into its page
+//   levels = pageTable.Update(); upload the first levels mips of the indirection texture
+//
+// Doesn't need Direct3D, so it also builds against the DirectX-Headers WSL adapter.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <dxgiformat.h>
+#else
+#include <wsl/winadapter.h>
+#include <directx/dxgiformat.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+namespace DirectX
+{
+    constexpr size_t VIRTUAL_TEXTURE_MAX_MIPS = 16;
+
+    // Tiles per row or column of a mip; tile coordinates are stored in 12 bits
+    constexpr size_t VIRTUAL_TEXTURE_MAX_TILES = 4096;
+
+    constexpr uint32_t VIRTUAL_TEXTURE_NO_TILE = 0xFFFFFFFF;
+    constexpr uint16_t VIRTUAL_TEXTURE_NO_PAGE = 0xFFFF;
+
+    // A tile is named by its position in its mip's grid. The feedback pass writes the same
+    // packing, so the shader only needs the tile size and the mip it sampled.
+    constexpr uint32_t MakeVirtualTextureTile(uint32_t x, uint32_t y, uint32_t mip) noexcept
+    {
+        return x | (y << 12) | (mip << 24);
+    }
+
+    constexpr uint32_t GetVirtualTextureTileX(uint32_t tile) noexcept { return tile & 0xFFF; }
+    constexpr uint32_t GetVirtualTextureTileY(uint32_t tile) noexcept { return (tile >> 12) & 0xFFF; }
+    constexpr uint32_t GetVirtualTextureTileMip(uint32_t tile) noexcept { return tile >> 24; }
+
+    struct VirtualTextureLayout
+    {
+        size_t width;
+        size_t height;
+        size_t mipCount;
+        DXGI_FORMAT format;
+        size_t tileSize;        // texels a tile covers, a power of two
+        size_t border;          // texels repeated from the neighbours on each side, for filtering
+        size_t tilesX[VIRTUAL_TEXTURE_MAX_MIPS];
+        size_t tilesY[VIRTUAL_TEXTURE_MAX_MIPS];
+        size_t firstTile[VIRTUAL_TEXTURE_MAX_MIPS]; // of each mip, in a flat array of every tile
+        size_t tileCount;
+        size_t tileRowBytes;    // of a cooked tile, border included
+        size_t tileRows;
+    };
+
+    // Block-compressed formats need the tile size and border to be whole blocks. Formats
+    // with packed or planar layouts can't be tiled.
+    HRESULT GetVirtualTextureLayout(
+        _In_ size_t width,
+        _In_ size_t height,
+        _In_ size_t mipCount,
+        _In_ DXGI_FORMAT format,
+        _In_ size_t tileSize,
+        _In_ size_t border,
+        _Out_ VirtualTextureLayout& layout) noexcept;
+
+    // Index into a flat array of every tile, or SIZE_MAX if the tile isn't in the layout
+    size_t GetVirtualTextureTileIndex(_In_ const VirtualTextureLayout& layout, _In_ uint32_t tile) noexcept;
+
+    // The tile of the next mip that covers this one; the coarsest mip's tiles have none
+    uint32_t GetVirtualTextureParentTile(_In_ const VirtualTextureLayout& layout, _In_ uint32_t tile) noexcept;
+
+    // Cooks one tile, border included, out of its mip as the DDS loader lays it out. Texels
+    // past the edges of the mip repeat the edge.
+    HRESULT CopyVirtualTextureTile(
+        _In_ const VirtualTextureLayout& layout,
+        _In_ uint32_t tile,
+        _In_reads_bytes_(mipRowPitch * mipRows) const uint8_t* mipData,
+        _In_ size_t mipRowPitch,
+        _In_ size_t mipRows,
+        _Out_writes_bytes_(destRowPitch * layout.tileRows) uint8_t* dest,
+        _In_ size_t destRowPitch) noexcept;
+
+    // Indirection entry of one tile: the page to sample and the mip that page holds, which
+    // is coarser than the tile's own when only an ancestor is resident. Each mip's entries
+    // fill the matching level of an R16G16_UINT texture.
+    struct VirtualTexturePageEntry
+    {
+        uint16_t page;
+        uint16_t mip;
+    };
+
+    static_assert(sizeof(VirtualTexturePageEntry) == 4, "VirtualTexturePageEntry size mismatch");
+
+    class VirtualTexturePageTable
+    {
+    public:
+        VirtualTexturePageTable() noexcept = default;
+
+        VirtualTexturePageTable(const VirtualTexturePageTable&) = delete;
+        VirtualTexturePageTable& operator=(const VirtualTexturePageTable&) = delete;
+
+        HRESULT Initialize(_In_ const VirtualTextureLayout& layout) noexcept;
+
+        const VirtualTextureLayout& GetLayout() const noexcept { return m_Layout; }
+
+        // VIRTUAL_TEXTURE_NO_PAGE unless the tile itself is resident
+        uint16_t GetPage(_In_ uint32_t tile) const noexcept;
+
+        void Map(_In_ uint32_t tile, _In_ uint16_t page) noexcept;
+        void Unmap(_In_ uint32_t tile) noexcept;
+
+        // Resolves the entries of the mips that changed since the last update, along with
+        // every finer mip, since those fall back to them. Returns how many levels, counting
+        // from mip 0, need uploading again.
+        size_t Update() noexcept;
+
+        // tilesX * tilesY entries, row by row, valid after Update
+        const VirtualTexturePageEntry* GetEntries(_In_ size_t mip) const noexcept { return m_Entries.get() + m_Layout.firstTile[mip]; }
+
+    private:
+        VirtualTextureLayout m_Layout = {};
+        std::unique_ptr<uint16_t[]> m_Pages;
+        std::unique_ptr<VirtualTexturePageEntry[]> m_Entries;
+        size_t m_DirtyLevels = 0;
+    };
+
+    // Pages go to the least recently used tile first. Tiles used in the current frame are
+    // never evicted, so a frame that needs more than the cache holds keeps what it has
+    // instead of thrashing, and pinned tiles, normally the coarsest mip, stay for good so
+    // every lookup has something to fall back to.
+    class VirtualTextureTileCache
+    {
+    public:
+        VirtualTextureTileCache() noexcept = default;
+
+        VirtualTextureTileCache(const VirtualTextureTileCache&) = delete;
+        VirtualTextureTileCache& operator=(const VirtualTextureTileCache&) = delete;
+
+        // pageCount is below VIRTUAL_TEXTURE_NO_PAGE
+        HRESULT Initialize(_In_ size_t pageCount) noexcept;
+
+        size_t GetPageCount() const noexcept { return m_PageCount; }
+
+        // VIRTUAL_TEXTURE_NO_TILE if the page is free
+        uint32_t GetTile(_In_ uint16_t page) const noexcept { return m_Tiles[page]; }
+
+        // Marks the page as used in frame, making it the last to be evicted
+        void Touch(_In_ uint16_t page, _In_ uint64_t frame) noexcept;
+
+        // Gives tile a free page, or else the least recently used unpinned page, and returns
+        // the tile that page held so it can be unmapped. S_FALSE, with no page, if every page
+        // is pinned or was used in frame.
+        HRESULT Allocate(
+            _In_ uint32_t tile,
+            _In_ uint64_t frame,
+            _In_ bool pin,
+            _Out_ uint16_t* page,
+            _Out_ uint32_t* evicted) noexcept;
+
+        // Returns the page to the free end of the list, pinned or not
+        void Free(_In_ uint16_t page) noexcept;
+
+    private:
+        size_t m_PageCount = 0;
+        std::unique_ptr<uint32_t[]> m_Tiles;
+        std::unique_ptr<uint64_t[]> m_LastUsed;
+        std::unique_ptr<bool[]> m_Pinned;
+
+        // Doubly linked LRU list of unpinned pages, least recent first; index m_PageCount is the head
+        std::unique_ptr<uint16_t[]> m_Prev;
+        std::unique_ptr<uint16_t[]> m_Next;
+
+        void Unlink(_In_ uint16_t page) noexcept;
+        void InsertAfter(_In_ uint16_t at, _In_ uint16_t page) noexcept;
+    };
+
+    struct VirtualTextureRequest
+    {
+        uint32_t tile;
+        uint32_t count;  // feedback entries that asked for it
+    };
+
+    class VirtualTextureFeedback
+    {
+    public:
+        VirtualTextureFeedback() noexcept = default;
+
+        VirtualTextureFeedback(const VirtualTextureFeedback&) = delete;
+        VirtualTextureFeedback& operator=(const VirtualTextureFeedback&) = delete;
+
+        HRESULT Initialize(_In_ const VirtualTextureLayout& layout) noexcept;
+
+        // Reads one frame of feedback, packed tiles as MakeVirtualTextureTile writes them;
+        // VIRTUAL_TEXTURE_NO_TILE and tiles outside the layout are skipped. Every resident
+        // page a pixel samples through, its tile's or an ancestor's, is touched. For a tile
+        // that isn't resident the missing tile just below its nearest resident ancestor is
+        // requested, so detail streams in one mip at a time and every load can be displayed
+        // at once. Requests are ordered coarsest mip first, then by how many pixels want them.
+        HRESULT Analyze(
+            _In_reads_(count) const uint32_t* feedback,
+            _In_ size_t count,
+            _In_ const VirtualTexturePageTable& pageTable,
+            _Inout_ VirtualTextureTileCache& cache,
+            _In_ uint64_t frame,
+            _Out_writes_(maxRequests) VirtualTextureRequest* requests,
+            _In_ size_t maxRequests,
+            _Out_ size_t* requestCount) noexcept;
+
+    private:
+        VirtualTextureLayout m_Layout = {};
+        std::unique_ptr<uint32_t[]> m_Counts;     // per tile, zero outside Analyze
+        std::unique_ptr<uint32_t[]> m_Candidates; // tiles with a non-zero count
+    };
+}
@@ -1,6 +1,7 @@
 #include "Water.h"
 #include "GeometryGenerator.h"
-#include "DDSTextureLoader.h"
+#include "MeshCompactor.h"
+#include "MeshOptimizer.h"
 #include "ShaderData.h"
 #include <SDL.h>
 
@@ -12,31 +13,33 @@ Water::Water(Renderer* renderer) : m_Renderer(renderer)
     m_TextureTransform *= DirectX::XMMatrixScaling(4.0f, 4.0f, 4.0f);
 }
 
-bool Water::Load()
+bool Water::Load(TextureArrayBuilder* textureArrays)
 {
     Geometry::CreateGrid(10.0f, 10.0f, 2, 2, &m_MeshData);
+    Geometry::OptimizeMesh(&m_MeshData);
+    Geometry::CompactMesh(m_MeshData, &m_CompactMesh);
 
     // Create vertex buffer
     D3D11_BUFFER_DESC vbd = {};
     vbd.Usage = D3D11_USAGE_DEFAULT;
-    vbd.ByteWidth = (UINT)(sizeof(Vertex) * m_MeshData.vertices.size());
+    vbd.ByteWidth = (UINT)(sizeof(Geometry::PackedVertex) * m_CompactMesh.vertices.size());
     vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vbd.CPUAccessFlags = 0;
 
     D3D11_SUBRESOURCE_DATA vInitData = {};
-    vInitData.pSysMem = &m_MeshData.vertices[0];
+    vInitData.pSysMem = &m_CompactMesh.vertices[0];
 
     DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateBuffer(&vbd, &vInitData, &m_VertexBuffer));
 
     // Create index buffer
     D3D11_BUFFER_DESC ibd = {};
     ibd.Usage = D3D11_USAGE_DEFAULT;
-    ibd.ByteWidth = (UINT)(sizeof(UINT) * m_MeshData.indices.size());
+    ibd.ByteWidth = (UINT)m_CompactMesh.indices.size();
     ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
     ibd.CPUAccessFlags = 0;
 
     D3D11_SUBRESOURCE_DATA iInitData = {};
-    iInitData.pSysMem = &m_MeshData.indices[0];
+    iInitData.pSysMem = &m_CompactMesh.indices[0];
 
     DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateBuffer(&ibd, &iInitData, &m_IndexBuffer));
 
@@ -48,10 +51,8 @@ bool Water::Load()
     bd.CPUAccessFlags = 0;
     DX::ThrowIfFailed(m_Renderer->GetDevice()->CreateBuffer(&bd, nullptr, &m_ConstantBuffer));
 
-    // Load texture
-    ID3D11Resource* resource = nullptr;
-    DX::ThrowIfFailed(DirectX::CreateDDSTextureFromFile(m_Renderer->GetDevice(), L"Textures\\water_diffuse.dds", &resource, &m_DiffuseTexture));
-    resource->Release();
+    // Reserve a slice for the texture, the builder packs it into an array once every object is loaded
+    m_DiffuseTexture = textureArrays->Add(L"Textures\\water_diffuse.dds");
 
     return true;
 }
@@ -59,13 +60,13 @@ bool Water::Load()
 void Water::Render(Camera* camera, double deltaTime)
 {
     // Bind the vertex buffer
-    UINT stride = sizeof(Vertex);
+    UINT stride = sizeof(Geometry::PackedVertex);
     UINT offset = 0;
 
     m_Renderer->GetDeviceContext()->IASetVertexBuffers(0, 1, &m_VertexBuffer, &stride, &offset);
 
     // Bind the index buffer
-    m_Renderer->GetDeviceContext()->IASetIndexBuffer(m_IndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+    m_Renderer->GetDeviceContext()->IASetIndexBuffer(m_IndexBuffer, m_CompactMesh.indexSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT, 0);
 
     // Set topology
     m_Renderer->GetDeviceContext()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -75,18 +76,19 @@ void Water::Render(Camera* camera, double deltaTime)
     m_TextureTransform *= DirectX::XMMatrixTranslation(0.0f, -0.5f * deltaTime, 0.0f);
 
     ConstantBuffer cb;
-    cb.mWorld = DirectX::XMMatrixTranspose(world);
+    cb.mWorld = DirectX::XMMatrixTranspose(Geometry::GetDequantizeTransform(m_CompactMesh) * world);
     cb.mView = DirectX::XMMatrixTranspose(camera->GetView());
     cb.mProjection = DirectX::XMMatrixTranspose(camera->GetProjection());
     cb.mTextureTransform = DirectX::XMMatrixTranspose(m_TextureTransform);
+    m_Material.mTextureSlice = (float)m_DiffuseTexture->index;
     cb.mMaterial = m_Material;
 
     m_Renderer->GetDeviceContext()->VSSetConstantBuffers(0, 1, &m_ConstantBuffer);
     m_Renderer->GetDeviceContext()->PSSetConstantBuffers(0, 1, &m_ConstantBuffer);
     m_Renderer->GetDeviceContext()->UpdateSubresource(m_ConstantBuffer, 0, nullptr, &cb, 0, 0);
 
-    m_Renderer->GetDeviceContext()->PSSetShaderResources(0, 1, &m_DiffuseTexture);
+    m_Renderer->SetDiffuseTexture(m_DiffuseTexture->array->GetView());
 
     // Render geometry
-    m_Renderer->GetDeviceContext()->DrawIndexed((UINT)m_MeshData.indices.size(), 0, 0);
+    m_Renderer->GetDeviceContext()->DrawIndexed(m_CompactMesh.indexCount, 0, 0);
 }
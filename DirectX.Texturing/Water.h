@@ -3,20 +3,23 @@
 #include "Renderer.h"
 #include "Camera.h"
 #include "Mesh.h"
+#include "MeshCompactor.h"
 #include "ShaderData.h"
+#include "TextureArrayBuilder.h"
 
 class Water
 {
 public:
 	Water(Renderer* renderer);
 
-	bool Load();
+	bool Load(TextureArrayBuilder* textureArrays);
 	void Render(Camera* camera, double deltaTime);
 
 private:
 	Renderer* m_Renderer = nullptr;
 
 	MeshData m_MeshData;
+	Geometry::CompactMeshData m_CompactMesh;
 	Material m_Material;
 
 	ID3D11Buffer* m_VertexBuffer = nullptr;
@@ -24,7 +27,7 @@ private:
 
 	ID3D11Buffer* m_ConstantBuffer = nullptr;
 
-	ID3D11ShaderResourceView* m_DiffuseTexture = nullptr;
+	std::shared_ptr<TextureArraySlice> m_DiffuseTexture;
 
 	DirectX::XMMATRIX m_TextureTransform;
 };
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include "Camera.h"
 #include <algorithm>
 #include "Timer.h"
+#include "TextureArrayBuilder.h"
+#include "LoadReport.h"
 
 #include "Crate.h"
 #include "Floor.h"
@@ -44,35 +46,62 @@ int main(int argc, char** argv)
 	// Camera
 	Camera* camera = new Camera(800, 600);
 
-	// Create shader
+	// Create shader, for the packed vertices every model is compacted to
 	Shader* shader = new Shader(renderer);
-	if (!shader->Create())
+	if (!shader->Create(Geometry::VertexFormat::Packed))
 		return -1;
 
+#ifdef DDS_LOADER_STATS
+	// Times every texture loaded during startup, written out once the loader first goes idle
+	LoadReport* loadReport = new LoadReport();
+#endif
+
+	// Updates to existing resources are staged and made once per frame
+	UploadManager* uploads = new UploadManager(renderer);
+	if (!uploads->Init())
+		return -1;
+
+	// Texture loading runs on worker threads, models render with a placeholder until it completes
+	TextureLoader* textureLoader = new TextureLoader(renderer, uploads);
+	if (!textureLoader->Init())
+		return -1;
+
+	// Textures come from the packed archive when there is one, otherwise from loose files
+	textureLoader->OpenArchive(L"Textures.pak");
+
+	// Streamed textures shrink the ones not being drawn to stay under this
+	textureLoader->SetBudget(64 * 1024 * 1024);
+
+	// Objects ask for their textures as they load, then they are packed into arrays together
+	TextureArrayBuilder* textureArrays = new TextureArrayBuilder(textureLoader);
+
 	// Models
 	Crate* crate = new Crate(renderer);
-	if (!crate->Load())
+	if (!crate->Load(textureArrays))
 		return -1;
 
 	Floor* floor = new Floor(renderer);
-	if (!floor->Load())
+	if (!floor->Load(textureArrays))
 		return -1;
 
 	Water* water = new Water(renderer);
-	if (!water->Load())
+	if (!water->Load(textureArrays))
 		return -1;
 
 	Pillar* pillarLeft = new Pillar(renderer);
-	if (!pillarLeft->Load())
+	if (!pillarLeft->Load(textureArrays))
 		return -1;
 	
 	Pillar* pillarRight = new Pillar(renderer);
-	if (!pillarRight->Load())
+	if (!pillarRight->Load(textureArrays))
 		return -1;
 
 	pillarLeft->Position.x = -3.0f;
 	pillarRight->Position.x = 3.0f;
 
+	if (!textureArrays->Build())
+		return -1;
+
 	// Timer
 	Timer timer;
 	timer.Start();
@@ -124,21 +153,42 @@ int main(int argc, char** argv)
 		{
 			timer.Tick();
 
+			textureLoader->Update();
+			uploads->Submit();
+
+#ifdef DDS_LOADER_STATS
+			if (loadReport != nullptr && textureLoader->IsIdle())
+			{
+				loadReport->Write(L"LoadReport.csv");
+				loadReport->Write(L"LoadReport.json");
+				delete loadReport;
+				loadReport = nullptr;
+			}
+#endif
+
 			renderer->Clear();
 
+			// Grouped by texture array, so the floor and pillars share one bind; water blends, so it goes last
 			shader->Use();
 			crate->Render(camera);
 			floor->Render(camera);
-			water->Render(camera, timer.DeltaTime());
-
 			pillarLeft->Render(camera);
 			pillarRight->Render(camera);
 
+			water->Render(camera, timer.DeltaTime());
+
 			renderer->Render();
 		}
 	}
 
 	// Cleanup
+	delete textureArrays;
+	delete textureLoader;
+	delete uploads;
+#ifdef DDS_LOADER_STATS
+	delete loadReport;
+#endif
+
 	renderer->Quit();
 	SDL_DestroyWindow(window);
 	SDL_Quit();